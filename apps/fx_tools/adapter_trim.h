@@ -0,0 +1,220 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Bit-parallel 3' adapter search with mismatches.
+//
+// The adapters are packed into 64 bit words, one bit per adapter
+// character, and searched with the shift-and algorithm extended to k
+// mismatches (Wu and Manber).  Several adapters that fit into one word are
+// searched at the same time.  Adapters longer than 64 characters are
+// truncated, trimming only depends on the adapter's prefix anyway.
+//
+// The read is cut at the leftmost position where an adapter occurs with at
+// most k mismatches or where a prefix of an adapter of at least the minimal
+// overlap matches the end of the read.  Partial matches of length l may have
+// at most floor(l * k / m) mismatches where m is the adapter length.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_ADAPTER_TRIM_H_
+#define SANDBOX_FX_TOOLS_APPS_FX_TOOLS_ADAPTER_TRIM_H_
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <vector>
+
+#include <seqan/basic.h>
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class AdapterGroup_
+// ----------------------------------------------------------------------------
+
+// Adapters packed into one word.
+
+struct AdapterGroup_
+{
+    // Character masks, bit i is set if the character matches adapter character i.
+    __uint64 masks[256];
+    // Bits of the first and last characters of the adapters.
+    __uint64 startBits;
+    __uint64 endBits;
+    // Offset and length of the adapters in the word.
+    std::vector<unsigned> offsets;
+    std::vector<unsigned> lengths;
+
+    AdapterGroup_() : startBits(0), endBits(0)
+    {
+        std::fill(masks, masks + 256, (__uint64)0);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// Class AdapterTrimmer
+// ----------------------------------------------------------------------------
+
+struct AdapterTrimmer
+{
+    // Maximal number of mismatches.
+    unsigned maxErrors;
+    // Minimal length of a partial match at the read end.
+    unsigned minOverlap;
+    // The adapter groups.
+    std::vector<AdapterGroup_> groups;
+    // Search state, one word per number of mismatches.
+    std::vector<__uint64> state;
+
+    AdapterTrimmer() : maxErrors(1), minOverlap(3)
+    {}
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function init()                                             [AdapterTrimmer]
+// ----------------------------------------------------------------------------
+
+inline void init(AdapterTrimmer & trimmer, unsigned maxErrors, unsigned minOverlap)
+{
+    trimmer.maxErrors = maxErrors;
+    trimmer.minOverlap = std::max(1u, minOverlap);
+    trimmer.groups.clear();
+    trimmer.state.resize(maxErrors + 1);
+}
+
+// ----------------------------------------------------------------------------
+// Function addAdapter()                                       [AdapterTrimmer]
+// ----------------------------------------------------------------------------
+
+// Add the adapter seq.  Adapter N characters match everything, read N characters only match adapter Ns.
+
+inline void addAdapter(AdapterTrimmer & trimmer, std::string const & seq)
+{
+    unsigned len = std::min((size_t)64, seq.size());
+    if (len == 0u)
+        return;
+
+    // Open a new group if the adapter does not fit into the last one.
+    unsigned used = trimmer.groups.empty() ? 64 : 0;
+    if (!trimmer.groups.empty() && !trimmer.groups.back().offsets.empty())
+        used = trimmer.groups.back().offsets.back() + trimmer.groups.back().lengths.back();
+    if (used + len > 64u)
+        trimmer.groups.push_back(AdapterGroup_());
+    AdapterGroup_ & group = trimmer.groups.back();
+    unsigned offset = group.offsets.empty() ? 0 : group.offsets.back() + group.lengths.back();
+
+    for (unsigned i = 0; i < len; ++i)
+    {
+        __uint64 bit = (__uint64)1 << (offset + i);
+        unsigned char c = toupper(seq[i]);
+        if (c == 'N')
+        {
+            for (unsigned x = 0; x < 256u; ++x)
+                group.masks[x] |= bit;
+            continue;
+        }
+        group.masks[c] |= bit;
+        group.masks[tolower(c)] |= bit;
+    }
+    group.startBits |= (__uint64)1 << offset;
+    group.endBits |= (__uint64)1 << (offset + len - 1);
+    group.offsets.push_back(offset);
+    group.lengths.push_back(len);
+}
+
+// ----------------------------------------------------------------------------
+// Function findAdapter()                                      [AdapterTrimmer]
+// ----------------------------------------------------------------------------
+
+// Returns the position to cut [seq, seq + len) at, len if no adapter was found.
+
+inline size_t findAdapter(AdapterTrimmer & trimmer, char const * seq, size_t len)
+{
+    size_t cutPos = len;
+    unsigned k = trimmer.maxErrors;
+    __uint64 * state = &trimmer.state[0];
+
+    for (unsigned g = 0; g < trimmer.groups.size(); ++g)
+    {
+        AdapterGroup_ const & group = trimmer.groups[g];
+        unsigned maxLen = *std::max_element(group.lengths.begin(), group.lengths.end());
+        std::fill(state, state + k + 1, (__uint64)0);
+
+        size_t i = 0;
+        for (; i < len; ++i)
+        {
+            __uint64 mask = group.masks[(unsigned char)seq[i]];
+            // Update from most to least errors, each needs the old value of the next lower one.
+            for (unsigned j = k; j > 0u; --j)
+                state[j] = (((state[j] << 1) | group.startBits) & mask) | (state[j - 1] << 1) | group.startBits;
+            state[0] = ((state[0] << 1) | group.startBits) & mask;
+
+            if (state[k] & group.endBits)
+            {
+                // Full matches ending at i.
+                for (unsigned a = 0; a < group.offsets.size(); ++a)
+                    if (i + 1 >= group.lengths[a] &&
+                        (state[k] & ((__uint64)1 << (group.offsets[a] + group.lengths[a] - 1))))
+                        cutPos = std::min(cutPos, i + 1 - group.lengths[a]);
+            }
+            // Later matches start at i + 2 - maxLen or later.
+            if (i + 2 >= cutPos + maxLen)
+                break;
+        }
+        if (i < len)
+            continue;  // Partial matches start behind len - maxLen and cannot be better.
+
+        // Partial matches at the read end, prefer the longest.
+        for (unsigned a = 0; a < group.offsets.size(); ++a)
+        {
+            unsigned m = group.lengths[a];
+            unsigned maxL = std::min((size_t)m - 1, len);
+            for (unsigned l = maxL; l >= trimmer.minOverlap; --l)
+            {
+                if (state[(size_t)l * k / m] & ((__uint64)1 << (group.offsets[a] + l - 1)))
+                {
+                    cutPos = std::min(cutPos, len - l);
+                    break;
+                }
+            }
+        }
+    }
+    return cutPos;
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_ADAPTER_TRIM_H_
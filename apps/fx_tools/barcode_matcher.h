@@ -0,0 +1,237 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Matching of read barcodes against a barcode sheet with mismatches.
+//
+// All barcodes and, for one allowed mismatch, all their Hamming-1
+// neighbours are precomputed into an open addressing hash table of 64 bit
+// fingerprints.  Looking up a read barcode is then one hash computation and
+// one probe sequence.  Neighbours shared by two barcodes are marked as
+// ambiguous, exact barcodes always take precedence over neighbours.  Dual
+// index barcodes such as ACGT+TTGC are supported, the '+' is kept as is.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_BARCODE_MATCHER_H_
+#define SANDBOX_FX_TOOLS_APPS_FX_TOOLS_BARCODE_MATCHER_H_
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <vector>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include "hash_functions.h"
+
+// ============================================================================
+// Tags, Classes, Enums
+// ============================================================================
+
+enum BarcodeMatchResult
+{
+    BARCODE_NO_MATCH = 0xffffffff,
+    BARCODE_AMBIGUOUS = 0xfffffffe
+};
+
+// ----------------------------------------------------------------------------
+// Class BarcodeEntry_
+// ----------------------------------------------------------------------------
+
+struct BarcodeEntry_
+{
+    // Fingerprint, 0 marks empty slots.
+    __uint64 key;
+    // Sample id or BARCODE_AMBIGUOUS.
+    __uint32 sampleId;
+    // Whether this is the barcode itself and not a neighbour.
+    bool exact;
+
+    BarcodeEntry_() : key(0), sampleId(BARCODE_NO_MATCH), exact(false)
+    {}
+};
+
+// ----------------------------------------------------------------------------
+// Class BarcodeMatcher
+// ----------------------------------------------------------------------------
+
+struct BarcodeMatcher
+{
+    // The barcodes and their sample ids, only used until build() is called.
+    std::vector<std::string> barcodes;
+    std::vector<__uint32> sampleIds;
+
+    // Hash table, the size is a power of two.
+    seqan::String<BarcodeEntry_> table;
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function barcodeKey_()
+// ----------------------------------------------------------------------------
+
+// Fingerprint of the upper case version of [ptr, ptr + len), barcodes are short.
+
+inline __uint64 barcodeKey_(char const * ptr, size_t len)
+{
+    char buffer[256];
+    len = std::min(len, sizeof(buffer));
+    for (size_t i = 0; i < len; ++i)
+        buffer[i] = toupper(ptr[i]);
+    __uint64 h = hashBytes(buffer, len);
+    return h ? h : 1;  // 0 marks empty slots.
+}
+
+// ----------------------------------------------------------------------------
+// Function insertEntry_()                                     [BarcodeMatcher]
+// ----------------------------------------------------------------------------
+
+// Returns false if an exact barcode collides with another exact barcode.
+
+inline bool insertEntry_(BarcodeMatcher & matcher, __uint64 key, __uint32 sampleId, bool exact)
+{
+    __uint64 mask = length(matcher.table) - 1;
+    __uint64 pos = mixHash64(key) & mask;
+    while (matcher.table[pos].key && matcher.table[pos].key != key)
+        pos = (pos + 1) & mask;
+
+    BarcodeEntry_ & entry = matcher.table[pos];
+    if (!entry.key)
+    {
+        entry.key = key;
+        entry.sampleId = sampleId;
+        entry.exact = exact;
+        return true;
+    }
+    if (entry.exact)
+        return !exact || entry.sampleId == sampleId;
+    // Exact barcodes replace neighbours, neighbours of different samples are ambiguous.
+    if (exact)
+    {
+        entry.sampleId = sampleId;
+        entry.exact = true;
+    }
+    else if (entry.sampleId != sampleId)
+    {
+        entry.sampleId = BARCODE_AMBIGUOUS;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Function insert()                                           [BarcodeMatcher]
+// ----------------------------------------------------------------------------
+
+inline void insert(BarcodeMatcher & matcher, char const * ptr, size_t len, __uint32 sampleId)
+{
+    matcher.barcodes.push_back(std::string(ptr, len));
+    matcher.sampleIds.push_back(sampleId);
+}
+
+// ----------------------------------------------------------------------------
+// Function build()                                            [BarcodeMatcher]
+// ----------------------------------------------------------------------------
+
+// Build the table allowing maxMismatches (0 or 1) mismatches.  Returns 0 on success, 1 if two samples have the same
+// barcode.
+
+inline int build(BarcodeMatcher & matcher, unsigned maxMismatches)
+{
+    static char const ALPHABET[] = "ACGTN";
+
+    // Size for the load factor to stay at or below 1/2.
+    size_t numEntries = 0;
+    for (unsigned i = 0; i < matcher.barcodes.size(); ++i)
+        numEntries += 1 + (maxMismatches ? 4 * matcher.barcodes[i].size() : 0);
+    size_t size = 1024;
+    while (size < 2 * numEntries)
+        size *= 2;
+    clear(matcher.table);
+    resize(matcher.table, size);
+
+    int res = 0;
+    for (unsigned i = 0; i < matcher.barcodes.size(); ++i)
+        if (!insertEntry_(matcher, barcodeKey_(matcher.barcodes[i].data(), matcher.barcodes[i].size()),
+                          matcher.sampleIds[i], true))
+            res = 1;
+
+    if (maxMismatches > 0u)
+    {
+        for (unsigned i = 0; i < matcher.barcodes.size(); ++i)
+        {
+            std::string neighbour = matcher.barcodes[i];
+            for (unsigned j = 0; j < neighbour.size(); ++j)
+            {
+                char c = toupper(neighbour[j]);
+                if (c == '+')
+                    continue;
+                for (unsigned k = 0; k < 5u; ++k)
+                {
+                    if (ALPHABET[k] == c)
+                        continue;
+                    neighbour[j] = ALPHABET[k];
+                    insertEntry_(matcher, barcodeKey_(neighbour.data(), neighbour.size()), matcher.sampleIds[i],
+                                 false);
+                }
+                neighbour[j] = matcher.barcodes[i][j];
+            }
+        }
+    }
+
+    std::vector<std::string>().swap(matcher.barcodes);
+    std::vector<__uint32>().swap(matcher.sampleIds);
+    return res;
+}
+
+// ----------------------------------------------------------------------------
+// Function findBarcode()                                      [BarcodeMatcher]
+// ----------------------------------------------------------------------------
+
+// Returns the sample id for the barcode [ptr, ptr + len), BARCODE_NO_MATCH or BARCODE_AMBIGUOUS.
+
+inline __uint32 findBarcode(BarcodeMatcher const & matcher, char const * ptr, size_t len)
+{
+    if (empty(matcher.table))
+        return BARCODE_NO_MATCH;
+    __uint64 key = barcodeKey_(ptr, len);
+    __uint64 mask = length(matcher.table) - 1;
+    for (__uint64 pos = mixHash64(key) & mask; matcher.table[pos].key; pos = (pos + 1) & mask)
+        if (matcher.table[pos].key == key)
+            return matcher.table[pos].sampleId;
+    return BARCODE_NO_MATCH;
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_BARCODE_MATCHER_H_
@@ -0,0 +1,495 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Sampled prefix-count index over the sequences of a FASTA file.
+//
+// For every sequence, the cumulative number of A, C, G, and T characters is
+// stored at every sampleRate-th position.  The composition of any region is
+// then given by the difference of two prefix counts, each of which is one
+// sample lookup plus a scan of less than sampleRate characters.  N (and any
+// other character) counts are derived from the region length.
+//
+// A checksum over all sequence characters is stored with the index so an
+// index for edited sequences of unchanged length is detected as stale.
+//
+// The FASTA file is accessed through a FAI index.  The functions are
+// templatized on the FAI index type since there are two versions around, one
+// in the rabema app and one in the seq_io module.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_COMPOSITION_INDEX_H_
+#define SANDBOX_FX_TOOLS_APPS_FX_TOOLS_COMPOSITION_INDEX_H_
+
+#include <fstream>
+#include <cstring>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include "hash_functions.h"
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class CompositionCounts
+// ----------------------------------------------------------------------------
+
+// Number of A, C, G, T, and N characters in a region, upper and lower case
+// characters are counted the same.  All characters that are not A, C, G, or T
+// count as N.
+
+struct CompositionCounts
+{
+    enum
+    {
+        A = 0,
+        C = 1,
+        G = 2,
+        T = 3,
+        N = 4
+    };
+
+    __uint64 counts[5];
+
+    CompositionCounts()
+    {
+        std::fill(counts, counts + 5, 0u);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// Class CompositionIndex
+// ----------------------------------------------------------------------------
+
+struct CompositionIndex
+{
+    enum
+    {
+        // The sequences are read and checksummed in chunks of this size.
+        CHUNK_SIZE = 1024 * 1024
+    };
+
+    // The prefix counts are stored for every sampleRate-th position.
+    unsigned sampleRate;
+    // Checksum over the characters of all sequences, see computeChecksum().
+    __uint64 checksum;
+
+    // Length of sequence i.
+    seqan::String<__uint64> seqLengths;
+    // Index of the first sample of sequence i in samples, divided by 4.
+    seqan::String<__uint64> sampleOffsets;
+    // The cumulative A, C, G, T counts, 4 values per sample.  Sequence i has
+    // seqLengths[i] / sampleRate + 1 samples, the first one at position 0.
+    seqan::String<__uint32> samples;
+
+    CompositionIndex() : sampleRate(1024), checksum(0)
+    {}
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function clear()
+// ----------------------------------------------------------------------------
+
+inline void clear(CompositionIndex & index)
+{
+    index.checksum = 0;
+    clear(index.seqLengths);
+    clear(index.sampleOffsets);
+    clear(index.samples);
+}
+
+// ----------------------------------------------------------------------------
+// Function cgCount()
+// ----------------------------------------------------------------------------
+
+inline __uint64 cgCount(CompositionCounts const & counts)
+{
+    return counts.counts[CompositionCounts::C] + counts.counts[CompositionCounts::G];
+}
+
+// ----------------------------------------------------------------------------
+// Function totalCount()
+// ----------------------------------------------------------------------------
+
+inline __uint64 totalCount(CompositionCounts const & counts)
+{
+    return counts.counts[0] + counts.counts[1] + counts.counts[2] + counts.counts[3] + counts.counts[4];
+}
+
+// ----------------------------------------------------------------------------
+// Function cgContent()
+// ----------------------------------------------------------------------------
+
+// Returns the C+G content relative to the region length, 0 for empty regions.
+
+inline double cgContent(CompositionCounts const & counts)
+{
+    __uint64 total = totalCount(counts);
+    if (total == 0u)
+        return 0;
+    return 1.0 * cgCount(counts) / total;
+}
+
+// ----------------------------------------------------------------------------
+// Function countComposition()
+// ----------------------------------------------------------------------------
+
+// Add the composition of the characters in [first, last) to counts.
+//
+// The loop is written branch-free on the case-folded characters so the
+// compiler can vectorize it.
+
+inline void countComposition(CompositionCounts & counts, char const * first, char const * last)
+{
+    __uint64 a = 0, c = 0, g = 0, t = 0;
+    for (char const * it = first; it != last; ++it)
+    {
+        char x = *it & ~0x20;  // To upper case.
+        a += (x == 'A');
+        c += (x == 'C');
+        g += (x == 'G');
+        t += (x == 'T');
+    }
+    counts.counts[CompositionCounts::A] += a;
+    counts.counts[CompositionCounts::C] += c;
+    counts.counts[CompositionCounts::G] += g;
+    counts.counts[CompositionCounts::T] += t;
+    counts.counts[CompositionCounts::N] += (last - first) - a - c - g - t;
+}
+
+// ----------------------------------------------------------------------------
+// Function numSeqs()
+// ----------------------------------------------------------------------------
+
+inline unsigned numSeqs(CompositionIndex const & index)
+{
+    return length(index.seqLengths);
+}
+
+// ----------------------------------------------------------------------------
+// Function updateChecksum_()
+// ----------------------------------------------------------------------------
+
+// Chain the hash of the chunk [first, last) into checksum.
+
+inline void updateChecksum_(__uint64 & checksum, char const * first, char const * last)
+{
+    checksum = hashBytes(first, last - first, checksum);
+}
+
+// ----------------------------------------------------------------------------
+// Function computeChecksum()
+// ----------------------------------------------------------------------------
+
+// Compute the checksum over the characters of all sequences in faiIndex.  The
+// sequences are read in the same chunks as in build().  Returns 0 on success,
+// 1 on errors.
+
+template <typename TFaiIndex>
+int computeChecksum(__uint64 & checksum, TFaiIndex & faiIndex)
+{
+    checksum = 0;
+    seqan::CharString buffer;
+    for (unsigned i = 0; i < length(faiIndex.indexEntryStore); ++i)
+    {
+        __uint64 seqLength = sequenceLength(faiIndex, i);
+        for (__uint64 chunkBegin = 0; chunkBegin < seqLength; chunkBegin += CompositionIndex::CHUNK_SIZE)
+        {
+            __uint64 chunkEnd = std::min(chunkBegin + CompositionIndex::CHUNK_SIZE, seqLength);
+            clear(buffer);
+            if (getSequenceInfix(buffer, faiIndex, i, chunkBegin, chunkEnd) != 0)
+                return 1;
+            if ((__uint64)length(buffer) != chunkEnd - chunkBegin)
+                return 1;
+            updateChecksum_(checksum, begin(buffer, seqan::Standard()), end(buffer, seqan::Standard()));
+        }
+    }
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function isCompatible()
+// ----------------------------------------------------------------------------
+
+// Returns true if the index was built with the given sample rate and the
+// sequence count, lengths and checksum in the index match the ones of the
+// given FAI index.  Computing the checksum reads all sequences once.
+
+template <typename TFaiIndex>
+bool isCompatible(CompositionIndex const & index, TFaiIndex & faiIndex, unsigned sampleRate)
+{
+    if (index.sampleRate != sampleRate)
+        return false;
+    if (length(index.seqLengths) != length(faiIndex.indexEntryStore))
+        return false;
+    for (unsigned i = 0; i < length(index.seqLengths); ++i)
+        if (index.seqLengths[i] != (__uint64)sequenceLength(faiIndex, i))
+            return false;
+    __uint64 checksum = 0;
+    if (computeChecksum(checksum, faiIndex) != 0)
+        return false;
+    return checksum == index.checksum;
+}
+
+// ----------------------------------------------------------------------------
+// Function build()
+// ----------------------------------------------------------------------------
+
+// Build composition index for all sequences in faiIndex.  The sequences are
+// read chunk-wise through the FAI index so we never hold a whole chromosome in
+// memory.  The checksum is computed in the same pass.  Returns 0 on success, 1
+// on errors.
+
+template <typename TFaiIndex>
+int build(CompositionIndex & index, TFaiIndex & faiIndex, unsigned sampleRate)
+{
+    if (sampleRate == 0u)
+        return 1;
+
+    clear(index);
+    index.sampleRate = sampleRate;
+
+    unsigned numSeqs = length(faiIndex.indexEntryStore);
+    resize(index.seqLengths, numSeqs, 0);
+    resize(index.sampleOffsets, numSeqs, 0);
+
+    seqan::CharString buffer;
+    for (unsigned i = 0; i < numSeqs; ++i)
+    {
+        __uint64 seqLength = sequenceLength(faiIndex, i);
+        if (seqLength > seqan::maxValue<__uint32>())
+            return 1;  // Counts would overflow.
+        index.seqLengths[i] = seqLength;
+        index.sampleOffsets[i] = length(index.samples) / 4;
+
+        // Sample at position 0.
+        CompositionCounts counts;
+        resize(index.samples, length(index.samples) + 4, 0);
+
+        for (__uint64 chunkBegin = 0; chunkBegin < seqLength; chunkBegin += CompositionIndex::CHUNK_SIZE)
+        {
+            __uint64 chunkEnd = std::min(chunkBegin + CompositionIndex::CHUNK_SIZE, seqLength);
+            clear(buffer);
+            if (getSequenceInfix(buffer, faiIndex, i, chunkBegin, chunkEnd) != 0)
+                return 1;
+            if ((__uint64)length(buffer) != chunkEnd - chunkBegin)
+                return 1;
+
+            char const * ptr = begin(buffer, seqan::Standard());
+            updateChecksum_(index.checksum, ptr, ptr + (chunkEnd - chunkBegin));
+
+            // Samples may span chunk boundaries, counts carries over to the next chunk.
+            for (__uint64 pos = chunkBegin; pos < chunkEnd; )
+            {
+                __uint64 sampleEnd = std::min((pos / sampleRate + 1) * (__uint64)sampleRate, chunkEnd);
+                countComposition(counts, ptr + (pos - chunkBegin), ptr + (sampleEnd - chunkBegin));
+                if (sampleEnd % sampleRate == 0u)  // Only full samples are stored.
+                    for (unsigned c = 0; c < 4; ++c)
+                        appendValue(index.samples, (__uint32)counts.counts[c]);
+                pos = sampleEnd;
+            }
+        }
+    }
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function getPrefixComposition()
+// ----------------------------------------------------------------------------
+
+// Write composition of the first pos characters of sequence seqId to counts.
+// Returns 0 on success, 1 on errors.
+
+template <typename TFaiIndex>
+int getPrefixComposition(CompositionCounts & counts,
+                         CompositionIndex const & index,
+                         TFaiIndex & faiIndex,
+                         unsigned seqId,
+                         __uint64 pos)
+{
+    counts = CompositionCounts();
+    if (seqId >= length(index.seqLengths) || pos > index.seqLengths[seqId])
+        return 1;
+
+    // Lookup sample.
+    __uint64 sampleNo = pos / index.sampleRate;
+    __uint32 const * sample = begin(index.samples, seqan::Standard()) + 4 * (index.sampleOffsets[seqId] + sampleNo);
+    __uint64 samplePos = sampleNo * index.sampleRate;
+    for (unsigned c = 0; c < 4; ++c)
+        counts.counts[c] = sample[c];
+    counts.counts[CompositionCounts::N] = samplePos - sample[0] - sample[1] - sample[2] - sample[3];
+
+    // Scan the remaining characters.
+    if (samplePos == pos)
+        return 0;
+    seqan::CharString buffer;
+    if (getSequenceInfix(buffer, faiIndex, seqId, samplePos, pos) != 0)
+        return 1;
+    countComposition(counts, begin(buffer, seqan::Standard()), end(buffer, seqan::Standard()));
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function getComposition()
+// ----------------------------------------------------------------------------
+
+// Write composition of the infix [beginPos, endPos) of sequence seqId to
+// counts.  Returns 0 on success, 1 on errors.
+
+template <typename TFaiIndex>
+int getComposition(CompositionCounts & counts,
+                   CompositionIndex const & index,
+                   TFaiIndex & faiIndex,
+                   unsigned seqId,
+                   __uint64 beginPos,
+                   __uint64 endPos)
+{
+    counts = CompositionCounts();
+    if (beginPos > endPos)
+        return 1;
+
+    // Short regions within one sample are simply scanned.
+    if (beginPos / index.sampleRate == endPos / index.sampleRate)
+    {
+        if (seqId >= length(index.seqLengths) || endPos > index.seqLengths[seqId])
+            return 1;
+        seqan::CharString buffer;
+        if (getSequenceInfix(buffer, faiIndex, seqId, beginPos, endPos) != 0)
+            return 1;
+        countComposition(counts, begin(buffer, seqan::Standard()), end(buffer, seqan::Standard()));
+        return 0;
+    }
+
+    CompositionCounts beginCounts;
+    if (getPrefixComposition(beginCounts, index, faiIndex, seqId, beginPos) != 0)
+        return 1;
+    if (getPrefixComposition(counts, index, faiIndex, seqId, endPos) != 0)
+        return 1;
+    for (unsigned c = 0; c < 5; ++c)
+        counts.counts[c] -= beginCounts.counts[c];
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function save()
+// ----------------------------------------------------------------------------
+
+// The file format is binary, in native byte order:
+//
+//   char[8]        magic "FXCMP\0\0\2", the last byte is the version
+//   uint32         sample rate
+//   uint32         number of sequences n
+//   uint64         checksum
+//   uint64[n]      sequence lengths
+//   uint32[4 * m]  the m samples of all sequences, in sequence order
+//
+// Returns 0 on success, 1 on errors.
+
+inline int save(CompositionIndex const & index, char const * path)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::out);
+    if (!out.good())
+        return 1;
+
+    char const MAGIC[8] = {'F', 'X', 'C', 'M', 'P', '\0', '\0', '\2'};
+    out.write(MAGIC, 8);
+    __uint32 sampleRate = index.sampleRate;
+    out.write(reinterpret_cast<char const *>(&sampleRate), sizeof(sampleRate));
+    __uint32 numSeqs = length(index.seqLengths);
+    out.write(reinterpret_cast<char const *>(&numSeqs), sizeof(numSeqs));
+    out.write(reinterpret_cast<char const *>(&index.checksum), sizeof(index.checksum));
+    if (numSeqs > 0u)
+        out.write(reinterpret_cast<char const *>(begin(index.seqLengths, seqan::Standard())),
+                  sizeof(__uint64) * numSeqs);
+    if (!empty(index.samples))
+        out.write(reinterpret_cast<char const *>(begin(index.samples, seqan::Standard())),
+                  sizeof(__uint32) * length(index.samples));
+
+    return !out.good();
+}
+
+// ----------------------------------------------------------------------------
+// Function load()
+// ----------------------------------------------------------------------------
+
+// Load composition index from path.  Returns 0 on success, 1 on errors.
+
+inline int load(CompositionIndex & index, char const * path)
+{
+    clear(index);
+
+    std::ifstream in(path, std::ios::binary | std::ios::in);
+    if (!in.good())
+        return 1;
+
+    char const MAGIC[8] = {'F', 'X', 'C', 'M', 'P', '\0', '\0', '\2'};
+    char magic[8];
+    if (!in.read(magic, 8) || memcmp(magic, MAGIC, 8) != 0)
+        return 1;
+    __uint32 sampleRate = 0, numSeqs = 0;
+    if (!in.read(reinterpret_cast<char *>(&sampleRate), sizeof(sampleRate)) || sampleRate == 0u)
+        return 1;
+    if (!in.read(reinterpret_cast<char *>(&numSeqs), sizeof(numSeqs)))
+        return 1;
+    if (!in.read(reinterpret_cast<char *>(&index.checksum), sizeof(index.checksum)))
+        return 1;
+    index.sampleRate = sampleRate;
+
+    resize(index.seqLengths, numSeqs, 0);
+    resize(index.sampleOffsets, numSeqs, 0);
+    if (numSeqs > 0u && !in.read(reinterpret_cast<char *>(begin(index.seqLengths, seqan::Standard())),
+                                 sizeof(__uint64) * numSeqs))
+        return 1;
+    __uint64 numSamples = 0;
+    for (unsigned i = 0; i < numSeqs; ++i)
+    {
+        index.sampleOffsets[i] = numSamples;
+        numSamples += index.seqLengths[i] / sampleRate + 1;
+    }
+
+    resize(index.samples, 4 * numSamples, 0);
+    if (numSamples > 0u && !in.read(reinterpret_cast<char *>(begin(index.samples, seqan::Standard())),
+                                    sizeof(__uint32) * 4 * numSamples))
+        return 1;
+
+    return 0;
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_COMPOSITION_INDEX_H_
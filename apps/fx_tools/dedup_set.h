@@ -0,0 +1,213 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Detection of exact duplicate records by their hash fingerprints.
+//
+// Only 64 or 128 bit fingerprints of the records are kept in an open
+// addressing hash table with linear probing whose size is bounded by a
+// memory budget.  With n records, the probability of a false duplicate is
+// about n^2 / 2^65 for 64 bit and negligible for 128 bit fingerprints.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_DEDUP_SET_H_
+#define SANDBOX_FX_TOOLS_APPS_FX_TOOLS_DEDUP_SET_H_
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include "hash_functions.h"
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class DedupFingerprint
+// ----------------------------------------------------------------------------
+
+struct DedupFingerprint
+{
+    // h1 is never 0, h2 is 0 for 64 bit fingerprints.
+    __uint64 h1;
+    __uint64 h2;
+
+    DedupFingerprint() : h1(1), h2(0)
+    {}
+};
+
+// ----------------------------------------------------------------------------
+// Class DedupSet
+// ----------------------------------------------------------------------------
+
+struct DedupSet
+{
+    // Number of 64 bit words per fingerprint, 1 or 2.
+    unsigned numWords;
+    // Maximal number of bytes to use for the table.
+    __uint64 maxBytes;
+    // The slots with numWords words each, a first word of 0 marks empty slots.  The number of slots is a power of
+    // two.
+    seqan::String<__uint64> table;
+    // Number of stored fingerprints.
+    __uint64 size;
+
+    DedupSet() : numWords(1), maxBytes(1024 * 1024 * 1024), size(0)
+    {}
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function computeFingerprint()
+// ----------------------------------------------------------------------------
+
+// Fingerprint of the sequence seq, combined with the identifier id if idLen is not 0.
+
+inline void computeFingerprint(DedupFingerprint & fp,
+                               char const * id, size_t idLen,
+                               char const * seq, size_t seqLen,
+                               unsigned numWords)
+{
+    __uint64 seed = idLen ? hashBytes(id, idLen) : 0;
+    fp.h1 = hashBytes(seq, seqLen, seed);
+    if (fp.h1 == 0u)
+        fp.h1 = 1;  // 0 marks empty slots.
+    fp.h2 = (numWords == 2u) ? hashBytes(seq, seqLen, seed ^ 0x5851f42d4c957f2dULL) : 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function numSlots()                                               [DedupSet]
+// ----------------------------------------------------------------------------
+
+inline __uint64 numSlots(DedupSet const & set)
+{
+    return length(set.table) / set.numWords;
+}
+
+// ----------------------------------------------------------------------------
+// Function init()                                                   [DedupSet]
+// ----------------------------------------------------------------------------
+
+inline void init(DedupSet & set, unsigned numWords, __uint64 maxBytes)
+{
+    set.numWords = numWords;
+    set.maxBytes = maxBytes;
+    set.size = 0;
+    clear(set.table);
+    resize(set.table, 1024 * numWords, 0);
+}
+
+// ----------------------------------------------------------------------------
+// Function insertSlot_()                                            [DedupSet]
+// ----------------------------------------------------------------------------
+
+// Returns true if fp was inserted, false if it was already there.
+
+inline bool insertSlot_(DedupSet & set, DedupFingerprint const & fp)
+{
+    __uint64 mask = numSlots(set) - 1;
+    __uint64 * table = begin(set.table, seqan::Standard());
+    if (set.numWords == 1u)
+    {
+        for (__uint64 pos = fp.h1 & mask; ; pos = (pos + 1) & mask)
+        {
+            if (table[pos] == fp.h1)
+                return false;
+            if (table[pos] == 0u)
+            {
+                table[pos] = fp.h1;
+                break;
+            }
+        }
+    }
+    else
+    {
+        for (__uint64 pos = fp.h1 & mask; ; pos = (pos + 1) & mask)
+        {
+            __uint64 * slot = table + 2 * pos;
+            if (slot[0] == fp.h1 && slot[1] == fp.h2)
+                return false;
+            if (slot[0] == 0u)
+            {
+                slot[0] = fp.h1;
+                slot[1] = fp.h2;
+                break;
+            }
+        }
+    }
+    set.size += 1;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Function insert()                                                 [DedupSet]
+// ----------------------------------------------------------------------------
+
+// Insert fp into set.  Returns 1 if fp was new, 0 if it is a duplicate and -1 if the table would exceed the memory
+// budget.
+
+inline int insert(DedupSet & set, DedupFingerprint const & fp)
+{
+    // Grow at a load factor of 3/4, as long as the budget allows.  Once it does not, fill up to 7/8.
+    if (4 * (set.size + 1) > 3 * numSlots(set))
+    {
+        __uint64 newBytes = 2 * length(set.table) * sizeof(__uint64);
+        if (newBytes <= set.maxBytes)
+        {
+            // Swap instead of copying the old table, the copy would not fit into the budget.
+            seqan::String<__uint64> oldTable;
+            swap(oldTable, set.table);
+            resize(set.table, 2 * length(oldTable), 0);
+            set.size = 0;
+            DedupFingerprint oldFp;
+            for (__uint64 i = 0; i < length(oldTable); i += set.numWords)
+            {
+                if (!oldTable[i])
+                    continue;
+                oldFp.h1 = oldTable[i];
+                oldFp.h2 = (set.numWords == 2u) ? oldTable[i + 1] : 0;
+                insertSlot_(set, oldFp);
+            }
+        }
+        else if (8 * (set.size + 1) > 7 * numSlots(set))
+        {
+            return -1;
+        }
+    }
+
+    return insertSlot_(set, fp) ? 1 : 0;
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_DEDUP_SET_H_
@@ -0,0 +1,867 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Accumulators for the per-position statistics of fx_fastq_stats.
+//
+// FastqStats counts bases and PHRED qualities per read position in a dense
+// matrix of histograms.  Positions of long reads are combined into bins, so
+// the memory is bounded.  Accumulators with the same binning can be merged,
+// e.g. those of several threads or of the snapshots of several shards.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_FASTQ_STATS_H_
+#define SANDBOX_FX_TOOLS_APPS_FX_TOOLS_FASTQ_STATS_H_
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif  // #ifdef _OPENMP
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include "hash_functions.h"
+#include "kmer_sketch.h"
+#include "random_sampling.h"
+#include "record_index.h"
+#include "record_scanner.h"
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class PositionBinning
+// ----------------------------------------------------------------------------
+
+// Maps read positions to columns.  Positions below exactLength have a column each, the later ones are combined into
+// bins such that long reads need a bounded number of columns.  With BIN_FIXED, all bins have binWidth positions,
+// with BIN_LOG, the first bin has binWidth positions and each following one twice as many as its predecessor.
+
+enum PositionBinMode
+{
+    BIN_FIXED,
+    BIN_LOG
+};
+
+struct PositionBinning
+{
+    unsigned exactLength;
+    PositionBinMode mode;
+    unsigned binWidth;
+
+    PositionBinning() : exactLength(1000), mode(BIN_LOG), binWidth(100)
+    {}
+
+    // Returns the column of position pos.
+    unsigned column(__uint64 pos) const
+    {
+        if (pos < exactLength)
+            return pos;
+        __uint64 bin = (pos - exactLength) / binWidth;
+        if (mode == BIN_FIXED)
+            return exactLength + bin;
+        unsigned logBin = 0;
+        for (bin += 1; bin > 1u; bin >>= 1)
+            ++logBin;
+        return exactLength + logBin;
+    }
+
+    // Returns the first position of column c.
+    __uint64 columnBegin(unsigned c) const
+    {
+        if (c < exactLength)
+            return c;
+        __uint64 bin = c - exactLength;
+        if (mode == BIN_FIXED)
+            return exactLength + bin * binWidth;
+        return exactLength + (((__uint64)1 << bin) - 1) * binWidth;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// Class QualHistograms
+// ----------------------------------------------------------------------------
+
+// Dense matrix of 64 bit counters, one row of PHRED quality counts per column.  Rows are padded to STRIDE counters
+// and start at 64 byte boundaries such that each row covers whole cache lines.
+
+struct QualHistograms
+{
+    // PHRED scores 0..93, i.e. '!'..'~'.
+    static unsigned const NUM_QUALS = 94;
+    static unsigned const STRIDE = 96;
+
+    std::vector<__uint64> store;
+    // Index of the first 64 byte aligned counter in store.
+    size_t offset;
+    unsigned numColumns;
+
+    QualHistograms() : offset(0), numColumns(0)
+    {}
+
+    QualHistograms(QualHistograms const & other) : offset(0), numColumns(0)
+    {
+        *this = other;
+    }
+
+    QualHistograms & operator=(QualHistograms const & other)
+    {
+        if (this == &other)
+            return *this;
+        numColumns = 0;
+        resize(other.numColumns);
+        if (numColumns)
+            std::copy(other.row(0), other.row(0) + (size_t)numColumns * STRIDE, row(0));
+        return *this;
+    }
+
+    __uint64 * row(unsigned i)
+    {
+        return &store[offset] + (size_t)i * STRIDE;
+    }
+
+    __uint64 const * row(unsigned i) const
+    {
+        return &store[offset] + (size_t)i * STRIDE;
+    }
+
+    // Resize to n columns, keeping the counts of the first min(n, numColumns) ones.
+    void resize(unsigned n)
+    {
+        std::vector<__uint64> newStore((size_t)n * STRIDE + 8, 0);
+        size_t misalignment = (reinterpret_cast<size_t>(&newStore[0]) / sizeof(__uint64)) % 8;
+        size_t newOffset = misalignment ? 8 - misalignment : 0;
+        unsigned numKept = std::min(n, numColumns);
+        if (numKept)
+            std::copy(row(0), row(0) + (size_t)numKept * STRIDE, &newStore[newOffset]);
+        store.swap(newStore);
+        offset = newOffset;
+        numColumns = n;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// Class FastqStats
+// ----------------------------------------------------------------------------
+
+struct FastqStats
+{
+    // -----------------------------------------------------------------------
+    // Members with Results
+    // -----------------------------------------------------------------------
+
+    // Length of the longest read and number of columns it spans.
+    unsigned maxLength;
+    unsigned numColumns;
+
+    // Number of bases in column i.
+    seqan::String<__int64> numBases;
+    // Smallest score in column i.
+    seqan::String<__int32> minScores;
+    // Largest score in column i.
+    seqan::String<__int32> maxScores;
+    // Sum of scores in column i.
+    seqan::String<__int64> sumScores;
+    // Mean of scores in column i.
+    seqan::String<double> meanScores;
+    // First quartile quality score (Q1) for column i.
+    seqan::String<double> firstQuartiles;
+    // Median quality score for column i.
+    seqan::String<double> medianScores;
+    // Third quartile quality score (Q3) for column i.
+    seqan::String<double> thirdQuartiles;
+    // Inter-quartile range  (Q3-Q1) for column i.
+    seqan::String<double> interQuartileRanges;
+    // Left-whisker value for boxplotting for column i.
+    seqan::String<__int32> leftWhiskers;
+    // Right-whisker value for boxplotting for column i.
+    seqan::String<__int32> rightWhiskers;
+    // Number of nucleotides A, C, G, T, N for column i at [i * 5 + ordValue(c)].
+    seqan::String<__int64> nucleotideCounts;
+
+    // -----------------------------------------------------------------------
+    // Histogram Members
+    // -----------------------------------------------------------------------
+
+    // Quality histogram, the base counts, score extrema and sums are computed from it in finalizeStats().
+    QualHistograms qualHistos;
+    // Number of reads by length, binned like the columns, at binning.column(length).
+    seqan::String<__int64> lengthCounts;
+    // Number of reads by rounded mean PHRED score.
+    seqan::String<__int64> meanQualCounts;
+    // Sketches of the reads' k-mers and sequences for finding overrepresented k-mers and duplicates.
+    KmerSketch kmers;
+
+    // -----------------------------------------------------------------------
+    // Configuration
+    // -----------------------------------------------------------------------
+
+    // Accumulators can only be merged if they use the same binning.
+    PositionBinning binning;
+
+    // -----------------------------------------------------------------------
+    // Constructor
+    // -----------------------------------------------------------------------
+
+    FastqStats() : maxLength(0), numColumns(0)
+    {
+        resize(meanQualCounts, QualHistograms::NUM_QUALS, 0);
+    }
+
+    // -----------------------------------------------------------------------
+    // Member Functions
+    // -----------------------------------------------------------------------
+
+    // Resize members to read of length.  Columns are only added, never removed, such that shorter reads and
+    // merging with other accumulators keep the counts of the longer columns.
+    void resizeToReadLength(unsigned len)
+    {
+        if (len <= maxLength)
+            return;
+        maxLength = len;
+        unsigned n = binning.column(len - 1) + 1;
+        if (n == numColumns)
+            return;
+        numColumns = n;
+
+        resize(numBases, n, 0);
+        resize(minScores, n, 0);
+        resize(maxScores, n, 0);
+        resize(sumScores, n, 0);
+        resize(meanScores, n, 0);
+        resize(firstQuartiles, n, 0);
+        resize(medianScores, n, 0);
+        resize(thirdQuartiles, n, 0);
+        resize(interQuartileRanges, n, 0);
+        resize(leftWhiskers, n, 0);
+        resize(rightWhiskers, n, 0);
+        resize(nucleotideCounts, 5 * n, 0);
+
+        qualHistos.resize(n);
+    }
+
+    // Use the binning and sketch parameters of other, e.g. for the accumulators of threads.
+    void copyConfig(FastqStats const & other)
+    {
+        binning = other.binning;
+        initLike(kmers, other.kmers);
+    }
+
+    // Update histogram and statistics for the read with the n characters at seq and quals.
+    void registerRead(char const * seq, char const * quals, unsigned n)
+    {
+        addRead(kmers, seq, n);
+
+        unsigned lengthColumn = binning.column(n);
+        if (lengthColumn >= length(lengthCounts))
+            resize(lengthCounts, lengthColumn + 1, 0);
+        lengthCounts[lengthColumn] += 1;
+        if (n == 0u)
+            return;
+        resizeToReadLength(n);
+
+        // Update nucleotide counts, all characters but ACGT count as N.
+        static DnaCodeTable const CODES;
+        __int64 * nucCounts = begin(nucleotideCounts, seqan::Standard());
+        unsigned numExact = std::min(n, binning.exactLength);
+        for (unsigned i = 0; i < numExact; ++i)
+            nucCounts[5 * i + CODES.table[(unsigned char)seq[i]]] += 1;
+
+        // Update quality histograms, each column has its own row so there are no dependencies between iterations.
+        int const MAX_QUAL = QualHistograms::NUM_QUALS - 1;
+        __uint64 * histos = qualHistos.row(0);
+        __uint64 qualSum = 0;
+        for (unsigned i = 0; i < numExact; ++i)
+        {
+            int qual = quals[i] - '!';  // PHRED scores.
+            qual = std::max(0, std::min(MAX_QUAL, qual));
+            histos[(size_t)i * QualHistograms::STRIDE + qual] += 1;
+            qualSum += qual;
+        }
+
+        // The binned positions are counted into the row of their bin.
+        for (unsigned c = numExact; c < binning.column(n - 1) + 1; ++c)
+        {
+            __int64 * nucCount = nucCounts + 5 * c;
+            __uint64 * histo = qualHistos.row(c);
+            unsigned end = std::min((__uint64)n, binning.columnBegin(c + 1));
+            for (unsigned i = binning.columnBegin(c); i < end; ++i)
+            {
+                nucCount[CODES.table[(unsigned char)seq[i]]] += 1;
+                int qual = std::max(0, std::min(MAX_QUAL, quals[i] - '!'));
+                histo[qual] += 1;
+                qualSum += qual;
+            }
+        }
+
+        meanQualCounts[(qualSum + n / 2) / n] += 1;
+    }
+
+    // Add the counts of other, e.g. the accumulator of another thread.  Only the counters are merged, everything
+    // else is computed from them in finalizeStats().  Returns 0 on success, 1 if the k-mer sketches have different
+    // parameters, nothing is merged then.
+    int merge(FastqStats const & other)
+    {
+        if (::merge(kmers, other.kmers) != 0)
+            return 1;
+        resizeToReadLength(other.maxLength);
+
+        for (unsigned i = 0; i < 5 * other.numColumns; ++i)
+            nucleotideCounts[i] += other.nucleotideCounts[i];
+
+        for (unsigned i = 0; i < other.numColumns; ++i)
+        {
+            __uint64 * histo = qualHistos.row(i);
+            __uint64 const * otherHisto = other.qualHistos.row(i);
+            for (unsigned q = 0; q < QualHistograms::NUM_QUALS; ++q)
+                histo[q] += otherHisto[q];
+        }
+
+        if (length(lengthCounts) < length(other.lengthCounts))
+            resize(lengthCounts, length(other.lengthCounts), 0);
+        for (unsigned i = 0; i < length(other.lengthCounts); ++i)
+            lengthCounts[i] += other.lengthCounts[i];
+        for (unsigned q = 0; q < QualHistograms::NUM_QUALS; ++q)
+            meanQualCounts[q] += other.meanQualCounts[q];
+        return 0;
+    }
+
+    // Compute statistics after updating for the last read.
+    void finalizeStats()
+    {
+        int const NUM_QUALS = QualHistograms::NUM_QUALS;
+
+        for (unsigned i = 0; i < numColumns; ++i)
+        {
+            __uint64 const * histo = qualHistos.row(i);
+
+            // Base counts from the nucleotide counts, score count, extrema, and sum from the histogram.
+            numBases[i] = 0;
+            for (unsigned c = 0; c < 5; ++c)
+                numBases[i] += nucleotideCounts[5 * i + c];
+            __uint64 n = 0;
+            sumScores[i] = 0;
+            minScores[i] = 0;
+            maxScores[i] = 0;
+            for (int q = NUM_QUALS - 1; q >= 0; --q)
+            {
+                if (!histo[q])
+                    continue;
+                if (!n)
+                    maxScores[i] = q;
+                minScores[i] = q;
+                n += histo[q];
+                sumScores[i] += (__int64)q * histo[q];
+            }
+            if (n == 0u)
+                continue;  // Skip if empty.
+
+            // Compute score mean.
+            meanScores[i] = (1.0 * sumScores[i]) / numBases[i];
+
+            // Compute score median and quartiles.
+            // TODO(holtgrew): Quartile/median computation not mathematically correct yet.
+            __uint64 firstQN = n / 4;
+            __uint64 medianN = n / 2;
+            __uint64 thirdQN = (3 * n) / 4;
+            __uint64 count = 0;  // Number of bases up to here.
+            for (int q = 0; q < NUM_QUALS; ++q)
+            {
+                if (!histo[q])
+                    continue;
+                if (count < firstQN && count + histo[q] >= firstQN)
+                    firstQuartiles[i] = q;
+                if (count < medianN && count + histo[q] >= medianN)
+                    medianScores[i] = q;
+                if (count < thirdQN && count + histo[q] >= thirdQN)
+                    thirdQuartiles[i] = q;
+                count += histo[q];
+            }
+            interQuartileRanges[i] = (thirdQuartiles[i] - firstQuartiles[i]);
+
+            // Compute whiskers as the data point that is still within 1.5 IQR of the lower quartile.
+            leftWhiskers[i] = firstQuartiles[i];
+            rightWhiskers[i] = thirdQuartiles[i];
+            double leftWhiskerBound = ((double)firstQuartiles[i]) - 1.5 * interQuartileRanges[i];
+            double rightWhiskerBound = ((double)thirdQuartiles[i]) + 1.5 * interQuartileRanges[i];
+            for (int q = 0; q < NUM_QUALS; ++q)
+                if (histo[q] && leftWhiskers[i] > q && q >= leftWhiskerBound)
+                    leftWhiskers[i] = q;
+            for (int q = 0; q < NUM_QUALS; ++q)
+                if (histo[q] && rightWhiskers[i] < q && q <= rightWhiskerBound)
+                    rightWhiskers[i] = q;
+        }
+    }
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function appendLines_()
+// ----------------------------------------------------------------------------
+
+// Append the characters of the lines in [it, end) to buffer, without line breaks.
+
+inline void appendLines_(std::string & buffer, char const * it, char const * end)
+{
+    while (it != end)
+    {
+        char const * next = nextLineBegin(it, end);
+        buffer.append(it, lineLength(it, next));
+        it = next;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function scanStatsChunk_()
+// ----------------------------------------------------------------------------
+
+// Register the FASTQ records starting in [it, chunkEnd) with stats.  The position behind the last one is written to
+// stop, this is the begin of the first record of the next chunk.  Returns 0 on success, 1 on invalid records, then
+// stop is the begin of the invalid record.
+
+inline int scanStatsChunk_(FastqStats & stats,
+                           char const * & stop,
+                           char const * it,
+                           char const * chunkEnd,
+                           char const * fileEnd)
+{
+    // Multi-line records are joined in these buffers, single-line records are registered in place.
+    std::string seqBuffer, qualBuffer;
+
+    while (it < chunkEnd && it != fileEnd)
+    {
+        __uint64 seqLength = 0;
+        char const * plusLine = 0;
+        char const * next = skipFastqRecord(seqLength, plusLine, it, fileEnd);
+        if (!next)
+        {
+            stop = it;
+            return 1;
+        }
+
+        char const * seq = nextLineBegin(it, fileEnd);
+        char const * quals = nextLineBegin(plusLine, fileEnd);
+        if (lineLength(seq, nextLineBegin(seq, plusLine)) != seqLength)
+        {
+            seqBuffer.clear();
+            appendLines_(seqBuffer, seq, plusLine);
+            seq = seqBuffer.data();
+        }
+        if (lineLength(quals, nextLineBegin(quals, next)) != seqLength)
+        {
+            qualBuffer.clear();
+            appendLines_(qualBuffer, quals, next);
+            quals = qualBuffer.data();
+        }
+        stats.registerRead(seq, quals, seqLength);
+
+        it = skipBlankLines(next, fileEnd);
+    }
+    stop = it;
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function computeStats()
+// ----------------------------------------------------------------------------
+
+// Register all records of the FASTQ file contents [fileBegin, fileEnd) with stats.  The contents are split into
+// chunks at record boundaries (see findRawRecordBegin()) and the chunks are scanned in parallel, each thread
+// registering into its own FastqStats.  The thread accumulators are merged into stats.  Returns 0 on success, 1 on
+// errors.
+
+inline int computeStats(FastqStats & stats, char const * fileBegin, char const * fileEnd, unsigned numThreads)
+{
+    numThreads = std::max(1u, numThreads);
+    __uint64 fileSize = fileEnd - fileBegin;
+
+    // Use a few chunks per thread for load balancing but do not make them too small.
+    __uint64 minChunkSize = 16 * 1024 * 1024;
+    __uint64 numChunks = numThreads * 4;
+    if (fileSize / numChunks < minChunkSize)
+        numChunks = std::max((__uint64)1u, fileSize / minChunkSize);
+
+    std::vector<FastqStats> threadStats(numThreads);
+    for (unsigned t = 0; t < numThreads; ++t)
+        threadStats[t].copyConfig(stats);
+    std::vector<char const *> chunkFirst(numChunks, (char const *)0);
+    std::vector<char const *> chunkStop(numChunks, (char const *)0);
+    std::vector<int> chunkRes(numChunks, 0);
+
+    SEQAN_OMP_PRAGMA(parallel for schedule(dynamic, 1) num_threads(numThreads))
+    for (int c = 0; c < (int)numChunks; ++c)
+    {
+        unsigned threadId = 0;
+#ifdef _OPENMP
+        threadId = omp_get_thread_num();
+#endif  // #ifdef _OPENMP
+        char const * chunkBegin = fileBegin + fileSize * c / numChunks;
+        char const * chunkEnd = fileBegin + fileSize * (c + 1) / numChunks;
+        if (c == 0)
+            chunkFirst[c] = skipBlankLines(fileBegin, fileEnd);
+        else
+            chunkFirst[c] = findRawRecordBegin(chunkBegin, fileBegin, fileEnd, RAW_FORMAT_FASTQ);
+        chunkRes[c] = scanStatsChunk_(threadStats[threadId], chunkStop[c], chunkFirst[c], chunkEnd, fileEnd);
+    }
+
+    // The scan of chunk c - 1 stops at the first record of chunk c.  If the resynchronization of chunk c was fooled
+    // (e.g. by a quality line starting with '@') then the thread accumulators cannot be fixed up and we fall back to
+    // a sequential scan.
+    bool resynced = true;
+    for (unsigned c = 1; c < numChunks; ++c)
+        resynced = resynced && (chunkRes[c - 1] != 0 || chunkFirst[c] == chunkStop[c - 1]);
+    if (!resynced)
+    {
+        char const * stop = 0;
+        return scanStatsChunk_(stats, stop, skipBlankLines(fileBegin, fileEnd), fileEnd, fileEnd);
+    }
+
+    for (unsigned c = 0; c < numChunks; ++c)
+        if (chunkRes[c] != 0)
+            return 1;
+    for (unsigned t = 0; t < numThreads; ++t)
+        if (stats.merge(threadStats[t]) != 0)
+            return 1;
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function sampleStats()
+// ----------------------------------------------------------------------------
+
+// Register the records of numBlocks blocks of blockSize bytes at random offsets of the FASTQ file at path with stats.
+// The blocks are read in parallel with pread() and resynchronized to their first record with findRawRecordBegin().
+// The record at the end of a block is usually incomplete and is not registered, neither are records that start in the
+// next block.  The fraction of the file's bytes covered by the registered records is written to fraction.  Returns 0
+// on success, 1 on errors.
+
+inline int sampleStats(FastqStats & stats,
+                       double & fraction,
+                       char const * path,
+                       __uint64 numBlocks,
+                       unsigned blockSize,
+                       __uint64 seed,
+                       unsigned numThreads)
+{
+    fraction = 0;
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return 1;
+    off_t fileSize = lseek(fd, 0, SEEK_END);
+    if (fileSize <= 0)
+    {
+        close(fd);
+        return fileSize < 0;
+    }
+
+    // Sorted block offsets, behind the last one is the file end.
+    FastRandom rng(seed);
+    std::vector<__uint64> offsets(numBlocks);
+    for (unsigned b = 0; b < numBlocks; ++b)
+        offsets[b] = nextRandom(rng) % (__uint64)fileSize;
+    std::sort(offsets.begin(), offsets.end());
+    offsets.push_back(fileSize);
+
+    numThreads = std::max(1u, numThreads);
+    std::vector<FastqStats> threadStats(numThreads);
+    for (unsigned t = 0; t < numThreads; ++t)
+        threadStats[t].copyConfig(stats);
+    std::vector<std::vector<char> > buffers(numThreads, std::vector<char>(blockSize + 1));
+    std::vector<__uint64> sampledBytes(numThreads, 0);
+
+    int res = 0;
+    SEQAN_OMP_PRAGMA(parallel for schedule(dynamic, 1) num_threads(numThreads) reduction(|:res))
+    for (int b = 0; b < (int)numBlocks; ++b)
+    {
+        unsigned threadId = 0;
+#ifdef _OPENMP
+        threadId = omp_get_thread_num();
+#endif  // #ifdef _OPENMP
+
+        // The character before the block is read as well, findRawRecordBegin() needs it for the line start check.
+        __uint64 readBegin = offsets[b] ? offsets[b] - 1 : 0;
+        __uint64 readLength = std::min((__uint64)blockSize + 1, (__uint64)fileSize - readBegin);
+        char * buffer = &buffers[threadId][0];
+        if (pread(fd, buffer, readLength, readBegin) != (ssize_t)readLength)
+        {
+            res |= 1;
+            continue;
+        }
+        char const * bufferEnd = buffer + readLength;
+        char const * blockEnd = buffer + std::min(offsets[b + 1] - readBegin, readLength);
+
+        char const * it = buffer + (offsets[b] - readBegin);
+        if (offsets[b] == 0u)
+            it = skipBlankLines(it, bufferEnd);
+        else
+            it = findRawRecordBegin(it, buffer, bufferEnd, RAW_FORMAT_FASTQ);
+        char const * stop = it;
+        scanStatsChunk_(threadStats[threadId], stop, it, blockEnd, bufferEnd);  // Fails on the incomplete record.
+        sampledBytes[threadId] += stop - it;
+    }
+    close(fd);
+    if (res != 0)
+        return 1;
+
+    __uint64 totalSampledBytes = 0;
+    for (unsigned t = 0; t < numThreads; ++t)
+    {
+        if (stats.merge(threadStats[t]) != 0)
+            return 1;
+        totalSampledBytes += sampledBytes[t];
+    }
+    fraction = (1.0 * totalSampledBytes) / fileSize;
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function scanStats()
+// ----------------------------------------------------------------------------
+
+// Register the records of the FASTQ file at path with the contents [fileBegin, fileEnd) with stats.  With numBlocks
+// > 0, only the records of numBlocks sampled blocks of blockSize > 0 bytes are registered as in sampleStats(), unless
+// the blocks would cover the whole file anyway.  The sampled fraction of the file is written to fraction.  Returns 0
+// on success, 1 on errors.
+
+inline int scanStats(FastqStats & stats,
+                     double & fraction,
+                     char const * path,
+                     char const * fileBegin,
+                     char const * fileEnd,
+                     __uint64 numBlocks,
+                     unsigned blockSize,
+                     __uint64 seed,
+                     unsigned numThreads)
+{
+    // Sample if the blocks cover less than the whole file, the full pass is exact and cheaper otherwise.  This is
+    // numBlocks * blockSize < fileSize without overflowing the product.
+    __uint64 fileSize = fileEnd - fileBegin;
+    fraction = 1;
+    if (numBlocks > 0u && numBlocks < (fileSize + blockSize - 1) / blockSize)
+        return sampleStats(stats, fraction, path, numBlocks, blockSize, seed, numThreads);
+    return computeStats(stats, fileBegin, fileEnd, numThreads);
+}
+
+// ----------------------------------------------------------------------------
+// Function writeKmerSketch_(), readKmerSketch_()
+// ----------------------------------------------------------------------------
+
+// The k-mer sketch part of the snapshots, see saveSnapshot().
+
+inline void writeKmerSketch_(std::ostream & out, KmerSketch const & sketch)
+{
+    writeVarUInt_(out, sketch.k);
+    if (sketch.k == 0u)
+        return;
+    writeVarUInt_(out, sketch.counts.numLines);
+    writeVarUInt_(out, sketch.top.capacity);
+    writeVarUInt_(out, sketch.numKmers);
+    writeVarUInt_(out, sketch.numReads);
+    __uint32 const * counters = &sketch.counts.store[sketch.counts.offset];
+    for (size_t i = 0; i < (size_t)sketch.counts.numLines * CountMinSketch::LINE_SIZE; ++i)
+        writeVarUInt_(out, counters[i]);
+    writeVarUInt_(out, sketch.top.entries.size());
+    for (size_t i = 0; i < sketch.top.entries.size(); ++i)
+        writeVarUInt_(out, sketch.top.entries[i].first);
+    out.write(reinterpret_cast<char const *>(&sketch.distinctReads.registers[0]), sketch.distinctReads.registers.size());
+}
+
+inline bool readKmerSketch_(KmerSketch & sketch, std::istream & in)
+{
+    __uint64 k = 0, numLines = 0, capacity = 0;
+    if (!readVarUInt_(k, in) || k > 31u)
+        return false;
+    if (k == 0u)
+    {
+        init(sketch, 0, 0, 0);
+        return true;
+    }
+    if (!readVarUInt_(numLines, in) || !readVarUInt_(capacity, in))
+        return false;
+    unsigned lineBits = 0;
+    while (lineBits < 31u && ((__uint64)1 << lineBits) < numLines)
+        ++lineBits;
+    if (((__uint64)1 << lineBits) != numLines)
+        return false;
+    init(sketch, k, lineBits, capacity);
+
+    if (!readVarUInt_(sketch.numKmers, in) || !readVarUInt_(sketch.numReads, in))
+        return false;
+    __uint32 * counters = &sketch.counts.store[sketch.counts.offset];
+    __uint64 x = 0;
+    for (size_t i = 0; i < (size_t)sketch.counts.numLines * CountMinSketch::LINE_SIZE; ++i)
+    {
+        if (!readVarUInt_(x, in))
+            return false;
+        counters[i] = x;
+    }
+    __uint64 numTop = 0;
+    if (!readVarUInt_(numTop, in) || numTop > capacity)
+        return false;
+    for (unsigned i = 0; i < numTop; ++i)
+    {
+        if (!readVarUInt_(x, in))
+            return false;
+        update(sketch.top, x, estimate(sketch.counts, mixHash64(x)));
+    }
+    std::vector<unsigned char> & registers = sketch.distinctReads.registers;
+    return (bool)in.read(reinterpret_cast<char *>(&registers[0]), registers.size());
+}
+
+// ----------------------------------------------------------------------------
+// Function saveSnapshot()
+// ----------------------------------------------------------------------------
+
+// Snapshots contain the raw counts of a FastqStats such that the statistics of several shards can be merged without
+// rereading them.  The file format is binary:
+//
+//   char[8]   magic "FXQCS\0\0\2", the last byte is the version
+//   varuint   exact length, bin mode, bin width
+//   varuint   maximal read length, number of columns n
+//   varuint   n * 5 nucleotide counts, by column
+//   varuint   n * 94 quality counts, by column
+//   varuint   number of read length bins m, m read length counts
+//   varuint   94 mean quality counts
+//   varuint   k-mer length k, the rest is only present for k > 0
+//   varuint   number of count sketch lines l, top k-mer capacity, number of k-mers, number of reads
+//   varuint   l * 16 count sketch counters
+//   varuint   number of top k-mers t, t top k-mers
+//   char[]    2^14 HyperLogLog registers
+//
+// Version 1 files end after the mean quality counts and are loaded without k-mer sketch.  Most quality counts and
+// counters are zero and take one byte.  Returns 0 on success, 1 on errors.
+
+inline int saveSnapshot(FastqStats const & stats, char const * path)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::out);
+    if (!out.good())
+        return 1;
+
+    char const MAGIC[8] = {'F', 'X', 'Q', 'C', 'S', '\0', '\0', '\2'};
+    out.write(MAGIC, 8);
+    writeVarUInt_(out, stats.binning.exactLength);
+    writeVarUInt_(out, stats.binning.mode);
+    writeVarUInt_(out, stats.binning.binWidth);
+    writeVarUInt_(out, stats.maxLength);
+    writeVarUInt_(out, stats.numColumns);
+    for (unsigned i = 0; i < 5 * stats.numColumns; ++i)
+        writeVarUInt_(out, stats.nucleotideCounts[i]);
+    for (unsigned i = 0; i < stats.numColumns; ++i)
+        for (unsigned q = 0; q < QualHistograms::NUM_QUALS; ++q)
+            writeVarUInt_(out, stats.qualHistos.row(i)[q]);
+    writeVarUInt_(out, length(stats.lengthCounts));
+    for (unsigned i = 0; i < length(stats.lengthCounts); ++i)
+        writeVarUInt_(out, stats.lengthCounts[i]);
+    for (unsigned q = 0; q < QualHistograms::NUM_QUALS; ++q)
+        writeVarUInt_(out, stats.meanQualCounts[q]);
+    writeKmerSketch_(out, stats.kmers);
+
+    return !out.good();
+}
+
+// ----------------------------------------------------------------------------
+// Function loadSnapshot()
+// ----------------------------------------------------------------------------
+
+// Load the counts of the snapshot at path into the empty stats, including the binning.  Returns 0 on success, 1 on
+// errors.
+
+inline int loadSnapshot(FastqStats & stats, char const * path)
+{
+    std::ifstream in(path, std::ios::binary | std::ios::in);
+    if (!in.good())
+        return 1;
+
+    char const MAGIC[7] = {'F', 'X', 'Q', 'C', 'S', '\0', '\0'};
+    char magic[8];
+    if (!in.read(magic, 8) || memcmp(magic, MAGIC, 7) != 0 || (magic[7] != '\1' && magic[7] != '\2'))
+        return 1;
+
+    __uint64 exactLength = 0, mode = 0, binWidth = 0, maxLength = 0, numColumns = 0;
+    if (!readVarUInt_(exactLength, in) || !readVarUInt_(mode, in) || !readVarUInt_(binWidth, in) ||
+        !readVarUInt_(maxLength, in) || !readVarUInt_(numColumns, in))
+        return 1;
+    if ((mode != BIN_FIXED && mode != BIN_LOG) || binWidth == 0u)
+        return 1;
+    stats.binning.exactLength = exactLength;
+    stats.binning.mode = static_cast<PositionBinMode>(mode);
+    stats.binning.binWidth = binWidth;
+    stats.resizeToReadLength(maxLength);
+    if (stats.numColumns != numColumns)
+        return 1;
+
+    __uint64 x = 0;
+    for (unsigned i = 0; i < 5 * stats.numColumns; ++i)
+    {
+        if (!readVarUInt_(x, in))
+            return 1;
+        stats.nucleotideCounts[i] = x;
+    }
+    for (unsigned i = 0; i < stats.numColumns; ++i)
+        for (unsigned q = 0; q < QualHistograms::NUM_QUALS; ++q)
+            if (!readVarUInt_(stats.qualHistos.row(i)[q], in))
+                return 1;
+    if (!readVarUInt_(x, in))
+        return 1;
+    resize(stats.lengthCounts, x, 0);
+    for (unsigned i = 0; i < length(stats.lengthCounts); ++i)
+    {
+        if (!readVarUInt_(x, in))
+            return 1;
+        stats.lengthCounts[i] = x;
+    }
+    for (unsigned q = 0; q < QualHistograms::NUM_QUALS; ++q)
+    {
+        if (!readVarUInt_(x, in))
+            return 1;
+        stats.meanQualCounts[q] = x;
+    }
+    if (magic[7] == '\2' && !readKmerSketch_(stats.kmers, in))
+        return 1;
+
+    return 0;
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_FASTQ_STATS_H_
@@ -46,6 +46,8 @@
 // TODO(holtgrew): This should go from rabema app into core...
 #include "../../../../core/apps/rabema/fai_index.h"
 
+#include "composition_index.h"
+
 // --------------------------------------------------------------------------
 // Class FxFaidxOptions
 // --------------------------------------------------------------------------
@@ -67,7 +69,16 @@ struct FxFaidxOptions
     // List of regions to retrieve.
     seqan::String<seqan::CharString> regions;
 
-    FxFaidxOptions() : verbosity(1)
+    // Whether or not to write the composition of the regions instead of their sequence.
+    bool composition;
+
+    // Path to composition index file.
+    seqan::CharString inCmpPath;
+
+    // Sample rate of the composition index when building it.
+    unsigned compositionSampleRate;
+
+    FxFaidxOptions() : verbosity(1), composition(false), compositionSampleRate(1024)
     {}
 };
 
@@ -100,6 +111,11 @@ parseArgs(FxFaidxOptions & options,
     addOption(parser, seqan::ArgParseOption("i", "index-file", "Path to the .fai index file.  Defaults to FASTA.fai", seqan::ArgParseArgument::STRING, false, "FASTA"));
     addOption(parser, seqan::ArgParseOption("o", "out-file", "Path to the resulting file.  If omitted, result is printed to stdout.", seqan::ArgParseArgument::STRING, false, "FASTA"));
 
+    addSection(parser, "Composition");
+    addOption(parser, seqan::ArgParseOption("c", "composition", "Write the A, C, G, T, N counts and the C+G content of each region as TSV instead of its sequence.  Uses the composition index which is built if necessary."));
+    addOption(parser, seqan::ArgParseOption("ci", "composition-index-file", "Path to the composition index file.  Defaults to FASTA.cmp", seqan::ArgParseArgument::STRING, false, "CMP"));
+    addOption(parser, seqan::ArgParseOption("cs", "composition-sample-rate", "Store prefix counts every \\fINUM\\fP characters when building the composition index.  Default: 1024.", seqan::ArgParseArgument::INTEGER, false, "NUM"));
+
     addSection(parser, "Regions");
     addOption(parser, seqan::ArgParseOption("r", "region", "Region to retrieve from FASTA file.  You can specify multiple regions with multiple \\fB-r\\fP \\fIREGION\\fP.  Note that regions are one-based, see below for detailed information about the format.", seqan::ArgParseArgument::STRING, true, "REGION"));
 
@@ -117,6 +133,7 @@ parseArgs(FxFaidxOptions & options,
     addListItem(parser, "\\fBfx_faidx\\fP \\fB-f\\fP \\fIREF.fa\\fP \\fB-r\\fP \\fIchr1\\fP", "Retrieve sequence named \"chr1\" from file \\fIREF.fa\\fP using the index with the default name \\fIREF.fa.fai\\fP.  The index file name is created if it does not exist.");
     addListItem(parser, "\\fBfx_faidx\\fP \\fB-f\\fP \\fIREF.fa\\fP \\fB-r\\fP \\fIchr1:100-1100\\fP", "Retrieve characters 100 to 1,100 from the sequence named \"chr1\" from file \\fIREF.fa\\fP using the index with the default name \\fIREF.fa.fai\\fP.");
     addListItem(parser, "\\fBfx_faidx\\fP \\fB-f\\fP \\fIREF.fa\\fP \\fB-r\\fP \\fIchr1:100-1100\\fP \\fB-r\\fP \\fIchr2:2,000\\fP", "Retrieve characters 100-1,000 from \"chr1\" and all characters from 2,000 of \"chr2\".");
+    addListItem(parser, "\\fBfx_faidx\\fP \\fB-f\\fP \\fIREF.fa\\fP \\fB-c\\fP \\fB-r\\fP \\fIchr1:100-1100\\fP", "Write the composition of characters 100 to 1,100 of \"chr1\", using the composition index with the default name \\fIREF.fa.cmp\\fP.");
     
     seqan::ArgumentParser::ParseResult res = parse(parser, argc, argv);
 
@@ -134,6 +151,20 @@ parseArgs(FxFaidxOptions & options,
         if (isSet(parser, "region"))
             options.regions = getOptionValues(parser, "region");
 
+        options.composition = isSet(parser, "composition");
+        // Set default composition index file name, get from parser if set.
+        options.inCmpPath = options.inFastaPath;
+        append(options.inCmpPath, ".cmp");
+        if (isSet(parser, "composition-index-file"))
+            getOptionValue(options.inCmpPath, parser, "composition-index-file");
+        if (isSet(parser, "composition-sample-rate"))
+            getOptionValue(options.compositionSampleRate, parser, "composition-sample-rate");
+        if (options.compositionSampleRate == 0u)
+        {
+            std::cerr << "ERROR: The composition sample rate must be positive.\n";
+            return seqan::ArgumentParser::PARSE_ERROR;
+        }
+
         if (isSet(parser, "out-file"))
             getOptionValue(options.outFastaPath, parser, "out-file");
 
@@ -270,6 +301,31 @@ int main(int argc, char const ** argv)
     if (options.verbosity >= 3)
         std::cerr << "Took " << (startTime - sysTime()) << " s\n";
 
+    // Load composition index if requested, create if necessary.
+    CompositionIndex cmpIndex;
+    if (options.composition)
+    {
+        startTime = sysTime();
+        if (load(cmpIndex, toCString(options.inCmpPath)) != 0 ||
+            !isCompatible(cmpIndex, faiIndex, options.compositionSampleRate))
+        {
+            if (options.verbosity >= 2)
+                std::cerr << "Building Composition Index " << options.inCmpPath << " ...";
+            if (build(cmpIndex, faiIndex, options.compositionSampleRate) != 0)
+            {
+                std::cerr << "Could not build composition index for FASTA file " << options.inFastaPath << "\n";
+                return 1;
+            }
+            if (save(cmpIndex, toCString(options.inCmpPath)) != 0)
+            {
+                std::cerr << "Could not write composition index to " << options.inCmpPath << "\n";
+                return 1;
+            }
+        }
+        if (options.verbosity >= 3)
+            std::cerr << "Took " << (sysTime() - startTime) << " s\n";
+    }
+
     // ---------------------------------------------------------------------------
     // Parse and Fetch Regions.
     // ---------------------------------------------------------------------------
@@ -313,8 +369,12 @@ int main(int argc, char const ** argv)
             std::cerr << "Could not open output file " << options.outFastaPath << "\n";
             return 1;
         }
+        outPtr = &outF;
     }
 
+    if (options.composition)
+        *outPtr << "#REGION\tLENGTH\tA\tC\tG\tT\tN\tCG_CONTENT\n";
+
     // Retrieve output infixes and write to result.
     for (unsigned i = 0; i < length(regions); ++i)
     {
@@ -328,7 +388,23 @@ int main(int argc, char const ** argv)
         if (region.endPos > 0 && (unsigned)region.endPos < endPos)
             endPos = region.endPos;
         if (beginPos > endPos)
-            endPos = beginPos;
+            beginPos = endPos;  // Empty region, clamped to the sequence end if it starts behind it.
+
+        if (options.composition)
+        {
+            CompositionCounts counts;
+            if (getComposition(counts, cmpIndex, faiIndex, region.seqId, beginPos, endPos) != 0)
+            {
+                std::cerr << "Could not compute composition for region " << options.regions[i] << "\n";
+                return 1;
+            }
+            *outPtr << id << '\t' << (endPos - beginPos);
+            for (unsigned c = 0; c < 5; ++c)
+                *outPtr << '\t' << counts.counts[c];
+            *outPtr << '\t' << cgContent(counts) << '\n';
+            continue;
+        }
+
         getSequenceInfix(seq, faiIndex, region.seqId, beginPos, endPos);
         if (writeRecord(*outPtr, id, seq, seqan::Fasta()) != 0)
         {
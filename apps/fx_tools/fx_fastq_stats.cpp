@@ -32,13 +32,24 @@
 // Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
 // ==========================================================================
 
-#include <map>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif  // #ifdef _OPENMP
 
 #include <seqan/arg_parse.h>
 #include <seqan/basic.h>
-#include <seqan/seq_io.h>
+#include <seqan/file.h>
 #include <seqan/sequence.h>
 
+#include "fastq_stats.h"
+#include "kmer_sketch.h"
+#include "record_index.h"
+#include "record_scanner.h"
+
 // ==========================================================================
 // Classes
 // ==========================================================================
@@ -62,170 +73,202 @@ struct AppOptions
     // The out file name is an out file.
     seqan::CharString outFilename;
 
+    // Path to the optional snapshot of the raw counts.
+    seqan::CharString snapshotFilename;
+    // Snapshots to merge instead of reading inFilename.
+    seqan::String<seqan::CharString> mergeFilenames;
+
+    // Paths to the optional read length and mean quality distributions.
+    seqan::CharString lengthsFilename;
+    seqan::CharString meanQualsFilename;
+
+    // Mapping of read positions to output columns.
+    PositionBinning binning;
+
+    // Path to the optional report of overrepresented k-mers and duplicates.
+    seqan::CharString kmersFilename;
+    // Length of the counted k-mers, 0 to disable, and number of reported k-mers.
+    unsigned kmerLength;
+    unsigned topKmers;
+    // The k-mer count sketch has 2^sketchBits lines of 64 bytes.
+    unsigned sketchBits;
+
+    // Number of blocks to sample and their size in bytes, 0 blocks to read the whole file.
+    __uint64 sampleBlocks;
+    unsigned sampleBlockSize;
+    // Seed for choosing the sampled blocks.
+    __uint64 seed;
+
+    // Number of threads to use for scanning the input.
+    unsigned numThreads;
+
     AppOptions() :
-        verbosity(1)
-    {}
+        verbosity(1), kmerLength(16), topKmers(50), sketchBits(16), sampleBlocks(0), sampleBlockSize(256 * 1024), seed(0), numThreads(1)
+    {
+#ifdef _OPENMP
+        numThreads = omp_get_max_threads();
+#endif  // #ifdef _OPENMP
+    }
 };
 
+// ==========================================================================
+// Functions
+// ==========================================================================
+
+// --------------------------------------------------------------------------
+// Function mergeSnapshots()
+// --------------------------------------------------------------------------
+
+// Merge the snapshots from options into stats.  All snapshots must use the same binning, stats gets the binning of
+// the first one.  The same holds for the k-mer sketches, snapshots without one are ignored for the k-mer report.
+// Returns 0 on success, 1 on errors.
+
+int mergeSnapshots(FastqStats & stats, AppOptions const & options)
+{
+    for (unsigned i = 0; i < length(options.mergeFilenames); ++i)
+    {
+        FastqStats snapshot;
+        if (loadSnapshot(snapshot, toCString(options.mergeFilenames[i])) != 0)
+        {
+            std::cerr << "ERROR: Could not load snapshot " << options.mergeFilenames[i] << ".\n";
+            return 1;
+        }
+        if (i == 0u)
+            stats.binning = snapshot.binning;
+        if (snapshot.binning.exactLength != stats.binning.exactLength || snapshot.binning.mode != stats.binning.mode ||
+            snapshot.binning.binWidth != stats.binning.binWidth)
+        {
+            std::cerr << "ERROR: Snapshot " << options.mergeFilenames[i] << " uses a different position binning than "
+                      << options.mergeFilenames[0] << ".\n";
+            return 1;
+        }
+        if (stats.merge(snapshot) != 0)
+        {
+            std::cerr << "ERROR: Snapshot " << options.mergeFilenames[i] << " uses different k-mer sketch parameters "
+                      << "than the snapshots before it.\n";
+            return 1;
+        }
+    }
+    return 0;
+}
+
 // --------------------------------------------------------------------------
-// Class FastqStats
+// Function scanInput()
 // --------------------------------------------------------------------------
 
-struct FastqStats
+// Register the reads of the input file from options with stats, or of a sample of it.  The sampled fraction of the
+// file is written to fraction.  Returns 0 on success, 1 on errors.
+
+int scanInput(FastqStats & stats, double & fraction, AppOptions const & options)
 {
-    // -----------------------------------------------------------------------
-    // Members with Results
-    // -----------------------------------------------------------------------
-
-    unsigned maxLength;
-    
-    // Number of bases in column i.
-    seqan::String<__int64> numBases;
-    // Smallest score in column i.
-    seqan::String<__int32> minScores;
-    // Largest score in column i.
-    seqan::String<__int32> maxScores;
-    // Sum of scores in column i.
-    seqan::String<__int64> sumScores;
-    // Mean of scores in column i.
-    seqan::String<double> meanScores;
-    // First quartile quality score (Q1) for column i.
-    seqan::String<double> firstQuartiles;
-    // Median quality score for column i.
-    seqan::String<double> medianScores;
-    // Third quartile quality score (Q3) for column i.
-    seqan::String<double> thirdQuartiles;
-    // Inter-quartile range  (Q3-Q1) for column i.
-    seqan::String<double> interQuartileRanges;
-    // Left-whisker value for boxplotting for column i.
-    seqan::String<__int32> leftWhiskers;
-    // Right-whisker value for boxplotting for column i.
-    seqan::String<__int32> rightWhiskers;
-    // Number of nucleotides A, C, G, T, N for column i.
-    seqan::String<seqan::String<__int64> > nucleotideCounts;
-
-    // -----------------------------------------------------------------------
-    // Histogram Members
-    // -----------------------------------------------------------------------
-
-    // Quality histogram.
-    seqan::String<std::map<__int32, __int32> > qualHistos;
-
-    // -----------------------------------------------------------------------
-    // Constructor
-    // -----------------------------------------------------------------------
-
-    FastqStats() : maxLength(0)
-    {}
-
-    // -----------------------------------------------------------------------
-    // Member Functions
-    // -----------------------------------------------------------------------
-
-    // Resize members to read of length.
-    void resizeToReadLength(unsigned n)
+    // Open input file, it is memory mapped such that it can be split into chunks for parallel scanning.
+    seqan::String<char, seqan::MMap<> > inString;
+    if (!open(inString, toCString(options.inFilename), seqan::OPEN_RDONLY))
     {
-        if (maxLength == n)
-            return;
-        maxLength = n;
-
-        resize(numBases, n, 0);
-        resize(minScores, n, 0);
-        resize(maxScores, n, 0);
-        resize(sumScores, n, 0);
-        resize(meanScores, n, 0);
-        resize(firstQuartiles, n, 0);
-        resize(medianScores, n, 0);
-        resize(thirdQuartiles, n, 0);
-        resize(interQuartileRanges, n, 0);
-        resize(leftWhiskers, n, 0);
-        resize(rightWhiskers, n, 0);
-        resize(nucleotideCounts, n);
-        for (unsigned i = 0; i < n; ++i)
-            resize(nucleotideCounts[i], 5, 0);
-
-        resize(qualHistos, n);
+        std::cerr << "ERROR: Could not open file " << options.inFilename << " for reading.\n";
+        return 1;
+    }
+    char const * fileBegin = begin(inString, seqan::Standard());
+    char const * fileEnd = end(inString, seqan::Standard());
+    if (guessRawFormat(fileBegin, fileEnd) != RAW_FORMAT_FASTQ && skipBlankLines(fileBegin, fileEnd) != fileEnd)
+    {
+        std::cerr << "ERROR: File " << options.inFilename << " is not a FASTQ file.\n";
+        return 1;
     }
 
-    // Update histogram and statistics for the given read.
-    void registerRead(seqan::Dna5String const & seq, seqan::CharString const & quals)
+    stats.binning = options.binning;
+    init(stats.kmers, options.kmerLength, options.sketchBits, options.topKmers);
+    if (scanStats(stats, fraction, toCString(options.inFilename), fileBegin, fileEnd, options.sampleBlocks,
+                  options.sampleBlockSize, options.seed, options.numThreads) != 0)
     {
-        resizeToReadLength(length(seq));
+        std::cerr << "ERROR: Could not read from " << options.inFilename << ".\n";
+        return 1;
+    }
+    return 0;
+}
 
-        // Update nucleotide counts.
-        for (unsigned i = 0; i < length(seq); ++i)
-        {
-            numBases[i] += 1;
-            nucleotideCounts[i][ordValue(seq[i])] += 1;
-        }
+// --------------------------------------------------------------------------
+// Function writeReadDistributions()
+// --------------------------------------------------------------------------
+
+// Write the read length and mean quality distributions to the paths from options, if any.  The read lengths are
+// given by the first length of their bin.  Returns 0 on success, 1 on errors.
 
-        // Update quality histograms and statistics.
-        for (unsigned i = 0; i < length(quals); ++i)
+int writeReadDistributions(AppOptions const & options, FastqStats const & stats)
+{
+    if (!empty(options.lengthsFilename))
+    {
+        std::ofstream out(toCString(options.lengthsFilename), std::ios::binary | std::ios::out);
+        if (!out.good())
         {
-            int qual = quals[i] - '!';  // PHRED scores.
-            if (numBases[i] == 0u || minScores[i] > qual)
-                minScores[i] = qual;
-            if (numBases[i] == 0u || maxScores[i] < qual)
-                maxScores[i] = qual;
-            qualHistos[i][qual] += 1;
-            sumScores[i] += qual;
+            std::cerr << "ERROR: Could not open file " << options.lengthsFilename << " for writing.\n";
+            return 1;
         }
+        out << "#length\tcount\n";
+        for (unsigned i = 0; i < length(stats.lengthCounts); ++i)
+            if (stats.lengthCounts[i])
+                out << stats.binning.columnBegin(i) << "\t" << stats.lengthCounts[i] << "\n";
     }
 
-    // Compute statistics after updating for the last read.
-    void finalizeStats()
+    if (!empty(options.meanQualsFilename))
     {
-        // Compute score means.
-        for (unsigned i = 0; i < length(meanScores); ++i)
-            meanScores[i] = (1.0 * sumScores[i]) / numBases[i];
-        // Compute score medians and quartiles.
-        for (unsigned i = 0; i < length(qualHistos); ++i)
+        std::ofstream out(toCString(options.meanQualsFilename), std::ios::binary | std::ios::out);
+        if (!out.good())
         {
-            if (qualHistos[i].size() == 0u)
-                continue;  // Skip if empty.
-
-            // TODO(holtgrew): Quartile/median computation not mathematically correct yet.
-            unsigned n = numBases[i];  // Number of bases.
-            unsigned firstQN = n / 4;
-            unsigned medianN = n / 2;
-            unsigned thirdQN = (3 * n) / 4;
-            unsigned count = 0;  // Number of bases up to here.
-            for (std::map<__int32, __int32>::const_iterator it = qualHistos[i].begin(); it != qualHistos[i].end(); ++it)
-            {
-                if (count < firstQN && count + it->second >= firstQN)
-                    firstQuartiles[i] = it->first;
-                if (count < medianN && count + it->second >= medianN)
-                    medianScores[i] = it->first;
-                if (count < thirdQN && count + it->second >= thirdQN)
-                    thirdQuartiles[i] = it->first;
-
-                count += it->second;
-            }
-            interQuartileRanges[i] = (thirdQuartiles[i] - firstQuartiles[i]);
+            std::cerr << "ERROR: Could not open file " << options.meanQualsFilename << " for writing.\n";
+            return 1;
         }
+        out << "#mean_qual\tcount\n";
+        for (unsigned q = 0; q < length(stats.meanQualCounts); ++q)
+            if (stats.meanQualCounts[q])
+                out << q << "\t" << stats.meanQualCounts[q] << "\n";
+    }
 
-        // Compute whiskers as the data point that is still within 1.5 IQR of the lower quartile.
-        for (unsigned i = 0; i < length(qualHistos); ++i)
-        {
-            if (qualHistos[i].size() == 0u)
-                continue;  // Skip if empty.
-            leftWhiskers[i] = firstQuartiles[i];
-            rightWhiskers[i] = thirdQuartiles[i];
-            double leftWhiskerBound = ((double)firstQuartiles[i]) - 1.5 * interQuartileRanges[i];
-            double rightWhiskerBound = ((double)thirdQuartiles[i]) + 1.5 * interQuartileRanges[i];
-            for (std::map<__int32, __int32>::const_iterator it = qualHistos[i].begin(); it != qualHistos[i].end(); ++it)
-                if (leftWhiskers[i] > it->first && it->first >= leftWhiskerBound)
-                    leftWhiskers[i] = it->first;
-            for (std::map<__int32, __int32>::const_iterator it = qualHistos[i].begin(); it != qualHistos[i].end(); ++it)
-                if (rightWhiskers[i] < it->first && it->first <= rightWhiskerBound)
-                    rightWhiskers[i] = it->first;
-        }
+    return 0;
+}
+
+// --------------------------------------------------------------------------
+// Function writeKmerReport()
+// --------------------------------------------------------------------------
+
+// Write the estimated number of distinct reads and the k-mers with the largest estimated counts to the path from
+// options, if any.  Returns 0 on success, 1 on errors.
+
+int writeKmerReport(AppOptions const & options, FastqStats const & stats)
+{
+    if (empty(options.kmersFilename))
+        return 0;
+    if (stats.kmers.k == 0u)
+    {
+        std::cerr << "ERROR: No k-mers were counted for " << options.kmersFilename << ".\n";
+        return 1;
     }
-};
 
-// ==========================================================================
-// Functions
-// ==========================================================================
+    std::ofstream out(toCString(options.kmersFilename), std::ios::binary | std::ios::out);
+    if (!out.good())
+    {
+        std::cerr << "ERROR: Could not open file " << options.kmersFilename << " for writing.\n";
+        return 1;
+    }
+
+    KmerSketch const & sketch = stats.kmers;
+    double distinctReads = std::min((double)sketch.numReads, cardinality(sketch.distinctReads));
+    out << "#reads\t" << sketch.numReads << "\n"
+        << "#distinct_reads\t" << (__uint64)(distinctReads + 0.5) << "\n"
+        << "#duplicate_fraction\t" << (sketch.numReads ? 1 - distinctReads / sketch.numReads : 0.0) << "\n"
+        << "#kmer\tcount\tfraction\n";
+
+    std::vector<std::pair<__uint64, __uint64> > top;
+    topKmers(top, sketch);
+    seqan::CharString kmer;
+    for (size_t i = 0; i < top.size(); ++i)
+    {
+        kmerToString(kmer, top[i].first, sketch.k);
+        out << kmer << "\t" << top[i].second << "\t" << (1.0 * top[i].second) / sketch.numKmers << "\n";
+    }
+
+    return !out.good();
+}
 
 // --------------------------------------------------------------------------
 // Function parseCommandLine()
@@ -243,17 +286,55 @@ parseCommandLine(AppOptions & options, int argc, char const ** argv)
     setDate(parser, "August 2012");
 
     // Define usage line and long description.
-    addUsageLine(parser, "\\fB-i\\fP \\fIINPUT.fq\\fP \\fB-o\\fP \\fIOUTPUT.tsv\\fP");
+    addUsageLine(parser, "\\fB-i\\fP \\fIINPUT.fq\\fP \\fB-o\\fP \\fIOUTPUT.tsv\\fP [\\fB-s\\fP \\fISNAPSHOT\\fP]");
+    addUsageLine(parser, "\\fB-m\\fP \\fISNAPSHOT\\fP [\\fB-m\\fP \\fISNAPSHOT\\fP ...] \\fB-o\\fP \\fIOUTPUT.tsv\\fP");
+    addDescription(parser,
+                   "Read a FASTQ file.  Writes out a TSV file with one record for each column/position with statistics "
+                   "on the nucleotides and qualities.");
     addDescription(parser,
-                   "Read a FASTQ file with reads sequences of the same length.  Writes out a TSV file with one record for "
-                   "each column/position with statistics on the nucleotides and qualities.");
+                   "Reads can have different lengths.  Positions behind \\fB--exact-length\\fP are combined into bins "
+                   "such that long reads use a bounded number of columns, the first column of a record is the first "
+                   "position of its bin.");
 
     addSection(parser, "Input / Output");
     addOption(parser, seqan::ArgParseOption("i", "input", "Input FASTQ file.", seqan::ArgParseOption::INPUTFILE, "INPUT"));
     setValidValues(parser, "input", "fastq fq");
-    setRequired(parser, "input");
+    addOption(parser, seqan::ArgParseOption("m", "merge", "Merge the snapshot \\fISNAPSHOT\\fP written with \\fB--snapshot\\fP instead of reading \\fB--input\\fP.  Can be given multiple times, all snapshots must use the same position binning.", seqan::ArgParseOption::INPUTFILE, true, "SNAPSHOT"));
     addOption(parser, seqan::ArgParseOption("o", "output", "Output TSV file.", seqan::ArgParseOption::OUTPUTFILE, "OUTPUT"));
     setRequired(parser, "output");
+    addOption(parser, seqan::ArgParseOption("ol", "output-lengths", "Output TSV file with the read length distribution.", seqan::ArgParseOption::OUTPUTFILE, "OUTPUT"));
+    addOption(parser, seqan::ArgParseOption("oq", "output-mean-quals", "Output TSV file with the distribution of the reads' rounded mean qualities.", seqan::ArgParseOption::OUTPUTFILE, "OUTPUT"));
+    addOption(parser, seqan::ArgParseOption("s", "snapshot", "Also write the raw counts to the binary snapshot \\fISNAPSHOT\\fP for merging with \\fB--merge\\fP.", seqan::ArgParseOption::OUTPUTFILE, "SNAPSHOT"));
+
+    addOption(parser, seqan::ArgParseOption("ok", "output-kmers", "Output TSV file with the estimated duplicate fraction of the reads and the most frequent k-mers, e.g. of adapters or other contaminations.", seqan::ArgParseOption::OUTPUTFILE, "OUTPUT"));
+
+    addSection(parser, "K-mer Sketch");
+    addOption(parser, seqan::ArgParseOption("k", "kmer-length", "Length of the counted k-mers, 0 to disable counting k-mers and duplicates.  Default: 16.", seqan::ArgParseArgument::INTEGER, false, "LEN"));
+    setMinValue(parser, "kmer-length", "0");
+    setMaxValue(parser, "kmer-length", "31");
+    addOption(parser, seqan::ArgParseOption("tk", "top-kmers", "Number of most frequent k-mers to report.  Default: 50.", seqan::ArgParseArgument::INTEGER, false, "NUM"));
+    setMinValue(parser, "top-kmers", "1");
+    addOption(parser, seqan::ArgParseOption("sk", "sketch-bits", "The k-mer count sketch has 2^\\fIBITS\\fP lines of 64 bytes per thread.  Default: 16 (4 MiB).", seqan::ArgParseArgument::INTEGER, false, "BITS"));
+    setMinValue(parser, "sketch-bits", "4");
+    setMaxValue(parser, "sketch-bits", "26");
+
+    addSection(parser, "Position Binning");
+    addOption(parser, seqan::ArgParseOption("el", "exact-length", "Positions below this get a column each, later ones are binned.  Default: 1000.", seqan::ArgParseArgument::INTEGER, false, "LEN"));
+    setMinValue(parser, "exact-length", "0");
+    addOption(parser, seqan::ArgParseOption("bm", "bin-mode", "Bin positions behind the exact length into bins of fixed width or into bins whose widths double.  Default: log.", seqan::ArgParseArgument::STRING, false, "MODE"));
+    setValidValues(parser, "bin-mode", "fixed log");
+    addOption(parser, seqan::ArgParseOption("bw", "bin-width", "Width of all (fixed) or of the first (log) bin.  Default: 100.", seqan::ArgParseArgument::INTEGER, false, "LEN"));
+    setMinValue(parser, "bin-width", "1");
+
+    addSection(parser, "Sampling");
+    addOption(parser, seqan::ArgParseOption("sb", "sample-blocks", "Approximate the statistics from \\fINUM\\fP blocks at random offsets of the input instead of reading all of it.  The fraction of the input covered by the sampled records is written as the first line of the output.  Default: 0 (read everything).", seqan::ArgParseArgument::INTEGER, false, "NUM"));
+    setMinValue(parser, "sample-blocks", "0");
+    addOption(parser, seqan::ArgParseOption("sbs", "sample-block-size", "Size of the sampled blocks in bytes.  Default: 262144.", seqan::ArgParseArgument::INTEGER, false, "BYTES"));
+    setMinValue(parser, "sample-block-size", "1024");
+    addOption(parser, seqan::ArgParseOption("sd", "seed", "Seed for choosing the sampled blocks.  Default: 0.", seqan::ArgParseArgument::INTEGER, false, "NUM"));
+
+    addSection(parser, "Performance");
+    addOption(parser, seqan::ArgParseOption("nt", "num-threads", "Number of threads to use.  Default: number of cores.", seqan::ArgParseArgument::INTEGER, false, "NUM"));
 
     // Parse command line.
     seqan::ArgumentParser::ParseResult res = seqan::parse(parser, argc, argv);
@@ -262,8 +343,51 @@ parseCommandLine(AppOptions & options, int argc, char const ** argv)
     if (res != seqan::ArgumentParser::PARSE_OK)
         return res;
 
-    seqan::getOptionValue(options.inFilename, parser, "input");
+    if (isSet(parser, "input"))
+        seqan::getOptionValue(options.inFilename, parser, "input");
     seqan::getOptionValue(options.outFilename, parser, "output");
+    if (isSet(parser, "snapshot"))
+        seqan::getOptionValue(options.snapshotFilename, parser, "snapshot");
+    std::vector<std::string> mergeFilenames = getOptionValues(parser, "merge");
+    for (unsigned i = 0; i < mergeFilenames.size(); ++i)
+        appendValue(options.mergeFilenames, seqan::CharString(mergeFilenames[i]));
+    if (empty(options.inFilename) == empty(options.mergeFilenames))
+    {
+        std::cerr << "ERROR: Exactly one of --input and --merge must be given.\n";
+        return seqan::ArgumentParser::PARSE_ERROR;
+    }
+    if (isSet(parser, "num-threads"))
+        seqan::getOptionValue(options.numThreads, parser, "num-threads");
+    if (isSet(parser, "output-lengths"))
+        seqan::getOptionValue(options.lengthsFilename, parser, "output-lengths");
+    if (isSet(parser, "output-mean-quals"))
+        seqan::getOptionValue(options.meanQualsFilename, parser, "output-mean-quals");
+
+    if (isSet(parser, "sample-blocks"))
+        seqan::getOptionValue(options.sampleBlocks, parser, "sample-blocks");
+    if (isSet(parser, "sample-block-size"))
+        seqan::getOptionValue(options.sampleBlockSize, parser, "sample-block-size");
+    if (isSet(parser, "seed"))
+        seqan::getOptionValue(options.seed, parser, "seed");
+
+    if (isSet(parser, "output-kmers"))
+        seqan::getOptionValue(options.kmersFilename, parser, "output-kmers");
+    if (isSet(parser, "kmer-length"))
+        seqan::getOptionValue(options.kmerLength, parser, "kmer-length");
+    if (isSet(parser, "top-kmers"))
+        seqan::getOptionValue(options.topKmers, parser, "top-kmers");
+    if (isSet(parser, "sketch-bits"))
+        seqan::getOptionValue(options.sketchBits, parser, "sketch-bits");
+
+    if (isSet(parser, "exact-length"))
+        seqan::getOptionValue(options.binning.exactLength, parser, "exact-length");
+    if (isSet(parser, "bin-width"))
+        seqan::getOptionValue(options.binning.binWidth, parser, "bin-width");
+    seqan::CharString binMode;
+    if (isSet(parser, "bin-mode"))
+        seqan::getOptionValue(binMode, parser, "bin-mode");
+    if (binMode == "fixed")
+        options.binning.mode = BIN_FIXED;
 
     return seqan::ArgumentParser::PARSE_OK;
 }
@@ -284,31 +408,16 @@ int main(int argc, char const ** argv)
     if (res != seqan::ArgumentParser::PARSE_OK)
         return res == seqan::ArgumentParser::PARSE_ERROR;
 
-    // Open input file.
-    seqan::SequenceStream inStream(toCString(options.inFilename));
-    if (!isGood(inStream))
-    {
-        std::cerr << "ERROR: Could not open file " << options.inFilename << " for reading.\n";
+    // Read sequences or merge snapshots and build result.
+    FastqStats stats;
+    double sampleFraction = 1;
+    if (!empty(options.mergeFilenames) ? mergeSnapshots(stats, options) : scanInput(stats, sampleFraction, options))
         return 1;
-    }
 
-    // Read sequences and build result.
-    FastqStats stats;
-    seqan::CharString id;
-    seqan::Dna5String seq;
-    seqan::CharString quals;
-    while (!atEnd(inStream))
+    if (!empty(options.snapshotFilename) && saveSnapshot(stats, toCString(options.snapshotFilename)) != 0)
     {
-        if (readRecord(id, seq, quals, inStream) != 0)
-        {
-            std::cerr << "ERROR: Could not read from " << options.inFilename << ".\n";
-            return 1;
-        }
-        if (empty(quals))  // Fill with Q40 if there are no qualities.
-            resize(quals, length(seq), '!' + 40);
-
-        // Update statistics.
-        stats.registerRead(seq, quals);
+        std::cerr << "ERROR: Could not write snapshot " << options.snapshotFilename << ".\n";
+        return 1;
     }
 
     // Finalize statistics and write to output.
@@ -327,10 +436,12 @@ int main(int argc, char const ** argv)
         out = &outStream;
     }
 
+    if (options.sampleBlocks > 0u)
+        *out << "#sample_fraction\t" << sampleFraction << "\n";
     *out << "#column\tcount\tmin\tmax\tsum\tmean\tQ1\tmedian\tQ3\tIQR\tlW\trW\tA_count\tC_count\tG_count\tT_count\tN_count\n";
-    for (unsigned i = 0; i < stats.maxLength; ++i)
+    for (unsigned i = 0; i < stats.numColumns; ++i)
     {
-        *out << i << "\t"
+        *out << stats.binning.columnBegin(i) << "\t"
              << stats.numBases[i] << "\t"
              << stats.minScores[i] << "\t"
              << stats.maxScores[i] << "\t"
@@ -342,13 +453,15 @@ int main(int argc, char const ** argv)
              << stats.interQuartileRanges[i] << "\t"
              << stats.leftWhiskers[i] << "\t"
              << stats.rightWhiskers[i] << "\t"
-             << stats.nucleotideCounts[i][0] << "\t"
-             << stats.nucleotideCounts[i][1] << "\t"
-             << stats.nucleotideCounts[i][2] << "\t"
-             << stats.nucleotideCounts[i][3] << "\t"
-             << stats.nucleotideCounts[i][4] << "\n";
+             << stats.nucleotideCounts[5 * i + 0] << "\t"
+             << stats.nucleotideCounts[5 * i + 1] << "\t"
+             << stats.nucleotideCounts[5 * i + 2] << "\t"
+             << stats.nucleotideCounts[5 * i + 3] << "\t"
+             << stats.nucleotideCounts[5 * i + 4] << "\n";
     }
 
-    return 0;
+    if (writeReadDistributions(options, stats) != 0)
+        return 1;
+    return writeKmerReport(options, stats);
 }
 
@@ -32,13 +32,33 @@
 // Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
 // ==========================================================================
 // Renaming of FASTA/Q read identifiers.
+//
+// The input is memory mapped and scanned record by record.  The new name is
+// formatted from a compiled pattern directly into the output buffer, the
+// sequence and quality lines are copied through as raw bytes.
+//
+// Paired files are processed in lockstep batches: while the records of one
+// batch are renamed and written, two threads scan the next batch of each
+// file.
 // ==========================================================================
 
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include <seqan/arg_parse.h>
 #include <seqan/basic.h>
+#include <seqan/file.h>
 #include <seqan/sequence.h>
 #include <seqan/stream.h>
 
+#include "name_map.h"
+#include "record_scanner.h"
+#include "rename_pattern.h"
+
 // --------------------------------------------------------------------------
 // Class FxRenamerOptions
 // --------------------------------------------------------------------------
@@ -54,84 +74,94 @@ struct FxRenamerOptions
     // Path to output file.
     seqan::CharString outPath;
 
-    // Whether or not to print FASTQ to output.
-    bool outFastq;
+    // The name pattern and the value of its {prefix} field.
+    seqan::CharString pattern;
+    seqan::CharString prefix;
 
-    // Set if one sequence is to be retrieved.
-    seqan::String<__uint64> seqIndices;
+    // Value of {index} for the first record.
+    __uint64 startIndex;
 
-    // Set if multiple sequences are to be retrieved.
-    seqan::String<seqan::Pair<__uint64> > seqIndexRanges;
+    // Path to write the name map to if not empty.
+    seqan::CharString mapOutPath;
 
-    // Set if output is to be limited to an infix.
-    __uint64 seqInfixBegin;
-    __uint64 seqInfixEnd;
+    // Path of the name map to restore the original names from if not empty.
+    seqan::CharString restoreMapPath;
 
-    // Whether or not to reverse-complement the result.
-    bool reverseComplement;
+    // Encoding of names in the written name maps.
+    NameMapCodec mapCodec;
 
-    // Maximal length of sequence characters to print.
-    __uint64 maxLength;
+    // Whether the input is a name map to be written as text.
+    bool dumpNames;
 
-    // Prefix of read names to output if not empty.
-    seqan::CharString readPattern;
+    // Second mate input, output and name map paths for paired renaming.  Without mateOutPath, the pairs are
+    // written interleaved to outPath.
+    seqan::CharString mateInPath;
+    seqan::CharString mateOutPath;
+    seqan::CharString mateMapOutPath;
 
     FxRenamerOptions() :
             verbosity(1),
-            outFastq(false),
-            seqInfixBegin(seqan::maxValue<__uint64>()),
-            seqInfixEnd(seqan::maxValue<__uint64>()),
-            reverseComplement(false),
-            maxLength(seqan::maxValue<__uint64>())
+            pattern("{prefix}{index}"),
+            startIndex(0),
+            mapCodec(NAME_MAP_TOKENS),
+            dumpNames(false)
     {}
 };
 
 // --------------------------------------------------------------------------
-// Function parseRange()
+// Class RawOutputBuffer
 // --------------------------------------------------------------------------
 
-template <typename TNum>
-bool parseRange(TNum & beginPos, TNum & endPos, seqan::CharString const & rangeStr)
+// Output buffer that records are formatted into directly, written to out in large blocks.
+
+struct RawOutputBuffer
 {
-    seqan::Stream<seqan::CharArray<char const *> > stream(begin(rangeStr, seqan::Standard()),
-                                                          end(rangeStr, seqan::Standard()));
-    seqan::RecordReader<seqan::Stream<seqan::CharArray<char const *> >, seqan::SinglePass<> > reader(stream);
+    std::ostream * out;
+    seqan::String<char> buffer;
+    size_t pos;
 
-    // Parse out begin position.
-    seqan::CharString buffer;
-    while (!atEnd(reader) && value(reader) != '-')
+    RawOutputBuffer() : out(0), pos(0)
     {
-        if (!isdigit(value(reader)) && value(reader) != ',')
-            return false;  // Error parsing.
-        if (isdigit(value(reader)))
-            appendValue(buffer, value(reader));
-        goNext(reader);
+        resize(buffer, 4 * 1024 * 1024);
     }
-    if (empty(buffer))
-        return false;
-    if (!lexicalCast2(beginPos, buffer))
-        return false;
-    if (atEnd(reader))
-        return true;
-    goNext(reader);  // Skip '-'.
-
-    // Parse out end position.
-    clear(buffer);
-    while (!atEnd(reader))
+};
+
+// Write out buffered characters, returns 0 on success, 1 on errors.
+
+int flush(RawOutputBuffer & buf)
+{
+    if (buf.pos == 0u)
+        return 0;
+    buf.out->write(&buf.buffer[0], buf.pos);
+    buf.pos = 0;
+    return !buf.out->good();
+}
+
+// Returns pointer to room for at least n characters, the caller advances buf.pos by the number of characters
+// written.  NULL on errors.
+
+char * reserve(RawOutputBuffer & buf, size_t n)
+{
+    if (buf.pos + n > length(buf.buffer))
     {
-        if (!isdigit(value(reader)) && value(reader) != ',')
-            return false;  // Error parsing.
-        if (isdigit(value(reader)))
-            appendValue(buffer, value(reader));
-        goNext(reader);
+        if (flush(buf) != 0)
+            return 0;
+        if (n > length(buf.buffer))
+            resize(buf.buffer, n);
     }
-    if (empty(buffer))
-        return false;
-    if (!lexicalCast2(endPos, buffer))
-        return false;
-    if (endPos < beginPos)
-        return false;
-    return true;
+    return &buf.buffer[0] + buf.pos;
+}
+
+// Append [first, last) to the buffer, returns 0 on success, 1 on errors.
+
+int append(RawOutputBuffer & buf, char const * first, char const * last)
+{
+    char * ptr = reserve(buf, last - first);
+    if (!ptr)
+        return 1;
+    memcpy(ptr, first, last - first);
+    buf.pos += last - first;
+    return 0;
 }
 
 // --------------------------------------------------------------------------
@@ -143,19 +173,18 @@ parseArgs(FxRenamerOptions & options,
           int argc,
           char const ** argv)
 {
-    seqan::ArgumentParser parser("fx_sak");
-    setShortDescription(parser, "Slicing and dicing of FASTA/FASTQ files..");
+    seqan::ArgumentParser parser("fx_renamer");
+    setShortDescription(parser, "Renaming of FASTA/FASTQ records.");
     setVersion(parser, "0.1");
     setDate(parser, "May 2012");
     
     addUsageLine(parser, "[\\fIOPTIONS\\fP] \\fIIN.fx\\fP");
-    addDescription(parser, "\"It slices, it dices and it makes the laundry!\"");
+    addDescription(parser, "Replace the read names of \\fIIN.fx\\fP by names built from \\fB--pattern\\fP.  Sequences and qualities are copied unchanged.");
+    addDescription(parser, "The pattern may contain the fields \\fI{prefix}\\fP (value of \\fB--prefix\\fP), \\fI{index}\\fP (record number), \\fI{index:R}\\fP and \\fI{index:R:W}\\fP (record number in radix \\fIR\\fP of 10, 16, 36 or 64, padded to width \\fIW\\fP), \\fI{mate}\\fP (1 or 2, from the \\fI/1\\fP suffix or Illumina comment of the original name), \\fI{name}\\fP and \\fI{comment}\\fP (original name up to and behind the first space).  Write \\fI{{\\fP and \\fI}}\\fP for literal braces.");
 
     // The only argument is the input file.
     addArgument(parser, seqan::ArgParseArgument(seqan::ArgParseArgument::INPUTFILE, false, "IN"));
 
-    // TODO(holtgrew): I want a custom help text!
-    // addOption(parser, seqan::ArgParseOption("h", "help", "This helpful screen."));
     addOption(parser, seqan::ArgParseOption("v", "verbose", "Verbose, log to STDERR."));
     hideOption(parser, "verbose");
     addOption(parser, seqan::ArgParseOption("vv", "very-verbose", "Very verbose, log to STDERR."));
@@ -163,19 +192,29 @@ parseArgs(FxRenamerOptions & options,
 
     addSection(parser, "Output Options");
     addOption(parser, seqan::ArgParseOption("o", "out-path", "Path to the resulting file.  If omitted, result is printed to stdout.", seqan::ArgParseArgument::STRING, false, "FASTX"));
-    addOption(parser, seqan::ArgParseOption("q", "qual", "Write output as  FASTQ file."));
-    addOption(parser, seqan::ArgParseOption("rc", "revcomp", "Reverse-complement output."));
-    addOption(parser, seqan::ArgParseOption("l", "max-length", "Maximal number of sequence characters to write out.", seqan::ArgParseArgument::INTEGER, false, "LEN"));
 
-    addSection(parser, "Filter Options");
-    addOption(parser, seqan::ArgParseOption("s", "sequence", "Select the given sequence for extraction by 0-based index.", seqan::ArgParseArgument::INTEGER, true, "NUM"));
-    addOption(parser, seqan::ArgParseOption("sn", "sequence-name", "Select sequence with name prefix being \\fINAME\\fP.", seqan::ArgParseArgument::STRING, true, "NAME"));
-    addOption(parser, seqan::ArgParseOption("ss", "sequences", "Select sequences \\fIfrom\\fP-\\fIto\\fP where \\fIfrom\\fP and \\fIto\\fP are 0-based indices.", seqan::ArgParseArgument::STRING, true, "RANGE"));
-    addOption(parser, seqan::ArgParseOption("i", "infix", "Select characters \\fIfrom\\fP-\\fIto\\fP where \\fIfrom\\fP and \\fIto\\fP are 0-based indices.'", seqan::ArgParseArgument::STRING, true, "RANGE"));
+    addSection(parser, "Renaming Options");
+    addOption(parser, seqan::ArgParseOption("p", "pattern", "Pattern for the new names.  Default: {prefix}{index}.", seqan::ArgParseArgument::STRING, false, "PATTERN"));
+    addOption(parser, seqan::ArgParseOption("pr", "prefix", "Value of the \\fI{prefix}\\fP field.  Default: empty.", seqan::ArgParseArgument::STRING, false, "STR"));
+    addOption(parser, seqan::ArgParseOption("si", "start-index", "Value of \\fI{index}\\fP for the first record.  Default: 0.", seqan::ArgParseArgument::INTEGER, false, "NUM"));
+
+    addSection(parser, "Paired Options");
+    addOption(parser, seqan::ArgParseOption("i2", "mate-in", "Rename the pairs of \\fIIN.fx\\fP and the second mate file \\fIIN2\\fP in lockstep.  Both mates get the same \\fI{index}\\fP and the \\fI{mate}\\fP of their file, their original names must agree up to a \\fI/1\\fP or \\fI/2\\fP suffix.", seqan::ArgParseArgument::STRING, false, "IN2"));
+    addOption(parser, seqan::ArgParseOption("o2", "mate-out", "Output path for the second mates.  If omitted, pairs are written interleaved to \\fB--out-path\\fP.", seqan::ArgParseArgument::STRING, false, "FASTX"));
+    addOption(parser, seqan::ArgParseOption("m2", "mate-map-out", "Name map for the second mates, see \\fB--map-out\\fP.", seqan::ArgParseArgument::STRING, false, "MAP"));
+
+    addSection(parser, "Name Map Options");
+    addOption(parser, seqan::ArgParseOption("m", "map-out", "Write the original names to the compact binary name map \\fIMAP\\fP such that they can be restored with \\fB--restore\\fP.", seqan::ArgParseArgument::STRING, false, "MAP"));
+    addOption(parser, seqan::ArgParseOption("mc", "map-codec", "Encoding of the names in \\fB--map-out\\fP.  \\fIfront\\fP: shared prefix with the previous name, \\fItokens\\fP: names are split into fields at separators such as ':', unchanged fields are dropped and numeric fields are stored as difference to the previous name.  Default: tokens.", seqan::ArgParseArgument::STRING, false, "CODEC"));
+    setValidValues(parser, "map-codec", "front tokens");
+    addOption(parser, seqan::ArgParseOption("dn", "dump-names", "\\fIIN\\fP is a name map, write the original names as text, one per line."));
+    addOption(parser, seqan::ArgParseOption("r", "restore", "Restore the original names of the renamed \\fIIN.fx\\fP from the name map \\fIMAP\\fP.  If the record number can be parsed from the new names, the records may be a subset in any order, otherwise they must be the records in the original order.", seqan::ArgParseArgument::STRING, false, "MAP"));
 
     addTextSection(parser, "Usage Examples");
-    addListItem(parser, "\\fBfx_sak\\fP \\fB-s\\fP \\fI10\\fP \\fIIN.fa\\fP", "Cut out 11th sequence from \\fIIN.fa\\fP and write to stdout as FASTA.");
-    addListItem(parser, "\\fBfx_sak\\fP \\fB-q\\fP \\fB-ss\\fP \\fI10-12\\fP \\fB-ss\\fP \\fI100-200\\fP \\fIIN.fq\\fP", "Cut out 11th up to and including 12th and 101th up to and including 199th sequence from \\fIIN.fq\\fP and write to stdout as FASTQ.");
+    addListItem(parser, "\\fBfx_renamer\\fP \\fB-pr\\fP \\fIrun7.\\fP \\fIIN.fq\\fP", "Rename the reads to \\fIrun7.0\\fP, \\fIrun7.1\\fP, ...");
+    addListItem(parser, "\\fBfx_renamer\\fP \\fB-p\\fP \\fI'{prefix}{index:64}/{mate}'\\fP \\fB-pr\\fP \\fIr\\fP \\fB-o\\fP \\fIOUT.fq\\fP \\fIIN.fq\\fP", "Rename the reads to short radix 64 names with the mate number.");
+    addListItem(parser, "\\fBfx_renamer\\fP \\fB-m\\fP \\fINAMES.map\\fP \\fB-o\\fP \\fISHORT.fq\\fP \\fIIN.fq\\fP; \\fBfx_renamer\\fP \\fB-r\\fP \\fINAMES.map\\fP \\fISHORT.fq\\fP", "Rename and record the original names, then restore them.");
+    addListItem(parser, "\\fBfx_renamer\\fP \\fB-p\\fP \\fI'{index}/{mate}'\\fP \\fB-i2\\fP \\fIR2.fq\\fP \\fB-o\\fP \\fIOUT_1.fq\\fP \\fB-o2\\fP \\fIOUT_2.fq\\fP \\fIR1.fq\\fP", "Rename the pairs of \\fIR1.fq\\fP and \\fIR2.fq\\fP consistently.");
 
     seqan::ArgumentParser::ParseResult res = parse(parser, argc, argv);
 
@@ -183,8 +222,6 @@ parseArgs(FxRenamerOptions & options,
     {
         getArgumentValue(options.inFastxPath, parser, 0);
 
-        options.outFastq = isSet(parser, "qual");
-
         if (isSet(parser, "out-path"))
             getOptionValue(options.outPath, parser, "out-path");
 
@@ -193,70 +230,356 @@ parseArgs(FxRenamerOptions & options,
         if (isSet(parser, "very-verbose"))
             options.verbosity = 3;
 
-        if (isSet(parser, "sequence"))
+        if (isSet(parser, "pattern"))
+            getOptionValue(options.pattern, parser, "pattern");
+        if (isSet(parser, "prefix"))
+            getOptionValue(options.prefix, parser, "prefix");
+        if (isSet(parser, "start-index"))
+            getOptionValue(options.startIndex, parser, "start-index");
+        if (isSet(parser, "map-out"))
+            getOptionValue(options.mapOutPath, parser, "map-out");
+        if (isSet(parser, "restore"))
+            getOptionValue(options.restoreMapPath, parser, "restore");
+        if (isSet(parser, "map-codec"))
         {
-            std::vector<std::string> sequenceIds = getOptionValues(parser, "sequence");
-            for (unsigned i = 0; i < seqan::length(sequenceIds); ++i)
-            {
-                unsigned idx = 0;
-                if (!seqan::lexicalCast2(idx, sequenceIds[i]))
-                {
-                    std::cerr << "ERROR: Invalid sequence index " << sequenceIds[i] << "\n";
-                    return seqan::ArgumentParser::PARSE_ERROR;
-                }
-                appendValue(options.seqIndices, idx);
-            }
+            seqan::CharString codec;
+            getOptionValue(codec, parser, "map-codec");
+            options.mapCodec = (codec == "front") ? NAME_MAP_FRONT_CODING : NAME_MAP_TOKENS;
+        }
+        options.dumpNames = isSet(parser, "dump-names");
+        if (!empty(options.mapOutPath) && !empty(options.restoreMapPath))
+        {
+            std::cerr << "ERROR: Only one of --map-out and --restore can be given.\n";
+            return seqan::ArgumentParser::PARSE_ERROR;
+        }
+        if (isSet(parser, "mate-in"))
+            getOptionValue(options.mateInPath, parser, "mate-in");
+        if (isSet(parser, "mate-out"))
+            getOptionValue(options.mateOutPath, parser, "mate-out");
+        if (isSet(parser, "mate-map-out"))
+            getOptionValue(options.mateMapOutPath, parser, "mate-map-out");
+        if (empty(options.mateInPath) && (!empty(options.mateOutPath) || !empty(options.mateMapOutPath)))
+        {
+            std::cerr << "ERROR: --mate-out and --mate-map-out require --mate-in.\n";
+            return seqan::ArgumentParser::PARSE_ERROR;
+        }
+        if (!empty(options.mateInPath) && !empty(options.restoreMapPath))
+        {
+            std::cerr << "ERROR: --restore works on one file, restore the mate files separately.\n";
+            return seqan::ArgumentParser::PARSE_ERROR;
         }
+    }
+
+    return res;
+}
+
+// ---------------------------------------------------------------------------
+// Class PatternHeaderWriter
+// ---------------------------------------------------------------------------
+
+// Writes the name for the current index, optionally recording the original header in a name map.
 
-        if (isSet(parser, "sequences"))
+struct PatternHeaderWriter
+{
+    RenamePattern const * pattern;
+    NameMapWriter * mapWriter;
+    __uint64 index;
+    // Value of {mate}, taken from the original header if 0.
+    char mate;
+
+    PatternHeaderWriter() : pattern(0), mapWriter(0), index(0), mate(0)
+    {}
+};
+
+int writeHeader(RawOutputBuffer & buf, PatternHeaderWriter & writer, char const * header, char const * headerEnd)
+{
+    char * out = reserve(buf, maxNameLength(*writer.pattern, headerEnd - header));
+    if (!out)
+        return 1;
+    char mate = writer.mate ? writer.mate : mateOfHeader(header, headerEnd);
+    char * ptr = formatName(out, *writer.pattern, writer.index, mate, header, headerEnd);
+    buf.pos += ptr - out;
+    if (writer.mapWriter && appendName(*writer.mapWriter, header, headerEnd) != 0)
+        return 1;
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Class RestoreHeaderWriter
+// ---------------------------------------------------------------------------
+
+// Writes the original header from a name map.  The record number is parsed from the new name if the pattern allows
+// this, otherwise the records must be in their original order.
+
+struct RestoreHeaderWriter
+{
+    NameMapReader * reader;
+    RenamePattern pattern;
+    bool byName;
+    __uint64 recordNo;
+    bool notFound;
+
+    RestoreHeaderWriter() : reader(0), byName(false), recordNo(0), notFound(false)
+    {}
+};
+
+int writeHeader(RawOutputBuffer & buf, RestoreHeaderWriter & writer, char const * header, char const * headerEnd)
+{
+    __uint64 index = 0;
+    if (writer.byName)
+    {
+        if (!parseIndex(index, writer.pattern, header, headerEnd) || index < writer.reader->startIndex)
         {
-            std::vector<std::string> sequenceRanges = getOptionValues(parser, "sequences");
-            seqan::CharString buffer;
-            for (unsigned i = 0; i < seqan::length(sequenceRanges); ++i)
+            writer.notFound = true;
+            return 1;
+        }
+        writer.recordNo = index - writer.reader->startIndex;
+    }
+    char const * nameBegin = 0;
+    char const * nameEnd = 0;
+    if (!lookup(nameBegin, nameEnd, *writer.reader, writer.recordNo))
+    {
+        writer.notFound = true;
+        return 1;
+    }
+    return append(buf, nameBegin, nameEnd);
+}
+
+// ---------------------------------------------------------------------------
+// Function rewriteRecord()
+// ---------------------------------------------------------------------------
+
+// Write the record at it to buf with its header replaced through writeHeader(buf, headerWriter, ...).  Returns the
+// end of the record, NULL on errors.
+
+template <typename THeaderWriter>
+char const * rewriteRecord(RawOutputBuffer & buf,
+                           char const * it,
+                           char const * fileEnd,
+                           RawRecordFormat format,
+                           THeaderWriter & headerWriter)
+{
+    char const * header = it + 1;
+    char const * payload = nextLineBegin(it, fileEnd);
+    char const * headerEnd = header + lineLength(header, payload);
+
+    char const * plusLine = 0;
+    char const * recordEnd = 0;
+    if (format == RAW_FORMAT_FASTA)
+    {
+        recordEnd = skipFastaRecord(it, fileEnd);
+    }
+    else
+    {
+        __uint64 seqLength = 0;
+        recordEnd = skipFastqRecord(seqLength, plusLine, it, fileEnd);
+        if (!recordEnd)
+            return 0;
+    }
+
+    // New header line.
+    if (append(buf, it, it + 1) != 0 || writeHeader(buf, headerWriter, header, headerEnd) != 0 ||
+        append(buf, "\n", "\n" + 1) != 0)
+        return 0;
+
+    // Payload as is, a name repeated on the '+' line is dropped.
+    char const * qualsBegin = plusLine ? nextLineBegin(plusLine, recordEnd) : 0;
+    if (plusLine && lineLength(plusLine, qualsBegin) > 1u)
+    {
+        if (append(buf, payload, plusLine + 1) != 0 || append(buf, "\n", "\n" + 1) != 0 ||
+            append(buf, qualsBegin, recordEnd) != 0)
+            return 0;
+    }
+    else if (append(buf, payload, recordEnd) != 0)
+    {
+        return 0;
+    }
+    if (recordEnd != payload && recordEnd[-1] != '\n' && append(buf, "\n", "\n" + 1) != 0)
+        return 0;
+
+    return recordEnd;
+}
+
+// ---------------------------------------------------------------------------
+// Class RecordBatch
+// ---------------------------------------------------------------------------
+
+// Begin and end positions of consecutive records of a memory mapped file.
+
+struct RecordBatch
+{
+    std::vector<std::pair<char const *, char const *> > records;
+    bool error;
+
+    RecordBatch() : error(false)
+    {}
+};
+
+// Scan up to n records from it into batch.  Returns the position behind them.
+
+char const * scanBatch(RecordBatch & batch, char const * it, char const * fileEnd, RawRecordFormat format, unsigned n)
+{
+    batch.records.clear();
+    batch.error = false;
+    while (it != fileEnd && batch.records.size() < n)
+    {
+        char const * next = skipRawRecord(it, fileEnd, format);
+        if (!next)
+        {
+            batch.error = true;
+            return fileEnd;
+        }
+        batch.records.push_back(std::make_pair(it, next));
+        it = next;
+    }
+    return it;
+}
+
+// ---------------------------------------------------------------------------
+// Function renamePairs()
+// ---------------------------------------------------------------------------
+
+// Rename the records of the two mate files [begins[i], ends[i]) in lockstep, the first mates are written to buf1
+// and the second ones to buf2 (which may be buf1 for interleaved output).  Returns 0 on success, 1 on errors.
+
+int renamePairs(__uint64 & numPairs,
+                RawOutputBuffer & buf1,
+                RawOutputBuffer & buf2,
+                PatternHeaderWriter (& headerWriters)[2],
+                char const * (& begins)[2],
+                char const * (& ends)[2],
+                RawRecordFormat (& formats)[2],
+                FxRenamerOptions const & options)
+{
+    unsigned const BATCH_SIZE = 4096;
+    RecordBatch batches[2][2];  // [slot][mate]
+    char const * its[2] = {skipBlankLines(begins[0], ends[0]), skipBlankLines(begins[1], ends[1])};
+    for (unsigned m = 0; m < 2; ++m)
+        its[m] = scanBatch(batches[0][m], its[m], ends[m], formats[m], BATCH_SIZE);
+
+    numPairs = 0;
+    int res = 0;
+    for (unsigned slot = 0; res == 0; slot = 1 - slot)
+    {
+        RecordBatch (& current)[2] = batches[slot];
+        RecordBatch (& next)[2] = batches[1 - slot];
+        for (unsigned m = 0; m < 2; ++m)
+        {
+            if (current[m].error)
             {
-                seqan::Pair<__uint64> range;
-                if (!parseRange(range.i1, range.i2, sequenceRanges[i]))
-                {
-                    std::cerr << "ERROR: Invalid range " << sequenceRanges[i] << "\n";
-                    return seqan::ArgumentParser::PARSE_ERROR;
-                }
-                appendValue(options.seqIndexRanges, range);
+                std::cerr << "ERROR: Invalid record " << (numPairs + current[m].records.size()) << " in "
+                          << (m ? options.mateInPath : options.inFastxPath) << "\n";
+                return 1;
             }
         }
+        if (current[0].records.size() != current[1].records.size())
+        {
+            std::cerr << "ERROR: The mate files have different numbers of records.\n";
+            return 1;
+        }
+        if (current[0].records.empty())
+            break;
 
-        if (isSet(parser, "infix"))
+        // Scan the next batches while renaming the current one.
+        SEQAN_OMP_PRAGMA(parallel sections num_threads(3))
         {
-            seqan::CharString buffer;
-            getOptionValue(buffer, parser, "infix");
-            if (!parseRange(options.seqInfixBegin, options.seqInfixEnd, buffer))
+            SEQAN_OMP_PRAGMA(section)
+            its[0] = scanBatch(next[0], its[0], ends[0], formats[0], BATCH_SIZE);
+            SEQAN_OMP_PRAGMA(section)
+            its[1] = scanBatch(next[1], its[1], ends[1], formats[1], BATCH_SIZE);
+            SEQAN_OMP_PRAGMA(section)
             {
-                std::cerr << "ERROR: Invalid range " << buffer << "\n";
-                return seqan::ArgumentParser::PARSE_ERROR;
+                for (unsigned i = 0; res == 0 && i < current[0].records.size(); ++i)
+                {
+                    char const * headers[2];
+                    char const * headerEnds[2];
+                    for (unsigned m = 0; m < 2; ++m)
+                    {
+                        headers[m] = current[m].records[i].first + 1;
+                        char const * lineEnd = nextLineBegin(headers[m], current[m].records[i].second);
+                        headerEnds[m] = mateNameEnd(headers[m], headers[m] + lineLength(headers[m], lineEnd));
+                    }
+                    if (headerEnds[0] - headers[0] != headerEnds[1] - headers[1] ||
+                        memcmp(headers[0], headers[1], headerEnds[0] - headers[0]) != 0)
+                    {
+                        std::cerr << "ERROR: Mate names differ at pair " << (numPairs + i) << ": "
+                                  << std::string(headers[0], headerEnds[0]) << " vs. "
+                                  << std::string(headers[1], headerEnds[1]) << "\n";
+                        res = 1;
+                        break;
+                    }
+                    for (unsigned m = 0; m < 2; ++m)
+                    {
+                        headerWriters[m].index = options.startIndex + numPairs + i;
+                        if (!rewriteRecord(m ? buf2 : buf1, current[m].records[i].first, current[m].records[i].second,
+                                           formats[m], headerWriters[m]))
+                        {
+                            std::cerr << "ERROR: Could not write pair " << (numPairs + i) << "\n";
+                            res = 1;
+                            break;
+                        }
+                    }
+                }
             }
         }
-
-        options.reverseComplement = isSet(parser, "revcomp");
-        
-        if (isSet(parser, "max-length"))
-            getOptionValue(options.maxLength, parser, "max-length");
-
-        if (isSet(parser, "sequence-name"))
-            getOptionValue(options.readPattern, parser, "sequence-name");
+        numPairs += current[0].records.size();
     }
-
     return res;
 }
 
 // ---------------------------------------------------------------------------
-// Function yesNo()
+// Function dumpNameMap()
 // ---------------------------------------------------------------------------
 
-char const * yesNo(bool b)
+// Write the names of the name map at options.inFastxPath as text lines.  Returns 0 on success, 1 on errors.
+
+int dumpNameMap(FxRenamerOptions const & options)
 {
-    if (b)
-        return "YES";
-    else
-        return "NO";
+    NameMapReader reader;
+    if (open(reader, toCString(options.inFastxPath)) != 0)
+    {
+        std::cerr << "ERROR: Could not load name map " << options.inFastxPath << "\n";
+        return 1;
+    }
+
+    RawOutputBuffer buf;
+    buf.out = &std::cout;
+    std::fstream outStream;
+    if (!empty(options.outPath))
+    {
+        outStream.open(toCString(options.outPath), std::ios::binary | std::ios::out);
+        if (!outStream.good())
+        {
+            std::cerr << "ERROR: Could not open output file " << options.outPath << "\n";
+            return 1;
+        }
+        buf.out = &outStream;
+    }
+
+    for (__uint64 recordNo = 0; recordNo < reader.numRecords; ++recordNo)
+    {
+        char const * nameBegin = 0;
+        char const * nameEnd = 0;
+        if (!lookup(nameBegin, nameEnd, reader, recordNo))
+        {
+            std::cerr << "ERROR: Corrupt name map at record " << recordNo << "\n";
+            return 1;
+        }
+        if (append(buf, nameBegin, nameEnd) != 0 || append(buf, "\n", "\n" + 1) != 0)
+        {
+            std::cerr << "ERROR: Could not write output!\n";
+            return 1;
+        }
+    }
+    if (flush(buf) != 0)
+    {
+        std::cerr << "ERROR: Could not write output!\n";
+        return 1;
+    }
+
+    if (options.verbosity >= 2)
+        std::cerr << "Wrote " << reader.numRecords << " names\n";
+    return 0;
 }
 
 // ---------------------------------------------------------------------------
@@ -273,6 +596,30 @@ int main(int argc, char const ** argv)
     if (res != seqan::ArgumentParser::PARSE_OK)
         return res == seqan::ArgumentParser::PARSE_ERROR;  // 1 on errors, 0 otherwise
 
+    if (options.dumpNames)
+        return dumpNameMap(options);
+
+    // When restoring, the pattern comes from the name map.
+    NameMapReader mapReader;
+    if (!empty(options.restoreMapPath))
+    {
+        if (open(mapReader, toCString(options.restoreMapPath)) != 0)
+        {
+            std::cerr << "ERROR: Could not load name map " << options.restoreMapPath << "\n";
+            return 1;
+        }
+        options.pattern = mapReader.pattern;
+        options.prefix = mapReader.prefix;
+        options.startIndex = mapReader.startIndex;
+    }
+
+    RenamePattern pattern;
+    if (compile(pattern, options.pattern, options.prefix) != 0)
+    {
+        std::cerr << "ERROR: Invalid pattern " << options.pattern << "\n";
+        return 1;
+    }
+
     // -----------------------------------------------------------------------
     // Show options.
     // -----------------------------------------------------------------------
@@ -283,206 +630,196 @@ int main(int argc, char const ** argv)
                   << "VERBOSITY    " << options.verbosity << "\n"
                   << "IN           " << options.inFastxPath << "\n"
                   << "OUT          " << options.outPath << "\n"
-                  << "FASTQ OUT    " << yesNo(options.outFastq) << "\n"
-                  << "INFIX BEGIN  " << options.seqInfixBegin << "\n"
-                  << "INFIX END    " << options.seqInfixEnd << "\n"
-                  << "MAX LEN      " << options.maxLength << "\n"
-                  << "READ PATTERN " << options.readPattern << "\n"
-                  << "REVCOMP      " << yesNo(options.reverseComplement) << "\n"
-                  << "SEQUENCES\n";
-        for (unsigned i = 0; i < length(options.seqIndices); ++i)
-            std::cerr << "  SEQ  " << options.seqIndices[i] << "\n";
-        for (unsigned i = 0; i < length(options.seqIndexRanges); ++i)
-            std::cerr << "  SEQS " << options.seqIndexRanges[i].i1 << "-" << options.seqIndexRanges[i].i2 << "\n";
+                  << "PATTERN      " << options.pattern << "\n"
+                  << "PREFIX       " << options.prefix << "\n"
+                  << "START INDEX  " << options.startIndex << "\n"
+                  << "MAP OUT      " << options.mapOutPath << "\n"
+                  << "RESTORE MAP  " << options.restoreMapPath << "\n"
+                  << "MATE IN      " << options.mateInPath << "\n"
+                  << "MATE OUT     " << options.mateOutPath << "\n"
+                  << "MATE MAP OUT " << options.mateMapOutPath << "\n"
+                  << "MAP CODEC    " << (options.mapCodec == NAME_MAP_TOKENS ? "tokens" : "front") << "\n";
     }
 
     // -----------------------------------------------------------------------
     // Open Files.
     // -----------------------------------------------------------------------
-    std::ostream * outPtr = & std::cout;
-    std::fstream inStream;
-    if (!empty(options.inFastxPath))
+    seqan::String<char, seqan::MMap<> > inString;
+    if (!open(inString, toCString(options.inFastxPath), seqan::OPEN_RDONLY))
     {
-        inStream.open(toCString(options.inFastxPath), std::ios::binary | std::ios::in);
-        if (!inStream.good())
+        std::cerr << "ERROR: Could not open input file " << options.inFastxPath << "\n";
+        return 1;
+    }
+    char const * fileBegin = begin(inString, seqan::Standard());
+    char const * fileEnd = end(inString, seqan::Standard());
+
+    RawRecordFormat format = guessRawFormat(fileBegin, fileEnd);
+    if (format == RAW_FORMAT_UNKNOWN && fileBegin != fileEnd)
+    {
+        std::cerr << "ERROR: Could not determine input format!\n";
+        return 1;
+    }
+
+    seqan::String<char, seqan::MMap<> > mateInString;
+    char const * mateFileBegin = 0;
+    char const * mateFileEnd = 0;
+    RawRecordFormat mateFormat = format;
+    if (!empty(options.mateInPath))
+    {
+        if (!open(mateInString, toCString(options.mateInPath), seqan::OPEN_RDONLY))
         {
-            std::cerr << "ERROR: Could not open input file " << options.inFastxPath << "\n";
+            std::cerr << "ERROR: Could not open input file " << options.mateInPath << "\n";
+            return 1;
+        }
+        mateFileBegin = begin(mateInString, seqan::Standard());
+        mateFileEnd = end(mateInString, seqan::Standard());
+        mateFormat = guessRawFormat(mateFileBegin, mateFileEnd);
+        if (mateFormat == RAW_FORMAT_UNKNOWN && mateFileBegin != mateFileEnd)
+        {
+            std::cerr << "ERROR: Could not determine input format of " << options.mateInPath << "\n";
             return 1;
         }
     }
+
+    RawOutputBuffer buf;
+    buf.out = &std::cout;
     std::fstream outStream;
     if (!empty(options.outPath))
     {
-        outStream.open(toCString(options.outPath), std::ios::binary | std::ios::in);
+        outStream.open(toCString(options.outPath), std::ios::binary | std::ios::out);
         if (!outStream.good())
         {
             std::cerr << "ERROR: Could not open output file " << options.outPath << "\n";
             return 1;
         }
-        outPtr = &outStream;
+        buf.out = &outStream;
+    }
+    RawOutputBuffer mateBuf;
+    std::fstream mateOutStream;
+    if (!empty(options.mateOutPath))
+    {
+        mateOutStream.open(toCString(options.mateOutPath), std::ios::binary | std::ios::out);
+        if (!mateOutStream.good())
+        {
+            std::cerr << "ERROR: Could not open output file " << options.mateOutPath << "\n";
+            return 1;
+        }
+        mateBuf.out = &mateOutStream;
     }
 
-    // Compute index of last sequence to write if any.
-    __uint64 endIdx = seqan::maxValue<__uint64>();
-    for (unsigned i = 0; i < length(options.seqIndices); ++i)
-        if (endIdx == seqan::maxValue<__uint64>() || endIdx > options.seqIndices[i] + 1)
-            endIdx = options.seqIndices[i] + 1;
-    for (unsigned i = 0; i < length(options.seqIndexRanges); ++i)
-        if (endIdx == seqan::maxValue<__uint64>() || endIdx > options.seqIndexRanges[i].i2)
-            endIdx = options.seqIndexRanges[i].i2;
-    if (options.verbosity >= 2)
-        std::cerr << "Sequence end idx: " << endIdx << "\n";
-    
-    // -----------------------------------------------------------------------
-    // Read and Write Filtered.
-    // -----------------------------------------------------------------------
-    startTime = sysTime();
-    seqan::RecordReader<std::fstream, seqan::SinglePass<> > reader(inStream);
-    seqan::AutoSeqStreamFormat tagSelector;
-    if (!checkStreamFormat(reader, tagSelector) || (tagSelector.tagId != 1 && tagSelector.tagId != 2))
+    NameMapWriter mapWriter;
+    if (!empty(options.mapOutPath) &&
+        open(mapWriter, toCString(options.mapOutPath), options.pattern, options.prefix, options.startIndex,
+             options.mapCodec) != 0)
     {
-        std::cerr << "ERROR: Could not determine input format!\n";
+        std::cerr << "ERROR: Could not open name map " << options.mapOutPath << "\n";
+        return 1;
+    }
+    NameMapWriter mateMapWriter;
+    if (!empty(options.mateMapOutPath) &&
+        open(mateMapWriter, toCString(options.mateMapOutPath), options.pattern, options.prefix,
+             options.startIndex, options.mapCodec) != 0)
+    {
+        std::cerr << "ERROR: Could not open name map " << options.mateMapOutPath << "\n";
         return 1;
     }
 
-    unsigned idx = 0;
-    __uint64 charsWritten = 0;
-    seqan::CharString id;
-    seqan::CharString seq;
-    seqan::CharString quals;
-    while (!atEnd(reader) && charsWritten < options.maxLength && idx < endIdx)
+    // -----------------------------------------------------------------------
+    // Rename Records.
+    // -----------------------------------------------------------------------
+    startTime = sysTime();
+    __uint64 idx = 0;
+    if (!empty(options.mateInPath))
     {
-        if (tagSelector.tagId == 1)
+        PatternHeaderWriter headerWriters[2];
+        char const * begins[2] = {fileBegin, mateFileBegin};
+        char const * ends[2] = {fileEnd, mateFileEnd};
+        RawRecordFormat formats[2] = {format, mateFormat};
+        for (unsigned m = 0; m < 2; ++m)
         {
-            // FASTA.
-            if (readRecord(id, seq, reader, seqan::Fasta()) != 0)
-            {
-                std::cerr << "ERROR: Reading record!\n";
-                return 1;
-            }
-            if (options.outFastq)
-                resize(quals, length(seq), 'I');
+            headerWriters[m].pattern = &pattern;
+            headerWriters[m].mate = '1' + m;
         }
-        else
+        headerWriters[0].mapWriter = empty(options.mapOutPath) ? 0 : &mapWriter;
+        headerWriters[1].mapWriter = empty(options.mateMapOutPath) ? 0 : &mateMapWriter;
+        if (renamePairs(idx, buf, empty(options.mateOutPath) ? buf : mateBuf, headerWriters, begins, ends, formats,
+                        options) != 0)
+            return 1;
+        if ((!empty(options.mapOutPath) && close(mapWriter) != 0) ||
+            (!empty(options.mateMapOutPath) && close(mateMapWriter) != 0))
         {
-            // FASTQ
-            if (readRecord(id, seq, quals, reader, seqan::Fastq()) != 0)
-            {
-                std::cerr << "ERROR: Reading record!\n";
-                return 1;
-            }
+            std::cerr << "ERROR: Could not write name maps.\n";
+            return 1;
         }
-
-        // Check whether to write out sequence.
-        bool writeOut = false;
-        if (empty(options.seqIndices) && empty(options.seqIndexRanges))
-            writeOut = true;
-        // One of options.seqIndices.
-        if (!writeOut)
+        if (!empty(options.mateOutPath) && flush(mateBuf) != 0)
         {
-            for (unsigned i = 0; i < length(options.seqIndices); ++i)
-            {
-                if (options.seqIndices[i] == idx)
-                {
-                    writeOut = true;
-                    break;
-                }
-            }
+            std::cerr << "ERROR: Could not write output!\n";
+            return 1;
         }
-        // One of options.seqIndexRanges.
-        if (!writeOut)
+    }
+    else if (empty(options.restoreMapPath))
+    {
+        PatternHeaderWriter headerWriter;
+        headerWriter.pattern = &pattern;
+        headerWriter.mapWriter = empty(options.mapOutPath) ? 0 : &mapWriter;
+        for (char const * it = skipBlankLines(fileBegin, fileEnd); it != fileEnd; ++idx)
         {
-            for (unsigned i = 0; i < length(options.seqIndexRanges); ++i)
+            headerWriter.index = options.startIndex + idx;
+            it = rewriteRecord(buf, it, fileEnd, format, headerWriter);
+            if (!it)
             {
-                if (idx >= options.seqIndexRanges[i].i1 && idx < options.seqIndexRanges[i].i2)
-                {
-                    writeOut = true;
-                    break;
-                }
+                std::cerr << "ERROR: Invalid record or write error at record " << idx << "\n";
+                return 1;
             }
+            it = skipBlankLines(it, fileEnd);
         }
-        // Name pattern matches.
-        if (!writeOut && !empty(options.readPattern))
+        if (!empty(options.mapOutPath) && close(mapWriter) != 0)
         {
-            unsigned l = length(options.readPattern);
-            if (l > length(id))
-                l = length(id);
-            if (prefix(id, l) == prefix(options.readPattern, l))
-                writeOut = true;
+            std::cerr << "ERROR: Could not write name map " << options.mapOutPath << "\n";
+            return 1;
         }
-
-        // Write out if we want this.
-        if (writeOut)
+    }
+    else
+    {
+        RestoreHeaderWriter headerWriter;
+        headerWriter.reader = &mapReader;
+        headerWriter.pattern = pattern;
+        headerWriter.byName = isInvertible(pattern);
+        if (options.verbosity >= 2)
+            std::cerr << "Restoring names " << (headerWriter.byName ? "by parsed index" : "in record order") << "\n";
+        for (char const * it = skipBlankLines(fileBegin, fileEnd); it != fileEnd; ++idx)
         {
-            // Get begin and end index of infix to write out.
-            __uint64 infixBegin = 0;
-            if (options.seqInfixBegin != seqan::maxValue<__uint64>())
-                infixBegin = options.seqInfixBegin;
-            if (infixBegin > length(seq))
-                infixBegin = length(seq);
-            __uint64 infixEnd = length(seq);
-            if (options.seqInfixEnd < length(seq))
-                infixEnd = options.seqInfixEnd;
-            if (infixEnd < infixBegin)
-                infixEnd = infixBegin;
-            if (options.verbosity >= 3)
-                std::cerr << "INFIX\tbegin:" << infixBegin << "\tend:" << infixEnd << "\n";
-
-            if (options.reverseComplement)
+            headerWriter.recordNo = idx;
+            it = rewriteRecord(buf, it, fileEnd, format, headerWriter);
+            if (!it && headerWriter.notFound)
             {
-                seqan::Dna5String seqCopy = seq;
-                reverseComplement(seqCopy);
-                reverse(quals);
-                infixEnd = length(seq) - infixEnd;
-                infixBegin = length(seq) - infixBegin;
-                std::swap(infixEnd, infixBegin);
-
-                if (options.outFastq)
-                {
-                    if (writeRecord(*outPtr, id, infix(seqCopy, infixBegin, infixEnd),
-                                    infix(quals, infixBegin, infixEnd), seqan::Fastq()) != 0)
-                    {
-                        std::cerr << "ERROR: Writing record!\n";
-                        return 1;
-                    }
-                }
-                else
-                {
-                    if (writeRecord(*outPtr, id, infix(seqCopy, infixBegin, infixEnd), seqan::Fasta()) != 0)
-                    {
-                        std::cerr << "ERROR: Writing record!\n";
-                        return 1;
-                    }
-                }
+                std::cerr << "ERROR: Record " << idx << " is not in name map " << options.restoreMapPath << "\n";
+                return 1;
             }
-            else
+            if (!it)
             {
-                if (options.outFastq)
-                {
-                    if (writeRecord(*outPtr, id, infix(seq, infixBegin, infixEnd),
-                                    infix(quals, infixBegin, infixEnd), seqan::Fastq()) != 0)
-                    {
-                        std::cerr << "ERROR: Writing record!\n";
-                        return 1;
-                    }
-                }
-                else
-                {
-                    if (writeRecord(*outPtr, id, infix(seq, infixBegin, infixEnd), seqan::Fasta()) != 0)
-                    {
-                        std::cerr << "ERROR: Writing record!\n";
-                        return 1;
-                    }
-                }
+                std::cerr << "ERROR: Invalid record or write error at record " << idx << "\n";
+                return 1;
             }
+            it = skipBlankLines(it, fileEnd);
         }
-
-        // Advance counter idx.
-        idx += 1;
+        if (!headerWriter.byName && idx != mapReader.numRecords)
+        {
+            std::cerr << "ERROR: The input has " << idx << " records but name map " << options.restoreMapPath
+                      << " has " << mapReader.numRecords << "\n";
+            return 1;
+        }
+    }
+    if (flush(buf) != 0)
+    {
+        std::cerr << "ERROR: Could not write output!\n";
+        return 1;
     }
 
     if (options.verbosity >= 2)
-        std::cerr << "Took " << (sysTime() - startTime) << " s\n";
+        std::cerr << (empty(options.restoreMapPath) ? "Renamed " : "Restored ") << idx
+                  << (empty(options.mateInPath) ? " records\n" : " pairs\n")
+                  << "Took " << (sysTime() - startTime) << " s\n";
 
     return 0;
 }
@@ -36,14 +36,45 @@
 // Rewrite of the original sak tool.
 // ==========================================================================
 
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
 #include <sstream>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif  // #ifdef _OPENMP
+
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <seqan/arg_parse.h>
 #include <seqan/basic.h>
+#include <seqan/file.h>
 #include <seqan/modifier.h>
 #include <seqan/sequence.h>
 #include <seqan/stream.h>
 
+#include "adapter_trim.h"
+#include "barcode_matcher.h"
+#include "dedup_set.h"
+#include "index_interval_set.h"
+#include "infix_file.h"
+#include "minimizer.h"
+#include "name_matcher.h"
+#include "output_set.h"
+#include "quality_trim.h"
+#include "random_sampling.h"
+#include "record_index.h"
+#include "record_sorter.h"
+#include "reverse_complement.h"
+
 // --------------------------------------------------------------------------
 // Class FxSakOptions
 // --------------------------------------------------------------------------
@@ -72,23 +103,158 @@ struct FxSakOptions
     __uint64 seqInfixBegin;
     __uint64 seqInfixEnd;
 
+    // Path to file with per-record infixes if not empty.
+    seqan::CharString infixFile;
+
+    // Whether the keys in infixFile are record indices instead of names.
+    bool infixFileIndices;
+
+    // Whether infixFile is in a different order than the records and has to be loaded.
+    bool infixFileUnordered;
+
     // Whether or not to reverse-complement the result.
     bool reverseComplement;
 
     // Maximal length of sequence characters to print.
     __uint64 maxLength;
 
-    // Prefix of read names to output if not empty.
-    seqan::CharString readPattern;
+    // Quality trimming thresholds, 0 to disable.  Leading and trailing bases below trimLeading and trimTrailing are
+    // removed, then the read is cut at the first window of trimWindowSize bases with mean below trimWindowQual, then
+    // BWA-style trimming with trimBwa is applied.
+    int trimLeading;
+    int trimTrailing;
+    unsigned trimWindowSize;
+    int trimWindowQual;
+    int trimBwa;
+
+    // Reads shorter than this after quality trimming are dropped.
+    unsigned trimMinLength;
+
+    // 3' adapters to trim, maximal number of mismatches and minimal overlap at the read end.
+    seqan::String<seqan::CharString> adapters;
+    unsigned adapterErrors;
+    unsigned adapterMinOverlap;
+
+    // Prefixes of read names to output if not empty.
+    seqan::String<seqan::CharString> readPatterns;
+
+    // Path to file with read names to output if not empty.
+    seqan::CharString namesFile;
+
+    // Whether or not the names in namesFile are prefixes.
+    bool namesFilePrefixes;
+
+    // Whether or not to use the record index for seeking to selected sequences.
+    bool useRecordIndex;
+
+    // Path to the record index file.
+    seqan::CharString recordIndexPath;
+
+    // Sample rate of the record index when building it.
+    unsigned recordIndexSampleRate;
+
+    // Number of threads to use.
+    unsigned numThreads;
+
+    // Fraction of the selected records to randomly sample, 1 to disable.
+    double sampleFraction;
+
+    // Number of the selected records to randomly sample, maxValue to disable.
+    __uint64 sampleCount;
+
+    // Seed for random sampling.
+    __uint64 seed;
+
+    // Number of files to split the output into, 0 to disable.
+    unsigned numShards;
+
+    // How to distribute the records to the shards, one of "round-robin", "records", "bases".
+    seqan::CharString splitMode;
+
+    // Whether or not to compress the output with gzip.
+    bool gzip;
+
+    // Path to the barcode sheet for demultiplexing if not empty.
+    seqan::CharString demuxSheet;
+
+    // Number of mismatches allowed in barcodes, 0 or 1.
+    unsigned barcodeMismatches;
+
+    // Sequence window to read the barcode from, maxValue to read it from the identifier.
+    __uint64 barcodeBegin;
+    __uint64 barcodeEnd;
+
+    // Maximal number of output files to keep open at the same time.
+    unsigned maxOpenFiles;
+
+    // k-mer length for --split-mode minimizer.
+    unsigned minimizerK;
+
+    // Remove exact duplicates, one of "" (off), "sequence", "id-sequence".
+    seqan::CharString dedupMode;
+
+    // Number of bits of the record fingerprints, 64 or 128.
+    unsigned dedupHashBits;
+
+    // Memory budget for the fingerprint table in MiB.
+    unsigned dedupMemory;
+
+    // Number of partitions for two-pass deduplication through temporary files, 0 for in-memory deduplication.
+    unsigned dedupPartitions;
+
+    // Directory for temporary files.
+    seqan::CharString tmpDir;
+
+    // Sort the output by key, one of "" (off), "name", "sequence", "length".
+    seqan::CharString sortKey;
+
+    // Memory limit for sorting in MiB.
+    unsigned sortMemory;
 
     FxSakOptions() :
             verbosity(1),
             outFastq(false),
             seqInfixBegin(seqan::maxValue<__uint64>()),
             seqInfixEnd(seqan::maxValue<__uint64>()),
+            infixFileIndices(false),
+            infixFileUnordered(false),
             reverseComplement(false),
-            maxLength(seqan::maxValue<__uint64>())
-    {}
+            maxLength(seqan::maxValue<__uint64>()),
+            trimLeading(0),
+            trimTrailing(0),
+            trimWindowSize(0),
+            trimWindowQual(0),
+            trimBwa(0),
+            trimMinLength(0),
+            adapterErrors(1),
+            adapterMinOverlap(3),
+            namesFilePrefixes(false),
+            useRecordIndex(true),
+            recordIndexSampleRate(1024),
+            numThreads(1),
+            sampleFraction(1),
+            sampleCount(seqan::maxValue<__uint64>()),
+            seed(0),
+            numShards(0),
+            splitMode("round-robin"),
+            gzip(false),
+            barcodeMismatches(1),
+            barcodeBegin(seqan::maxValue<__uint64>()),
+            barcodeEnd(seqan::maxValue<__uint64>()),
+            maxOpenFiles(256),
+            minimizerK(21),
+            dedupHashBits(64),
+            dedupMemory(1024),
+            dedupPartitions(0),
+            tmpDir("/tmp"),
+            sortMemory(1024)
+    {
+        if (getenv("TMPDIR"))
+            tmpDir = getenv("TMPDIR");
+#ifdef _OPENMP
+        numThreads = omp_get_max_threads();
+#endif  // #ifdef _OPENMP
+    }
 };
 
 // --------------------------------------------------------------------------
@@ -155,6 +321,7 @@ parseArgs(FxSakOptions & options,
     
     addUsageLine(parser, "[\\fIOPTIONS\\fP] \\fIIN.fx\\fP");
     addDescription(parser, "\"It slices, it dices and it makes the laundry!\"");
+    addDescription(parser, "\\fIIN.fx\\fP can also be a pipe or \\fI/dev/stdin\\fP.  Such inputs are streamed, the record index is not used and \\fB--sample-count\\fP, \\fB--sort\\fP, \\fB--dedup-partitions\\fP and \\fB--split-mode\\fP \\fIrecords\\fP are not available.");
 
     // The only argument is the input file.
     addArgument(parser, seqan::ArgParseArgument(seqan::ArgParseArgument::INPUTFILE, false, "IN"));
@@ -165,22 +332,78 @@ parseArgs(FxSakOptions & options,
     hideOption(parser, "verbose");
     addOption(parser, seqan::ArgParseOption("vv", "very-verbose", "Very verbose, log to STDERR."));
     hideOption(parser, "very-verbose");
+    addOption(parser, seqan::ArgParseOption("nt", "num-threads", "Number of threads to use.  Default: number of cores.", seqan::ArgParseArgument::INTEGER, false, "NUM"));
 
     addSection(parser, "Output Options");
     addOption(parser, seqan::ArgParseOption("o", "out-path", "Path to the resulting file.  If omitted, result is printed to stdout.", seqan::ArgParseArgument::STRING, false, "FASTX"));
     addOption(parser, seqan::ArgParseOption("q", "qual", "Write output as  FASTQ file."));
     addOption(parser, seqan::ArgParseOption("rc", "revcomp", "Reverse-complement output."));
     addOption(parser, seqan::ArgParseOption("l", "max-length", "Maximal number of sequence characters to write out.", seqan::ArgParseArgument::INTEGER, false, "LEN"));
+    addOption(parser, seqan::ArgParseOption("z", "gzip", "Compress output with GZIP, requires \\fB--out-path\\fP."));
+    addOption(parser, seqan::ArgParseOption("sp", "split", "Split the output into \\fINUM\\fP files in one pass.  The shard number is inserted before the file extension of \\fB--out-path\\fP, e.g. \\fIOUT.fq.gz\\fP becomes \\fIOUT.0.fq.gz\\fP, \\fIOUT.1.fq.gz\\fP, ...", seqan::ArgParseArgument::INTEGER, false, "NUM"));
+    addOption(parser, seqan::ArgParseOption("sm", "split-mode", "How to distribute records to the \\fB--split\\fP files.  \\fIround-robin\\fP: alternating, \\fIrecords\\fP: consecutive runs of equal numbers of input records, i.e. ranges of the input that cannot be combined with selections, \\fB--sample-fraction\\fP or \\fB--dedup\\fP, \\fIbases\\fP: each record goes to the file with the fewest bases so far, \\fIminimizer\\fP: by the hash of the smallest canonical k-mer such that overlapping reads go to the same file.  Default: round-robin.", seqan::ArgParseArgument::STRING, false, "MODE"));
+    setValidValues(parser, "split-mode", "round-robin records bases minimizer");
+    addOption(parser, seqan::ArgParseOption("mk", "minimizer-k", "k-mer length for \\fB--split-mode\\fP \\fIminimizer\\fP, at most 31.  Default: 21.", seqan::ArgParseArgument::INTEGER, false, "K"));
+    addOption(parser, seqan::ArgParseOption("mof", "max-open-files", "Maximal number of output files to keep open with \\fB--split\\fP and \\fB--demux\\fP.  With more outputs, files are reopened for writing each batch of buffered records.  Default: 256.", seqan::ArgParseArgument::INTEGER, false, "NUM"));
+
+    addSection(parser, "Demultiplexing Options");
+    addOption(parser, seqan::ArgParseOption("dx", "demux", "Demultiplex by barcode into one file per sample in one pass.  \\fISHEET\\fP is a tab-separated file with sample name and barcode, a sample may have multiple barcodes.  The sample name is inserted before the file extension of \\fB--out-path\\fP and may only contain the characters A-Z, a-z, 0-9, '.', '_' and '-', records without a (unique) match go to the sample \\fIunmatched\\fP.", seqan::ArgParseArgument::STRING, false, "SHEET"));
+    addOption(parser, seqan::ArgParseOption("bm", "barcode-mismatches", "Number of mismatches allowed in barcodes.  Default: 1.", seqan::ArgParseArgument::INTEGER, false, "NUM"));
+    setValidValues(parser, "barcode-mismatches", "0 1");
+    addOption(parser, seqan::ArgParseOption("bw", "barcode-window", "Read the barcode from the characters \\fIfrom\\fP-\\fIto\\fP (0-based) of the trimmed sequence instead of from the identifier behind the last ':' as in \\fI@NAME 1:N:0:BARCODE\\fP.", seqan::ArgParseArgument::STRING, false, "RANGE"));
 
     addSection(parser, "Filter Options");
     addOption(parser, seqan::ArgParseOption("s", "sequence", "Select the given sequence for extraction by 0-based index.", seqan::ArgParseArgument::INTEGER, true, "NUM"));
     addOption(parser, seqan::ArgParseOption("sn", "sequence-name", "Select sequence with name prefix being \\fINAME\\fP.", seqan::ArgParseArgument::STRING, true, "NAME"));
+    addOption(parser, seqan::ArgParseOption("nf", "names-file", "Select sequences whose name (up to the first whitespace) is listed in \\fIFILE\\fP, one name per line.  A leading '@' or '>' is ignored.", seqan::ArgParseArgument::STRING, false, "FILE"));
+    addOption(parser, seqan::ArgParseOption("np", "names-prefix", "Interpret the names from \\fB--names-file\\fP as name prefixes."));
     addOption(parser, seqan::ArgParseOption("ss", "sequences", "Select sequences \\fIfrom\\fP-\\fIto\\fP where \\fIfrom\\fP and \\fIto\\fP are 0-based indices.", seqan::ArgParseArgument::STRING, true, "RANGE"));
     addOption(parser, seqan::ArgParseOption("i", "infix", "Select characters \\fIfrom\\fP-\\fIto\\fP where \\fIfrom\\fP and \\fIto\\fP are 0-based indices.'", seqan::ArgParseArgument::STRING, true, "RANGE"));
+    addOption(parser, seqan::ArgParseOption("if", "infix-file", "Select characters per record from a tab-separated file with the columns name (first word of the identifier), 0-based begin and end position.  Overrides \\fB--infix\\fP for the records listed.  By default, the file is read alongside the input and must have one line for each written record, in the order they are written.  With \\fB--infix-file-indices\\fP, records may be left out.", seqan::ArgParseArgument::STRING, false, "TSV"));
+    addOption(parser, seqan::ArgParseOption("ifi", "infix-file-indices", "The first column of \\fB--infix-file\\fP holds 0-based record indices instead of names."));
+    addOption(parser, seqan::ArgParseOption("ifu", "infix-file-unordered", "Load \\fB--infix-file\\fP into a hash table, it can then be in any order."));
+
+    addSection(parser, "Quality Trimming Options");
+    addOption(parser, seqan::ArgParseOption("tl", "trim-leading", "Remove leading bases with quality below \\fIQUAL\\fP.  Trimming is done before \\fB--infix\\fP and \\fB--revcomp\\fP are applied.", seqan::ArgParseArgument::INTEGER, false, "QUAL"));
+    addOption(parser, seqan::ArgParseOption("tt", "trim-trailing", "Remove trailing bases with quality below \\fIQUAL\\fP.", seqan::ArgParseArgument::INTEGER, false, "QUAL"));
+    addOption(parser, seqan::ArgParseOption("tw", "trim-window", "Cut the read at the first window of \\fISIZE\\fP bases with a mean quality below \\fIQUAL\\fP.", seqan::ArgParseArgument::STRING, false, "SIZE:QUAL"));
+    addOption(parser, seqan::ArgParseOption("tb", "trim-bwa", "BWA-style trimming of the 3' end with threshold \\fIQUAL\\fP.", seqan::ArgParseArgument::INTEGER, false, "QUAL"));
+    addOption(parser, seqan::ArgParseOption("tm", "trim-min-length", "Drop reads shorter than \\fILEN\\fP after quality and adapter trimming.  Default: 0.", seqan::ArgParseArgument::INTEGER, false, "LEN"));
+
+    addSection(parser, "Adapter Trimming Options");
+    addOption(parser, seqan::ArgParseOption("a", "adapter", "Cut reads at the first occurrence of the 3' adapter \\fISEQ\\fP or, at the read end, of a prefix of it.  Can be given multiple times, all adapters are searched at once.  Applied after quality trimming.", seqan::ArgParseArgument::STRING, true, "SEQ"));
+    addOption(parser, seqan::ArgParseOption("ae", "adapter-errors", "Maximal number of mismatches in an adapter match.  Partial matches of \\fIl\\fP of the \\fIm\\fP adapter characters may have \\fIl\\fP * \\fINUM\\fP / \\fIm\\fP mismatches.  Default: 1.", seqan::ArgParseArgument::INTEGER, false, "NUM"));
+    addOption(parser, seqan::ArgParseOption("ao", "adapter-min-overlap", "Minimal length of a partial adapter match at the read end.  Default: 3.", seqan::ArgParseArgument::INTEGER, false, "LEN"));
+
+    addSection(parser, "Sampling Options");
+    addOption(parser, seqan::ArgParseOption("sf", "sample-fraction", "Randomly sample each selected sequence with probability \\fIFRAC\\fP.", seqan::ArgParseArgument::DOUBLE, false, "FRAC"));
+    addOption(parser, seqan::ArgParseOption("sc", "sample-count", "Randomly sample \\fINUM\\fP of the selected sequences, after deduplication and dropping sequences shorter than \\fB--trim-min-length\\fP.  The sampled sequences are kept in memory as file offsets only and written in input order at the end.", seqan::ArgParseArgument::INTEGER, false, "NUM"));
+    addOption(parser, seqan::ArgParseOption("sd", "seed", "Seed for random sampling.  Use the same seed for both files of a pair to sample the same records.  Default: 0.", seqan::ArgParseArgument::INTEGER, false, "NUM"));
+
+    addSection(parser, "Deduplication Options");
+    addOption(parser, seqan::ArgParseOption("dd", "dedup", "Remove exact duplicates of selected records, comparing the \\fIsequence\\fP or the first word of the identifier and the sequence (\\fIid-sequence\\fP).  The first occurrence is kept.", seqan::ArgParseArgument::STRING, false, "MODE"));
+    setValidValues(parser, "dedup", "sequence id-sequence");
+    addOption(parser, seqan::ArgParseOption("db", "dedup-hash-bits", "Number of bits of the record fingerprints.  Default: 64.", seqan::ArgParseArgument::INTEGER, false, "NUM"));
+    setValidValues(parser, "dedup-hash-bits", "64 128");
+    addOption(parser, seqan::ArgParseOption("dm", "dedup-memory", "Memory budget for the fingerprint table in MiB.  Default: 1024.", seqan::ArgParseArgument::INTEGER, false, "MIB"));
+    addOption(parser, seqan::ArgParseOption("dp", "dedup-partitions", "Find duplicates in a first pass, partitioning the fingerprints into \\fINUM\\fP temporary files that are processed one at a time.  Use this if the fingerprints do not fit into the memory budget.  Default: 0 (one pass in memory).", seqan::ArgParseArgument::INTEGER, false, "NUM"));
+    addOption(parser, seqan::ArgParseOption("td", "tmp-dir", "Directory for temporary files.  Default: $TMPDIR or /tmp.", seqan::ArgParseArgument::STRING, false, "DIR"));
+
+    addSection(parser, "Sorting Options");
+    addOption(parser, seqan::ArgParseOption("so", "sort", "Sort the output by the full identifier (\\fIname\\fP), the \\fIsequence\\fP or the sequence \\fIlength\\fP.  Records with equal keys keep their input order.  Sorted runs that exceed \\fB--sort-memory\\fP are written to \\fB--tmp-dir\\fP and merged.", seqan::ArgParseArgument::STRING, false, "KEY"));
+    setValidValues(parser, "sort", "name sequence length");
+    addOption(parser, seqan::ArgParseOption("som", "sort-memory", "Memory limit for sorting in MiB.  Default: 1024.", seqan::ArgParseArgument::INTEGER, false, "MIB"));
+
+    addSection(parser, "Record Index Options");
+    addOption(parser, seqan::ArgParseOption("ri", "record-index-file", "Path to the record index file used for seeking to sequences selected by index.  It is built on first use.  Defaults to \\fIIN.fx\\fP.ridx", seqan::ArgParseArgument::STRING, false, "RIDX"));
+    addOption(parser, seqan::ArgParseOption("nri", "no-record-index", "Do not use or build a record index, read from the beginning of the file."));
+    addOption(parser, seqan::ArgParseOption("rs", "record-index-sample-rate", "Store the offset of every \\fINUM\\fP-th record when building the record index.  Default: 1024.", seqan::ArgParseArgument::INTEGER, false, "NUM"));
 
     addTextSection(parser, "Usage Examples");
     addListItem(parser, "\\fBfx_sak\\fP \\fB-s\\fP \\fI10\\fP \\fIIN.fa\\fP", "Cut out 11th sequence from \\fIIN.fa\\fP and write to stdout as FASTA.");
     addListItem(parser, "\\fBfx_sak\\fP \\fB-q\\fP \\fB-ss\\fP \\fI10-12\\fP \\fB-ss\\fP \\fI100-200\\fP \\fIIN.fq\\fP", "Cut out 11th up to and including 12th and 101th up to and including 199th sequence from \\fIIN.fq\\fP and write to stdout as FASTQ.");
+    addListItem(parser, "\\fBfx_sak\\fP \\fB-q\\fP \\fB-z\\fP \\fB--split\\fP \\fI16\\fP \\fB-o\\fP \\fIOUT.fq.gz\\fP \\fIIN.fq\\fP", "Distribute the records of \\fIIN.fq\\fP round-robin to the 16 files \\fIOUT.0.fq.gz\\fP up to \\fIOUT.15.fq.gz\\fP.");
+    addListItem(parser, "\\fBfx_sak\\fP \\fB-q\\fP \\fB-sf\\fP \\fI0.01\\fP \\fB--seed\\fP \\fI7\\fP \\fB-o\\fP \\fIOUT_1.fq\\fP \\fIIN_1.fq\\fP", "Randomly sample 1% of the records of \\fIIN_1.fq\\fP.  Running the same command on \\fIIN_2.fq\\fP selects the mates of these records.");
 
     seqan::ArgumentParser::ParseResult res = parse(parser, argc, argv);
 
@@ -203,7 +426,7 @@ parseArgs(FxSakOptions & options,
             std::vector<std::string> sequenceIds = getOptionValues(parser, "sequence");
             for (unsigned i = 0; i < seqan::length(sequenceIds); ++i)
             {
-                unsigned idx = 0;
+                __uint64 idx = 0;
                 if (!seqan::lexicalCast2(idx, sequenceIds[i]))
                 {
                     std::cerr << "ERROR: Invalid sequence index " << sequenceIds[i] << "\n";
@@ -219,7 +442,7 @@ parseArgs(FxSakOptions & options,
             seqan::CharString buffer;
             for (unsigned i = 0; i < seqan::length(sequenceRanges); ++i)
             {
-                seqan::Pair<__uint64> range;
+                seqan::Pair<__uint64> range(0, seqan::maxValue<__uint64>());  // Only FROM given: up to the end.
                 if (!parseRange(range.i1, range.i2, sequenceRanges[i]))
                 {
                     std::cerr << "ERROR: Invalid range " << sequenceRanges[i] << "\n";
@@ -240,13 +463,201 @@ parseArgs(FxSakOptions & options,
             }
         }
 
+        if (isSet(parser, "infix-file"))
+            getOptionValue(options.infixFile, parser, "infix-file");
+        options.infixFileIndices = isSet(parser, "infix-file-indices");
+        options.infixFileUnordered = isSet(parser, "infix-file-unordered");
+
         options.reverseComplement = isSet(parser, "revcomp");
         
         if (isSet(parser, "max-length"))
             getOptionValue(options.maxLength, parser, "max-length");
 
+        if (isSet(parser, "trim-leading"))
+            getOptionValue(options.trimLeading, parser, "trim-leading");
+        if (isSet(parser, "trim-trailing"))
+            getOptionValue(options.trimTrailing, parser, "trim-trailing");
+        if (isSet(parser, "trim-bwa"))
+            getOptionValue(options.trimBwa, parser, "trim-bwa");
+        if (isSet(parser, "trim-min-length"))
+            getOptionValue(options.trimMinLength, parser, "trim-min-length");
+        if (isSet(parser, "trim-window"))
+        {
+            std::string buffer;
+            getOptionValue(buffer, parser, "trim-window");
+            size_t colon = buffer.find(':');
+            if (colon == std::string::npos ||
+                !seqan::lexicalCast2(options.trimWindowSize, buffer.substr(0, colon)) ||
+                !seqan::lexicalCast2(options.trimWindowQual, buffer.substr(colon + 1)) ||
+                options.trimWindowSize == 0u)
+            {
+                std::cerr << "ERROR: Invalid trimming window " << buffer << "\n";
+                return seqan::ArgumentParser::PARSE_ERROR;
+            }
+        }
+        if (isSet(parser, "adapter"))
+        {
+            std::vector<std::string> adapters = getOptionValues(parser, "adapter");
+            for (unsigned i = 0; i < adapters.size(); ++i)
+                appendValue(options.adapters, adapters[i]);
+        }
+        if (isSet(parser, "adapter-errors"))
+            getOptionValue(options.adapterErrors, parser, "adapter-errors");
+        if (isSet(parser, "adapter-min-overlap"))
+            getOptionValue(options.adapterMinOverlap, parser, "adapter-min-overlap");
+
+        if (options.trimLeading < 0 || options.trimTrailing < 0 || options.trimWindowQual < 0 || options.trimBwa < 0)
+        {
+            std::cerr << "ERROR: Quality thresholds must not be negative.\n";
+            return seqan::ArgumentParser::PARSE_ERROR;
+        }
+
         if (isSet(parser, "sequence-name"))
-            getOptionValue(options.readPattern, parser, "sequence-name");
+        {
+            std::vector<std::string> sequenceNames = getOptionValues(parser, "sequence-name");
+            for (unsigned i = 0; i < seqan::length(sequenceNames); ++i)
+                appendValue(options.readPatterns, sequenceNames[i]);
+        }
+
+        if (isSet(parser, "names-file"))
+            getOptionValue(options.namesFile, parser, "names-file");
+        options.namesFilePrefixes = isSet(parser, "names-prefix");
+
+        if (isSet(parser, "num-threads"))
+            getOptionValue(options.numThreads, parser, "num-threads");
+
+        if (isSet(parser, "sample-fraction"))
+            getOptionValue(options.sampleFraction, parser, "sample-fraction");
+        if (isSet(parser, "sample-count"))
+            getOptionValue(options.sampleCount, parser, "sample-count");
+        if (isSet(parser, "seed"))
+            getOptionValue(options.seed, parser, "seed");
+        if (options.sampleFraction < 0 || options.sampleFraction > 1)
+        {
+            std::cerr << "ERROR: The sample fraction must be in [0, 1].\n";
+            return seqan::ArgumentParser::PARSE_ERROR;
+        }
+        if (isSet(parser, "sample-fraction") && isSet(parser, "sample-count"))
+        {
+            std::cerr << "ERROR: Only one of --sample-fraction and --sample-count can be given.\n";
+            return seqan::ArgumentParser::PARSE_ERROR;
+        }
+
+        options.gzip = isSet(parser, "gzip");
+#if !SEQAN_HAS_ZLIB
+        if (options.gzip)
+        {
+            std::cerr << "ERROR: --gzip is not available, fx_sak was built without zlib.\n";
+            return seqan::ArgumentParser::PARSE_ERROR;
+        }
+#endif  // #if !SEQAN_HAS_ZLIB
+        if (isSet(parser, "split"))
+            getOptionValue(options.numShards, parser, "split");
+        if (isSet(parser, "split-mode"))
+            getOptionValue(options.splitMode, parser, "split-mode");
+        if (isSet(parser, "minimizer-k"))
+            getOptionValue(options.minimizerK, parser, "minimizer-k");
+        if (options.minimizerK == 0u || options.minimizerK > 31u)
+        {
+            std::cerr << "ERROR: --minimizer-k must be in 1..31.\n";
+            return seqan::ArgumentParser::PARSE_ERROR;
+        }
+        if (isSet(parser, "split") && options.numShards == 0u)
+        {
+            std::cerr << "ERROR: The number of split files must be positive.\n";
+            return seqan::ArgumentParser::PARSE_ERROR;
+        }
+        if (isSet(parser, "split-mode") && !isSet(parser, "split"))
+        {
+            std::cerr << "ERROR: --split-mode requires --split.\n";
+            return seqan::ArgumentParser::PARSE_ERROR;
+        }
+        if (isSet(parser, "minimizer-k") && (!isSet(parser, "split") || options.splitMode != "minimizer"))
+        {
+            std::cerr << "ERROR: --minimizer-k requires --split and --split-mode minimizer.\n";
+            return seqan::ArgumentParser::PARSE_ERROR;
+        }
+        if (isSet(parser, "max-open-files"))
+            getOptionValue(options.maxOpenFiles, parser, "max-open-files");
+        if (isSet(parser, "demux"))
+            getOptionValue(options.demuxSheet, parser, "demux");
+        if (isSet(parser, "barcode-mismatches"))
+            getOptionValue(options.barcodeMismatches, parser, "barcode-mismatches");
+        if (isSet(parser, "barcode-window"))
+        {
+            seqan::CharString buffer;
+            getOptionValue(buffer, parser, "barcode-window");
+            if (!parseRange(options.barcodeBegin, options.barcodeEnd, buffer) ||
+                options.barcodeEnd == seqan::maxValue<__uint64>() || options.barcodeBegin == options.barcodeEnd)
+            {
+                std::cerr << "ERROR: Invalid barcode window " << buffer << "\n";
+                return seqan::ArgumentParser::PARSE_ERROR;
+            }
+        }
+        if ((options.gzip || options.numShards > 0u || !empty(options.demuxSheet)) && empty(options.outPath))
+        {
+            std::cerr << "ERROR: --gzip, --split and --demux require --out-path.\n";
+            return seqan::ArgumentParser::PARSE_ERROR;
+        }
+        if (options.numShards > 0u && !empty(options.demuxSheet))
+        {
+            std::cerr << "ERROR: Only one of --split and --demux can be given.\n";
+            return seqan::ArgumentParser::PARSE_ERROR;
+        }
+
+        if (isSet(parser, "dedup"))
+            getOptionValue(options.dedupMode, parser, "dedup");
+        if (isSet(parser, "dedup-hash-bits"))
+            getOptionValue(options.dedupHashBits, parser, "dedup-hash-bits");
+        if (isSet(parser, "dedup-memory"))
+            getOptionValue(options.dedupMemory, parser, "dedup-memory");
+        if (isSet(parser, "dedup-partitions"))
+            getOptionValue(options.dedupPartitions, parser, "dedup-partitions");
+        if (isSet(parser, "tmp-dir"))
+            getOptionValue(options.tmpDir, parser, "tmp-dir");
+
+        if (isSet(parser, "sort"))
+            getOptionValue(options.sortKey, parser, "sort");
+        if (isSet(parser, "sort-memory"))
+            getOptionValue(options.sortMemory, parser, "sort-memory");
+
+        // Runs of records are ranges of input record indices, they would be unbalanced if records are filtered out
+        // in between.
+        if (options.numShards > 0u && options.splitMode == "records" &&
+            (!empty(options.seqIndices) || !empty(options.seqIndexRanges) || !empty(options.readPatterns) ||
+             !empty(options.namesFile) || options.sampleFraction < 1 || !empty(options.dedupMode)))
+        {
+            std::cerr << "ERROR: --split-mode records cannot be used with sequence selections, --sample-fraction or "
+                      << "--dedup.\n";
+            return seqan::ArgumentParser::PARSE_ERROR;
+        }
+
+        // Sorted and count-sampled records are written at the end when the record indices are not known anymore and
+        // not in input order if sorted.
+        if (!empty(options.infixFile) && options.infixFileIndices &&
+            (!empty(options.sortKey) || isSet(parser, "sample-count")))
+        {
+            std::cerr << "ERROR: --infix-file-indices cannot be used with --sort or --sample-count.\n";
+            return seqan::ArgumentParser::PARSE_ERROR;
+        }
+        if (!empty(options.infixFile) && !options.infixFileUnordered && !empty(options.sortKey))
+        {
+            std::cerr << "ERROR: --infix-file with --sort requires --infix-file-unordered.\n";
+            return seqan::ArgumentParser::PARSE_ERROR;
+        }
+
+        options.useRecordIndex = !isSet(parser, "no-record-index");
+        options.recordIndexPath = options.inFastxPath;
+        append(options.recordIndexPath, ".ridx");
+        if (isSet(parser, "record-index-file"))
+            getOptionValue(options.recordIndexPath, parser, "record-index-file");
+        if (isSet(parser, "record-index-sample-rate"))
+            getOptionValue(options.recordIndexSampleRate, parser, "record-index-sample-rate");
+        if (options.recordIndexSampleRate == 0u)
+        {
+            std::cerr << "ERROR: The record index sample rate must be positive.\n";
+            return seqan::ArgumentParser::PARSE_ERROR;
+        }
     }
 
     return res;
@@ -265,225 +676,1494 @@ char const * yesNo(bool b)
 }
 
 // ---------------------------------------------------------------------------
-// Function main()
+// Function buildNameMatcher()
 // ---------------------------------------------------------------------------
 
-int main(int argc, char const ** argv)
-{
-    double startTime = 0;
-    
-    // Parse command line.
-    FxSakOptions options;
-    seqan::ArgumentParser::ParseResult res = parseArgs(options, argc, argv);
-    if (res != seqan::ArgumentParser::PARSE_OK)
-        return res == seqan::ArgumentParser::PARSE_ERROR;  // 1 on errors, 0 otherwise
+// Build name matcher from the --sequence-name prefixes and the --names-file.  Returns 0 on success, 1 on errors.
 
-    // -----------------------------------------------------------------------
-    // Show options.
-    // -----------------------------------------------------------------------
-    if (options.verbosity >= 2)
-    {
-        std::cerr << "____OPTIONS___________________________________________________________________\n"
-                  << "\n"
-                  << "VERBOSITY    " << options.verbosity << "\n"
-                  << "IN           " << options.inFastxPath << "\n"
-                  << "OUT          " << options.outPath << "\n"
-                  << "FASTQ OUT    " << yesNo(options.outFastq) << "\n"
-                  << "INFIX BEGIN  " << options.seqInfixBegin << "\n"
-                  << "INFIX END    " << options.seqInfixEnd << "\n"
-                  << "MAX LEN      " << options.maxLength << "\n"
-                  << "READ PATTERN " << options.readPattern << "\n"
-                  << "REVCOMP      " << yesNo(options.reverseComplement) << "\n"
-                  << "SEQUENCES\n";
-        for (unsigned i = 0; i < length(options.seqIndices); ++i)
-            std::cerr << "  SEQ  " << options.seqIndices[i] << "\n";
-        for (unsigned i = 0; i < length(options.seqIndexRanges); ++i)
-            std::cerr << "  SEQS " << options.seqIndexRanges[i].i1 << "-" << options.seqIndexRanges[i].i2 << "\n";
-    }
+int buildNameMatcher(NameMatcher & matcher, FxSakOptions const & options)
+{
+    for (unsigned i = 0; i < length(options.readPatterns); ++i)
+        insert(matcher.prefixes, begin(options.readPatterns[i], seqan::Standard()), length(options.readPatterns[i]));
 
-    // -----------------------------------------------------------------------
-    // Open Files.
-    // -----------------------------------------------------------------------
-    std::ostream * outPtr = & std::cout;
-    std::fstream inStream;
-    if (!empty(options.inFastxPath))
+    if (!empty(options.namesFile))
     {
-        inStream.open(toCString(options.inFastxPath), std::ios::binary | std::ios::in);
-        if (!inStream.good())
+        std::ifstream namesStream(toCString(options.namesFile), std::ios::binary | std::ios::in);
+        if (!namesStream.good())
         {
-            std::cerr << "ERROR: Could not open input file " << options.inFastxPath << "\n";
+            std::cerr << "ERROR: Could not open names file " << options.namesFile << "\n";
             return 1;
         }
-    }
-    std::fstream outStream;
-    if (!empty(options.outPath))
-    {
-        outStream.open(toCString(options.outPath), std::ios::binary | std::ios::in);
-        if (!outStream.good())
+        seqan::RecordReader<std::ifstream, seqan::SinglePass<> > reader(namesStream);
+        seqan::CharString line;
+        while (!atEnd(reader))
         {
-            std::cerr << "ERROR: Could not open output file " << options.outPath << "\n";
-            return 1;
+            clear(line);
+            int res = readLine(line, reader);
+            if (res != 0 && res != seqan::EOF_BEFORE_SUCCESS)
+            {
+                std::cerr << "ERROR: Could not read names file " << options.namesFile << "\n";
+                return 1;
+            }
+            char const * ptr = begin(line, seqan::Standard());
+            size_t len = length(line);
+            if (len > 0u && (ptr[0] == '@' || ptr[0] == '>'))
+                ++ptr, --len;
+            len = firstWordLength(ptr, len);
+            if (len == 0u)
+                continue;  // Skip empty lines.
+            if (options.namesFilePrefixes)
+                insert(matcher.prefixes, ptr, len);
+            else
+                insert(matcher.names, ptr, len);
         }
-        outPtr = &outStream;
     }
 
-    // Compute index of last sequence to write if any.
-    __uint64 endIdx = seqan::maxValue<__uint64>();
-    for (unsigned i = 0; i < length(options.seqIndices); ++i)
-        if (endIdx == seqan::maxValue<__uint64>() || endIdx > options.seqIndices[i] + 1)
-            endIdx = options.seqIndices[i] + 1;
-    for (unsigned i = 0; i < length(options.seqIndexRanges); ++i)
-        if (endIdx == seqan::maxValue<__uint64>() || endIdx > options.seqIndexRanges[i].i2)
-            endIdx = options.seqIndexRanges[i].i2;
-    if (options.verbosity >= 2)
-        std::cerr << "Sequence end idx: " << endIdx << "\n";
-    
-    // -----------------------------------------------------------------------
-    // Read and Write Filtered.
-    // -----------------------------------------------------------------------
-    startTime = sysTime();
-    seqan::RecordReader<std::fstream, seqan::SinglePass<> > reader(inStream);
-    seqan::AutoSeqStreamFormat tagSelector;
-    if (!checkStreamFormat(reader, tagSelector) || (tagSelector.tagId != 1 && tagSelector.tagId != 2))
+    build(matcher.prefixes);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Function loadBarcodeSheet()
+// ---------------------------------------------------------------------------
+
+// Load the --demux sheet into matcher, the sample names are appended to sampleNames in the order of their ids.
+// Returns 0 on success, 1 on errors.
+
+int loadBarcodeSheet(BarcodeMatcher & matcher,
+                     seqan::String<seqan::CharString> & sampleNames,
+                     FxSakOptions const & options)
+{
+    std::ifstream sheet(toCString(options.demuxSheet), std::ios::binary | std::ios::in);
+    if (!sheet.good())
     {
-        std::cerr << "ERROR: Could not determine input format!\n";
+        std::cerr << "ERROR: Could not open barcode sheet " << options.demuxSheet << "\n";
         return 1;
     }
 
-    unsigned idx = 0;
-    __uint64 charsWritten = 0;
-    seqan::CharString id;
-    seqan::CharString seq;
-    seqan::CharString quals;
-    while (!atEnd(reader) && charsWritten < options.maxLength && idx < endIdx)
+    std::map<std::string, __uint32> sampleIds;
+    std::map<std::string, std::string> sampleKeys;  // lower case name => name
+    std::string line;
+    for (unsigned lineNo = 1; std::getline(sheet, line); ++lineNo)
     {
-        if (tagSelector.tagId == 1)
+        if (!line.empty() && line[line.size() - 1] == '\r')
+            line.resize(line.size() - 1);
+        if (line.empty() || line[0] == '#')
+            continue;
+        size_t tab = line.find('\t');
+        if (tab == 0u || tab == std::string::npos || tab + 1 == line.size())
         {
-            // FASTA.
-            if (readRecord(id, seq, reader, seqan::Fasta()) != 0)
-            {
-                std::cerr << "ERROR: Reading record!\n";
-                return 1;
-            }
-            if (options.outFastq)
-                resize(quals, length(seq), 'I');
+            std::cerr << "ERROR: Invalid line " << lineNo << " in barcode sheet " << options.demuxSheet << "\n";
+            return 1;
         }
-        else
+        std::string name = line.substr(0, tab);
+        // The sample names become part of the output paths.
+        std::string key = name;
+        for (unsigned i = 0; i < key.size(); ++i)
         {
-            // FASTQ
-            if (readRecord(id, seq, quals, reader, seqan::Fastq()) != 0)
+            if (!isalnum((unsigned char)key[i]) && key[i] != '.' && key[i] != '_' && key[i] != '-')
             {
-                std::cerr << "ERROR: Reading record!\n";
+                std::cerr << "ERROR: Invalid sample name \"" << name << "\" in line " << lineNo << " of barcode sheet "
+                          << options.demuxSheet << ", only A-Z, a-z, 0-9, '.', '_' and '-' are allowed.\n";
                 return 1;
             }
+            key[i] = tolower(key[i]);
         }
-
-        // Check whether to write out sequence.
-        bool writeOut = false;
-        if (empty(options.seqIndices) && empty(options.seqIndexRanges))
-            writeOut = true;
-        // One of options.seqIndices.
-        if (!writeOut)
+        if (name == "." || name == "..")
         {
-            for (unsigned i = 0; i < length(options.seqIndices); ++i)
-            {
-                if (options.seqIndices[i] == idx)
-                {
-                    writeOut = true;
-                    break;
-                }
-            }
+            std::cerr << "ERROR: Invalid sample name \"" << name << "\" in line " << lineNo << " of barcode sheet "
+                      << options.demuxSheet << "\n";
+            return 1;
         }
-        // One of options.seqIndexRanges.
-        if (!writeOut)
+        if (key == "unmatched")
         {
-            for (unsigned i = 0; i < length(options.seqIndexRanges); ++i)
-            {
-                if (idx >= options.seqIndexRanges[i].i1 && idx < options.seqIndexRanges[i].i2)
-                {
-                    writeOut = true;
-                    break;
-                }
-            }
+            std::cerr << "ERROR: The sample name \"unmatched\" is reserved.\n";
+            return 1;
         }
-        // Name pattern matches.
-        if (!writeOut && !empty(options.readPattern))
-        {
-            unsigned l = length(options.readPattern);
-            if (l > length(id))
-                l = length(id);
-            if (prefix(id, l) == prefix(options.readPattern, l))
-                writeOut = true;
-        }
-
-        // Write out if we want this.
-        if (writeOut)
-        {
-            // Get begin and end index of infix to write out.
-            __uint64 infixBegin = 0;
-            if (options.seqInfixBegin != seqan::maxValue<__uint64>())
-                infixBegin = options.seqInfixBegin;
-            if (infixBegin > length(seq))
-                infixBegin = length(seq);
-            __uint64 infixEnd = length(seq);
-            if (options.seqInfixEnd < length(seq))
-                infixEnd = options.seqInfixEnd;
-            if (infixEnd < infixBegin)
-                infixEnd = infixBegin;
-            if (options.verbosity >= 3)
-                std::cerr << "INFIX\tbegin:" << infixBegin << "\tend:" << infixEnd << "\n";
-
-            if (options.reverseComplement)
-            {
-                seqan::Dna5String seqCopy = seq;
-                reverseComplement(seqCopy);
-                reverse(quals);
-                infixEnd = length(seq) - infixEnd;
-                infixBegin = length(seq) - infixBegin;
-                std::swap(infixEnd, infixBegin);
-
-                if (options.outFastq)
-                {
-                    if (writeRecord(*outPtr, id, infix(seqCopy, infixBegin, infixEnd),
-                                    infix(quals, infixBegin, infixEnd), seqan::Fastq()) != 0)
-                    {
-                        std::cerr << "ERROR: Writing record!\n";
-                        return 1;
-                    }
-                }
-                else
-                {
-                    if (writeRecord(*outPtr, id, infix(seqCopy, infixBegin, infixEnd), seqan::Fasta()) != 0)
-                    {
-                        std::cerr << "ERROR: Writing record!\n";
-                        return 1;
-                    }
-                }
-            }
-            else
-            {
-                if (options.outFastq)
-                {
-                    if (writeRecord(*outPtr, id, infix(seq, infixBegin, infixEnd),
-                                    infix(quals, infixBegin, infixEnd), seqan::Fastq()) != 0)
-                    {
-                        std::cerr << "ERROR: Writing record!\n";
-                        return 1;
-                    }
-                }
-                else
-                {
-                    if (writeRecord(*outPtr, id, infix(seq, infixBegin, infixEnd), seqan::Fasta()) != 0)
-                    {
-                        std::cerr << "ERROR: Writing record!\n";
-                        return 1;
-                    }
-                }
-            }
+        // Names that only differ in case would share an output file on case-insensitive file systems.
+        std::map<std::string, std::string>::const_iterator itKey = sampleKeys.find(key);
+        if (itKey != sampleKeys.end() && itKey->second != name)
+        {
+            std::cerr << "ERROR: The sample names \"" << itKey->second << "\" and \"" << name
+                      << "\" in barcode sheet " << options.demuxSheet << " only differ in case.\n";
+            return 1;
+        }
+        if (!sampleIds.count(name))
+        {
+            sampleKeys[key] = name;
+            sampleIds[name] = length(sampleNames);
+            appendValue(sampleNames, seqan::CharString(name.c_str()));
         }
+        insert(matcher, line.data() + tab + 1, line.size() - tab - 1, sampleIds[name]);
+    }
 
-        // Advance counter idx.
-        idx += 1;
+    if (build(matcher, options.barcodeMismatches) != 0)
+    {
+        std::cerr << "ERROR: Different samples have the same barcode in " << options.demuxSheet << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Function loadOrBuildRecordIndex()
+// ---------------------------------------------------------------------------
+
+// Load the record index for the memory mapped input file [fileBegin, fileEnd), build and save it if it does not exist,
+// is stale or was built with a different sample rate.  Returns 0 on success, 1 on errors.
+
+int loadOrBuildRecordIndex(RecordIndex & recordIndex,
+                           char const * fileBegin,
+                           char const * fileEnd,
+                           FxSakOptions const & options)
+{
+    if (load(recordIndex, toCString(options.recordIndexPath)) == 0 &&
+        recordIndex.fileSize == (__uint64)(fileEnd - fileBegin) &&
+        recordIndex.sampleRate == options.recordIndexSampleRate)
+        return 0;
+
+    double startTime = sysTime();
+    if (options.verbosity >= 2)
+        std::cerr << "Building record index " << options.recordIndexPath << " ...";
+    if (build(recordIndex, fileBegin, fileEnd, options.recordIndexSampleRate, options.numThreads) != 0)
+    {
+        std::cerr << "ERROR: Could not build record index for " << options.inFastxPath << "\n";
+        return 1;
+    }
+    if (options.verbosity >= 2)
+        std::cerr << " OK\nTook " << (sysTime() - startTime) << " s\n";
+
+    // Not being able to write the index is no reason to stop, we can still use it for this run.
+    if (save(recordIndex, toCString(options.recordIndexPath)) != 0)
+        std::cerr << "WARNING: Could not write record index to " << options.recordIndexPath << "\n";
+
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Class FxSakRecord
+// ---------------------------------------------------------------------------
+
+// Buffers for the record that is currently processed.
+
+struct FxSakRecord
+{
+    seqan::CharString id;
+    seqan::CharString seq;
+    seqan::CharString quals;
+
+    // Infix of this record, overriding the one from the options if not maxValue.
+    __uint64 infixBegin;
+    __uint64 infixEnd;
+
+    FxSakRecord() : infixBegin(seqan::maxValue<__uint64>()), infixEnd(seqan::maxValue<__uint64>())
+    {}
+};
+
+// ---------------------------------------------------------------------------
+// Function readSakRecord()
+// ---------------------------------------------------------------------------
+
+// Parse the record in [first, last) into record.  Qualities of FASTA records are filled with 'I' if fillQuals is
+// true.  Returns 0 on success, 1 on errors.
+
+int readSakRecord(FxSakRecord & record,
+                  char const * first,
+                  char const * last,
+                  RawRecordFormat format,
+                  bool fillQuals)
+{
+    seqan::Stream<seqan::CharArray<char const *> > recordStream(first, last);
+    seqan::RecordReader<seqan::Stream<seqan::CharArray<char const *> >, seqan::SinglePass<> > reader(recordStream);
+    if (format == RAW_FORMAT_FASTA)
+    {
+        if (readRecord(record.id, record.seq, reader, seqan::Fasta()) != 0)
+            return 1;
+        if (fillQuals)
+            resize(record.quals, length(record.seq), 'I');
+    }
+    else
+    {
+        if (readRecord(record.id, record.seq, record.quals, reader, seqan::Fastq()) != 0)
+            return 1;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Class InputWindow
+// ---------------------------------------------------------------------------
+
+// Inputs that cannot be memory mapped (pipes, process substitution, /dev/stdin) are streamed through a window that
+// holds at least the current record.  The records are then scanned exactly as in a memory mapped file but the buffer
+// moves, so byte offsets into the input are not available.
+
+struct InputWindow
+{
+    // Stream to read from, NULL for memory mapped inputs.
+    std::istream * in;
+    seqan::CharString buffer;
+    bool atEnd;
+    bool failed;
+
+    InputWindow() : in(0), atEnd(false), failed(false)
+    {}
+};
+
+// ---------------------------------------------------------------------------
+// Function readMore()                                          [InputWindow]
+// ---------------------------------------------------------------------------
+
+// Move [it, fileEnd) to the front of the buffer and append the next chunk of the input.  it, fileBegin and fileEnd
+// are updated to point into the moved buffer.
+
+void readMore(InputWindow & window, char const * & it, char const * & fileBegin, char const * & fileEnd)
+{
+    size_t const CHUNK_SIZE = 1024 * 1024;
+    size_t keep = fileEnd - it;
+    memmove(begin(window.buffer, seqan::Standard()), it, keep);
+    resize(window.buffer, keep + CHUNK_SIZE);
+    window.in->read(begin(window.buffer, seqan::Standard()) + keep, CHUNK_SIZE);
+    size_t numRead = window.in->gcount();
+    window.atEnd = (numRead == 0u);
+    window.failed = window.in->bad();
+    resize(window.buffer, keep + numRead);
+
+    fileBegin = it = begin(window.buffer, seqan::Standard());
+    fileEnd = fileBegin + length(window.buffer);
+}
+
+// ---------------------------------------------------------------------------
+// Function fillWindow()                                        [InputWindow]
+// ---------------------------------------------------------------------------
+
+// Make sure that the record at it and the begin of the next one are in the buffer, reading more of a streamed input
+// if necessary.  The end of the record found on the way is written to recordEnd so it is not scanned again, it is
+// NULL for memory mapped inputs and invalid records.  Returns false on read errors.
+
+bool fillWindow(InputWindow & window,
+                char const * & recordEnd,
+                char const * & it,
+                char const * & fileBegin,
+                char const * & fileEnd,
+                RawRecordFormat format)
+{
+    recordEnd = 0;
+    if (!window.in)
+        return true;
+    while (!window.failed)
+    {
+        // A record is complete if something follows it, the last one only at the end of the input.
+        recordEnd = (it != fileEnd) ? skipRawRecord(it, fileEnd, format) : 0;
+        if ((recordEnd != 0 && recordEnd != fileEnd) || window.atEnd)
+            break;
+        readMore(window, it, fileBegin, fileEnd);
+    }
+    return !window.failed;
+}
+
+// ---------------------------------------------------------------------------
+// Class TrimStats
+// ---------------------------------------------------------------------------
+
+struct TrimStats
+{
+    // Number of reads looked at, number of reads with trimmed bases, number of trimmed bases.
+    __uint64 numReads;
+    __uint64 numTrimmedReads;
+    __uint64 numTrimmedBases;
+    // Number of reads with an adapter and number of bases removed with adapters.
+    __uint64 numAdapterReads;
+    __uint64 numAdapterBases;
+    // Number of reads dropped for being too short after trimming.
+    __uint64 numDropped;
+
+    TrimStats() : numReads(0), numTrimmedReads(0), numTrimmedBases(0), numAdapterReads(0), numAdapterBases(0),
+                  numDropped(0)
+    {}
+};
+
+// ---------------------------------------------------------------------------
+// Function qualityTrimmingEnabled(), trimmingEnabled()
+// ---------------------------------------------------------------------------
+
+inline bool qualityTrimmingEnabled(FxSakOptions const & options)
+{
+    return options.trimLeading > 0 || options.trimTrailing > 0 || options.trimWindowSize > 0u ||
+           options.trimBwa > 0;
+}
+
+inline bool trimmingEnabled(FxSakOptions const & options)
+{
+    return qualityTrimmingEnabled(options) || !empty(options.adapters) || options.trimMinLength > 0u;
+}
+
+// ---------------------------------------------------------------------------
+// Function trimSakRecord()
+// ---------------------------------------------------------------------------
+
+// Quality-trim record as configured in options, then cut it at the first adapter match if adapters is not NULL.
+// Updates stats if not NULL.  Returns false if the record is to be dropped because it is too short afterwards.
+
+bool trimSakRecord(FxSakRecord & record, AdapterTrimmer * adapters, FxSakOptions const & options, TrimStats * stats)
+{
+    size_t len = length(record.seq);
+    size_t trimBegin = 0, trimEnd = len;
+    if (qualityTrimmingEnabled(options))
+    {
+        char const * quals = begin(record.quals, seqan::Standard());
+        trimEnd = len = std::min(len, (size_t)length(record.quals));
+        if (options.trimLeading > 0)
+            trimBegin = firstAtLeast(quals, len, options.trimLeading);
+        if (options.trimTrailing > 0)
+            trimEnd = std::max(trimBegin, behindLastAtLeast(quals, len, options.trimTrailing));
+        if (options.trimWindowSize > 0u)
+            trimEnd = trimBegin + slidingWindowEnd(quals + trimBegin, trimEnd - trimBegin, options.trimWindowSize,
+                                                   options.trimWindowQual);
+        if (options.trimBwa > 0)
+            trimEnd = trimBegin + bwaTrimEnd(quals + trimBegin, trimEnd - trimBegin, options.trimBwa);
+    }
+    size_t qualTrimEnd = trimEnd;
+    if (adapters)
+        trimEnd = trimBegin + findAdapter(*adapters, begin(record.seq, seqan::Standard()) + trimBegin,
+                                          trimEnd - trimBegin);
+
+    if (trimEnd < length(record.seq))
+        erase(record.seq, trimEnd, length(record.seq));
+    if (trimEnd < length(record.quals))
+        erase(record.quals, trimEnd, length(record.quals));
+    if (trimBegin > 0u)
+    {
+        erase(record.seq, 0, trimBegin);
+        erase(record.quals, 0, std::min(trimBegin, (size_t)length(record.quals)));
+    }
+
+    bool keep = (length(record.seq) >= options.trimMinLength);
+    if (stats)
+    {
+        stats->numReads += 1;
+        stats->numTrimmedReads += (trimBegin > 0u || qualTrimEnd < len);
+        stats->numTrimmedBases += len - (qualTrimEnd - trimBegin);
+        stats->numAdapterReads += (trimEnd < qualTrimEnd);
+        stats->numAdapterBases += qualTrimEnd - trimEnd;
+        stats->numDropped += !keep;
+    }
+    return keep;
+}
+
+// ---------------------------------------------------------------------------
+// Function writeSakRecord()
+// ---------------------------------------------------------------------------
+
+// Write record to out, restricted to the infix and reverse-complemented as configured in options.  The output is
+// truncated such that charsWritten, the number of sequence characters written so far, does not exceed
+// options.maxLength.  Returns 0 on success, 1 on errors.
+
+int writeSakRecord(std::ostream & out, FxSakRecord & record, __uint64 & charsWritten, FxSakOptions const & options)
+{
+    seqan::CharString & seq = record.seq;
+    seqan::CharString & quals = record.quals;
+
+    // Get begin and end index of infix to write out, the one of the record takes precedence.
+    __uint64 seqInfixBegin = options.seqInfixBegin;
+    __uint64 seqInfixEnd = options.seqInfixEnd;
+    if (record.infixBegin != seqan::maxValue<__uint64>())
+    {
+        seqInfixBegin = record.infixBegin;
+        seqInfixEnd = record.infixEnd;
+    }
+    __uint64 infixBegin = 0;
+    if (seqInfixBegin != seqan::maxValue<__uint64>())
+        infixBegin = seqInfixBegin;
+    if (infixBegin > length(seq))
+        infixBegin = length(seq);
+    __uint64 infixEnd = length(seq);
+    if (seqInfixEnd < length(seq))
+        infixEnd = seqInfixEnd;
+    if (infixEnd < infixBegin)
+        infixEnd = infixBegin;
+    if (options.verbosity >= 3)
+        std::cerr << "INFIX\tbegin:" << infixBegin << "\tend:" << infixEnd << "\n";
+
+    // The reverse-complement of the infix is the infix of the reverse-complement with mirrored coordinates.  Only
+    // the infix is reverse-complemented, in place, case and IUPAC codes are kept.
+    if (options.reverseComplement)
+    {
+        bool withQuals = options.outFastq && length(quals) >= infixEnd;
+        reverseComplementInPlace(begin(seq, seqan::Standard()) + infixBegin,
+                                 begin(seq, seqan::Standard()) + infixEnd,
+                                 withQuals ? begin(quals, seqan::Standard()) + infixBegin : 0);
+    }
+
+    // Truncate the output to the remaining --max-length characters.
+    if (options.maxLength - charsWritten < infixEnd - infixBegin)
+        infixEnd = infixBegin + (options.maxLength - charsWritten);
+    charsWritten += infixEnd - infixBegin;
+
+    if (options.outFastq)
+        return writeRecord(out, record.id, infix(seq, infixBegin, infixEnd), infix(quals, infixBegin, infixEnd),
+                           seqan::Fastq()) != 0;
+    else
+        return writeRecord(out, record.id, infix(seq, infixBegin, infixEnd), seqan::Fasta()) != 0;
+}
+
+// ---------------------------------------------------------------------------
+// Function lookupRecordInfix()
+// ---------------------------------------------------------------------------
+
+// Set the infix of record with index idx from infixFile, if it is open.  Returns 0 on success, 1 on errors.
+
+int lookupRecordInfix(FxSakRecord & record, InfixFile * infixFile, __uint64 idx)
+{
+    record.infixBegin = seqan::maxValue<__uint64>();
+    record.infixEnd = seqan::maxValue<__uint64>();
+    if (!infixFile)
+        return 0;
+
+    bool found = false;
+    __uint64 beginPos = 0, endPos = 0;
+    char const * id = begin(record.id, seqan::Standard());
+    size_t idLen = firstWordLength(id, length(record.id));
+    int res = lookup(found, beginPos, endPos, *infixFile, idx, id, idLen);
+    if (res == 2)
+    {
+        std::cerr << "ERROR: Record " << std::string(id, idLen) << " does not match the infix file entry";
+        if (infixFile->hasPending)
+            std::cerr << " " << infixFile->pendingName << " in line " << infixFile->lineNo;
+        std::cerr << ".  The infix file must list the written records in order, use --infix-file-unordered.\n";
+        return 1;
+    }
+    if (res != 0)
+    {
+        std::cerr << "ERROR: Invalid entry or indices not increasing in infix file line " << infixFile->lineNo
+                  << "\n";
+        return 1;
+    }
+    if (found)
+    {
+        record.infixBegin = beginPos;
+        record.infixEnd = endPos;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Function taggedPath(), shardPath()
+// ---------------------------------------------------------------------------
+
+// Path with tag inserted before the file extension, ignoring a trailing ".gz", e.g. OUT.fq.gz becomes OUT.TAG.fq.gz.
+
+seqan::CharString taggedPath(seqan::CharString const & path, seqan::CharString const & tag)
+{
+    // Find position of the extension dot in the file name.
+    unsigned nameBegin = 0;
+    for (unsigned j = 0; j < length(path); ++j)
+        if (path[j] == '/')
+            nameBegin = j + 1;
+    unsigned extPos = length(path);
+    for (unsigned j = length(path); j > nameBegin; --j)
+        if (path[j - 1] == '.')
+        {
+            extPos = j - 1;
+            break;
+        }
+    if (extPos != length(path) && suffix(path, extPos) == ".gz")
+        for (unsigned j = extPos; j > nameBegin; --j)
+            if (path[j - 1] == '.')
+            {
+                extPos = j - 1;
+                break;
+            }
+
+    seqan::CharString result = prefix(path, extPos);
+    appendValue(result, '.');
+    append(result, tag);
+    append(result, suffix(path, extPos));
+    return result;
+}
+
+// Path of shard i, e.g. OUT.fq.gz becomes OUT.3.fq.gz.
+
+seqan::CharString shardPath(seqan::CharString const & path, unsigned i)
+{
+    std::stringstream ss;
+    ss << i;
+    return taggedPath(path, seqan::CharString(ss.str()));
+}
+
+// ---------------------------------------------------------------------------
+// Class ShardChooser
+// ---------------------------------------------------------------------------
+
+// Assigns records to the --split or --demux output files and keeps per shard counts.
+
+struct ShardChooser
+{
+    enum Mode
+    {
+        ROUND_ROBIN,
+        RECORDS,
+        BASES,
+        DEMUX,
+        MINIMIZER
+    };
+
+    Mode mode;
+    unsigned numShards;
+
+    // Total number of records, for mode RECORDS.
+    __uint64 numTotal;
+
+    // Number of records and bases written to each shard.
+    seqan::String<__uint64> numRecords;
+    seqan::String<__uint64> numBases;
+
+    // Min-heap of (bases, shard) for mode BASES.
+    std::vector<std::pair<__uint64, unsigned> > heap;
+
+    // Number of records assigned so far.
+    __uint64 numChosen;
+
+    // Barcodes for mode DEMUX, the last shard takes unmatched and ambiguous records.  The barcode is read from the
+    // sequence window [barcodeBegin, barcodeEnd) or, if barcodeBegin is maxValue, is the part of the identifier
+    // behind the last ':'.
+    BarcodeMatcher const * barcodes;
+    __uint64 barcodeBegin;
+    __uint64 barcodeEnd;
+
+    // k-mer length for mode MINIMIZER.
+    unsigned minimizerK;
+
+    ShardChooser() : mode(ROUND_ROBIN), numShards(1), numTotal(0), numChosen(0), barcodes(0),
+                     barcodeBegin(seqan::maxValue<__uint64>()), barcodeEnd(seqan::maxValue<__uint64>()),
+                     minimizerK(21)
+    {}
+};
+
+void init(ShardChooser & chooser, seqan::CharString const & mode, unsigned numShards)
+{
+    if (mode == "records")
+        chooser.mode = ShardChooser::RECORDS;
+    else if (mode == "bases")
+        chooser.mode = ShardChooser::BASES;
+    else if (mode == "demux")
+        chooser.mode = ShardChooser::DEMUX;
+    else if (mode == "minimizer")
+        chooser.mode = ShardChooser::MINIMIZER;
+    else
+        chooser.mode = ShardChooser::ROUND_ROBIN;
+    chooser.numShards = std::max(1u, numShards);
+    clear(chooser.numRecords);
+    resize(chooser.numRecords, chooser.numShards, 0);
+    clear(chooser.numBases);
+    resize(chooser.numBases, chooser.numShards, 0);
+    chooser.heap.clear();
+    for (unsigned i = 0; i < chooser.numShards; ++i)
+        chooser.heap.push_back(std::make_pair((__uint64)0, i));
+    chooser.numChosen = 0;
+}
+
+// Returns the shard of record by its barcode for mode DEMUX.
+
+unsigned barcodeShard_(ShardChooser const & chooser, FxSakRecord const & record)
+{
+    char const * ptr = 0;
+    size_t len = 0;
+    if (chooser.barcodeBegin == seqan::maxValue<__uint64>())
+    {
+        // Illumina style "@NAME 1:N:0:BARCODE".
+        char const * idBegin = begin(record.id, seqan::Standard());
+        char const * idEnd = end(record.id, seqan::Standard());
+        ptr = idEnd;
+        while (ptr != idBegin && ptr[-1] != ':' && ptr[-1] != ' ')
+            --ptr;
+        len = idEnd - ptr;
+    }
+    else if (chooser.barcodeEnd <= length(record.seq))
+    {
+        ptr = begin(record.seq, seqan::Standard()) + chooser.barcodeBegin;
+        len = chooser.barcodeEnd - chooser.barcodeBegin;
+    }
+
+    __uint32 sampleId = len ? findBarcode(*chooser.barcodes, ptr, len) : (__uint32)BARCODE_NO_MATCH;
+    if (sampleId >= chooser.numShards - 1)
+        return chooser.numShards - 1;  // Unmatched or ambiguous.
+    return sampleId;
+}
+
+// Returns shard for the record with the given number (out of chooser.numTotal for mode RECORDS).
+
+unsigned chooseShard(ShardChooser & chooser, __uint64 recordNo, FxSakRecord const & record)
+{
+    __uint64 recordLength = length(record.seq);
+    unsigned shard = 0;
+    switch (chooser.mode)
+    {
+        case ShardChooser::DEMUX:
+            shard = barcodeShard_(chooser, record);
+            break;
+        case ShardChooser::MINIMIZER:
+            // Reads without any unambiguous k-mer all end up in the same shard.
+            shard = readMinimizer(begin(record.seq, seqan::Standard()), recordLength, chooser.minimizerK) %
+                    chooser.numShards;
+            break;
+        case ShardChooser::RECORDS:
+            if (chooser.numTotal > 0u)
+                shard = (unsigned)std::min((__uint64)chooser.numShards - 1,
+                                           (__uint64)((double)recordNo * chooser.numShards / chooser.numTotal));
+            break;
+        case ShardChooser::BASES:
+            // Greedily put the record into the shard with the fewest bases.
+            std::pop_heap(chooser.heap.begin(), chooser.heap.end(), std::greater<std::pair<__uint64, unsigned> >());
+            shard = chooser.heap.back().second;
+            chooser.heap.back().first += recordLength;
+            std::push_heap(chooser.heap.begin(), chooser.heap.end(), std::greater<std::pair<__uint64, unsigned> >());
+            break;
+        default:
+            shard = chooser.numChosen % chooser.numShards;
+    }
+    chooser.numChosen += 1;
+    chooser.numRecords[shard] += 1;
+    chooser.numBases[shard] += recordLength;
+    return shard;
+}
+
+// ---------------------------------------------------------------------------
+// Function writeSakOutput()
+// ---------------------------------------------------------------------------
+
+// Write record to outPtr or, if outputSet has outputs, to the output selected by chooser.  Records are skipped once
+// charsWritten reaches options.maxLength.  Returns 0 on success, 1 on errors.
+
+int writeSakOutput(std::ostream * outPtr,
+                   OutputSet & outputSet,
+                   ShardChooser & chooser,
+                   FxSakRecord & record,
+                   __uint64 recordNo,
+                   __uint64 & charsWritten,
+                   FxSakOptions const & options)
+{
+    if (charsWritten >= options.maxLength)
+        return 0;
+    if (empty(outputSet.paths))
+        return writeSakRecord(*outPtr, record, charsWritten, options);
+
+    unsigned shard = chooseShard(chooser, recordNo, record);
+    if (writeSakRecord(outputStream(outputSet, shard), record, charsWritten, options) != 0)
+        return 1;
+    return recordWritten(outputSet, shard);
+}
+
+// ---------------------------------------------------------------------------
+// Function addSortRecord()
+// ---------------------------------------------------------------------------
+
+// Add the parsed record at [beginPos, endPos) in the input file to sorter with the key configured in options.  Returns
+// 0 on success, 1 on errors.
+
+int addSortRecord(RecordSorter & sorter,
+                  FxSakRecord const & record,
+                  __uint64 beginPos,
+                  __uint64 endPos,
+                  FxSakOptions const & options)
+{
+    if (options.sortKey == "name")
+        return add(sorter, begin(record.id, seqan::Standard()), length(record.id), beginPos, endPos);
+    if (options.sortKey == "sequence")
+        return add(sorter, begin(record.seq, seqan::Standard()), length(record.seq), beginPos, endPos);
+
+    // Big endian length, compares like the number.
+    char key[8];
+    __uint64 len = length(record.seq);
+    for (int i = 7; i >= 0; --i, len >>= 8)
+        key[i] = (char)(len & 0xff);
+    return add(sorter, key, 8, beginPos, endPos);
+}
+
+// ---------------------------------------------------------------------------
+// Class SortedRecordWriter_
+// ---------------------------------------------------------------------------
+
+// Called for the sorted records, parses and writes them.
+
+struct SortedRecordWriter_
+{
+    char const * fileBegin;
+    RawRecordFormat format;
+    std::ostream * outPtr;
+    OutputSet & outputSet;
+    ShardChooser & shardChooser;
+    InfixFile * infixFile;
+    AdapterTrimmer * adapters;
+    __uint64 & charsWritten;
+    FxSakOptions const & options;
+    FxSakRecord record;
+    __uint64 recordNo;
+
+    SortedRecordWriter_(char const * fileBegin, RawRecordFormat format, std::ostream * outPtr, OutputSet & outputSet,
+                        ShardChooser & shardChooser, InfixFile * infixFile, AdapterTrimmer * adapters,
+                        __uint64 & charsWritten, FxSakOptions const & options) :
+            fileBegin(fileBegin), format(format), outPtr(outPtr), outputSet(outputSet), shardChooser(shardChooser),
+            infixFile(infixFile), adapters(adapters), charsWritten(charsWritten), options(options), recordNo(0)
+    {}
+
+    int operator()(__uint64 beginPos, __uint64 endPos)
+    {
+        if (charsWritten >= options.maxLength)
+            return 0;
+        if (readSakRecord(record, fileBegin + beginPos, fileBegin + endPos, format, options.outFastq) != 0)
+        {
+            std::cerr << "ERROR: Reading record!\n";
+            return 1;
+        }
+        // The record was trimmed and counted before it was sorted already.
+        if (trimmingEnabled(options))
+            trimSakRecord(record, adapters, options, 0);
+        // The record index is not known here, the infix file is keyed by name.
+        if (lookupRecordInfix(record, infixFile, seqan::maxValue<__uint64>()) != 0)
+            return 1;
+        if (writeSakOutput(outPtr, outputSet, shardChooser, record, recordNo++, charsWritten, options) != 0)
+        {
+            std::cerr << "ERROR: Writing record!\n";
+            return 1;
+        }
+        return 0;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Function isSelected()
+// ---------------------------------------------------------------------------
+
+// Returns true if the record with index idx starting at it is selected by index or by name.  The indices must not
+// decrease between calls.
+
+inline bool isSelected(IndexIntervalSet & selection,
+                       NameMatcher const & nameMatcher,
+                       __uint64 idx,
+                       char const * it,
+                       char const * fileEnd)
+{
+    if (!selection.active && empty(nameMatcher))
+        return true;
+    // One of options.seqIndices or options.seqIndexRanges.
+    if (selection.active && contains(selection, idx))
+        return true;
+    // Name or name prefix matches, look at the header line in the buffer.
+    return !empty(nameMatcher) && matches(nameMatcher, it + 1, lineLength(it + 1, nextLineBegin(it, fileEnd)));
+}
+
+// ---------------------------------------------------------------------------
+// Function computeFingerprint()
+// ---------------------------------------------------------------------------
+
+// Fingerprint of record for deduplication as configured in options.
+
+inline void computeFingerprint(DedupFingerprint & fp, FxSakRecord const & record, FxSakOptions const & options)
+{
+    char const * id = begin(record.id, seqan::Standard());
+    size_t idLen = (options.dedupMode == "id-sequence") ? firstWordLength(id, length(record.id)) : 0;
+    computeFingerprint(fp, id, idLen, begin(record.seq, seqan::Standard()), length(record.seq),
+                       options.dedupHashBits / 64);
+}
+
+// ---------------------------------------------------------------------------
+// Function markDuplicatesPartitioned()
+// ---------------------------------------------------------------------------
+
+// First pass of the two-pass deduplication.  The fingerprints of the selected records are written together with the
+// record indices to options.dedupPartitions temporary files, partitioned by fingerprint.  The partitions are then
+// loaded one at a time and the indices of duplicates are marked in the bit vector dupBits.  Returns 0 on success, 1
+// on errors.
+
+int markDuplicatesPartitioned(seqan::String<__uint64> & dupBits,
+                              char const * fileBegin,
+                              char const * fileEnd,
+                              RawRecordFormat format,
+                              IndexIntervalSet selection,  // copy, the cursor is modified
+                              NameMatcher const & nameMatcher,
+                              AdapterTrimmer * adapters,
+                              FxSakOptions const & options)
+{
+    unsigned numWords = options.dedupHashBits / 64;
+    unsigned numParts = options.dedupPartitions;
+
+    seqan::String<seqan::CharString> paths;
+    for (unsigned i = 0; i < numParts; ++i)
+    {
+        std::stringstream ss;
+        ss << options.tmpDir << "/fx_sak." << getpid() << ".dedup." << i;
+        appendValue(paths, seqan::CharString(ss.str()));
+    }
+
+    // Pass 1: Write out (fingerprint, index) entries.
+    {
+        std::vector<std::ofstream *> parts(numParts, 0);
+        int res = 0;
+        for (unsigned i = 0; i < numParts && res == 0; ++i)
+        {
+            parts[i] = new std::ofstream(toCString(paths[i]), std::ios::binary | std::ios::out);
+            if (!parts[i]->good())
+            {
+                std::cerr << "ERROR: Could not open temporary file " << paths[i] << "\n";
+                res = 1;
+            }
+        }
+
+        FxSakRecord record;
+        DedupFingerprint fp;
+        __uint64 idx = 0;
+        __uint64 endIdx = (empty(nameMatcher) && selection.active) ? endIndex(selection) : seqan::maxValue<__uint64>();
+        for (char const * it = skipBlankLines(fileBegin, fileEnd); it != fileEnd && idx < endIdx && res == 0; ++idx)
+        {
+            char const * recordEnd = skipRawRecord(it, fileEnd, format);
+            if (recordEnd == 0)
+            {
+                std::cerr << "ERROR: Invalid record " << idx << "!\n";
+                res = 1;
+                break;
+            }
+            if (isSelected(selection, nameMatcher, idx, it, fileEnd))
+            {
+                if (readSakRecord(record, it, recordEnd, format, false) != 0)
+                {
+                    std::cerr << "ERROR: Reading record!\n";
+                    res = 1;
+                    break;
+                }
+                // Fingerprints are computed from trimmed reads, reads that are dropped then do not count.
+                if (trimmingEnabled(options) && !trimSakRecord(record, adapters, options, 0))
+                {
+                    it = recordEnd;
+                    continue;
+                }
+                computeFingerprint(fp, record, options);
+                __uint64 entry[3] = { fp.h1, fp.h2, idx };
+                std::ofstream & part = *parts[(fp.h1 >> 32) % numParts];
+                part.write(reinterpret_cast<char const *>(entry), sizeof(__uint64) * numWords);
+                part.write(reinterpret_cast<char const *>(entry + 2), sizeof(__uint64));
+            }
+            it = recordEnd;
+        }
+
+        for (unsigned i = 0; i < numParts; ++i)
+        {
+            if (parts[i] && !parts[i]->good() && res == 0)
+            {
+                std::cerr << "ERROR: Could not write temporary file " << paths[i] << "\n";
+                res = 1;
+            }
+            delete parts[i];
+        }
+        if (res != 0)
+        {
+            for (unsigned i = 0; i < numParts; ++i)
+                std::remove(toCString(paths[i]));
+            return 1;
+        }
+    }
+
+    // Pass 2: Find duplicates in each partition.  The entries of each partition are in input order, so the first
+    // occurrence is the one that is kept.
+    clear(dupBits);
+    int res = 0;
+    for (unsigned i = 0; i < numParts; ++i)
+    {
+        if (res == 0)
+        {
+            std::ifstream part(toCString(paths[i]), std::ios::binary | std::ios::in);
+            DedupSet set;
+            init(set, numWords, (__uint64)options.dedupMemory * 1024 * 1024);
+            DedupFingerprint fp;
+            __uint64 entry[3] = { 0, 0, 0 };
+            while (res == 0 && part.read(reinterpret_cast<char *>(entry), sizeof(__uint64) * (numWords + 1)))
+            {
+                fp.h1 = entry[0];
+                fp.h2 = (numWords == 2u) ? entry[1] : 0;
+                __uint64 idx = entry[numWords];
+                int ret = insert(set, fp);
+                if (ret < 0)
+                {
+                    std::cerr << "ERROR: Fingerprints of partition " << i << " exceed the memory budget, "
+                              << "increase --dedup-memory or --dedup-partitions.\n";
+                    res = 1;
+                }
+                else if (ret == 0)
+                {
+                    if (length(dupBits) <= idx / 64)
+                        resize(dupBits, idx / 64 + 1, 0);
+                    dupBits[idx / 64] |= (__uint64)1 << (idx % 64);
+                }
+            }
+        }
+        std::remove(toCString(paths[i]));
+    }
+    return res;
+}
+
+// ---------------------------------------------------------------------------
+// Function main()
+// ---------------------------------------------------------------------------
+
+int main(int argc, char const ** argv)
+{
+    double startTime = 0;
+    
+    // Parse command line.
+    FxSakOptions options;
+    seqan::ArgumentParser::ParseResult res = parseArgs(options, argc, argv);
+    if (res != seqan::ArgumentParser::PARSE_OK)
+        return res == seqan::ArgumentParser::PARSE_ERROR;  // 1 on errors, 0 otherwise
+
+    // -----------------------------------------------------------------------
+    // Show options.
+    // -----------------------------------------------------------------------
+    if (options.verbosity >= 2)
+    {
+        std::cerr << "____OPTIONS___________________________________________________________________\n"
+                  << "\n"
+                  << "VERBOSITY    " << options.verbosity << "\n"
+                  << "IN           " << options.inFastxPath << "\n"
+                  << "OUT          " << options.outPath << "\n"
+                  << "FASTQ OUT    " << yesNo(options.outFastq) << "\n"
+                  << "INFIX BEGIN  " << options.seqInfixBegin << "\n"
+                  << "INFIX END    " << options.seqInfixEnd << "\n"
+                  << "INFIX FILE   " << options.infixFile << "\n"
+                  << "  INDICES    " << yesNo(options.infixFileIndices) << "\n"
+                  << "  UNORDERED  " << yesNo(options.infixFileUnordered) << "\n"
+                  << "MAX LEN      " << options.maxLength << "\n"
+                  << "NAMES FILE   " << options.namesFile << "\n"
+                  << "NAMES PREFIX " << yesNo(options.namesFilePrefixes) << "\n"
+                  << "REVCOMP      " << yesNo(options.reverseComplement) << "\n"
+                  << "TRIM LEADING " << options.trimLeading << "\n"
+                  << "TRIM TRAIL.  " << options.trimTrailing << "\n"
+                  << "TRIM WINDOW  " << options.trimWindowSize << ":" << options.trimWindowQual << "\n"
+                  << "TRIM BWA     " << options.trimBwa << "\n"
+                  << "TRIM MIN LEN " << options.trimMinLength << "\n"
+                  << "ADAPTER ERR. " << options.adapterErrors << "\n"
+                  << "ADAPTER OVL. " << options.adapterMinOverlap << "\n"
+                  << "RECORD INDEX " << (options.useRecordIndex ? options.recordIndexPath : seqan::CharString("-")) << "\n"
+                  << "NUM THREADS  " << options.numThreads << "\n"
+                  << "SAMPLE FRAC  " << options.sampleFraction << "\n"
+                  << "SAMPLE COUNT " << options.sampleCount << "\n"
+                  << "SEED         " << options.seed << "\n"
+                  << "SPLIT        " << options.numShards << "\n"
+                  << "SPLIT MODE   " << options.splitMode << "\n"
+                  << "MINIMIZER K  " << options.minimizerK << "\n"
+                  << "GZIP         " << yesNo(options.gzip) << "\n"
+                  << "MAX OPEN     " << options.maxOpenFiles << "\n"
+                  << "DEMUX SHEET  " << options.demuxSheet << "\n"
+                  << "BARCODE MM   " << options.barcodeMismatches << "\n"
+                  << "BARCODE WIN. " << options.barcodeBegin << "-" << options.barcodeEnd << "\n"
+                  << "DEDUP        " << options.dedupMode << "\n"
+                  << "DEDUP BITS   " << options.dedupHashBits << "\n"
+                  << "DEDUP MEMORY " << options.dedupMemory << "\n"
+                  << "DEDUP PARTS  " << options.dedupPartitions << "\n"
+                  << "TMP DIR      " << options.tmpDir << "\n"
+                  << "SORT         " << options.sortKey << "\n"
+                  << "SORT MEMORY  " << options.sortMemory << "\n"
+                  << "SEQUENCES\n";
+        for (unsigned i = 0; i < length(options.seqIndices); ++i)
+            std::cerr << "  SEQ  " << options.seqIndices[i] << "\n";
+        for (unsigned i = 0; i < length(options.seqIndexRanges); ++i)
+            std::cerr << "  SEQS " << options.seqIndexRanges[i].i1 << "-" << options.seqIndexRanges[i].i2 << "\n";
+        for (unsigned i = 0; i < length(options.readPatterns); ++i)
+            std::cerr << "  NAME " << options.readPatterns[i] << "\n";
+        std::cerr << "ADAPTERS\n";
+        for (unsigned i = 0; i < length(options.adapters); ++i)
+            std::cerr << "  " << options.adapters[i] << "\n";
+    }
+
+    // -----------------------------------------------------------------------
+    // Open Files.
+    // -----------------------------------------------------------------------
+
+    // Regular input files are memory mapped such that we can skip over records that we do not want without parsing
+    // them and seek using the record index.  Other inputs are streamed through a window.
+    seqan::String<char, seqan::MMap<> > inString;
+    std::ifstream inStream;
+    InputWindow window;
+    char const * fileBegin = 0;
+    char const * fileEnd = 0;
+    struct stat inStat;
+    if (stat(toCString(options.inFastxPath), &inStat) == 0 && S_ISREG(inStat.st_mode) &&
+        open(inString, toCString(options.inFastxPath), seqan::OPEN_RDONLY))
+    {
+        fileBegin = begin(inString, seqan::Standard());
+        fileEnd = end(inString, seqan::Standard());
+    }
+    else
+    {
+        inStream.open(toCString(options.inFastxPath), std::ios::binary | std::ios::in);
+        if (!inStream.good())
+        {
+            std::cerr << "ERROR: Could not open input file " << options.inFastxPath << "\n";
+            return 1;
+        }
+        window.in = &inStream;
+        char const * it = 0;
+        while (!window.atEnd && !window.failed && skipBlankLines(fileBegin, fileEnd) == fileEnd)
+            readMore(window, it, fileBegin, fileEnd);
+    }
+    if (window.in && (options.sampleCount != seqan::maxValue<__uint64>() || !empty(options.sortKey) ||
+                      options.dedupPartitions > 0u || (options.numShards > 0u && options.splitMode == "records")))
+    {
+        std::cerr << "ERROR: --sample-count, --sort, --dedup-partitions and --split-mode records need a regular "
+                  << "input file, " << options.inFastxPath << " cannot be memory mapped.\n";
+        return 1;
+    }
+
+    // Load barcode sheet for demultiplexing.
+    BarcodeMatcher barcodes;
+    seqan::String<seqan::CharString> sampleNames;
+    if (!empty(options.demuxSheet))
+    {
+        if (loadBarcodeSheet(barcodes, sampleNames, options) != 0)
+            return 1;
+        appendValue(sampleNames, seqan::CharString("unmatched"));
+    }
+
+    // Split, demultiplexed and compressed output goes through a buffered output set.
+    std::ostream * outPtr = & std::cout;
+    std::fstream outStream;
+    OutputSet outputSet;
+    outputSet.maxOpenFiles = options.maxOpenFiles;
+    ShardChooser shardChooser;
+    if (options.numShards > 0u || options.gzip || !empty(sampleNames))
+    {
+        seqan::String<seqan::CharString> paths;
+        for (unsigned i = 0; i < length(sampleNames); ++i)
+            appendValue(paths, taggedPath(options.outPath, sampleNames[i]));
+        for (unsigned i = 0; i < options.numShards; ++i)
+            appendValue(paths, shardPath(options.outPath, i));
+        if (empty(paths))
+            appendValue(paths, options.outPath);
+        if (open(outputSet, paths, options.gzip, options.numThreads) != 0)
+        {
+            std::cerr << "ERROR: Could not open output files for " << options.outPath << "\n";
+            return 1;
+        }
+        init(shardChooser, empty(sampleNames) ? options.splitMode : seqan::CharString("demux"), length(paths));
+        shardChooser.barcodes = &barcodes;
+        shardChooser.barcodeBegin = options.barcodeBegin;
+        shardChooser.barcodeEnd = options.barcodeEnd;
+        shardChooser.minimizerK = options.minimizerK;
+    }
+    else if (!empty(options.outPath))
+    {
+        outStream.open(toCString(options.outPath), std::ios::binary | std::ios::out);
+        if (!outStream.good())
+        {
+            std::cerr << "ERROR: Could not open output file " << options.outPath << "\n";
+            return 1;
+        }
+        outPtr = &outStream;
+    }
+
+    RawRecordFormat format = guessRawFormat(fileBegin, fileEnd);
+    if (format == RAW_FORMAT_UNKNOWN && skipBlankLines(fileBegin, fileEnd) != fileEnd)
+    {
+        std::cerr << "ERROR: Could not determine input format!\n";
+        return 1;
+    }
+
+    // Load names to select by.
+    NameMatcher nameMatcher;
+    if (buildNameMatcher(nameMatcher, options) != 0)
+        return 1;
+    if (options.verbosity >= 2)
+        std::cerr << "Loaded " << nameMatcher.names.size << " names\n";
+
+    // Open per-record infix file.
+    InfixFile infixFile;
+    InfixFile * infixFilePtr = 0;
+    if (!empty(options.infixFile))
+    {
+        if (open(infixFile, toCString(options.infixFile), options.infixFileIndices, !options.infixFileUnordered) != 0)
+        {
+            std::cerr << "ERROR: Could not read infix file " << options.infixFile << " (line " << infixFile.lineNo
+                      << ")\n";
+            return 1;
+        }
+        infixFilePtr = &infixFile;
+    }
+
+    // Compile index selections.
+    IndexIntervalSet selection;
+    build(selection, options.seqIndices, options.seqIndexRanges);
+
+    // Compute index of first and behind last sequence to write if we only select by index.  We stop reading right
+    // after the last selected sequence.
+    __uint64 beginIdx = 0;
+    __uint64 endIdx = seqan::maxValue<__uint64>();
+    if (empty(nameMatcher) && selection.active)
+    {
+        beginIdx = beginIndex(selection);
+        endIdx = endIndex(selection);
+    }
+    if (options.verbosity >= 2)
+        std::cerr << "Sequence begin idx: " << beginIdx << "\nSequence end idx: " << endIdx << "\n";
+
+    // -----------------------------------------------------------------------
+    // Seek Using Record Index.
+    // -----------------------------------------------------------------------
+    __uint64 idx = 0;
+    char const * it = skipBlankLines(fileBegin, fileEnd);
+    RecordIndex recordIndex;
+    bool useRecordIndex = (options.useRecordIndex && !window.in && beginIdx >= options.recordIndexSampleRate &&
+                           beginIdx < endIdx);
+    // Splitting into runs of records needs the number of records which the record index provides.
+    bool needRecordCount = (shardChooser.mode == ShardChooser::RECORDS && !empty(outputSet.paths));
+    if (needRecordCount && !options.useRecordIndex)
+    {
+        if (build(recordIndex, fileBegin, fileEnd, options.recordIndexSampleRate, options.numThreads) != 0)
+        {
+            std::cerr << "ERROR: Could not count records of " << options.inFastxPath << "\n";
+            return 1;
+        }
+    }
+    else if (useRecordIndex || needRecordCount)
+    {
+        if (loadOrBuildRecordIndex(recordIndex, fileBegin, fileEnd, options) != 0)
+            return 1;
+    }
+    shardChooser.numTotal = recordIndex.numRecords;
+    if (useRecordIndex)
+    {
+        __uint64 offset = 0;
+        findRecord(offset, idx, recordIndex, beginIdx);
+        if (options.verbosity >= 2)
+            std::cerr << "Seeking to record " << idx << " at offset " << offset << "\n";
+        it = fileBegin + offset;
+    }
+
+    // -----------------------------------------------------------------------
+    // Read and Write Filtered.
+    // -----------------------------------------------------------------------
+    startTime = sysTime();
+
+    // Quality trimming needs FASTQ input.
+    bool trimming = trimmingEnabled(options);
+    TrimStats trimStats;
+    if (qualityTrimmingEnabled(options) && format != RAW_FORMAT_FASTQ)
+    {
+        std::cerr << "ERROR: Quality trimming requires FASTQ input.\n";
+        return 1;
+    }
+    AdapterTrimmer adapters;
+    AdapterTrimmer * adaptersPtr = 0;
+    if (!empty(options.adapters))
+    {
+        init(adapters, options.adapterErrors, options.adapterMinOverlap);
+        for (unsigned i = 0; i < length(options.adapters); ++i)
+            addAdapter(adapters, std::string(begin(options.adapters[i], seqan::Standard()),
+                                             end(options.adapters[i], seqan::Standard())));
+        adaptersPtr = &adapters;
+    }
+
+    // Random sampling of the otherwise selected records.  Selected records are numbered consecutively, these numbers
+    // are given to the samplers.  The reservoir stores byte ranges of the records in the input file.
+    bool sampleByFraction = (options.sampleFraction < 1);
+    bool sampleByCount = (options.sampleCount != seqan::maxValue<__uint64>());
+    BernoulliSampler bernoulliSampler;
+    init(bernoulliSampler, options.sampleFraction, options.seed);
+    ReservoirSampler reservoirSampler;
+    seqan::String<seqan::Pair<__uint64> > reservoir;
+    if (sampleByCount)
+    {
+        init(reservoirSampler, options.sampleCount, options.seed);
+        reserve(reservoir, std::min(options.sampleCount, (__uint64)1024 * 1024));
+    }
+    __uint64 numSelected = 0;
+    // Records that are too short after trimming are dropped before they can take a place in the reservoir, so
+    // exactly sampleCount records are written if there are enough.
+    bool trimBeforeSampling = sampleByCount && options.trimMinLength > 0u;
+
+    // Deduplication, either in this pass or with duplicates marked in dupBits in a first pass.
+    bool dedup = !empty(options.dedupMode);
+    bool dedupPartitioned = dedup && options.dedupPartitions > 0u;
+    DedupSet dedupSet;
+    DedupFingerprint fingerprint;
+    seqan::String<__uint64> dupBits;
+    __uint64 numDuplicates = 0;
+
+    // Sorting, the records are collected in the sorter and written at the end.
+    bool sorting = !empty(options.sortKey);
+    RecordSorter sorter;
+    if (sorting)
+    {
+        std::stringstream ss;
+        ss << options.tmpDir << "/fx_sak." << getpid() << ".sort.";
+        init(sorter, (__uint64)options.sortMemory * 1024 * 1024, ss.str(), options.numThreads);
+    }
+    if (dedup)
+        init(dedupSet, options.dedupHashBits / 64, (__uint64)options.dedupMemory * 1024 * 1024);
+    if (dedupPartitioned)
+    {
+        if (options.verbosity >= 2)
+            std::cerr << "Finding duplicates using " << options.dedupPartitions << " partitions ...";
+        if (markDuplicatesPartitioned(dupBits, fileBegin, fileEnd, format, selection, nameMatcher, adaptersPtr,
+                                      options) != 0)
+            return 1;
+        if (options.verbosity >= 2)
+            std::cerr << " OK\n";
+    }
+
+    __uint64 charsWritten = 0;
+    FxSakRecord record;
+    char const * windowRecordEnd = 0;
+    while (charsWritten < options.maxLength && idx < endIdx &&
+           fillWindow(window, windowRecordEnd, it, fileBegin, fileEnd, format) && it != fileEnd)
+    {
+        // Check whether to write out sequence.
+        bool writeOut = isSelected(selection, nameMatcher, idx, it, fileEnd);
+
+        // Drop exact duplicates of earlier selected records.  Without partitioning, the record has to be parsed for
+        // computing its fingerprint.  The end of a streamed record is already known from filling the window.
+        char const * recordEnd = windowRecordEnd;
+        bool parsed = false;
+        if (writeOut && dedupPartitioned)
+        {
+            writeOut = !(idx / 64 < length(dupBits) && (dupBits[idx / 64] & ((__uint64)1 << (idx % 64))));
+            numDuplicates += !writeOut;
+        }
+        else if (writeOut && dedup)
+        {
+            if ((!recordEnd && (recordEnd = skipRawRecord(it, fileEnd, format)) == 0) ||
+                readSakRecord(record, it, recordEnd, format, options.outFastq) != 0)
+            {
+                std::cerr << "ERROR: Reading record " << idx << "!\n";
+                return 1;
+            }
+            parsed = true;
+            if (trimming && !trimSakRecord(record, adaptersPtr, options, &trimStats))
+            {
+                writeOut = false;
+            }
+            else
+            {
+                computeFingerprint(fingerprint, record, options);
+                int ret = insert(dedupSet, fingerprint);
+                if (ret < 0)
+                {
+                    std::cerr << "ERROR: Fingerprints exceed the memory budget, increase --dedup-memory or use "
+                              << "--dedup-partitions.\n";
+                    return 1;
+                }
+                writeOut = (ret == 1);
+                numDuplicates += !writeOut;
+            }
+        }
+
+        // Drop records that are too short after trimming before they are sampled.
+        if (writeOut && !parsed && trimBeforeSampling)
+        {
+            if ((!recordEnd && (recordEnd = skipRawRecord(it, fileEnd, format)) == 0) ||
+                readSakRecord(record, it, recordEnd, format, options.outFastq) != 0)
+            {
+                std::cerr << "ERROR: Reading record " << idx << "!\n";
+                return 1;
+            }
+            parsed = true;
+            writeOut = trimSakRecord(record, adaptersPtr, options, &trimStats);
+        }
+
+        // Random sampling.
+        __uint64 reservoirSlot = seqan::maxValue<__uint64>();
+        if (writeOut && sampleByFraction)
+            writeOut = sample(bernoulliSampler, numSelected++);
+        else if (writeOut && sampleByCount)
+            writeOut = ((reservoirSlot = sample(reservoirSampler, numSelected++)) != seqan::maxValue<__uint64>());
+
+        // Skip record without parsing it if we do not want it.  If only selecting by index and the next selected
+        // record is far away then seek there with the record index.
+        if (!writeOut)
+        {
+            if (useRecordIndex && empty(nameMatcher) && selection.cursor < length(selection.intervals) &&
+                selection.intervals[selection.cursor].i1 >= idx + options.recordIndexSampleRate)
+            {
+                __uint64 offset = 0, foundIdx = 0;
+                findRecord(offset, foundIdx, recordIndex, selection.intervals[selection.cursor].i1);
+                if (foundIdx > idx)
+                {
+                    it = fileBegin + offset;
+                    idx = foundIdx;
+                    continue;
+                }
+            }
+            if ((it = (recordEnd ? recordEnd : skipRawRecord(it, fileEnd, format))) == 0)
+            {
+                std::cerr << "ERROR: Invalid record " << idx << "!\n";
+                return 1;
+            }
+            idx += 1;
+            continue;
+        }
+
+        if (recordEnd == 0)
+            recordEnd = skipRawRecord(it, fileEnd, format);
+        if (recordEnd == 0)
+        {
+            std::cerr << "ERROR: Invalid record " << idx << "!\n";
+            return 1;
+        }
+
+        // Put records sampled into the reservoir aside, they are written at the end.
+        if (reservoirSlot != seqan::maxValue<__uint64>())
+        {
+            if (reservoirSlot >= length(reservoir))
+                resize(reservoir, reservoirSlot + 1);
+            reservoir[reservoirSlot] = seqan::Pair<__uint64>(it - fileBegin, recordEnd - fileBegin);
+        }
+        else
+        {
+            // Parse the record we want and write it out.
+            if (!parsed && readSakRecord(record, it, recordEnd, format, options.outFastq) != 0)
+            {
+                std::cerr << "ERROR: Reading record!\n";
+                return 1;
+            }
+            // Drop records that are too short after quality trimming.
+            if (!parsed && trimming && !trimSakRecord(record, adaptersPtr, options, &trimStats))
+            {
+                it = recordEnd;
+                idx += 1;
+                continue;
+            }
+            if (sorting)
+            {
+                if (addSortRecord(sorter, record, it - fileBegin, recordEnd - fileBegin, options) != 0)
+                {
+                    std::cerr << "ERROR: Writing sorted run to " << options.tmpDir << "!\n";
+                    return 1;
+                }
+            }
+            else
+            {
+                if (lookupRecordInfix(record, infixFilePtr, idx) != 0)
+                    return 1;
+                if (writeSakOutput(outPtr, outputSet, shardChooser, record, idx, charsWritten, options) != 0)
+                {
+                    std::cerr << "ERROR: Writing record!\n";
+                    return 1;
+                }
+            }
+        }
+
+        it = recordEnd;
+        idx += 1;
+    }
+
+    if (window.failed)
+    {
+        std::cerr << "ERROR: Could not read from " << options.inFastxPath << "\n";
+        return 1;
+    }
+
+    // Write out the records from the reservoir in input order.  When splitting into runs of records, the runs are
+    // taken from the sample.
+    std::sort(begin(reservoir, seqan::Standard()), end(reservoir, seqan::Standard()), LessBeginPos_());
+    shardChooser.numTotal = length(reservoir);
+    for (unsigned i = 0; i < length(reservoir) && charsWritten < options.maxLength; ++i)
+    {
+        if (readSakRecord(record, fileBegin + reservoir[i].i1, fileBegin + reservoir[i].i2, format,
+                          options.outFastq) != 0)
+        {
+            std::cerr << "ERROR: Reading record!\n";
+            return 1;
+        }
+        // With in-memory deduplication or a minimal length, the record was trimmed and counted before it was put into
+        // the reservoir.
+        TrimStats * stats = ((dedup && !dedupPartitioned) || trimBeforeSampling) ? 0 : &trimStats;
+        if (trimming && !trimSakRecord(record, adaptersPtr, options, stats))
+            continue;
+        if (sorting)
+        {
+            if (addSortRecord(sorter, record, reservoir[i].i1, reservoir[i].i2, options) != 0)
+            {
+                std::cerr << "ERROR: Writing sorted run to " << options.tmpDir << "!\n";
+                return 1;
+            }
+        }
+        else
+        {
+            // The record index is not known here, an infix file is keyed by name.
+            if (lookupRecordInfix(record, infixFilePtr, seqan::maxValue<__uint64>()) != 0)
+                return 1;
+            if (writeSakOutput(outPtr, outputSet, shardChooser, record, i, charsWritten, options) != 0)
+            {
+                std::cerr << "ERROR: Writing record!\n";
+                return 1;
+            }
+        }
+    }
+
+    // Write out the sorted records.
+    if (sorting)
+    {
+        if (options.verbosity >= 2)
+            std::cerr << "Merging " << sorter.runPaths.size() << " sorted runs of " << sorter.numRecords
+                      << " records\n";
+        shardChooser.numTotal = sorter.numRecords;
+        SortedRecordWriter_ sortedWriter(fileBegin, format, outPtr, outputSet, shardChooser, infixFilePtr, adaptersPtr,
+                                         charsWritten, options);
+        if (forEachSorted(sorter, sortedWriter) != 0)
+            return 1;
+    }
+    if (!options.infixFileIndices && !atEnd(infixFile) && charsWritten < options.maxLength)
+    {
+        std::cerr << "ERROR: Infix file entry in line " << infixFile.lineNo << " does not match the written "
+                  << "records in order, use --infix-file-unordered.\n";
+        return 1;
+    }
+    if (close(outputSet) != 0)
+    {
+        std::cerr << "ERROR: Writing output files!\n";
+        return 1;
+    }
+    if (options.verbosity >= 2 && (sampleByFraction || sampleByCount))
+        std::cerr << "Sampled from " << numSelected << " selected sequences\n";
+    if (options.verbosity >= 1 && qualityTrimmingEnabled(options))
+        std::cerr << "Quality trimming: " << trimStats.numTrimmedReads << " of " << trimStats.numReads
+                  << " reads trimmed, " << trimStats.numTrimmedBases << " bases removed\n";
+    if (options.verbosity >= 1 && adaptersPtr)
+        std::cerr << "Adapter trimming: " << trimStats.numAdapterReads << " of " << trimStats.numReads
+                  << " reads trimmed, " << trimStats.numAdapterBases << " bases removed\n";
+    if (options.verbosity >= 1 && options.trimMinLength > 0u)
+        std::cerr << "Dropped " << trimStats.numDropped << " reads shorter than " << options.trimMinLength
+                  << " after trimming\n";
+    if (options.verbosity >= 1 && dedup)
+        std::cerr << "Removed " << numDuplicates << " duplicate sequences\n";
+    if (options.verbosity >= 2 && options.numShards > 0u)
+    {
+        std::cerr << "SHARD\tRECORDS\tBASES\n";
+        for (unsigned i = 0; i < options.numShards; ++i)
+            std::cerr << i << "\t" << shardChooser.numRecords[i] << "\t" << shardChooser.numBases[i] << "\n";
+    }
+    if (options.verbosity >= 1 && shardChooser.mode == ShardChooser::MINIMIZER && shardChooser.numChosen > 0u)
+    {
+        // Partition balance: largest bucket relative to the mean.
+        __uint64 minBases = *std::min_element(begin(shardChooser.numBases, seqan::Standard()),
+                                              end(shardChooser.numBases, seqan::Standard()));
+        __uint64 maxBases = *std::max_element(begin(shardChooser.numBases, seqan::Standard()),
+                                              end(shardChooser.numBases, seqan::Standard()));
+        __uint64 totalBases = 0;
+        for (unsigned i = 0; i < length(shardChooser.numBases); ++i)
+            totalBases += shardChooser.numBases[i];
+        double meanBases = (double)totalBases / options.numShards;
+        std::cerr << "Minimizer buckets: " << options.numShards << ", bases min " << minBases << ", mean "
+                  << meanBases << ", max " << maxBases << ", max/mean "
+                  << (meanBases > 0 ? maxBases / meanBases : 1.0) << "\n";
+    }
+    if (options.verbosity >= 1 && !empty(sampleNames))
+        std::cerr << "Demultiplexed " << shardChooser.numChosen << " records, "
+                  << back(shardChooser.numRecords) << " without matching barcode\n";
+    if (options.verbosity >= 2 && !empty(sampleNames))
+    {
+        std::cerr << "SAMPLE\tRECORDS\tBASES\n";
+        for (unsigned i = 0; i < length(sampleNames); ++i)
+            std::cerr << sampleNames[i] << "\t" << shardChooser.numRecords[i] << "\t" << shardChooser.numBases[i]
+                      << "\n";
     }
 
     if (options.verbosity >= 2)
@@ -45,6 +45,8 @@
 #include <seqan/bam_io.h>
 #include <seqan/seq_io.h>
 
+#include "composition_index.h"
+
 // --------------------------------------------------------------------------
 // Class FxSamCoverageOptions
 // --------------------------------------------------------------------------
@@ -202,28 +204,41 @@ int main(int argc, char const ** argv)
               << "___C+G CONTENT COMPUTATION________________________________________________________\n"
               << "\n";
 
-    for (unsigned i = 0; i < numSeqs(faiIndex); ++i)
+    // Use the composition index next to the genome if there is one for this genome.  Otherwise, build it in memory,
+    // sampling at the bin boundaries such that each bin's composition is the difference of two samples.
+    CompositionIndex cmpIndex;
+    seqan::CharString cmpPath = options.inGenomePath;
+    append(cmpPath, ".cmp");
+    if (load(cmpIndex, toCString(cmpPath)) != 0 || !isCompatible(cmpIndex, faiIndex))
     {
-        std::cerr << "[" << sequenceName(faiIndex, i) << "] ...";
-        unsigned numBins = (sequenceLength(faiIndex, i) + options.windowSize - 1) / options.windowSize;
-        resize(bins[i], numBins);
-        seqan::Dna5String contigSeq;
-        if (readSequence(contigSeq, faiIndex, i) != 0)
+        std::cerr << "Indexing composition ...";
+        if (build(cmpIndex, faiIndex, options.windowSize) != 0)
         {
-            std::cerr << "\nERROR: Could not read sequence " << sequenceName(faiIndex, i) << " from file!\n";
+            std::cerr << "\nERROR: Could not build composition index!\n";
             return 1;
         }
+        std::cerr << " OK\n";
+    }
+
+    for (unsigned i = 0; i < numSeqs(faiIndex); ++i)
+    {
+        std::cerr << "[" << sequenceName(faiIndex, i) << "] ...";
+        unsigned seqLength = sequenceLength(faiIndex, i);
+        unsigned numBins = (seqLength + options.windowSize - 1) / options.windowSize;
+        resize(bins[i], numBins);
 
         for (unsigned bin = 0; bin < numBins; ++bin)
         {
-            unsigned cgCounter = 0;
-            unsigned binSize = 0;
-            bins[i][bin].length = options.windowSize;
-            if ((bin + 1) * options.windowSize > length(contigSeq))
-                bins[i][bin].length = length(contigSeq) - bin * options.windowSize;
-            for (unsigned pos = bin * options.windowSize; pos < length(contigSeq) && pos < (bin + 1) * options.windowSize; ++pos, ++binSize)
-                cgCounter += (contigSeq[pos] == 'C' || contigSeq[pos] == 'G');
-            bins[i][bin].cgContent = 1.0 * cgCounter / binSize;
+            unsigned binBegin = bin * options.windowSize;
+            unsigned binEnd = std::min(binBegin + options.windowSize, seqLength);
+            bins[i][bin].length = binEnd - binBegin;
+            CompositionCounts counts;
+            if (getComposition(counts, cmpIndex, faiIndex, i, binBegin, binEnd) != 0)
+            {
+                std::cerr << "\nERROR: Could not read sequence " << sequenceName(faiIndex, i) << " from file!\n";
+                return 1;
+            }
+            bins[i][bin].cgContent = cgContent(counts);
         }
         std::cerr << "DONE\n";
     }
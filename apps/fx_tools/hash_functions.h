@@ -0,0 +1,126 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Fast non-cryptographic 64 bit hashing of byte strings.
+//
+// The input is consumed in 8 byte words with one multiplication and rotation
+// per word, followed by a final avalanche step (the SplitMix64 finalizer).
+// This is in the spirit of the xxHash/wyhash family and good enough for hash
+// tables and fingerprints.
+//
+// DnaCodeTable gives the 2 bit codes for packing k-mers into words before
+// hashing them.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_HASH_FUNCTIONS_H_
+#define SANDBOX_FX_TOOLS_APPS_FX_TOOLS_HASH_FUNCTIONS_H_
+
+#include <algorithm>
+#include <cstring>
+
+#include <seqan/basic.h>
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class DnaCodeTable
+// ----------------------------------------------------------------------------
+
+// Maps ACGT (either case) to 0-3, everything else to 4.
+
+struct DnaCodeTable
+{
+    unsigned char table[256];
+
+    DnaCodeTable()
+    {
+        std::fill(table, table + 256, 4);
+        table[(unsigned char)'A'] = table[(unsigned char)'a'] = 0;
+        table[(unsigned char)'C'] = table[(unsigned char)'c'] = 1;
+        table[(unsigned char)'G'] = table[(unsigned char)'g'] = 2;
+        table[(unsigned char)'T'] = table[(unsigned char)'t'] = 3;
+    }
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function mixHash64()
+// ----------------------------------------------------------------------------
+
+// Avalanche the bits of x, this is the SplitMix64 finalizer.
+
+inline __uint64 mixHash64(__uint64 x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// ----------------------------------------------------------------------------
+// Function hashBytes()
+// ----------------------------------------------------------------------------
+
+inline __uint64 hashBytes(char const * ptr, size_t len, __uint64 seed = 0)
+{
+    __uint64 const PRIME1 = 0x9e3779b185ebca87ULL;
+    __uint64 const PRIME2 = 0xc2b2ae3d27d4eb4fULL;
+
+    __uint64 h = seed ^ (len * PRIME1);
+    for (; len >= 8u; ptr += 8, len -= 8)
+    {
+        __uint64 word;
+        memcpy(&word, ptr, 8);
+        word *= PRIME2;
+        word = (word << 31) | (word >> 33);
+        h ^= word * PRIME1;
+        h = ((h << 27) | (h >> 37)) * PRIME1 + PRIME2;
+    }
+    if (len > 0u)
+    {
+        __uint64 word = 0;
+        memcpy(&word, ptr, len);
+        h ^= (word * PRIME2) ^ (word >> 29);
+        h *= PRIME1;
+    }
+    return mixHash64(h);
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_HASH_FUNCTIONS_H_
@@ -0,0 +1,151 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Sets of selected record indices.
+//
+// The single indices and index ranges given on the command line are compiled
+// into sorted, disjoint intervals that are queried in increasing index order.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_INDEX_INTERVAL_SET_H_
+#define SANDBOX_FX_TOOLS_APPS_FX_TOOLS_INDEX_INTERVAL_SET_H_
+
+#include <algorithm>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class IndexIntervalSet
+// ----------------------------------------------------------------------------
+
+// The sequence index selections, compiled into sorted, disjoint and non-adjacent half-open intervals.  Since the
+// records are read in order, membership is checked with a cursor that only moves forward.
+
+struct IndexIntervalSet
+{
+    // Whether or not any selection was given, the intervals can still be empty.
+    bool active;
+
+    // The intervals [i1, i2).
+    seqan::String<seqan::Pair<__uint64> > intervals;
+
+    // Index of the first interval that does not end at or before the last queried index.
+    unsigned cursor;
+
+    IndexIntervalSet() : active(false), cursor(0)
+    {}
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function build()                                        [IndexIntervalSet]
+// ----------------------------------------------------------------------------
+
+struct LessBeginPos_
+{
+    bool operator()(seqan::Pair<__uint64> const & lhs, seqan::Pair<__uint64> const & rhs) const
+    {
+        return lhs.i1 < rhs.i1;
+    }
+};
+
+inline void build(IndexIntervalSet & set,
+                  seqan::String<__uint64> const & seqIndices,
+                  seqan::String<seqan::Pair<__uint64> > const & seqIndexRanges)
+{
+    set.active = !empty(seqIndices) || !empty(seqIndexRanges);
+    set.cursor = 0;
+
+    seqan::String<seqan::Pair<__uint64> > tmp;
+    for (unsigned i = 0; i < length(seqIndices); ++i)
+        appendValue(tmp, seqan::Pair<__uint64>(seqIndices[i], seqIndices[i] + 1));
+    for (unsigned i = 0; i < length(seqIndexRanges); ++i)
+        if (seqIndexRanges[i].i1 < seqIndexRanges[i].i2)
+            appendValue(tmp, seqIndexRanges[i]);
+    std::sort(begin(tmp, seqan::Standard()), end(tmp, seqan::Standard()), LessBeginPos_());
+
+    // Merge overlapping and adjacent intervals.
+    clear(set.intervals);
+    for (unsigned i = 0; i < length(tmp); ++i)
+    {
+        if (!empty(set.intervals) && tmp[i].i1 <= back(set.intervals).i2)
+            back(set.intervals).i2 = std::max(back(set.intervals).i2, tmp[i].i2);
+        else
+            appendValue(set.intervals, tmp[i]);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function contains()                                     [IndexIntervalSet]
+// ----------------------------------------------------------------------------
+
+// Returns true if idx is selected.  The queried indices must not decrease between calls.
+
+inline bool contains(IndexIntervalSet & set, __uint64 idx)
+{
+    while (set.cursor < length(set.intervals) && set.intervals[set.cursor].i2 <= idx)
+        ++set.cursor;
+    return set.cursor < length(set.intervals) && set.intervals[set.cursor].i1 <= idx;
+}
+
+// ----------------------------------------------------------------------------
+// Function beginIndex(), endIndex()                       [IndexIntervalSet]
+// ----------------------------------------------------------------------------
+
+// Index of the first selected sequence, maxValue if there is none.
+
+inline __uint64 beginIndex(IndexIntervalSet const & set)
+{
+    if (empty(set.intervals))
+        return seqan::maxValue<__uint64>();
+    return front(set.intervals).i1;
+}
+
+// Index behind the last selected sequence, 0 if there is none.
+
+inline __uint64 endIndex(IndexIntervalSet const & set)
+{
+    if (empty(set.intervals))
+        return 0;
+    return back(set.intervals).i2;
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_INDEX_INTERVAL_SET_H_
@@ -0,0 +1,309 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Per-record infix coordinates from a tab-separated file.
+//
+// Each line holds a key, a 0-based begin and an end position.  The key is
+// either the first word of the record identifier or the 0-based record
+// index.  Lines that are empty or start with '#' are ignored.
+//
+// If the file is in the order of the records, it is streamed and only the
+// next entry is kept in memory.  Otherwise, all entries are loaded into an
+// open addressing hash table keyed by 64 bit fingerprints of the names.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_INFIX_FILE_H_
+#define SANDBOX_FX_TOOLS_APPS_FX_TOOLS_INFIX_FILE_H_
+
+#include <fstream>
+#include <string>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include "hash_functions.h"
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class InfixEntry_
+// ----------------------------------------------------------------------------
+
+struct InfixEntry_
+{
+    // Record index + 1 or name fingerprint, 0 marks empty hash table slots.
+    __uint64 key;
+    __uint64 beginPos;
+    __uint64 endPos;
+
+    InfixEntry_() : key(0), beginPos(0), endPos(0)
+    {}
+};
+
+// ----------------------------------------------------------------------------
+// Class InfixFile
+// ----------------------------------------------------------------------------
+
+class InfixFile
+{
+public:
+    // Whether the keys are record indices instead of names.
+    bool byIndex;
+    // Whether the file is streamed instead of loaded into the hash table.
+    bool streamed;
+
+    std::ifstream in;
+    // Number of the last line read, for error messages.
+    __uint64 lineNo;
+
+    // Next entry when streaming, pendingName is its name if not by index.
+    bool hasPending;
+    InfixEntry_ pending;
+    std::string pendingName;
+
+    // The hash table when not streaming, the size is a power of two.
+    seqan::String<InfixEntry_> table;
+    __uint64 size;
+
+    InfixFile() : byIndex(false), streamed(true), lineNo(0), hasPending(false), size(0)
+    {}
+
+private:
+    InfixFile(InfixFile const &);
+    InfixFile & operator=(InfixFile const &);
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function infixNameKey_()
+// ----------------------------------------------------------------------------
+
+inline __uint64 infixNameKey_(char const * ptr, size_t len)
+{
+    __uint64 h = hashBytes(ptr, len);
+    return h ? h : 1;  // 0 marks empty slots.
+}
+
+// ----------------------------------------------------------------------------
+// Function readEntry_()                                            [InfixFile]
+// ----------------------------------------------------------------------------
+
+// Read the next entry into entry and name.  Returns 0 on success, 1 on errors and -1 at the end of the file.
+
+inline int readEntry_(InfixEntry_ & entry, std::string & name, InfixFile & file)
+{
+    std::string line;
+    while (std::getline(file.in, line))
+    {
+        file.lineNo += 1;
+        if (!line.empty() && line[line.size() - 1] == '\r')
+            line.resize(line.size() - 1);
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        size_t tab1 = line.find('\t');
+        size_t tab2 = (tab1 == std::string::npos) ? tab1 : line.find('\t', tab1 + 1);
+        if (tab2 == std::string::npos)
+            return 1;
+        size_t tab3 = line.find('\t', tab2 + 1);
+        name.assign(line, 0, tab1);
+        if (!seqan::lexicalCast2(entry.beginPos, line.substr(tab1 + 1, tab2 - tab1 - 1)) ||
+            !seqan::lexicalCast2(entry.endPos, line.substr(tab2 + 1, tab3 - tab2 - 1)) ||
+            entry.endPos < entry.beginPos || name.empty())
+            return 1;
+
+        if (file.byIndex)
+        {
+            __uint64 idx = 0;
+            if (!seqan::lexicalCast2(idx, name))
+                return 1;
+            entry.key = idx + 1;
+        }
+        else
+        {
+            entry.key = infixNameKey_(name.data(), name.size());
+        }
+        return 0;
+    }
+    return -1;
+}
+
+// ----------------------------------------------------------------------------
+// Function insert_()                                               [InfixFile]
+// ----------------------------------------------------------------------------
+
+inline void insert_(InfixFile & file, InfixEntry_ const & entry)
+{
+    // Grow to keep the load factor at or below 1/2.
+    if (2 * (file.size + 1) > length(file.table))
+    {
+        seqan::String<InfixEntry_> oldTable;
+        swap(oldTable, file.table);
+        resize(file.table, std::max((size_t)1024, (size_t)(2 * length(oldTable))));
+        file.size = 0;
+        for (size_t i = 0; i < length(oldTable); ++i)
+            if (oldTable[i].key)
+                insert_(file, oldTable[i]);
+    }
+
+    __uint64 mask = length(file.table) - 1;
+    __uint64 pos = mixHash64(entry.key) & mask;
+    while (file.table[pos].key && file.table[pos].key != entry.key)
+        pos = (pos + 1) & mask;
+    if (!file.table[pos].key)
+        file.size += 1;
+    file.table[pos] = entry;  // Later entries replace earlier ones.
+}
+
+// ----------------------------------------------------------------------------
+// Function open()                                                  [InfixFile]
+// ----------------------------------------------------------------------------
+
+// Open the infix file at path.  Unless streamed is true, the whole file is loaded.  Returns 0 on success, 1 on
+// errors; file.lineNo is the number of the offending line for parse errors.
+
+inline int open(InfixFile & file, char const * path, bool byIndex, bool streamed)
+{
+    file.byIndex = byIndex;
+    file.streamed = streamed;
+    file.lineNo = 0;
+    file.hasPending = false;
+    file.in.open(path, std::ios::binary | std::ios::in);
+    if (!file.in.good())
+        return 1;
+
+    int res = 0;
+    if (streamed)
+    {
+        res = readEntry_(file.pending, file.pendingName, file);
+        file.hasPending = (res == 0);
+        return res > 0;
+    }
+
+    InfixEntry_ entry;
+    std::string name;
+    while ((res = readEntry_(entry, name, file)) == 0)
+        insert_(file, entry);
+    file.in.close();
+    return res > 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function lookup()                                                [InfixFile]
+// ----------------------------------------------------------------------------
+
+// Look up the infix of the record with index idx and identifier [id, id + idLen).  found is set to whether there
+// is an entry, beginPos and endPos to its coordinates.  Returns 0 on success, 1 on parse errors and streamed
+// indices that are not increasing and 2 if a streamed name entry does not match the record.
+//
+// When streaming, entries are consumed in file order.  Index entries are used when they match the record and kept
+// for later records otherwise, entries with indices below idx refer to records that were not written and are
+// dropped.  Name entries cannot be skipped like this since a name that does not match might still come later, so
+// every looked up record must have the next entry.
+
+inline int lookup(bool & found,
+                  __uint64 & beginPos,
+                  __uint64 & endPos,
+                  InfixFile & file,
+                  __uint64 idx,
+                  char const * id,
+                  size_t idLen)
+{
+    found = false;
+    if (!file.streamed)
+    {
+        if (file.size == 0u)
+            return 0;
+        __uint64 key = file.byIndex ? idx + 1 : infixNameKey_(id, idLen);
+        __uint64 mask = length(file.table) - 1;
+        for (__uint64 pos = mixHash64(key) & mask; file.table[pos].key; pos = (pos + 1) & mask)
+        {
+            if (file.table[pos].key == key)
+            {
+                found = true;
+                beginPos = file.table[pos].beginPos;
+                endPos = file.table[pos].endPos;
+                break;
+            }
+        }
+        return 0;
+    }
+
+    if (file.byIndex)
+    {
+        while (file.hasPending && file.pending.key < idx + 1)
+        {
+            __uint64 prevKey = file.pending.key;
+            int res = readEntry_(file.pending, file.pendingName, file);
+            file.hasPending = (res == 0);
+            if (res > 0 || (res == 0 && file.pending.key <= prevKey))
+                return 1;
+        }
+        found = file.hasPending && file.pending.key == idx + 1;
+    }
+    else
+    {
+        found = file.hasPending && file.pendingName.size() == idLen &&
+                file.pendingName.compare(0, idLen, id, idLen) == 0;
+        if (!found)
+            return 2;
+    }
+    if (!found)
+        return 0;
+
+    beginPos = file.pending.beginPos;
+    endPos = file.pending.endPos;
+    int res = readEntry_(file.pending, file.pendingName, file);
+    file.hasPending = (res == 0);
+    if (res == 0 && file.byIndex && file.pending.key <= idx + 1)
+        return 1;
+    return res > 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function atEnd()                                                 [InfixFile]
+// ----------------------------------------------------------------------------
+
+// Returns true if all streamed entries were used.
+
+inline bool atEnd(InfixFile const & file)
+{
+    return !file.streamed || !file.hasPending;
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_INFIX_FILE_H_
@@ -0,0 +1,504 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Fixed memory sketches for finding overrepresented k-mers and estimating
+// the number of distinct reads.
+//
+// CountMinSketch counts k-mers with conservative updates.  It is blocked:
+// the counters of one key are all in the same 64 byte line such that an
+// update touches one cache line.  TopKmers keeps the k-mers with the largest
+// estimated counts (heavy hitters).  HyperLogLog estimates the number of
+// distinct read sequences from their hashes.  All of them can be merged,
+// e.g. the sketches of several threads.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_KMER_SKETCH_H_
+#define SANDBOX_FX_TOOLS_APPS_FX_TOOLS_KMER_SKETCH_H_
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+#include <seqan/basic.h>
+
+#include "hash_functions.h"
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class CountMinSketch
+// ----------------------------------------------------------------------------
+
+// Key x is counted in four counters of line h(x) % numLines, chosen by further independent bits of h(x), i.e. the
+// rows of the sketch are interleaved.  The counters saturate.
+
+struct CountMinSketch
+{
+    static unsigned const LINE_SIZE = 16;
+
+    // Number of lines, a power of two.
+    unsigned numLines;
+
+    std::vector<__uint32> store;
+    // Index of the first 64 byte aligned counter in store.
+    size_t offset;
+
+    CountMinSketch() : numLines(0), offset(0)
+    {}
+
+    CountMinSketch(CountMinSketch const & other) : numLines(0), offset(0)
+    {
+        *this = other;
+    }
+
+    CountMinSketch & operator=(CountMinSketch const & other);
+};
+
+// ----------------------------------------------------------------------------
+// Class TopKmers
+// ----------------------------------------------------------------------------
+
+// The k-mers with the largest estimated counts in no particular order, at most capacity.
+
+struct TopKmers
+{
+    unsigned capacity;
+    std::vector<std::pair<__uint64, __uint64> > entries;  // (k-mer, count)
+    // Smallest count in entries if there are capacity entries, 0 otherwise.
+    __uint64 minCount;
+
+    TopKmers() : capacity(0), minCount(0)
+    {}
+};
+
+// ----------------------------------------------------------------------------
+// Class HyperLogLog
+// ----------------------------------------------------------------------------
+
+struct HyperLogLog
+{
+    // There are 2^precision registers.
+    unsigned precision;
+    std::vector<unsigned char> registers;
+
+    HyperLogLog() : precision(0)
+    {}
+};
+
+// ----------------------------------------------------------------------------
+// Class KmerSketch
+// ----------------------------------------------------------------------------
+
+// Counts the k-mers of all reads and their distinct sequences.  k-mers with ambiguous bases are skipped.  Disabled
+// if k is 0.
+
+struct KmerSketch
+{
+    unsigned k;
+    __uint64 numKmers;
+    __uint64 numReads;
+
+    CountMinSketch counts;
+    TopKmers top;
+    HyperLogLog distinctReads;
+
+    KmerSketch() : k(0), numKmers(0), numReads(0)
+    {}
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function init()                                             [CountMinSketch]
+// ----------------------------------------------------------------------------
+
+// Use 2^lineBits lines of 64 bytes.
+
+inline void init(CountMinSketch & sketch, unsigned lineBits)
+{
+    sketch.numLines = 1u << lineBits;
+    std::vector<__uint32> store((size_t)sketch.numLines * CountMinSketch::LINE_SIZE + CountMinSketch::LINE_SIZE, 0);
+    size_t misalignment = (reinterpret_cast<size_t>(&store[0]) / sizeof(__uint32)) % CountMinSketch::LINE_SIZE;
+    sketch.offset = misalignment ? CountMinSketch::LINE_SIZE - misalignment : 0;
+    sketch.store.swap(store);
+}
+
+inline CountMinSketch & CountMinSketch::operator=(CountMinSketch const & other)
+{
+    if (this == &other)
+        return *this;
+    store.clear();
+    numLines = 0;
+    if (other.numLines)
+    {
+        unsigned lineBits = 0;
+        while ((1u << lineBits) < other.numLines)
+            ++lineBits;
+        init(*this, lineBits);
+        std::copy(other.store.begin() + other.offset,
+                  other.store.begin() + other.offset + (size_t)numLines * LINE_SIZE,
+                  store.begin() + offset);
+    }
+    return *this;
+}
+
+// ----------------------------------------------------------------------------
+// Function counterIndices_()                                  [CountMinSketch]
+// ----------------------------------------------------------------------------
+
+// Write the store indices of the counters of the key with hash value h to indices.
+
+inline void counterIndices_(size_t indices[4], CountMinSketch const & sketch, __uint64 h)
+{
+    size_t line = sketch.offset + (size_t)(h & (sketch.numLines - 1)) * CountMinSketch::LINE_SIZE;
+    for (unsigned i = 0; i < 4; ++i)
+        indices[i] = line + ((h >> (32 + 4 * i)) & 15);
+}
+
+// ----------------------------------------------------------------------------
+// Function increment()                                        [CountMinSketch]
+// ----------------------------------------------------------------------------
+
+// Count the key with hash value h and return its new estimated count.  Conservative update: only the smallest
+// counters are incremented.
+
+inline __uint64 increment(CountMinSketch & sketch, __uint64 h)
+{
+    size_t idx[4];
+    counterIndices_(idx, sketch, h);
+    __uint32 * counters = &sketch.store[0];
+    __uint32 v0 = counters[idx[0]], v1 = counters[idx[1]], v2 = counters[idx[2]], v3 = counters[idx[3]];
+    __uint32 m01 = (v0 < v1) ? v0 : v1;
+    __uint32 m23 = (v2 < v3) ? v2 : v3;
+    __uint32 estimate = (m01 < m23) ? m01 : m23;
+    // Branch-free, the counters are at least estimate and the smallest ones are incremented unless saturated.  Rows
+    // can share a counter, the values are therefore all read before writing.
+    __uint32 inc = (estimate != seqan::maxValue<__uint32>());
+    counters[idx[0]] = v0 + (v0 == estimate) * inc;
+    counters[idx[1]] = v1 + (v1 == estimate) * inc;
+    counters[idx[2]] = v2 + (v2 == estimate) * inc;
+    counters[idx[3]] = v3 + (v3 == estimate) * inc;
+    return estimate + inc;
+}
+
+// ----------------------------------------------------------------------------
+// Function estimate()                                         [CountMinSketch]
+// ----------------------------------------------------------------------------
+
+inline __uint64 estimate(CountMinSketch const & sketch, __uint64 h)
+{
+    size_t idx[4];
+    counterIndices_(idx, sketch, h);
+    std::vector<__uint32> const & counters = sketch.store;
+    return std::min(std::min(counters[idx[0]], counters[idx[1]]), std::min(counters[idx[2]], counters[idx[3]]));
+}
+
+// ----------------------------------------------------------------------------
+// Function merge()                                            [CountMinSketch]
+// ----------------------------------------------------------------------------
+
+// Add the counters of other, which must have the same number of lines.  Returns 0 on success, 1 if the numbers of
+// lines differ.
+
+inline int merge(CountMinSketch & sketch, CountMinSketch const & other)
+{
+    if (sketch.numLines != other.numLines)
+        return 1;
+    if (sketch.numLines == 0u)
+        return 0;
+    __uint32 * it = &sketch.store[sketch.offset];
+    __uint32 const * otherIt = &other.store[other.offset];
+    for (size_t i = 0; i < (size_t)sketch.numLines * CountMinSketch::LINE_SIZE; ++i)
+        it[i] = (it[i] > seqan::maxValue<__uint32>() - otherIt[i]) ? seqan::maxValue<__uint32>() : it[i] + otherIt[i];
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function update()                                                 [TopKmers]
+// ----------------------------------------------------------------------------
+
+// Update the count of kmer to count.  Cheap unless count exceeds the smallest count of a full set.
+
+inline void update(TopKmers & top, __uint64 kmer, __uint64 count)
+{
+    if (top.capacity == 0u || (top.entries.size() == top.capacity && count <= top.minCount))
+        return;
+
+    size_t pos = 0;
+    while (pos < top.entries.size() && top.entries[pos].first != kmer)
+        ++pos;
+    if (pos == top.entries.size())
+    {
+        if (top.entries.size() < top.capacity)
+        {
+            top.entries.push_back(std::make_pair(kmer, count));
+            if (top.entries.size() < top.capacity)
+                return;
+        }
+        else
+        {
+            // Replace the entry with the smallest count.
+            pos = 0;
+            for (size_t i = 1; i < top.entries.size(); ++i)
+                if (top.entries[i].second < top.entries[pos].second)
+                    pos = i;
+            top.entries[pos] = std::make_pair(kmer, count);
+        }
+    }
+    else
+    {
+        bool wasMin = (top.entries[pos].second == top.minCount);
+        top.entries[pos].second = count;
+        if (!wasMin)
+            return;
+    }
+
+    top.minCount = top.entries[0].second;
+    for (size_t i = 1; i < top.entries.size(); ++i)
+        top.minCount = std::min(top.minCount, top.entries[i].second);
+}
+
+// ----------------------------------------------------------------------------
+// Function init()                                                [HyperLogLog]
+// ----------------------------------------------------------------------------
+
+inline void init(HyperLogLog & hll, unsigned precision)
+{
+    hll.precision = precision;
+    hll.registers.assign((size_t)1 << precision, 0);
+}
+
+// ----------------------------------------------------------------------------
+// Function insert()                                              [HyperLogLog]
+// ----------------------------------------------------------------------------
+
+// Insert the item with the hash value h.
+
+inline void insert(HyperLogLog & hll, __uint64 h)
+{
+    size_t idx = h >> (64 - hll.precision);
+    // Rank of the first 1 bit in the remaining bits, the sentinel bounds it.
+    __uint64 rest = (h << hll.precision) | ((__uint64)1 << (hll.precision - 1));
+    unsigned char rank = 1;
+    for (; !(rest & ((__uint64)1 << 63)); rest <<= 1)
+        ++rank;
+    hll.registers[idx] = std::max(hll.registers[idx], rank);
+}
+
+// ----------------------------------------------------------------------------
+// Function cardinality()                                         [HyperLogLog]
+// ----------------------------------------------------------------------------
+
+// Returns the estimated number of distinct items, using linear counting for small cardinalities.
+
+inline double cardinality(HyperLogLog const & hll)
+{
+    double m = hll.registers.size();
+    double sum = 0;
+    unsigned numZeros = 0;
+    for (size_t i = 0; i < hll.registers.size(); ++i)
+    {
+        sum += std::ldexp(1.0, -hll.registers[i]);
+        numZeros += (hll.registers[i] == 0);
+    }
+    double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+    if (estimate <= 2.5 * m && numZeros > 0u)
+        estimate = m * std::log(m / numZeros);
+    return estimate;
+}
+
+// ----------------------------------------------------------------------------
+// Function merge()                                               [HyperLogLog]
+// ----------------------------------------------------------------------------
+
+// Returns 0 on success, 1 if the numbers of registers differ.
+
+inline int merge(HyperLogLog & hll, HyperLogLog const & other)
+{
+    if (hll.registers.size() != other.registers.size())
+        return 1;
+    for (size_t i = 0; i < hll.registers.size(); ++i)
+        hll.registers[i] = std::max(hll.registers[i], other.registers[i]);
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function init()                                                 [KmerSketch]
+// ----------------------------------------------------------------------------
+
+// Count k-mers for 1 <= k <= 31 in 2^lineBits lines and keep topSize heavy hitters, 0 disables the sketch.
+
+inline void init(KmerSketch & sketch, unsigned k, unsigned lineBits, unsigned topSize)
+{
+    sketch = KmerSketch();
+    sketch.k = k;
+    if (k == 0u)
+        return;
+    init(sketch.counts, lineBits);
+    sketch.top.capacity = topSize;
+    init(sketch.distinctReads, 14);
+}
+
+// ----------------------------------------------------------------------------
+// Function initLike()                                             [KmerSketch]
+// ----------------------------------------------------------------------------
+
+// Initialize sketch empty with the parameters of other.
+
+inline void initLike(KmerSketch & sketch, KmerSketch const & other)
+{
+    unsigned lineBits = 0;
+    while ((1u << lineBits) < other.counts.numLines)
+        ++lineBits;
+    init(sketch, other.k, lineBits, other.top.capacity);
+}
+
+// ----------------------------------------------------------------------------
+// Function addRead()                                              [KmerSketch]
+// ----------------------------------------------------------------------------
+
+inline void addRead(KmerSketch & sketch, char const * seq, unsigned len)
+{
+    if (sketch.k == 0u)
+        return;
+    static DnaCodeTable const CODES;
+    static unsigned const BLOCK_SIZE = 64;
+
+    sketch.numReads += 1;
+    insert(sketch.distinctReads, hashBytes(seq, len));
+
+    __uint64 const mask = ((__uint64)1 << (2 * sketch.k)) - 1;
+    __uint64 kmer = 0;
+    unsigned numValid = 0;  // Number of unambiguous bases ending at the current position.
+
+    // The k-mers of a block are hashed and their lines prefetched first such that the cache misses of the updates
+    // overlap.
+    __uint64 kmers[BLOCK_SIZE];
+    __uint64 hashes[BLOCK_SIZE];
+    for (unsigned blockBegin = 0; blockBegin < len; blockBegin += BLOCK_SIZE)
+    {
+        unsigned blockLen = std::min(BLOCK_SIZE, len - blockBegin);
+        unsigned numKmers = 0;
+        for (unsigned j = 0; j < blockLen; ++j)
+        {
+            unsigned c = CODES.table[(unsigned char)seq[blockBegin + j]];
+            kmer = ((kmer << 2) | (c & 3)) & mask;
+            numValid = (c & 4) ? 0 : numValid + 1;
+            if (numValid < sketch.k)
+                continue;
+            kmers[numKmers] = kmer;
+            hashes[numKmers] = mixHash64(kmer);
+#if defined(__GNUC__)
+            __builtin_prefetch(&sketch.counts.store[sketch.counts.offset] +
+                               (size_t)(hashes[numKmers] & (sketch.counts.numLines - 1)) * CountMinSketch::LINE_SIZE);
+#endif  // #if defined(__GNUC__)
+            ++numKmers;
+        }
+
+        sketch.numKmers += numKmers;
+        for (unsigned j = 0; j < numKmers; ++j)
+            update(sketch.top, kmers[j], increment(sketch.counts, hashes[j]));
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function merge()                                                [KmerSketch]
+// ----------------------------------------------------------------------------
+
+// Merge other into sketch.  Both must use the same parameters unless one of them is disabled.  The heavy hitters are
+// the candidates of both with the largest merged estimates.  Returns 0 on success, 1 if k or the sketch sizes differ,
+// sketch is left unchanged then.
+
+inline int merge(KmerSketch & sketch, KmerSketch const & other)
+{
+    if (other.k == 0u)
+        return 0;
+    if (sketch.k == 0u)
+    {
+        sketch = other;
+        return 0;
+    }
+    if (sketch.k != other.k || sketch.counts.numLines != other.counts.numLines ||
+        sketch.distinctReads.registers.size() != other.distinctReads.registers.size())
+        return 1;
+
+    sketch.numKmers += other.numKmers;
+    sketch.numReads += other.numReads;
+    merge(sketch.counts, other.counts);
+    merge(sketch.distinctReads, other.distinctReads);
+
+    std::vector<std::pair<__uint64, __uint64> > candidates(sketch.top.entries);
+    candidates.insert(candidates.end(), other.top.entries.begin(), other.top.entries.end());
+    sketch.top.entries.clear();
+    sketch.top.minCount = 0;
+    for (size_t i = 0; i < candidates.size(); ++i)
+        update(sketch.top, candidates[i].first, estimate(sketch.counts, mixHash64(candidates[i].first)));
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function topKmers()                                             [KmerSketch]
+// ----------------------------------------------------------------------------
+
+// Write the heavy hitters with their estimated counts to result, by decreasing count.
+
+inline void topKmers(std::vector<std::pair<__uint64, __uint64> > & result, KmerSketch const & sketch)
+{
+    result.clear();
+    for (size_t i = 0; i < sketch.top.entries.size(); ++i)
+    {
+        __uint64 kmer = sketch.top.entries[i].first;
+        result.push_back(std::make_pair(estimate(sketch.counts, mixHash64(kmer)), kmer));
+    }
+    std::sort(result.begin(), result.end(), std::greater<std::pair<__uint64, __uint64> >());
+    for (size_t i = 0; i < result.size(); ++i)
+        std::swap(result[i].first, result[i].second);
+}
+
+// ----------------------------------------------------------------------------
+// Function kmerToString()
+// ----------------------------------------------------------------------------
+
+inline void kmerToString(seqan::CharString & result, __uint64 kmer, unsigned k)
+{
+    resize(result, k);
+    for (unsigned i = 0; i < k; ++i, kmer >>= 2)
+        result[k - 1 - i] = "ACGT"[kmer & 3];
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_KMER_SKETCH_H_
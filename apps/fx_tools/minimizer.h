@@ -0,0 +1,108 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Read minimizers for content-based partitioning.
+//
+// The minimizer of a read is its canonical k-mer (the smaller of the k-mer
+// and its reverse complement in 2-bit encoding) with the smallest hash
+// value.  Reads that overlap by a stretch containing this k-mer share it,
+// as do a read and its reverse complement, so hashing the minimizer to a
+// bucket keeps overlapping reads together.
+//
+// The read is processed in blocks: a scalar loop rolls the forward and
+// reverse complement k-mers over the block, a second loop without data
+// dependencies hashes them and takes the minimum.  The compiler can
+// vectorize the latter.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_MINIMIZER_H_
+#define SANDBOX_FX_TOOLS_APPS_FX_TOOLS_MINIMIZER_H_
+
+#include <algorithm>
+
+#include <seqan/basic.h>
+
+#include "hash_functions.h"
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function readMinimizer()
+// ----------------------------------------------------------------------------
+
+// Returns the hash value of the minimizer of [seq, seq + len) for k <= 31, maxValue if there is no k-mer without
+// ambiguous bases.
+
+inline __uint64 readMinimizer(char const * seq, size_t len, unsigned k)
+{
+    static DnaCodeTable const CODES;
+    static size_t const BLOCK_SIZE = 64;
+
+    __uint64 const mask = (k >= 32u) ? ~(__uint64)0 : (((__uint64)1 << (2 * k)) - 1);
+    unsigned const shift = 2 * (k - 1);
+
+    __uint64 kmers[BLOCK_SIZE];
+    __uint64 invalid[BLOCK_SIZE];
+    __uint64 fwd = 0, rev = 0, best = ~(__uint64)0;
+    unsigned numValid = 0;  // Number of unambiguous bases ending at the current position, capped at k.
+
+    for (size_t blockBegin = 0; blockBegin < len; blockBegin += BLOCK_SIZE)
+    {
+        size_t blockLen = std::min(BLOCK_SIZE, len - blockBegin);
+
+        // Roll forward and reverse complement k-mers.
+        for (size_t j = 0; j < blockLen; ++j)
+        {
+            __uint64 c = CODES.table[(unsigned char)seq[blockBegin + j]];
+            __uint64 ambiguous = (__uint64)0 - (c >> 2);  // All ones for 'N' etc.
+            c &= 3;
+            fwd = ((fwd << 2) | c) & mask;
+            rev = (rev >> 2) | ((3 - c) << shift);
+            numValid = ambiguous ? 0 : std::min(numValid + 1, k);
+            kmers[j] = std::min(fwd, rev);
+            invalid[j] = (numValid < k) ? ~(__uint64)0 : 0;
+        }
+
+        // Hash and take the minimum.
+        __uint64 blockBest = ~(__uint64)0;
+        for (size_t j = 0; j < blockLen; ++j)
+            blockBest = std::min(blockBest, mixHash64(kmers[j]) | invalid[j]);
+        best = std::min(best, blockBest);
+    }
+
+    return best;
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_MINIMIZER_H_
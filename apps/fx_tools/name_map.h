@@ -0,0 +1,386 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Compact store of original read names for reversible renaming.
+//
+// The original headers are written in record order into blocks of
+// blockSize names.  Within a block, each name is encoded relative to the
+// previous one, either front coded as the length of the shared prefix and
+// the remaining suffix, or with the token delta coding of name_tokenizer.h.
+// Illumina names share most of their characters with the previous read, so
+// this takes a few bytes per name.  A table of block offsets at the end of
+// the file gives random access by record number while decoding at most one
+// block.
+//
+// The file is read through a memory mapping, only the block that is looked
+// up is decoded into memory.  The name pattern and prefix are stored as
+// well such that the record number can be recovered from a new name.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_NAME_MAP_H_
+#define SANDBOX_FX_TOOLS_APPS_FX_TOOLS_NAME_MAP_H_
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <seqan/basic.h>
+#include <seqan/file.h>
+#include <seqan/sequence.h>
+
+#include "name_tokenizer.h"
+
+// ============================================================================
+// Tags, Classes, Enums
+// ============================================================================
+
+enum NameMapCodec
+{
+    NAME_MAP_FRONT_CODING = 0,
+    NAME_MAP_TOKENS = 1
+};
+
+// ----------------------------------------------------------------------------
+// Class NameMapWriter
+// ----------------------------------------------------------------------------
+
+struct NameMapWriter
+{
+    std::ofstream out;
+
+    // Number of names per block, names written so far, and value of {index} for the first name.
+    __uint64 blockSize;
+    __uint64 numRecords;
+    __uint64 startIndex;
+
+    NameMapCodec codec;
+
+    // Currently encoded block and the previous name in it.
+    std::string block;
+    std::string prev;
+    NameTokenizer tokenizer;
+
+    // File offsets of the blocks, and of the end of the last block after close().
+    std::vector<__uint64> blockOffsets;
+
+    NameMapWriter() : blockSize(1024), numRecords(0), startIndex(0), codec(NAME_MAP_TOKENS)
+    {}
+};
+
+// ----------------------------------------------------------------------------
+// Class NameMapReader
+// ----------------------------------------------------------------------------
+
+struct NameMapReader
+{
+    seqan::String<char, seqan::MMap<> > file;
+
+    __uint64 blockSize;
+    __uint64 numRecords;
+    __uint64 startIndex;
+    seqan::CharString pattern;
+    seqan::CharString prefix;
+    NameMapCodec codec;
+
+    // Begin of the data and the table of numBlocks + 1 block offsets in the mapping.
+    char const * fileBegin;
+    char const * fileEnd;
+    char const * blockTable;
+    __uint64 numBlocks;
+
+    // Names of the decoded block, name i is [nameEnds[i - 1], nameEnds[i]) of names.
+    __uint64 cachedBlock;
+    std::string names;
+    seqan::String<unsigned> nameEnds;
+    NameTokenizer tokenizer;
+
+    NameMapReader() : blockSize(0), numRecords(0), startIndex(0), codec(NAME_MAP_FRONT_CODING), fileBegin(0),
+                      fileEnd(0), blockTable(0), numBlocks(0), cachedBlock(seqan::maxValue<__uint64>())
+    {}
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function open()                                              [NameMapWriter]
+// ----------------------------------------------------------------------------
+
+// The file format is binary:
+//
+//   char[8]   magic "FXNMAP\0\2", the last byte is the version
+//   uint64    number of records, start index, block size, offset of block table
+//   varuint   pattern length, pattern, prefix length, prefix, codec
+//   blocks    per name: varuint shared prefix length, varuint suffix length, suffix for front coding,
+//             encoded names for tokens
+//   uint64    block offsets and end of the last block, at the end of the file and aligned to 8 bytes
+//
+// Version 1 files have no codec field and are front coded.  The fixed size fields are written in native byte order
+// and filled in by close().  Returns 0 on success, 1 on errors.
+
+inline int open(NameMapWriter & writer, char const * path, seqan::CharString const & pattern,
+                seqan::CharString const & prefix, __uint64 startIndex, NameMapCodec codec)
+{
+    writer.out.open(path, std::ios::binary | std::ios::out);
+    if (!writer.out.good())
+        return 1;
+    writer.numRecords = 0;
+    writer.startIndex = startIndex;
+    writer.codec = codec;
+    writer.block.clear();
+    writer.prev.clear();
+    clear(writer.tokenizer);
+    writer.blockOffsets.clear();
+
+    char const MAGIC[8] = {'F', 'X', 'N', 'M', 'A', 'P', '\0', '\2'};
+    writer.out.write(MAGIC, 8);
+    __uint64 fixed[4] = {0, 0, 0, 0};
+    writer.out.write(reinterpret_cast<char const *>(fixed), sizeof(fixed));
+    std::string buffer;
+    appendVarUInt_(buffer, length(pattern));
+    buffer.append(begin(pattern, seqan::Standard()), end(pattern, seqan::Standard()));
+    appendVarUInt_(buffer, length(prefix));
+    buffer.append(begin(prefix, seqan::Standard()), end(prefix, seqan::Standard()));
+    appendVarUInt_(buffer, codec);
+    writer.out.write(buffer.data(), buffer.size());
+    return !writer.out.good();
+}
+
+// ----------------------------------------------------------------------------
+// Function flushBlock_()                                       [NameMapWriter]
+// ----------------------------------------------------------------------------
+
+inline void flushBlock_(NameMapWriter & writer)
+{
+    writer.blockOffsets.push_back(writer.out.tellp());
+    writer.out.write(writer.block.data(), writer.block.size());
+    writer.block.clear();
+    writer.prev.clear();
+    clear(writer.tokenizer);
+}
+
+// ----------------------------------------------------------------------------
+// Function appendName()                                        [NameMapWriter]
+// ----------------------------------------------------------------------------
+
+// Append the original header [header, headerEnd) of the next record.  Returns 0 on success, 1 on errors.
+
+inline int appendName(NameMapWriter & writer, char const * header, char const * headerEnd)
+{
+    if (writer.codec == NAME_MAP_TOKENS)
+    {
+        encodeName(writer.block, writer.tokenizer, header, headerEnd);
+    }
+    else
+    {
+        size_t len = headerEnd - header;
+        size_t shared = 0;
+        size_t maxShared = std::min(len, writer.prev.size());
+        while (shared < maxShared && writer.prev[shared] == header[shared])
+            ++shared;
+
+        appendVarUInt_(writer.block, shared);
+        appendVarUInt_(writer.block, len - shared);
+        writer.block.append(header + shared, headerEnd);
+        writer.prev.assign(header, headerEnd);
+    }
+
+    if (++writer.numRecords % writer.blockSize == 0u)
+        flushBlock_(writer);
+    return !writer.out.good();
+}
+
+// ----------------------------------------------------------------------------
+// Function close()                                             [NameMapWriter]
+// ----------------------------------------------------------------------------
+
+// Write the last block, the block table and the header fields.  Returns 0 on success, 1 on errors.
+
+inline int close(NameMapWriter & writer)
+{
+    if (!writer.block.empty())
+        flushBlock_(writer);
+
+    __uint64 pos = writer.out.tellp();
+    writer.blockOffsets.push_back(pos);
+    char const PADDING[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    writer.out.write(PADDING, (8 - pos % 8) % 8);
+    __uint64 tableOffset = pos + (8 - pos % 8) % 8;
+    writer.out.write(reinterpret_cast<char const *>(&writer.blockOffsets[0]),
+                     writer.blockOffsets.size() * sizeof(__uint64));
+
+    __uint64 fixed[4] = {writer.numRecords, writer.startIndex, writer.blockSize, tableOffset};
+    writer.out.seekp(8);
+    writer.out.write(reinterpret_cast<char const *>(fixed), sizeof(fixed));
+    writer.out.close();
+    return writer.out.fail();
+}
+
+// ----------------------------------------------------------------------------
+// Function open()                                              [NameMapReader]
+// ----------------------------------------------------------------------------
+
+// Map the file at path.  Returns 0 on success, 1 on errors.
+
+inline int open(NameMapReader & reader, char const * path)
+{
+    if (!open(reader.file, path, seqan::OPEN_RDONLY))
+        return 1;
+    reader.fileBegin = begin(reader.file, seqan::Standard());
+    reader.fileEnd = end(reader.file, seqan::Standard());
+    reader.cachedBlock = seqan::maxValue<__uint64>();
+
+    char const MAGIC[7] = {'F', 'X', 'N', 'M', 'A', 'P', '\0'};
+    __uint64 fixed[4];
+    if (reader.fileEnd - reader.fileBegin < 8 + (long)sizeof(fixed) || memcmp(reader.fileBegin, MAGIC, 7) != 0)
+        return 1;
+    char version = reader.fileBegin[7];
+    if (version != '\1' && version != '\2')
+        return 1;
+    memcpy(fixed, reader.fileBegin + 8, sizeof(fixed));
+    reader.numRecords = fixed[0];
+    reader.startIndex = fixed[1];
+    reader.blockSize = fixed[2];
+    if (reader.blockSize == 0u || fixed[3] > (__uint64)(reader.fileEnd - reader.fileBegin))
+        return 1;
+    reader.blockTable = reader.fileBegin + fixed[3];
+    reader.numBlocks = (reader.numRecords + reader.blockSize - 1) / reader.blockSize;
+    if ((__uint64)(reader.fileEnd - reader.blockTable) != (reader.numBlocks + 1) * sizeof(__uint64))
+        return 1;
+
+    char const * it = reader.fileBegin + 8 + sizeof(fixed);
+    __uint64 len = 0;
+    if (!decodeVarUInt_(len, it, reader.blockTable) || len > (__uint64)(reader.blockTable - it))
+        return 1;
+    reader.pattern = seqan::CharString();
+    for (; len > 0u; --len)
+        appendValue(reader.pattern, *it++);
+    if (!decodeVarUInt_(len, it, reader.blockTable) || len > (__uint64)(reader.blockTable - it))
+        return 1;
+    reader.prefix = seqan::CharString();
+    for (; len > 0u; --len)
+        appendValue(reader.prefix, *it++);
+    __uint64 codec = NAME_MAP_FRONT_CODING;
+    if (version == '\2' && !decodeVarUInt_(codec, it, reader.blockTable))
+        return 1;
+    if (codec != NAME_MAP_FRONT_CODING && codec != NAME_MAP_TOKENS)
+        return 1;
+    reader.codec = static_cast<NameMapCodec>(codec);
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function blockOffset_()                                      [NameMapReader]
+// ----------------------------------------------------------------------------
+
+inline __uint64 blockOffset_(NameMapReader const & reader, __uint64 blockNo)
+{
+    __uint64 offset = 0;
+    memcpy(&offset, reader.blockTable + blockNo * sizeof(__uint64), sizeof(offset));
+    return offset;
+}
+
+// ----------------------------------------------------------------------------
+// Function decodeBlock_()                                      [NameMapReader]
+// ----------------------------------------------------------------------------
+
+inline bool decodeBlock_(NameMapReader & reader, __uint64 blockNo)
+{
+    reader.names.clear();
+    clear(reader.nameEnds);
+    reader.cachedBlock = seqan::maxValue<__uint64>();
+
+    __uint64 beginOffset = blockOffset_(reader, blockNo);
+    __uint64 endOffset = blockOffset_(reader, blockNo + 1);
+    if (beginOffset > endOffset || endOffset > (__uint64)(reader.blockTable - reader.fileBegin))
+        return false;
+    char const * it = reader.fileBegin + beginOffset;
+    char const * itEnd = reader.fileBegin + endOffset;
+
+    clear(reader.tokenizer);
+    unsigned prevBegin = 0;
+    while (it != itEnd)
+    {
+        if (reader.codec == NAME_MAP_TOKENS)
+        {
+            if (!decodeName(reader.names, reader.tokenizer, it, itEnd))
+                return false;
+            appendValue(reader.nameEnds, (unsigned)reader.names.size());
+            continue;
+        }
+
+        __uint64 shared = 0, suffixLen = 0;
+        if (!decodeVarUInt_(shared, it, itEnd) || !decodeVarUInt_(suffixLen, it, itEnd))
+            return false;
+        unsigned prevLen = empty(reader.nameEnds) ? 0 : back(reader.nameEnds) - prevBegin;
+        if (shared > prevLen || suffixLen > (__uint64)(itEnd - it))
+            return false;
+        unsigned nameBegin = reader.names.size();
+        reader.names.resize(nameBegin + shared);
+        if (shared)
+            memcpy(&reader.names[nameBegin], reader.names.data() + prevBegin, shared);
+        reader.names.append(it, suffixLen);
+        it += suffixLen;
+        appendValue(reader.nameEnds, (unsigned)reader.names.size());
+        prevBegin = nameBegin;
+    }
+    reader.cachedBlock = blockNo;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Function lookup()                                            [NameMapReader]
+// ----------------------------------------------------------------------------
+
+// Set [nameBegin, nameEnd) to the original header of the record with the given 0-based number.  The pointers stay
+// valid until the next lookup in another block.  Returns false if there is no such record or the file is corrupt.
+
+inline bool lookup(char const * & nameBegin, char const * & nameEnd, NameMapReader & reader, __uint64 recordNo)
+{
+    if (recordNo >= reader.numRecords)
+        return false;
+    __uint64 blockNo = recordNo / reader.blockSize;
+    if (blockNo != reader.cachedBlock && !decodeBlock_(reader, blockNo))
+        return false;
+    __uint64 i = recordNo % reader.blockSize;
+    if (i >= length(reader.nameEnds))
+        return false;
+    nameBegin = reader.names.data() + (i ? reader.nameEnds[i - 1] : 0);
+    nameEnd = reader.names.data() + reader.nameEnds[i];
+    return true;
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_NAME_MAP_H_
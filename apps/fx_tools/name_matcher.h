@@ -0,0 +1,329 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Matching of read identifiers against large sets of names or name prefixes.
+//
+// Exact names are stored as 64 bit fingerprints in an open addressing hash
+// table.  With n names, the probability of a read being falsely selected is
+// about n / 2^64, i.e. negligible even for hundreds of millions of names.
+//
+// Prefixes are stored in a trie whose children are laid out contiguously and
+// sorted by label.  Checking an identifier costs at most one child lookup per
+// character, independent of the number of prefixes.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_NAME_MATCHER_H_
+#define SANDBOX_FX_TOOLS_APPS_FX_TOOLS_NAME_MATCHER_H_
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include "hash_functions.h"
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class NameHashSet
+// ----------------------------------------------------------------------------
+
+struct NameHashSet
+{
+    // Fingerprints, 0 marks empty slots.  The size is a power of two.
+    seqan::String<__uint64> table;
+    // Number of stored fingerprints.
+    __uint64 size;
+
+    NameHashSet() : size(0)
+    {}
+};
+
+// ----------------------------------------------------------------------------
+// Class PrefixTrieNode_
+// ----------------------------------------------------------------------------
+
+struct PrefixTrieNode_
+{
+    // Index of first child, the children are stored consecutively.
+    __uint32 childBegin;
+    // Number of children.
+    __uint16 childCount;
+    // Label of the edge leading to this node.
+    char label;
+    // Whether a prefix ends here.
+    bool terminal;
+
+    PrefixTrieNode_() : childBegin(0), childCount(0), label(0), terminal(false)
+    {}
+};
+
+// ----------------------------------------------------------------------------
+// Class PrefixTrie
+// ----------------------------------------------------------------------------
+
+struct PrefixTrie
+{
+    // The nodes, node 0 is the root if there are any.
+    seqan::String<PrefixTrieNode_> nodes;
+    // The prefixes, these are only used until build() is called.
+    std::vector<std::string> prefixes;
+};
+
+// ----------------------------------------------------------------------------
+// Class NameMatcher
+// ----------------------------------------------------------------------------
+
+// Exact names are compared to the first word of the identifier, prefixes to
+// the whole identifier.
+
+struct NameMatcher
+{
+    NameHashSet names;
+    PrefixTrie prefixes;
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function nameFingerprint_()
+// ----------------------------------------------------------------------------
+
+inline __uint64 nameFingerprint_(char const * ptr, size_t len)
+{
+    __uint64 h = hashBytes(ptr, len);
+    return h ? h : 1;  // 0 marks empty slots.
+}
+
+// ----------------------------------------------------------------------------
+// Function insert()                                              [NameHashSet]
+// ----------------------------------------------------------------------------
+
+inline void insert(NameHashSet & set, char const * ptr, size_t len)
+{
+    // Grow to keep the load factor at or below 1/2.
+    if (2 * (set.size + 1) > length(set.table))
+    {
+        seqan::String<__uint64> oldTable;
+        swap(oldTable, set.table);
+        resize(set.table, std::max((size_t)1024, (size_t)(2 * length(oldTable))), 0);
+        set.size = 0;
+        for (size_t i = 0; i < length(oldTable); ++i)
+        {
+            if (!oldTable[i])
+                continue;
+            __uint64 mask = length(set.table) - 1;
+            __uint64 pos = oldTable[i] & mask;
+            while (set.table[pos])
+                pos = (pos + 1) & mask;
+            set.table[pos] = oldTable[i];
+            set.size += 1;
+        }
+    }
+
+    __uint64 fingerprint = nameFingerprint_(ptr, len);
+    __uint64 mask = length(set.table) - 1;
+    __uint64 pos = fingerprint & mask;
+    while (set.table[pos])
+    {
+        if (set.table[pos] == fingerprint)
+            return;  // Already there.
+        pos = (pos + 1) & mask;
+    }
+    set.table[pos] = fingerprint;
+    set.size += 1;
+}
+
+// ----------------------------------------------------------------------------
+// Function contains()                                            [NameHashSet]
+// ----------------------------------------------------------------------------
+
+inline bool contains(NameHashSet const & set, char const * ptr, size_t len)
+{
+    if (set.size == 0u)
+        return false;
+    __uint64 fingerprint = nameFingerprint_(ptr, len);
+    __uint64 mask = length(set.table) - 1;
+    for (__uint64 pos = fingerprint & mask; set.table[pos]; pos = (pos + 1) & mask)
+        if (set.table[pos] == fingerprint)
+            return true;
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+// Function buildTrieNode_()                                       [PrefixTrie]
+// ----------------------------------------------------------------------------
+
+// Build the subtrie for the sorted, prefix-free patterns [lo, hi) that share
+// their first depth characters.
+
+inline void buildTrieNode_(PrefixTrie & trie, unsigned nodeId, unsigned lo, unsigned hi, unsigned depth)
+{
+    if (trie.prefixes[lo].size() == depth)
+    {
+        trie.nodes[nodeId].terminal = true;  // Prefix-free, so this is the only pattern in [lo, hi).
+        return;
+    }
+
+    // Allocate the children consecutively, then recurse.
+    unsigned childBegin = length(trie.nodes);
+    for (unsigned i = lo; i < hi; ++i)
+    {
+        if (i == lo || trie.prefixes[i][depth] != trie.prefixes[i - 1][depth])
+        {
+            appendValue(trie.nodes, PrefixTrieNode_());
+            back(trie.nodes).label = trie.prefixes[i][depth];
+        }
+    }
+    trie.nodes[nodeId].childBegin = childBegin;
+    trie.nodes[nodeId].childCount = length(trie.nodes) - childBegin;
+
+    unsigned childId = childBegin;
+    for (unsigned i = lo, j = lo; i < hi; i = j, ++childId)
+    {
+        for (j = i + 1; j < hi && trie.prefixes[j][depth] == trie.prefixes[i][depth]; ++j)
+            continue;
+        buildTrieNode_(trie, childId, i, j, depth + 1);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function insert()                                               [PrefixTrie]
+// ----------------------------------------------------------------------------
+
+inline void insert(PrefixTrie & trie, char const * ptr, size_t len)
+{
+    trie.prefixes.push_back(std::string(ptr, len));
+}
+
+// ----------------------------------------------------------------------------
+// Function build()                                                [PrefixTrie]
+// ----------------------------------------------------------------------------
+
+// Build the trie from the inserted prefixes, must be called before contains().
+
+inline void build(PrefixTrie & trie)
+{
+    clear(trie.nodes);
+    if (trie.prefixes.empty())
+        return;
+
+    // Sort and remove prefixes that have another prefix as their prefix, these are redundant.
+    std::sort(trie.prefixes.begin(), trie.prefixes.end());
+    unsigned n = 1;
+    for (unsigned i = 1; i < trie.prefixes.size(); ++i)
+        if (trie.prefixes[i].compare(0, trie.prefixes[n - 1].size(), trie.prefixes[n - 1]) != 0)
+            trie.prefixes[n++] = trie.prefixes[i];
+    trie.prefixes.resize(n);
+
+    appendValue(trie.nodes, PrefixTrieNode_());
+    buildTrieNode_(trie, 0, 0, n, 0);
+    std::vector<std::string>().swap(trie.prefixes);
+}
+
+// ----------------------------------------------------------------------------
+// Function contains()                                             [PrefixTrie]
+// ----------------------------------------------------------------------------
+
+// Returns true if one of the prefixes is a prefix of [ptr, ptr + len).
+
+inline bool contains(PrefixTrie const & trie, char const * ptr, size_t len)
+{
+    if (empty(trie.nodes))
+        return false;
+
+    PrefixTrieNode_ const * nodes = begin(trie.nodes, seqan::Standard());
+    PrefixTrieNode_ const * node = nodes;
+    for (size_t i = 0; !node->terminal; ++i)
+    {
+        if (i == len)
+            return false;
+        // Binary search for the child, the children are sorted by label as unsigned bytes like std::string sorts.
+        PrefixTrieNode_ const * first = nodes + node->childBegin;
+        PrefixTrieNode_ const * last = first + node->childCount;
+        while (first < last)
+        {
+            PrefixTrieNode_ const * mid = first + (last - first) / 2;
+            if ((unsigned char)mid->label < (unsigned char)ptr[i])
+                first = mid + 1;
+            else
+                last = mid;
+        }
+        if (first == nodes + node->childBegin + node->childCount || first->label != ptr[i])
+            return false;
+        node = first;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Function empty()                                               [NameMatcher]
+// ----------------------------------------------------------------------------
+
+inline bool empty(NameMatcher const & matcher)
+{
+    return matcher.names.size == 0u && empty(matcher.prefixes.nodes);
+}
+
+// ----------------------------------------------------------------------------
+// Function firstWordLength()
+// ----------------------------------------------------------------------------
+
+// Returns the length of the first whitespace-delimited word of [ptr, ptr + len).
+
+inline size_t firstWordLength(char const * ptr, size_t len)
+{
+    size_t i = 0;
+    while (i < len && ptr[i] != ' ' && ptr[i] != '\t' && ptr[i] != '\r' && ptr[i] != '\n')
+        ++i;
+    return i;
+}
+
+// ----------------------------------------------------------------------------
+// Function matches()                                             [NameMatcher]
+// ----------------------------------------------------------------------------
+
+inline bool matches(NameMatcher const & matcher, char const * ptr, size_t len)
+{
+    if (contains(matcher.names, ptr, firstWordLength(ptr, len)))
+        return true;
+    return contains(matcher.prefixes, ptr, len);
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_NAME_MATCHER_H_
@@ -0,0 +1,342 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Tokenized delta encoding of read names.
+//
+// A name is split into tokens at the separators ": /_-.#=|" and compared
+// with the tokens of the previous name.  If the separators are the same,
+// only the tokens that changed are written: a bit mask of the changed
+// tokens, then numeric tokens as the difference to the previous value and
+// other tokens as literals.  For Illumina names such as
+//
+//   A00123:45:HXXXXXXXX:1:1101:12345:23456 1:N:0:ACGTACGT
+//
+// usually only the x and y coordinates change, so a name takes a handful
+// of bytes.  Names with different separators are written in full along
+// with their separators.  Decoding restores the exact original text.
+//
+// Records are encoded as
+//
+//   varuint   changed token mask << 1 | new shape flag
+//   if new:   varuint number of tokens, separator characters
+//   changed:  varuint zigzag(delta) << 1 for numeric tokens, or
+//             varuint length << 1 | 1 followed by the characters
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_NAME_TOKENIZER_H_
+#define SANDBOX_FX_TOOLS_APPS_FX_TOOLS_NAME_TOKENIZER_H_
+
+#include <string>
+#include <vector>
+
+#include <seqan/basic.h>
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class NameTokens_
+// ----------------------------------------------------------------------------
+
+// The tokens of one name, token i is [ends[i - 1], ends[i]) of text and followed by seps[i] unless it is the last.
+
+struct NameTokens_
+{
+    std::string text;
+    std::string seps;
+    std::vector<unsigned> ends;
+    std::vector<__uint64> values;
+    std::vector<bool> numeric;
+};
+
+// ----------------------------------------------------------------------------
+// Class NameTokenizer
+// ----------------------------------------------------------------------------
+
+// Encoder and decoder state, the tokens of the previous name.
+
+struct NameTokenizer
+{
+    NameTokens_ prev;
+    NameTokens_ cur;
+    bool hasPrev;
+
+    NameTokenizer() : hasPrev(false)
+    {}
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function clear()                                             [NameTokenizer]
+// ----------------------------------------------------------------------------
+
+// Forget the previous name, the next one is encoded in full.
+
+inline void clear(NameTokenizer & tokenizer)
+{
+    tokenizer.hasPrev = false;
+}
+
+// ----------------------------------------------------------------------------
+// Function isNameSeparator_()
+// ----------------------------------------------------------------------------
+
+inline bool isNameSeparator_(char c)
+{
+    return c == ':' || c == ' ' || c == '/' || c == '_' || c == '-' || c == '.' || c == '#' || c == '=' || c == '|';
+}
+
+// ----------------------------------------------------------------------------
+// Function appendToken_()
+// ----------------------------------------------------------------------------
+
+// Append [ptr, ptr + len) as the next token.  Numbers of up to 18 digits without leading zeros are numeric.
+
+inline void appendToken_(NameTokens_ & tokens, char const * ptr, size_t len)
+{
+    tokens.text.append(ptr, len);
+    tokens.ends.push_back(tokens.text.size());
+
+    bool numeric = (len > 0u && len <= 18u && (len == 1u || ptr[0] != '0'));
+    __uint64 value = 0;
+    for (size_t i = 0; numeric && i < len; ++i)
+    {
+        numeric = (ptr[i] >= '0' && ptr[i] <= '9');
+        value = value * 10 + (ptr[i] - '0');
+    }
+    tokens.numeric.push_back(numeric);
+    tokens.values.push_back(numeric ? value : 0);
+}
+
+// ----------------------------------------------------------------------------
+// Function tokenize_()
+// ----------------------------------------------------------------------------
+
+// There are at most 63 tokens such that the change mask fits into a 64 bit word, the rest of a longer name is
+// kept as the last token.
+
+inline void tokenize_(NameTokens_ & tokens, char const * name, char const * nameEnd)
+{
+    tokens.text.clear();
+    tokens.seps.clear();
+    tokens.ends.clear();
+    tokens.values.clear();
+    tokens.numeric.clear();
+
+    char const * tokenBegin = name;
+    for (char const * it = name; it != nameEnd && tokens.ends.size() < 62u; ++it)
+    {
+        if (!isNameSeparator_(*it))
+            continue;
+        appendToken_(tokens, tokenBegin, it - tokenBegin);
+        tokens.seps.push_back(*it);
+        tokenBegin = it + 1;
+    }
+    appendToken_(tokens, tokenBegin, nameEnd - tokenBegin);
+}
+
+// ----------------------------------------------------------------------------
+// Function appendVarUInt_(), decodeVarUInt_()
+// ----------------------------------------------------------------------------
+
+// LEB128 encoding as in record_index.h, on memory buffers.
+
+inline void appendVarUInt_(std::string & out, __uint64 x)
+{
+    while (x >= 0x80u)
+    {
+        out.push_back(static_cast<char>((x & 0x7f) | 0x80));
+        x >>= 7;
+    }
+    out.push_back(static_cast<char>(x));
+}
+
+inline bool decodeVarUInt_(__uint64 & x, char const * & it, char const * end)
+{
+    x = 0;
+    for (unsigned shift = 0; shift < 64 && it != end; shift += 7)
+    {
+        unsigned char c = *it++;
+        x |= (__uint64)(c & 0x7f) << shift;
+        if (!(c & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+// Function encodeName()                                        [NameTokenizer]
+// ----------------------------------------------------------------------------
+
+// Append the encoding of [name, nameEnd) to out.
+
+inline void encodeName(std::string & out, NameTokenizer & tokenizer, char const * name, char const * nameEnd)
+{
+    NameTokens_ & cur = tokenizer.cur;
+    NameTokens_ & prev = tokenizer.prev;
+    tokenize_(cur, name, nameEnd);
+
+    bool newShape = !tokenizer.hasPrev || cur.seps != prev.seps;
+    unsigned numTokens = cur.ends.size();
+    __uint64 mask = 0;
+    for (unsigned i = 0; i < numTokens; ++i)
+    {
+        unsigned b = i ? cur.ends[i - 1] : 0;
+        unsigned pb = (!newShape && i) ? prev.ends[i - 1] : 0;
+        if (newShape || cur.ends[i] - b != prev.ends[i] - pb ||
+            cur.text.compare(b, cur.ends[i] - b, prev.text, pb, prev.ends[i] - pb) != 0)
+            mask |= (__uint64)1 << i;
+    }
+
+    appendVarUInt_(out, (mask << 1) | (newShape ? 1 : 0));
+    if (newShape)
+    {
+        appendVarUInt_(out, numTokens);
+        out.append(cur.seps);
+    }
+    for (unsigned i = 0; i < numTokens; ++i)
+    {
+        if (!(mask & ((__uint64)1 << i)))
+            continue;
+        if (!newShape && cur.numeric[i] && prev.numeric[i])
+        {
+            __int64 delta = (__int64)(cur.values[i] - prev.values[i]);
+            appendVarUInt_(out, ((__uint64)((delta << 1) ^ (delta >> 63))) << 1);
+        }
+        else
+        {
+            unsigned b = i ? cur.ends[i - 1] : 0;
+            appendVarUInt_(out, ((__uint64)(cur.ends[i] - b) << 1) | 1);
+            out.append(cur.text, b, cur.ends[i] - b);
+        }
+    }
+
+    std::swap(tokenizer.cur, tokenizer.prev);
+    tokenizer.hasPrev = true;
+}
+
+// ----------------------------------------------------------------------------
+// Function decodeName()                                        [NameTokenizer]
+// ----------------------------------------------------------------------------
+
+// Decode the next name from [it, end) and append it to name.  Returns false on corrupt input.
+
+inline bool decodeName(std::string & name, NameTokenizer & tokenizer, char const * & it, char const * end)
+{
+    NameTokens_ & cur = tokenizer.cur;
+    NameTokens_ & prev = tokenizer.prev;
+
+    __uint64 x = 0;
+    if (!decodeVarUInt_(x, it, end))
+        return false;
+    bool newShape = x & 1;
+    __uint64 mask = x >> 1;
+    if (!newShape && !tokenizer.hasPrev)
+        return false;
+
+    cur.text.clear();
+    cur.ends.clear();
+    cur.values.clear();
+    cur.numeric.clear();
+    if (newShape)
+    {
+        __uint64 numTokens = 0;
+        if (!decodeVarUInt_(numTokens, it, end) || numTokens == 0u || numTokens > 63u ||
+            numTokens - 1 > (__uint64)(end - it))
+            return false;
+        cur.seps.assign(it, it + (numTokens - 1));
+        it += numTokens - 1;
+    }
+    else
+    {
+        cur.seps = prev.seps;
+    }
+
+    unsigned numTokens = cur.seps.size() + 1;
+    for (unsigned i = 0; i < numTokens; ++i)
+    {
+        if (!(mask & ((__uint64)1 << i)))
+        {
+            if (newShape)
+                return false;
+            unsigned pb = i ? prev.ends[i - 1] : 0;
+            appendToken_(cur, prev.text.data() + pb, prev.ends[i] - pb);
+            continue;
+        }
+        if (!decodeVarUInt_(x, it, end))
+            return false;
+        if (x & 1)
+        {
+            __uint64 len = x >> 1;
+            if (len > (__uint64)(end - it))
+                return false;
+            appendToken_(cur, it, len);
+            it += len;
+        }
+        else
+        {
+            if (newShape || !prev.numeric[i])
+                return false;
+            __uint64 zigzag = x >> 1;
+            __int64 delta = (__int64)(zigzag >> 1) ^ -(__int64)(zigzag & 1);
+            char buffer[24];
+            char * ptr = buffer + sizeof(buffer);
+            __uint64 value = prev.values[i] + delta;
+            do
+            {
+                *--ptr = '0' + (char)(value % 10);
+                value /= 10;
+            }
+            while (value);
+            appendToken_(cur, ptr, buffer + sizeof(buffer) - ptr);
+        }
+    }
+
+    for (unsigned i = 0; i < numTokens; ++i)
+    {
+        unsigned b = i ? cur.ends[i - 1] : 0;
+        name.append(cur.text, b, cur.ends[i] - b);
+        if (i + 1 < numTokens)
+            name.push_back(cur.seps[i]);
+    }
+
+    std::swap(tokenizer.cur, tokenizer.prev);
+    tokenizer.hasPrev = true;
+    return true;
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_NAME_TOKENIZER_H_
@@ -0,0 +1,306 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// A set of buffered, optionally gzip-compressed output files.
+//
+// Records are written into an in-memory buffer per output.  Full buffers are
+// queued and flushed in batches: the batch is compressed in parallel (each
+// buffer becomes one gzip member, concatenated members are valid gzip
+// files) and then appended to the files.  If there are more outputs than we
+// may keep open, the files are opened for each batch write and closed again,
+// once per output with queued blocks.
+//
+// Compression needs zlib, i.e. SEQAN_HAS_ZLIB.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_OUTPUT_SET_H_
+#define SANDBOX_FX_TOOLS_APPS_FX_TOOLS_OUTPUT_SET_H_
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if SEQAN_HAS_ZLIB
+#include <zlib.h>
+#endif  // #if SEQAN_HAS_ZLIB
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class OutputSet
+// ----------------------------------------------------------------------------
+
+class OutputSet
+{
+public:
+    // Paths of the output files.
+    seqan::String<seqan::CharString> paths;
+    // Whether or not to gzip-compress the output.
+    bool gzip;
+    // Number of threads to use for compression.
+    unsigned numThreads;
+    // Buffers are queued for writing when they reach this size.
+    size_t blockSize;
+    // Number of queued bytes to trigger writing of the queued buffers.
+    size_t batchSize;
+    // Keep files open if there are at most this many outputs.
+    unsigned maxOpenFiles;
+
+    // The buffers and files of each output, files are NULL when not open.
+    std::vector<std::stringstream *> buffers;
+    std::vector<std::ofstream *> files;
+    // Queued buffer contents with their output id.
+    std::vector<std::pair<unsigned, std::string> > pending;
+    size_t pendingBytes;
+
+    OutputSet() : gzip(false), numThreads(1), blockSize(1024 * 1024), batchSize(64 * 1024 * 1024),
+                  maxOpenFiles(256), pendingBytes(0)
+    {}
+
+    ~OutputSet()
+    {
+        for (unsigned i = 0; i < buffers.size(); ++i)
+            delete buffers[i];
+        for (unsigned i = 0; i < files.size(); ++i)
+            delete files[i];
+    }
+
+private:
+    OutputSet(OutputSet const &);
+    OutputSet & operator=(OutputSet const &);
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+#if SEQAN_HAS_ZLIB
+
+// ----------------------------------------------------------------------------
+// Function gzipCompressBlock()
+// ----------------------------------------------------------------------------
+
+// Compress in into a complete gzip member in out.  Returns 0 on success, 1 on errors.
+
+inline int gzipCompressBlock(std::string & out, std::string const & in)
+{
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    // 15 + 16 window bits for a gzip instead of a zlib wrapper.
+    if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return 1;
+    out.resize(deflateBound(&strm, in.size()) + 32);
+    strm.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in.data()));
+    strm.avail_in = in.size();
+    strm.next_out = reinterpret_cast<Bytef *>(&out[0]);
+    strm.avail_out = out.size();
+    int res = deflate(&strm, Z_FINISH);
+    out.resize(out.size() - strm.avail_out);
+    deflateEnd(&strm);
+    return res != Z_STREAM_END;
+}
+
+#endif  // #if SEQAN_HAS_ZLIB
+
+// ----------------------------------------------------------------------------
+// Function open()
+// ----------------------------------------------------------------------------
+
+// Open the outputs, the files are created (and truncated) right away.  Returns 0 on success, 1 on errors, including
+// gzip without zlib support.
+
+inline int open(OutputSet & set, seqan::String<seqan::CharString> const & paths, bool gzip, unsigned numThreads)
+{
+#if !SEQAN_HAS_ZLIB
+    if (gzip)
+        return 1;
+#endif  // #if !SEQAN_HAS_ZLIB
+    set.paths = paths;
+    set.gzip = gzip;
+    set.numThreads = std::max(1u, numThreads);
+    set.buffers.resize(length(paths), 0);
+    set.files.resize(length(paths), 0);
+    for (unsigned i = 0; i < length(paths); ++i)
+    {
+        set.buffers[i] = new std::stringstream();
+        set.files[i] = new std::ofstream(toCString(paths[i]), std::ios::binary | std::ios::out);
+        if (!set.files[i]->good())
+            return 1;
+        if (length(paths) > set.maxOpenFiles)
+        {
+            delete set.files[i];
+            set.files[i] = 0;
+        }
+    }
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function outputStream()
+// ----------------------------------------------------------------------------
+
+// Returns the buffer stream to write records of output i to.  Call recordWritten() after writing each record.
+
+inline std::ostream & outputStream(OutputSet & set, unsigned i)
+{
+    return *set.buffers[i];
+}
+
+// ----------------------------------------------------------------------------
+// Class LessPendingOutput_
+// ----------------------------------------------------------------------------
+
+struct LessPendingOutput_
+{
+    bool operator()(std::pair<unsigned, std::string> const & lhs, std::pair<unsigned, std::string> const & rhs) const
+    {
+        return lhs.first < rhs.first;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// Function flushPending_()
+// ----------------------------------------------------------------------------
+
+inline int flushPending_(OutputSet & set)
+{
+    if (set.pending.empty())
+        return 0;
+
+#if SEQAN_HAS_ZLIB
+    // Compress in parallel.
+    if (set.gzip)
+    {
+        int res = 0;
+        SEQAN_OMP_PRAGMA(parallel for schedule(dynamic, 1) num_threads(set.numThreads) reduction(|:res))
+        for (int j = 0; j < (int)set.pending.size(); ++j)
+        {
+            std::string compressed;
+            res |= gzipCompressBlock(compressed, set.pending[j].second);
+            set.pending[j].second.swap(compressed);
+        }
+        if (res != 0)
+            return 1;
+    }
+#endif  // #if SEQAN_HAS_ZLIB
+
+    // Group the blocks by output so closed files are opened only once per batch.  The sort is stable, this keeps the
+    // order of the blocks of each output.
+    std::stable_sort(set.pending.begin(), set.pending.end(), LessPendingOutput_());
+    for (unsigned j = 0, k = 0; j < set.pending.size(); j = k)
+    {
+        unsigned i = set.pending[j].first;
+        std::ofstream file;
+        std::ofstream * out = set.files[i];
+        if (!out)
+        {
+            file.open(toCString(set.paths[i]), std::ios::binary | std::ios::out | std::ios::app);
+            out = &file;
+        }
+        for (k = j; k < set.pending.size() && set.pending[k].first == i; ++k)
+            out->write(set.pending[k].second.data(), set.pending[k].second.size());
+        if (out == &file)
+            file.close();
+        if (!out->good())
+            return 1;
+    }
+    set.pending.clear();
+    set.pendingBytes = 0;
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function queueBuffer_()
+// ----------------------------------------------------------------------------
+
+inline void queueBuffer_(OutputSet & set, unsigned i)
+{
+    set.pending.push_back(std::make_pair(i, set.buffers[i]->str()));
+    set.pendingBytes += set.pending.back().second.size();
+    set.buffers[i]->str("");
+    set.buffers[i]->clear();
+}
+
+// ----------------------------------------------------------------------------
+// Function recordWritten()
+// ----------------------------------------------------------------------------
+
+// Queue buffer of output i if it is full, flush the queue if it is large enough.  Returns 0 on success, 1 on
+// errors.
+
+inline int recordWritten(OutputSet & set, unsigned i)
+{
+    if ((size_t)set.buffers[i]->tellp() < set.blockSize)
+        return 0;
+    queueBuffer_(set, i);
+    if (set.pendingBytes < set.batchSize && set.pending.size() < 4 * set.numThreads)
+        return 0;
+    return flushPending_(set);
+}
+
+// ----------------------------------------------------------------------------
+// Function close()
+// ----------------------------------------------------------------------------
+
+// Write out all buffers and close the files.  Returns 0 on success, 1 on errors, including errors when flushing the
+// files on closing.
+
+inline int close(OutputSet & set)
+{
+    for (unsigned i = 0; i < set.buffers.size(); ++i)
+        if (set.buffers[i]->tellp() > 0)
+            queueBuffer_(set, i);
+    int res = flushPending_(set);
+    for (unsigned i = 0; i < set.files.size(); ++i)
+    {
+        if (!set.files[i])
+            continue;
+        set.files[i]->close();
+        if (set.files[i]->fail())
+            res = 1;
+        delete set.files[i];
+        set.files[i] = 0;
+    }
+    return res;
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_OUTPUT_SET_H_
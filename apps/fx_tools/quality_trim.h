@@ -0,0 +1,196 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Quality trimming kernels.
+//
+// The quality strings are Phred+33 encoded, thresholds are given as Phred
+// values.  Each kernel returns a cut position, the caller trims the read to
+// the resulting interval.
+//
+// If SSE2 is available at compile time, the threshold scans compare 16
+// qualities at a time.  The sliding window scan uses this to skip ahead to
+// the first low quality base since windows without one cannot fall below
+// the threshold.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_QUALITY_TRIM_H_
+#define SANDBOX_FX_TOOLS_APPS_FX_TOOLS_QUALITY_TRIM_H_
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif  // #if defined(__SSE2__)
+
+#include <seqan/basic.h>
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function firstAtLeast()
+// ----------------------------------------------------------------------------
+
+// Returns position of the first quality >= minQual in [quals, quals + len), len if there is none.
+
+inline size_t firstAtLeast(char const * quals, size_t len, int minQual)
+{
+    char threshold = (char)(minQual + 33);
+    size_t i = 0;
+#if defined(__SSE2__)
+    // Qualities are < 128, so signed comparison is fine.
+    __m128i const t = _mm_set1_epi8(threshold - 1);
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const *>(quals + i));
+        if (_mm_movemask_epi8(_mm_cmpgt_epi8(x, t)))
+            break;
+    }
+#endif  // #if defined(__SSE2__)
+    for (; i < len; ++i)
+        if (quals[i] >= threshold)
+            return i;
+    return len;
+}
+
+// ----------------------------------------------------------------------------
+// Function firstBelow()
+// ----------------------------------------------------------------------------
+
+// Returns position of the first quality < minQual in [quals, quals + len), len if there is none.
+
+inline size_t firstBelow(char const * quals, size_t len, int minQual)
+{
+    char threshold = (char)(minQual + 33);
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128i const t = _mm_set1_epi8(threshold);
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const *>(quals + i));
+        if (_mm_movemask_epi8(_mm_cmplt_epi8(x, t)))
+            break;
+    }
+#endif  // #if defined(__SSE2__)
+    for (; i < len; ++i)
+        if (quals[i] < threshold)
+            return i;
+    return len;
+}
+
+// ----------------------------------------------------------------------------
+// Function behindLastAtLeast()
+// ----------------------------------------------------------------------------
+
+// Returns position behind the last quality >= minQual in [quals, quals + len), 0 if there is none.
+
+inline size_t behindLastAtLeast(char const * quals, size_t len, int minQual)
+{
+    char threshold = (char)(minQual + 33);
+    size_t i = len;
+#if defined(__SSE2__)
+    __m128i const t = _mm_set1_epi8(threshold - 1);
+    for (; i >= 16u; i -= 16)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const *>(quals + i - 16));
+        if (_mm_movemask_epi8(_mm_cmpgt_epi8(x, t)))
+            break;
+    }
+#endif  // #if defined(__SSE2__)
+    for (; i > 0u; --i)
+        if (quals[i - 1] >= threshold)
+            return i;
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function slidingWindowEnd()
+// ----------------------------------------------------------------------------
+
+// Returns the begin of the first window of windowSize qualities whose mean is below minQual, scanning from the 5'
+// end, len if there is none.  Reads shorter than the window are treated as one window.
+
+inline size_t slidingWindowEnd(char const * quals, size_t len, unsigned windowSize, int minQual)
+{
+    if (windowSize > len)
+        windowSize = len;
+    if (windowSize == 0u)
+        return len;
+
+    // Windows that end before the first low quality base pass.
+    size_t low = firstBelow(quals, len, minQual);
+    if (low == len)
+        return len;
+    size_t i = (low + 1 >= windowSize) ? low + 1 - windowSize : 0;
+
+    // Compare sums instead of means, the sum is updated while the window slides.
+    long minSum = (long)minQual * windowSize;
+    long sum = 0;
+    for (size_t j = i; j < i + windowSize; ++j)
+        sum += quals[j] - 33;
+    for (; ; ++i)
+    {
+        if (sum < minSum)
+            return i;
+        if (i + windowSize >= len)
+            return len;
+        sum += quals[i + windowSize] - quals[i];
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function bwaTrimEnd()
+// ----------------------------------------------------------------------------
+
+// BWA-style 3' trimming: returns the position that maximizes the sum of (minQual - quality) over the trimmed
+// suffix, len if nothing is to be trimmed.  Like BWA, the scan stops once the sum drops below zero.
+
+inline size_t bwaTrimEnd(char const * quals, size_t len, int minQual)
+{
+    long sum = 0;
+    long maxSum = 0;
+    size_t maxPos = len;
+    for (size_t i = len; i > 0u; --i)
+    {
+        sum += minQual - (quals[i - 1] - 33);
+        if (sum < 0)
+            break;
+        if (sum > maxSum)
+        {
+            maxSum = sum;
+            maxPos = i - 1;
+        }
+    }
+    return maxPos;
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_QUALITY_TRIM_H_
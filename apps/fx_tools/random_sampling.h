@@ -0,0 +1,234 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Fast seeded pseudo random numbers and streaming random sampling.
+//
+// BernoulliSampler selects each item with a fixed probability, ReservoirSampler
+// selects a fixed number of items uniformly at random (Algorithm L, Li 1994).
+// Both jump over the items that are not selected by drawing the gap to the
+// next selected item, so they cost one random number per selected item.
+//
+// The decisions only depend on the seed and on the item numbers.  Sampling
+// two files with the same number of items and the same seed, e.g. the two
+// files of a paired-end run, selects the same items from both.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_RANDOM_SAMPLING_H_
+#define SANDBOX_FX_TOOLS_APPS_FX_TOOLS_RANDOM_SAMPLING_H_
+
+#include <cmath>
+
+#include <seqan/basic.h>
+
+#include "hash_functions.h"
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class FastRandom
+// ----------------------------------------------------------------------------
+
+// SplitMix64 generator: a Weyl sequence put through the SplitMix64 finalizer.
+
+struct FastRandom
+{
+    __uint64 state;
+
+    explicit
+    FastRandom(__uint64 seed = 0) : state(seed)
+    {}
+};
+
+// ----------------------------------------------------------------------------
+// Class BernoulliSampler
+// ----------------------------------------------------------------------------
+
+struct BernoulliSampler
+{
+    // Probability of selecting an item.
+    double fraction;
+    // Number of the next item to select.
+    __uint64 nextPick;
+
+    FastRandom rng;
+
+    BernoulliSampler() : fraction(0), nextPick(seqan::maxValue<__uint64>())
+    {}
+};
+
+// ----------------------------------------------------------------------------
+// Class ReservoirSampler
+// ----------------------------------------------------------------------------
+
+struct ReservoirSampler
+{
+    // Number of items to select.
+    __uint64 size;
+    // Algorithm L's running maximum of uniform random numbers.
+    double w;
+    // Number of the next item to select.
+    __uint64 nextPick;
+
+    FastRandom rng;
+
+    ReservoirSampler() : size(0), w(0), nextPick(0)
+    {}
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function nextRandom()
+// ----------------------------------------------------------------------------
+
+inline __uint64 nextRandom(FastRandom & rng)
+{
+    rng.state += 0x9e3779b97f4a7c15ULL;
+    return mixHash64(rng.state);
+}
+
+// ----------------------------------------------------------------------------
+// Function nextUnitRandom()
+// ----------------------------------------------------------------------------
+
+// Returns a uniform random number from (0, 1].
+
+inline double nextUnitRandom(FastRandom & rng)
+{
+    return ((nextRandom(rng) >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+// ----------------------------------------------------------------------------
+// Function geometricGap_()
+// ----------------------------------------------------------------------------
+
+// Number of failures before the first success of Bernoulli trials with success probability exp(logQ) given the
+// logarithm of the failure probability logQ < 0.  Returns maxValue on overflow.
+
+inline __uint64 geometricGap_(FastRandom & rng, double logQ)
+{
+    if (!(logQ < 0))
+        return seqan::maxValue<__uint64>();
+    double gap = std::floor(std::log(nextUnitRandom(rng)) / logQ);
+    if (gap >= 18446744073709551615.0)
+        return seqan::maxValue<__uint64>();
+    return static_cast<__uint64>(gap);
+}
+
+// ----------------------------------------------------------------------------
+// Function safeAdd_()
+// ----------------------------------------------------------------------------
+
+inline __uint64 safeAdd_(__uint64 a, __uint64 b)
+{
+    return (a > seqan::maxValue<__uint64>() - b) ? seqan::maxValue<__uint64>() : a + b;
+}
+
+// ----------------------------------------------------------------------------
+// Function init()                                           [BernoulliSampler]
+// ----------------------------------------------------------------------------
+
+inline void init(BernoulliSampler & sampler, double fraction, __uint64 seed)
+{
+    sampler.fraction = fraction;
+    sampler.rng = FastRandom(seed);
+    if (fraction <= 0)
+        sampler.nextPick = seqan::maxValue<__uint64>();
+    else if (fraction >= 1)
+        sampler.nextPick = 0;
+    else
+        sampler.nextPick = geometricGap_(sampler.rng, std::log1p(-fraction));
+}
+
+// ----------------------------------------------------------------------------
+// Function sample()                                         [BernoulliSampler]
+// ----------------------------------------------------------------------------
+
+// Returns true if item i is selected.  The items must be queried in increasing order, items may be left out.
+
+inline bool sample(BernoulliSampler & sampler, __uint64 i)
+{
+    if (i != sampler.nextPick)
+        return false;
+    if (sampler.fraction >= 1)
+        sampler.nextPick = i + 1;
+    else
+        sampler.nextPick = safeAdd_(i + 1, geometricGap_(sampler.rng, std::log1p(-sampler.fraction)));
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Function init()                                           [ReservoirSampler]
+// ----------------------------------------------------------------------------
+
+inline void init(ReservoirSampler & sampler, __uint64 size, __uint64 seed)
+{
+    sampler.size = size;
+    sampler.rng = FastRandom(seed);
+    sampler.nextPick = 0;
+    if (size > 0u)
+        sampler.w = std::exp(std::log(nextUnitRandom(sampler.rng)) / size);
+}
+
+// ----------------------------------------------------------------------------
+// Function sample()                                         [ReservoirSampler]
+// ----------------------------------------------------------------------------
+
+// Returns the reservoir slot that item i is to be stored in or maxValue if i is not selected.  All items must be
+// offered in increasing order, starting with 0.
+
+inline __uint64 sample(ReservoirSampler & sampler, __uint64 i)
+{
+    if (sampler.size == 0u || i != sampler.nextPick)
+        return seqan::maxValue<__uint64>();
+
+    __uint64 slot = i;
+    if (i >= sampler.size)
+    {
+        slot = nextRandom(sampler.rng) % sampler.size;
+        sampler.w *= std::exp(std::log(nextUnitRandom(sampler.rng)) / sampler.size);
+    }
+
+    // The first size items fill the reservoir, then skip ahead.
+    if (i + 1 < sampler.size)
+        sampler.nextPick = i + 1;
+    else
+        sampler.nextPick = safeAdd_(i + 1, geometricGap_(sampler.rng, std::log1p(-sampler.w)));
+    return slot;
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_RANDOM_SAMPLING_H_
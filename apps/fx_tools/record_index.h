@@ -0,0 +1,350 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Sampled record offset index for FASTA and FASTQ files.
+//
+// The index stores the byte offset of about every sampleRate-th record
+// together with its 0-based record number.  Seeking to record n is then a
+// binary search for the last sample at or before n and skipping less than
+// sampleRate records from there.
+//
+// The index is built in parallel on a memory mapped file: the file is split
+// into chunks, each chunk is scanned for records independently and the
+// per-chunk record counts are combined afterwards.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_RECORD_INDEX_H_
+#define SANDBOX_FX_TOOLS_APPS_FX_TOOLS_RECORD_INDEX_H_
+
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include "record_scanner.h"
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class RecordIndex
+// ----------------------------------------------------------------------------
+
+struct RecordIndex
+{
+    // Format of the indexed file.
+    RawRecordFormat format;
+    // About every sampleRate-th record is sampled.
+    unsigned sampleRate;
+    // Size of the indexed file, used for detecting stale indices.
+    __uint64 fileSize;
+    // Total number of records in the file.
+    __uint64 numRecords;
+
+    // Numbers of the sampled records, ascending and starting with 0.
+    seqan::String<__uint64> recordNos;
+    // Byte offsets of the sampled records.
+    seqan::String<__uint64> offsets;
+
+    RecordIndex() : format(RAW_FORMAT_UNKNOWN), sampleRate(1024), fileSize(0), numRecords(0)
+    {}
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function clear()
+// ----------------------------------------------------------------------------
+
+inline void clear(RecordIndex & index)
+{
+    index.format = RAW_FORMAT_UNKNOWN;
+    index.fileSize = 0;
+    index.numRecords = 0;
+    clear(index.recordNos);
+    clear(index.offsets);
+}
+
+// ----------------------------------------------------------------------------
+// Function scanRecordIndexChunk_()
+// ----------------------------------------------------------------------------
+
+// Scan records starting at it while their begin is before chunkEnd.  Appends
+// the offset of every sampleRate-th record to offsets, the number of records
+// to numRecords and writes the first position at or behind chunkEnd to
+// stop.  Returns 1 on invalid records, 0 on success.
+
+inline int scanRecordIndexChunk_(seqan::String<__uint64> & offsets,
+                                 __uint64 & numRecords,
+                                 char const * & stop,
+                                 char const * it,
+                                 char const * fileBegin,
+                                 char const * chunkEnd,
+                                 char const * fileEnd,
+                                 RawRecordFormat format,
+                                 unsigned sampleRate)
+{
+    clear(offsets);
+    numRecords = 0;
+    while (it < chunkEnd && it != fileEnd)
+    {
+        if (numRecords % sampleRate == 0u)
+            appendValue(offsets, (__uint64)(it - fileBegin));
+        numRecords += 1;
+        if ((it = skipRawRecord(it, fileEnd, format)) == 0)
+            return 1;
+    }
+    stop = it;
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function build()
+// ----------------------------------------------------------------------------
+
+// Build record index for the file contents [fileBegin, fileEnd).  The chunks
+// are scanned in parallel if OpenMP is available.  Returns 0 on success, 1 on
+// errors.
+
+inline int build(RecordIndex & index,
+                 char const * fileBegin,
+                 char const * fileEnd,
+                 unsigned sampleRate,
+                 unsigned numThreads)
+{
+    clear(index);
+    if (sampleRate == 0u)
+        return 1;
+    index.sampleRate = sampleRate;
+    index.fileSize = fileEnd - fileBegin;
+    index.format = guessRawFormat(fileBegin, fileEnd);
+    if (index.format == RAW_FORMAT_UNKNOWN)
+        return (skipBlankLines(fileBegin, fileEnd) == fileEnd) ? 0 : 1;  // Only empty files are OK.
+
+    // Use a few chunks per thread for load balancing but do not make them too small.
+    __uint64 minChunkSize = 16 * 1024 * 1024;
+    __uint64 numChunks = std::max(1u, numThreads) * 4;
+    if (index.fileSize / numChunks < minChunkSize)
+        numChunks = std::max((__uint64)1u, index.fileSize / minChunkSize);
+
+    seqan::String<seqan::String<__uint64> > chunkOffsets;
+    resize(chunkOffsets, numChunks);
+    seqan::String<__uint64> chunkNumRecords;
+    resize(chunkNumRecords, numChunks, 0);
+    seqan::String<char const *> chunkFirst;
+    resize(chunkFirst, numChunks, (char const *)0);
+    seqan::String<char const *> chunkStop;
+    resize(chunkStop, numChunks, (char const *)0);
+    seqan::String<int> chunkRes;
+    resize(chunkRes, numChunks, 0);
+
+    SEQAN_OMP_PRAGMA(parallel for schedule(dynamic, 1) num_threads(std::max(1u, numThreads)))
+    for (int c = 0; c < (int)numChunks; ++c)
+    {
+        char const * chunkBegin = fileBegin + index.fileSize * c / numChunks;
+        char const * chunkEnd = fileBegin + index.fileSize * (c + 1) / numChunks;
+        if (c == 0)
+            chunkFirst[c] = skipBlankLines(fileBegin, fileEnd);
+        else
+            chunkFirst[c] = findRawRecordBegin(chunkBegin, fileBegin, fileEnd, index.format);
+        chunkRes[c] = scanRecordIndexChunk_(chunkOffsets[c], chunkNumRecords[c], chunkStop[c], chunkFirst[c],
+                                            fileBegin, chunkEnd, fileEnd, index.format, sampleRate);
+    }
+
+    // Combine the chunks.  The scan of chunk c - 1 stops at the first record of chunk c.  If this is not where the
+    // resynchronization for chunk c ended up then the latter was fooled (e.g. by a quality line starting with '@')
+    // and we rescan chunk c sequentially.
+    for (unsigned c = 0; c < numChunks; ++c)
+    {
+        if (c > 0u && chunkFirst[c] != chunkStop[c - 1])
+        {
+            char const * chunkEnd = fileBegin + index.fileSize * (c + 1) / numChunks;
+            chunkFirst[c] = chunkStop[c - 1];
+            chunkRes[c] = scanRecordIndexChunk_(chunkOffsets[c], chunkNumRecords[c], chunkStop[c], chunkFirst[c],
+                                                fileBegin, chunkEnd, fileEnd, index.format, sampleRate);
+        }
+        if (chunkRes[c] != 0)
+            return 1;
+
+        for (unsigned i = 0; i < length(chunkOffsets[c]); ++i)
+        {
+            appendValue(index.recordNos, index.numRecords + (__uint64)i * sampleRate);
+            appendValue(index.offsets, chunkOffsets[c][i]);
+        }
+        index.numRecords += chunkNumRecords[c];
+    }
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function findRecord()
+// ----------------------------------------------------------------------------
+
+// Write offset and number of the last sampled record at or before recordNo
+// to offset and foundNo.
+
+inline void findRecord(__uint64 & offset, __uint64 & foundNo, RecordIndex const & index, __uint64 recordNo)
+{
+    offset = 0;
+    foundNo = 0;
+    __uint64 const * first = begin(index.recordNos, seqan::Standard());
+    __uint64 const * last = end(index.recordNos, seqan::Standard());
+    __uint64 const * it = std::upper_bound(first, last, recordNo);
+    if (it == first)
+        return;
+    --it;
+    foundNo = *it;
+    offset = index.offsets[it - first];
+}
+
+// ----------------------------------------------------------------------------
+// Function writeVarUInt_(), readVarUInt_()
+// ----------------------------------------------------------------------------
+
+// LEB128 encoding of unsigned integers: 7 bits per byte, high bit set for all
+// but the last byte.
+
+inline void writeVarUInt_(std::ostream & out, __uint64 x)
+{
+    while (x >= 0x80u)
+    {
+        out.put(static_cast<char>((x & 0x7f) | 0x80));
+        x >>= 7;
+    }
+    out.put(static_cast<char>(x));
+}
+
+inline bool readVarUInt_(__uint64 & x, std::istream & in)
+{
+    x = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7)
+    {
+        int c = in.get();
+        if (c == EOF)
+            return false;
+        x |= (__uint64)(c & 0x7f) << shift;
+        if (!(c & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+// Function save()
+// ----------------------------------------------------------------------------
+
+// The file format is binary:
+//
+//   char[8]   magic "FXRIX\0\0\1", the last byte is the version
+//   varuint   format, sample rate, file size, number of records, number of samples m
+//   varuint   m deltas of the sampled record numbers
+//   varuint   m deltas of the sampled byte offsets
+//
+// The deltas are small and make the file a few bytes per sample.  Returns 0
+// on success, 1 on errors.
+
+inline int save(RecordIndex const & index, char const * path)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::out);
+    if (!out.good())
+        return 1;
+
+    char const MAGIC[8] = {'F', 'X', 'R', 'I', 'X', '\0', '\0', '\1'};
+    out.write(MAGIC, 8);
+    writeVarUInt_(out, index.format);
+    writeVarUInt_(out, index.sampleRate);
+    writeVarUInt_(out, index.fileSize);
+    writeVarUInt_(out, index.numRecords);
+    writeVarUInt_(out, length(index.recordNos));
+    for (unsigned i = 0; i < length(index.recordNos); ++i)
+        writeVarUInt_(out, index.recordNos[i] - (i ? index.recordNos[i - 1] : 0));
+    for (unsigned i = 0; i < length(index.offsets); ++i)
+        writeVarUInt_(out, index.offsets[i] - (i ? index.offsets[i - 1] : 0));
+
+    return !out.good();
+}
+
+// ----------------------------------------------------------------------------
+// Function load()
+// ----------------------------------------------------------------------------
+
+// Load record index from path.  Returns 0 on success, 1 on errors.
+
+inline int load(RecordIndex & index, char const * path)
+{
+    clear(index);
+
+    std::ifstream in(path, std::ios::binary | std::ios::in);
+    if (!in.good())
+        return 1;
+
+    char const MAGIC[8] = {'F', 'X', 'R', 'I', 'X', '\0', '\0', '\1'};
+    char magic[8];
+    if (!in.read(magic, 8) || memcmp(magic, MAGIC, 8) != 0)
+        return 1;
+
+    __uint64 format = 0, sampleRate = 0, numSamples = 0;
+    if (!readVarUInt_(format, in) || !readVarUInt_(sampleRate, in) || !readVarUInt_(index.fileSize, in) ||
+        !readVarUInt_(index.numRecords, in) || !readVarUInt_(numSamples, in))
+        return 1;
+    if (format != RAW_FORMAT_FASTA && format != RAW_FORMAT_FASTQ && format != RAW_FORMAT_UNKNOWN)
+        return 1;
+    index.format = static_cast<RawRecordFormat>(format);
+    index.sampleRate = sampleRate;
+
+    resize(index.recordNos, numSamples, 0);
+    resize(index.offsets, numSamples, 0);
+    __uint64 x = 0;
+    for (unsigned i = 0; i < numSamples; ++i)
+    {
+        if (!readVarUInt_(x, in))
+            return 1;
+        index.recordNos[i] = x + (i ? index.recordNos[i - 1] : 0);
+    }
+    for (unsigned i = 0; i < numSamples; ++i)
+    {
+        if (!readVarUInt_(x, in))
+            return 1;
+        index.offsets[i] = x + (i ? index.offsets[i - 1] : 0);
+    }
+
+    return 0;
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_RECORD_INDEX_H_
@@ -0,0 +1,252 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Scanning of FASTA and FASTQ records in raw character buffers, e.g. memory
+// mapped files, without materializing identifiers, sequences, or qualities.
+//
+// All functions work on [it, end) character ranges and use memchr() for
+// finding line ends.  Multi-line FASTA and FASTQ records are supported.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_RECORD_SCANNER_H_
+#define SANDBOX_FX_TOOLS_APPS_FX_TOOLS_RECORD_SCANNER_H_
+
+#include <cstring>
+
+#include <seqan/basic.h>
+
+// ============================================================================
+// Tags, Classes, Enums
+// ============================================================================
+
+// The values are the same as the tagId values of seqan::AutoSeqStreamFormat.
+
+enum RawRecordFormat
+{
+    RAW_FORMAT_UNKNOWN = 0,
+    RAW_FORMAT_FASTA = 1,
+    RAW_FORMAT_FASTQ = 2
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function nextLineBegin()
+// ----------------------------------------------------------------------------
+
+// Returns the begin of the line behind the one it points into, end if there is none.
+
+inline char const * nextLineBegin(char const * it, char const * end)
+{
+    char const * ptr = static_cast<char const *>(memchr(it, '\n', end - it));
+    return ptr ? ptr + 1 : end;
+}
+
+// ----------------------------------------------------------------------------
+// Function lineLength()
+// ----------------------------------------------------------------------------
+
+// Returns the length of the line [it, next) without the trailing "\n" or "\r\n".
+
+inline __uint64 lineLength(char const * it, char const * next)
+{
+    if (next != it && next[-1] == '\n')
+        --next;
+    if (next != it && next[-1] == '\r')
+        --next;
+    return next - it;
+}
+
+// ----------------------------------------------------------------------------
+// Function skipBlankLines()
+// ----------------------------------------------------------------------------
+
+inline char const * skipBlankLines(char const * it, char const * end)
+{
+    while (it != end && (*it == '\n' || *it == '\r'))
+        ++it;
+    return it;
+}
+
+// ----------------------------------------------------------------------------
+// Function guessRawFormat()
+// ----------------------------------------------------------------------------
+
+inline RawRecordFormat guessRawFormat(char const * it, char const * end)
+{
+    it = skipBlankLines(it, end);
+    if (it == end)
+        return RAW_FORMAT_UNKNOWN;
+    if (*it == '>')
+        return RAW_FORMAT_FASTA;
+    if (*it == '@')
+        return RAW_FORMAT_FASTQ;
+    return RAW_FORMAT_UNKNOWN;
+}
+
+// ----------------------------------------------------------------------------
+// Function skipFastaRecord()
+// ----------------------------------------------------------------------------
+
+// it must point to the '>' of a FASTA record.  Returns the begin of the next
+// record or end.
+
+inline char const * skipFastaRecord(char const * it, char const * end)
+{
+    it = nextLineBegin(it, end);  // Skip header line.
+    while (it != end)
+    {
+        char const * ptr = static_cast<char const *>(memchr(it, '>', end - it));
+        if (!ptr)
+            return end;
+        if (ptr[-1] == '\n')
+            return ptr;
+        it = ptr + 1;
+    }
+    return end;
+}
+
+// ----------------------------------------------------------------------------
+// Function skipFastqRecord()
+// ----------------------------------------------------------------------------
+
+// it must point to the '@' of a FASTQ record.  Returns the position behind the
+// record or NULL if there is no valid record at it.  The sequence length is
+// written to seqLength, the begin of the '+' line to plusLine.
+
+inline char const * skipFastqRecord(__uint64 & seqLength, char const * & plusLine, char const * it,
+                                    char const * end)
+{
+    seqLength = 0;
+    if (it == end || *it != '@')
+        return 0;
+    it = nextLineBegin(it, end);  // Skip header line.
+
+    // Sequence lines up to the '+' line.
+    while (it != end && *it != '+')
+    {
+        char const * next = nextLineBegin(it, end);
+        seqLength += lineLength(it, next);
+        it = next;
+    }
+    if (it == end)
+        return 0;
+    plusLine = it;
+    it = nextLineBegin(it, end);  // Skip '+' line.
+
+    // Quality lines, at least one (possibly empty) line.
+    __uint64 qualLength = 0;
+    do
+    {
+        if (it == end)
+            break;
+        char const * next = nextLineBegin(it, end);
+        qualLength += lineLength(it, next);
+        it = next;
+    }
+    while (qualLength < seqLength);
+
+    if (qualLength != seqLength)
+        return 0;
+    return it;
+}
+
+inline char const * skipFastqRecord(__uint64 & seqLength, char const * it, char const * end)
+{
+    char const * plusLine = 0;
+    return skipFastqRecord(seqLength, plusLine, it, end);
+}
+
+inline char const * skipFastqRecord(char const * it, char const * end)
+{
+    __uint64 seqLength = 0;
+    return skipFastqRecord(seqLength, it, end);
+}
+
+// ----------------------------------------------------------------------------
+// Function skipRawRecord()
+// ----------------------------------------------------------------------------
+
+// Skip the record at it and following blank lines.  Returns NULL on errors.
+
+inline char const * skipRawRecord(char const * it, char const * end, RawRecordFormat format)
+{
+    if (format == RAW_FORMAT_FASTA)
+        it = (it != end && *it == '>') ? skipFastaRecord(it, end) : 0;
+    else
+        it = skipFastqRecord(it, end);
+    return it ? skipBlankLines(it, end) : 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function findRawRecordBegin()
+// ----------------------------------------------------------------------------
+
+// Returns the begin of the first record at or behind it, end if there is
+// none.  fileBegin is the begin of the buffer and used for line start checks.
+//
+// For FASTA, this is the first '>' at the begin of a line.  For FASTQ, a '@'
+// at the begin of a line can also be the begin of a quality line.  We accept
+// a candidate if it and the next record parse with matching sequence and
+// quality lengths.
+
+inline char const * findRawRecordBegin(char const * it, char const * fileBegin, char const * end,
+                                       RawRecordFormat format)
+{
+    if (it != fileBegin && it[-1] != '\n')
+        it = nextLineBegin(it, end);
+
+    for (; it != end; it = nextLineBegin(it, end))
+    {
+        if (format == RAW_FORMAT_FASTA)
+        {
+            if (*it == '>')
+                return it;
+            continue;
+        }
+
+        if (*it != '@')
+            continue;
+        char const * ptr = it;
+        bool valid = true;
+        for (unsigned i = 0; valid && i < 2 && ptr != end; ++i)
+            valid = ((ptr = skipRawRecord(ptr, end, format)) != 0);
+        if (valid)
+            return it;
+    }
+    return end;
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_RECORD_SCANNER_H_
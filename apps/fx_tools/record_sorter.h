@@ -0,0 +1,377 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// External memory sorting of records by binary keys.
+//
+// Records are given as byte ranges [begin, end) of the input file together
+// with their sort key.  The keys are stored in one buffer and referenced by
+// compact entries that also hold the first eight key bytes as an integer, so
+// most comparisons do not touch the key buffer.  When the memory limit is
+// reached, the entries are sorted on multiple threads and spilled to a
+// temporary file as a sorted run.  The runs are combined with a k-way merge.
+// Records with equal keys keep their input order.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_RECORD_SORTER_H_
+#define SANDBOX_FX_TOOLS_APPS_FX_TOOLS_RECORD_SORTER_H_
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class SortEntry_
+// ----------------------------------------------------------------------------
+
+struct SortEntry_
+{
+    // First 8 key bytes, big endian and zero-padded, such that integer comparison equals lexicographic comparison.
+    __uint64 keyPrefix;
+    // Position and length of the key in the key buffer.
+    __uint64 keyPos;
+    __uint64 keyLen;
+    // Byte range of the record.
+    __uint64 beginPos;
+    __uint64 endPos;
+};
+
+// ----------------------------------------------------------------------------
+// Class LessSortEntry_
+// ----------------------------------------------------------------------------
+
+struct LessSortEntry_
+{
+    char const * keys;
+
+    explicit LessSortEntry_(char const * keys) : keys(keys)
+    {}
+
+    bool operator()(SortEntry_ const & lhs, SortEntry_ const & rhs) const
+    {
+        if (lhs.keyPrefix != rhs.keyPrefix)
+            return lhs.keyPrefix < rhs.keyPrefix;
+        if (lhs.keyLen > 8u || rhs.keyLen > 8u)
+        {
+            __uint64 len = std::min(lhs.keyLen, rhs.keyLen);
+            int res = (len > 8u) ? memcmp(keys + lhs.keyPos + 8, keys + rhs.keyPos + 8, len - 8) : 0;
+            if (res != 0)
+                return res < 0;
+        }
+        if (lhs.keyLen != rhs.keyLen)
+            return lhs.keyLen < rhs.keyLen;
+        return lhs.beginPos < rhs.beginPos;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// Class SortRunReader_
+// ----------------------------------------------------------------------------
+
+// Sequential reader of a spilled run.  The records of a run are stored as (begin, end, key length, key).
+
+struct SortRunReader_
+{
+    std::ifstream * in;
+    // Number of entries not read yet, a run ending before is truncated.
+    __uint64 numLeft;
+    std::string key;
+    __uint64 beginPos;
+    __uint64 endPos;
+
+    SortRunReader_() : in(0), numLeft(0), beginPos(0), endPos(0)
+    {}
+};
+
+// ----------------------------------------------------------------------------
+// Class RecordSorter
+// ----------------------------------------------------------------------------
+
+class RecordSorter
+{
+public:
+    // Maximal number of bytes to use for keys and entries before spilling a run.
+    __uint64 maxBytes;
+    // Prefix of the paths of the temporary files.
+    std::string tmpPrefix;
+    // Number of threads to use for sorting.
+    unsigned numThreads;
+
+    // The keys and entries of the current run.
+    seqan::String<char> keys;
+    std::vector<SortEntry_> entries;
+    // The paths of the spilled runs and their numbers of entries.
+    std::vector<std::string> runPaths;
+    std::vector<__uint64> runSizes;
+    // Total number of records.
+    __uint64 numRecords;
+
+    RecordSorter() : maxBytes(1024 * 1024 * 1024), numThreads(1), numRecords(0)
+    {}
+
+    ~RecordSorter()
+    {
+        for (unsigned i = 0; i < runPaths.size(); ++i)
+            std::remove(runPaths[i].c_str());
+    }
+
+private:
+    RecordSorter(RecordSorter const &);
+    RecordSorter & operator=(RecordSorter const &);
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function init()                                               [RecordSorter]
+// ----------------------------------------------------------------------------
+
+inline void init(RecordSorter & sorter, __uint64 maxBytes, std::string const & tmpPrefix, unsigned numThreads)
+{
+    sorter.maxBytes = maxBytes;
+    sorter.tmpPrefix = tmpPrefix;
+    sorter.numThreads = std::max(1u, numThreads);
+    clear(sorter.keys);
+    sorter.entries.clear();
+    sorter.numRecords = 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function parallelSort_()
+// ----------------------------------------------------------------------------
+
+// Sort chunks on separate threads, then merge pairs of neighbouring chunks in parallel until one is left.
+
+template <typename TValue, typename TLess>
+void parallelSort_(std::vector<TValue> & values, TLess const & less, unsigned numThreads)
+{
+    int numChunks = std::max(1, std::min((int)numThreads, (int)(values.size() / 4096)));
+    std::vector<size_t> bounds(numChunks + 1);
+    for (int i = 0; i <= numChunks; ++i)
+        bounds[i] = values.size() * i / numChunks;
+
+    SEQAN_OMP_PRAGMA(parallel for num_threads(numThreads))
+    for (int i = 0; i < numChunks; ++i)
+        std::sort(values.begin() + bounds[i], values.begin() + bounds[i + 1], less);
+
+    for (int width = 1; width < numChunks; width *= 2)
+    {
+        SEQAN_OMP_PRAGMA(parallel for num_threads(numThreads))
+        for (int i = 0; i < numChunks - width; i += 2 * width)
+        {
+            int last = std::min(i + 2 * width, numChunks);
+            std::inplace_merge(values.begin() + bounds[i], values.begin() + bounds[i + width],
+                               values.begin() + bounds[last], less);
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function spillRun_()                                          [RecordSorter]
+// ----------------------------------------------------------------------------
+
+// Sort the current run and write it to a temporary file.  Returns 0 on success, 1 on errors.
+
+inline int spillRun_(RecordSorter & sorter)
+{
+    parallelSort_(sorter.entries, LessSortEntry_(begin(sorter.keys, seqan::Standard())), sorter.numThreads);
+
+    std::stringstream ss;
+    ss << sorter.tmpPrefix << sorter.runPaths.size();
+    sorter.runPaths.push_back(ss.str());
+    sorter.runSizes.push_back(sorter.entries.size());
+    std::ofstream out(sorter.runPaths.back().c_str(), std::ios::binary | std::ios::out);
+    char const * keys = begin(sorter.keys, seqan::Standard());
+    for (unsigned i = 0; i < sorter.entries.size() && out.good(); ++i)
+    {
+        SortEntry_ const & entry = sorter.entries[i];
+        out.write(reinterpret_cast<char const *>(&entry.beginPos), sizeof(__uint64));
+        out.write(reinterpret_cast<char const *>(&entry.endPos), sizeof(__uint64));
+        out.write(reinterpret_cast<char const *>(&entry.keyLen), sizeof(__uint64));
+        out.write(keys + entry.keyPos, entry.keyLen);
+    }
+    out.close();  // Flushes, errors such as a full disk may only show here.
+    if (out.fail())
+        return 1;
+
+    clear(sorter.keys);
+    sorter.entries.clear();
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function add()                                                [RecordSorter]
+// ----------------------------------------------------------------------------
+
+// Add the record [beginPos, endPos) with the given key.  Returns 0 on success, 1 on errors.
+
+inline int add(RecordSorter & sorter, char const * key, size_t keyLen, __uint64 beginPos, __uint64 endPos)
+{
+    SortEntry_ entry;
+    unsigned char prefix[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    memcpy(prefix, key, std::min((size_t)8, keyLen));
+    entry.keyPrefix = 0;
+    for (unsigned i = 0; i < 8u; ++i)
+        entry.keyPrefix = (entry.keyPrefix << 8) | prefix[i];
+    entry.keyPos = length(sorter.keys);
+    entry.keyLen = keyLen;
+    entry.beginPos = beginPos;
+    entry.endPos = endPos;
+    resize(sorter.keys, entry.keyPos + keyLen);
+    memcpy(begin(sorter.keys, seqan::Standard()) + entry.keyPos, key, keyLen);
+    sorter.entries.push_back(entry);
+    sorter.numRecords += 1;
+
+    if (length(sorter.keys) + sorter.entries.size() * sizeof(SortEntry_) >= sorter.maxBytes)
+        return spillRun_(sorter);
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function readRunEntry_()
+// ----------------------------------------------------------------------------
+
+// Read the next entry of a run.  Returns 0 on success, 1 at the end of the run and -1 if the run file is truncated
+// or cannot be read.
+
+inline int readRunEntry_(SortRunReader_ & reader)
+{
+    if (reader.numLeft == 0u)
+        return 1;
+    __uint64 header[3];
+    if (!reader.in->read(reinterpret_cast<char *>(header), sizeof(header)))
+        return -1;
+    reader.beginPos = header[0];
+    reader.endPos = header[1];
+    reader.key.resize(header[2]);
+    if (header[2] > 0u && !reader.in->read(&reader.key[0], header[2]))
+        return -1;
+    reader.numLeft -= 1;
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Class GreaterRunHead_
+// ----------------------------------------------------------------------------
+
+// Orders run readers by their current entry for a min-heap, ties are broken by the input order.
+
+struct GreaterRunHead_
+{
+    std::vector<SortRunReader_> const * readers;
+
+    explicit GreaterRunHead_(std::vector<SortRunReader_> const & readers) : readers(&readers)
+    {}
+
+    bool operator()(unsigned lhs, unsigned rhs) const
+    {
+        SortRunReader_ const & l = (*readers)[lhs];
+        SortRunReader_ const & r = (*readers)[rhs];
+        int res = l.key.compare(r.key);
+        if (res != 0)
+            return res > 0;
+        return l.beginPos > r.beginPos;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// Function forEachSorted()                                      [RecordSorter]
+// ----------------------------------------------------------------------------
+
+// Call f(beginPos, endPos) for the records in sorted order, f returns 0 on success.  Returns 0 on success, 1 on
+// errors.
+
+template <typename TFunctor>
+int forEachSorted(RecordSorter & sorter, TFunctor & f)
+{
+    // Everything fit into memory, no need for temporary files.
+    if (sorter.runPaths.empty())
+    {
+        parallelSort_(sorter.entries, LessSortEntry_(begin(sorter.keys, seqan::Standard())), sorter.numThreads);
+        for (unsigned i = 0; i < sorter.entries.size(); ++i)
+            if (f(sorter.entries[i].beginPos, sorter.entries[i].endPos) != 0)
+                return 1;
+        return 0;
+    }
+
+    if (!sorter.entries.empty() && spillRun_(sorter) != 0)
+        return 1;
+
+    // K-way merge of the runs.
+    std::vector<SortRunReader_> readers(sorter.runPaths.size());
+    std::vector<std::ifstream *> streams(sorter.runPaths.size(), 0);
+    GreaterRunHead_ greater(readers);
+    std::priority_queue<unsigned, std::vector<unsigned>, GreaterRunHead_> heap(greater);
+    int res = 0;
+    for (unsigned i = 0; i < readers.size(); ++i)
+    {
+        streams[i] = new std::ifstream(sorter.runPaths[i].c_str(), std::ios::binary | std::ios::in);
+        readers[i].in = streams[i];
+        readers[i].numLeft = sorter.runSizes[i];
+        int readRes = streams[i]->good() ? readRunEntry_(readers[i]) : -1;
+        if (readRes < 0)
+            res = 1;
+        else if (readRes == 0)
+            heap.push(i);
+    }
+    while (res == 0 && !heap.empty())
+    {
+        unsigned i = heap.top();
+        heap.pop();
+        res = f(readers[i].beginPos, readers[i].endPos);
+        int readRes = readRunEntry_(readers[i]);
+        if (readRes < 0)
+            res = 1;
+        else if (readRes == 0)
+            heap.push(i);
+    }
+    for (unsigned i = 0; i < streams.size(); ++i)
+        delete streams[i];
+    return res != 0;
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_RECORD_SORTER_H_
@@ -0,0 +1,479 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Read name templates for fx_renamer.
+//
+// A pattern such as "{prefix}{index:64}/{mate}" is parsed once into a plan
+// of formatting operations.  Formatting a name then writes the literals and
+// fields directly into the caller's output buffer without allocations.
+//
+// Fields:
+//
+//   {prefix}             the value of --prefix
+//   {index[:R[:W]]}      record number in radix R (10, 16, 36 or 64),
+//                        zero padded to width W
+//   {mate}               mate number, 1 or 2
+//   {name}               the original name up to the first space
+//   {comment}            the original header behind the first space
+//
+// "{{" and "}}" are literal braces.  The radix 64 digits are in ASCII order
+// such that zero padded names sort like their numbers.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_RENAME_PATTERN_H_
+#define SANDBOX_FX_TOOLS_APPS_FX_TOOLS_RENAME_PATTERN_H_
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class RenameOp_
+// ----------------------------------------------------------------------------
+
+struct RenameOp_
+{
+    enum Kind
+    {
+        LITERAL,
+        INDEX,
+        MATE,
+        NAME,
+        COMMENT
+    };
+
+    Kind kind;
+    // Range in RenamePattern::literals for LITERAL.
+    unsigned literalBegin;
+    unsigned literalEnd;
+    // Radix and minimal width for INDEX.
+    unsigned radix;
+    unsigned width;
+
+    RenameOp_() : kind(LITERAL), literalBegin(0), literalEnd(0), radix(10), width(0)
+    {}
+};
+
+// ----------------------------------------------------------------------------
+// Class RenamePattern
+// ----------------------------------------------------------------------------
+
+struct RenamePattern
+{
+    seqan::String<RenameOp_> ops;
+    seqan::CharString literals;
+
+    // A formatted name is at most fixedLength + headerFactor * (header length) characters long.
+    unsigned fixedLength;
+    unsigned headerFactor;
+
+    RenamePattern() : fixedLength(0), headerFactor(0)
+    {}
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function appendLiteral_()                                    [RenamePattern]
+// ----------------------------------------------------------------------------
+
+// Append literal characters, merged with a directly preceding literal.
+
+inline void appendLiteral_(RenamePattern & pattern, char const * ptr, size_t len)
+{
+    if (len == 0u)
+        return;
+    if (empty(pattern.ops) || back(pattern.ops).kind != RenameOp_::LITERAL)
+    {
+        RenameOp_ op;
+        op.literalBegin = op.literalEnd = length(pattern.literals);
+        appendValue(pattern.ops, op);
+    }
+    for (size_t i = 0; i < len; ++i)
+        appendValue(pattern.literals, ptr[i]);
+    back(pattern.ops).literalEnd = length(pattern.literals);
+    pattern.fixedLength += len;
+}
+
+// ----------------------------------------------------------------------------
+// Function compile()                                           [RenamePattern]
+// ----------------------------------------------------------------------------
+
+// Parse str into pattern, {prefix} is replaced by prefix.  Returns 0 on success and 1 on syntax errors.
+
+inline int compile(RenamePattern & pattern, seqan::CharString const & str, seqan::CharString const & prefix)
+{
+    clear(pattern.ops);
+    clear(pattern.literals);
+    pattern.fixedLength = 0;
+    pattern.headerFactor = 0;
+
+    char const * it = begin(str, seqan::Standard());
+    char const * itEnd = end(str, seqan::Standard());
+    while (it != itEnd)
+    {
+        if (*it == '}')
+        {
+            if (it + 1 == itEnd || it[1] != '}')
+                return 1;
+            appendLiteral_(pattern, it, 1);
+            it += 2;
+            continue;
+        }
+        if (*it != '{')
+        {
+            char const * next = it;
+            while (next != itEnd && *next != '{' && *next != '}')
+                ++next;
+            appendLiteral_(pattern, it, next - it);
+            it = next;
+            continue;
+        }
+        if (it + 1 != itEnd && it[1] == '{')
+        {
+            appendLiteral_(pattern, it, 1);
+            it += 2;
+            continue;
+        }
+
+        // Parse field "{key[:arg[:arg]]}".
+        char const * fieldEnd = std::find(it, itEnd, '}');
+        if (fieldEnd == itEnd)
+            return 1;
+        std::string field(it + 1, fieldEnd);
+        it = fieldEnd + 1;
+        std::string key = field.substr(0, field.find(':'));
+        std::string args = (key.size() < field.size()) ? field.substr(key.size() + 1) : std::string();
+
+        RenameOp_ op;
+        if (key == "prefix" && args.empty())
+        {
+            appendLiteral_(pattern, begin(prefix, seqan::Standard()), length(prefix));
+            continue;
+        }
+        else if (key == "index")
+        {
+            op.kind = RenameOp_::INDEX;
+            if (!args.empty())
+            {
+                std::string radixStr = args.substr(0, args.find(':'));
+                std::string widthStr = (radixStr.size() < args.size()) ? args.substr(radixStr.size() + 1) : "0";
+                if (!seqan::lexicalCast2(op.radix, radixStr) || !seqan::lexicalCast2(op.width, widthStr))
+                    return 1;
+                if (op.radix != 10u && op.radix != 16u && op.radix != 36u && op.radix != 64u)
+                    return 1;
+                if (op.width > 64u)
+                    return 1;
+            }
+            pattern.fixedLength += std::max(64u, op.width);
+        }
+        else if (key == "mate" && args.empty())
+        {
+            op.kind = RenameOp_::MATE;
+            pattern.fixedLength += 1;
+        }
+        else if (key == "name" && args.empty())
+        {
+            op.kind = RenameOp_::NAME;
+            pattern.headerFactor += 1;
+        }
+        else if (key == "comment" && args.empty())
+        {
+            op.kind = RenameOp_::COMMENT;
+            pattern.headerFactor += 1;
+        }
+        else
+        {
+            return 1;
+        }
+        appendValue(pattern.ops, op);
+    }
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function formatIndex_()
+// ----------------------------------------------------------------------------
+
+inline char * formatIndex_(char * out, __uint64 x, unsigned radix, unsigned width)
+{
+    static char const DIGITS[65] = "-0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ_abcdefghijklmnopqrstuvwxyz";
+    static char const DIGITS_LOWER[37] = "0123456789abcdefghijklmnopqrstuvwxyz";
+    char const * digits = (radix == 64u) ? DIGITS : DIGITS_LOWER;
+
+    // Write digits backwards into a temporary buffer, the common radix 10 case avoids the division by a variable.
+    char buffer[64];
+    char * ptr = buffer + sizeof(buffer);
+    if (radix == 10u)
+    {
+        do
+        {
+            *--ptr = '0' + (char)(x % 10);
+            x /= 10;
+        }
+        while (x);
+    }
+    else
+    {
+        do
+        {
+            *--ptr = digits[x % radix];
+            x /= radix;
+        }
+        while (x);
+    }
+    for (unsigned len = buffer + sizeof(buffer) - ptr; len < width; ++len)
+        *out++ = digits[0];
+    size_t len = buffer + sizeof(buffer) - ptr;
+    memcpy(out, ptr, len);
+    return out + len;
+}
+
+// ----------------------------------------------------------------------------
+// Function digitValue_()
+// ----------------------------------------------------------------------------
+
+// Returns the value of digit c in radix, radix if c is no digit.
+
+inline unsigned digitValue_(char c, unsigned radix)
+{
+    unsigned x = radix;
+    if (radix == 64u)
+    {
+        if (c == '-')
+            x = 0;
+        else if (c >= '0' && c <= '9')
+            x = c - '0' + 1;
+        else if (c >= 'A' && c <= 'Z')
+            x = c - 'A' + 11;
+        else if (c == '_')
+            x = 37;
+        else if (c >= 'a' && c <= 'z')
+            x = c - 'a' + 38;
+    }
+    else
+    {
+        if (c >= '0' && c <= '9')
+            x = c - '0';
+        else if (c >= 'a' && c <= 'z')
+            x = c - 'a' + 10;
+    }
+    return (x < radix) ? x : radix;
+}
+
+// ----------------------------------------------------------------------------
+// Function isInvertible()                                      [RenamePattern]
+// ----------------------------------------------------------------------------
+
+// Returns true if parseIndex() can recover the index from names formatted with pattern.  This is the case if there
+// is an {index} field, there are no {name} or {comment} fields before the last one, and each {index} field is
+// followed by the end or a literal that does not start with one of its digits.
+
+inline bool isInvertible(RenamePattern const & pattern)
+{
+    bool hasIndex = false;
+    for (unsigned i = 0; i < length(pattern.ops); ++i)
+    {
+        RenameOp_ const & op = pattern.ops[i];
+        if (op.kind == RenameOp_::NAME || op.kind == RenameOp_::COMMENT)
+        {
+            for (unsigned j = i + 1; j < length(pattern.ops); ++j)
+                if (pattern.ops[j].kind == RenameOp_::INDEX)
+                    return false;
+            return hasIndex;
+        }
+        if (op.kind != RenameOp_::INDEX)
+            continue;
+        hasIndex = true;
+        if (i + 1 == length(pattern.ops))
+            break;
+        RenameOp_ const & next = pattern.ops[i + 1];
+        if (next.kind != RenameOp_::LITERAL ||
+            digitValue_(pattern.literals[next.literalBegin], op.radix) < op.radix)
+            return false;
+    }
+    return hasIndex;
+}
+
+// ----------------------------------------------------------------------------
+// Function parseIndex()                                        [RenamePattern]
+// ----------------------------------------------------------------------------
+
+// Recover the {index} value from [name, nameEnd) formatted with the invertible pattern.  Everything behind the last
+// {index} field is ignored such that names with stripped mate suffixes are accepted.  Returns false if the name
+// does not match.
+
+inline bool parseIndex(__uint64 & index, RenamePattern const & pattern, char const * name, char const * nameEnd)
+{
+    unsigned lastIndexOp = 0;
+    for (unsigned i = 0; i < length(pattern.ops); ++i)
+        if (pattern.ops[i].kind == RenameOp_::INDEX)
+            lastIndexOp = i;
+
+    bool found = false;
+    for (unsigned i = 0; i <= lastIndexOp; ++i)
+    {
+        RenameOp_ const & op = pattern.ops[i];
+        switch (op.kind)
+        {
+            case RenameOp_::LITERAL:
+            {
+                size_t len = op.literalEnd - op.literalBegin;
+                if ((size_t)(nameEnd - name) < len || memcmp(name, &pattern.literals[0] + op.literalBegin, len) != 0)
+                    return false;
+                name += len;
+                break;
+            }
+            case RenameOp_::INDEX:
+            {
+                __uint64 x = 0;
+                char const * digitsBegin = name;
+                for (unsigned d; name != nameEnd && (d = digitValue_(*name, op.radix)) < op.radix; ++name)
+                    x = x * op.radix + d;
+                if (name == digitsBegin || (found && x != index))
+                    return false;
+                index = x;
+                found = true;
+                break;
+            }
+            case RenameOp_::MATE:
+                if (name == nameEnd)
+                    return false;
+                ++name;
+                break;
+            default:
+                return false;
+        }
+    }
+    return found;
+}
+
+// ----------------------------------------------------------------------------
+// Function maxNameLength()                                     [RenamePattern]
+// ----------------------------------------------------------------------------
+
+// Upper bound on the length of a name formatted from a header of headerLength characters.
+
+inline size_t maxNameLength(RenamePattern const & pattern, size_t headerLength)
+{
+    return pattern.fixedLength + pattern.headerFactor * headerLength;
+}
+
+// ----------------------------------------------------------------------------
+// Function formatName()                                        [RenamePattern]
+// ----------------------------------------------------------------------------
+
+// Write the name for record index with the given mate number ('1' or '2') and original header [header, headerEnd)
+// to out.  out must have room for maxNameLength() characters, returns the end of the written name.
+
+inline char * formatName(char * out, RenamePattern const & pattern, __uint64 index, char mate,
+                         char const * header, char const * headerEnd)
+{
+    for (unsigned i = 0; i < length(pattern.ops); ++i)
+    {
+        RenameOp_ const & op = pattern.ops[i];
+        switch (op.kind)
+        {
+            case RenameOp_::LITERAL:
+                memcpy(out, &pattern.literals[0] + op.literalBegin, op.literalEnd - op.literalBegin);
+                out += op.literalEnd - op.literalBegin;
+                break;
+            case RenameOp_::INDEX:
+                out = formatIndex_(out, index, op.radix, op.width);
+                break;
+            case RenameOp_::MATE:
+                *out++ = mate;
+                break;
+            case RenameOp_::NAME:
+            case RenameOp_::COMMENT:
+            {
+                char const * nameEnd = header;
+                while (nameEnd != headerEnd && *nameEnd != ' ' && *nameEnd != '\t')
+                    ++nameEnd;
+                char const * from = (op.kind == RenameOp_::NAME) ? header : std::min(nameEnd + 1, headerEnd);
+                char const * to = (op.kind == RenameOp_::NAME) ? nameEnd : headerEnd;
+                memcpy(out, from, to - from);
+                out += to - from;
+                break;
+            }
+        }
+    }
+    return out;
+}
+
+// ----------------------------------------------------------------------------
+// Function mateOfHeader()
+// ----------------------------------------------------------------------------
+
+// Returns the mate number of a read header as '1' or '2'.  This is the suffix "/1" or "/2" of the name or the first
+// field of an Illumina 1.8 comment such as "2:N:0:ACGT", '1' if there is neither.
+
+inline char mateOfHeader(char const * header, char const * headerEnd)
+{
+    char const * nameEnd = header;
+    while (nameEnd != headerEnd && *nameEnd != ' ' && *nameEnd != '\t')
+        ++nameEnd;
+    if (nameEnd - header >= 2 && nameEnd[-2] == '/' && (nameEnd[-1] == '1' || nameEnd[-1] == '2'))
+        return nameEnd[-1];
+    if (headerEnd - nameEnd >= 3 && (nameEnd[1] == '1' || nameEnd[1] == '2') && nameEnd[2] == ':')
+        return nameEnd[1];
+    return '1';
+}
+
+// ----------------------------------------------------------------------------
+// Function mateNameEnd()
+// ----------------------------------------------------------------------------
+
+// Returns the end of the name of a read header without a "/1" or "/2" mate suffix.  Both mates of a pair have the
+// same name up to there.
+
+inline char const * mateNameEnd(char const * header, char const * headerEnd)
+{
+    char const * nameEnd = header;
+    while (nameEnd != headerEnd && *nameEnd != ' ' && *nameEnd != '\t')
+        ++nameEnd;
+    if (nameEnd - header >= 2 && nameEnd[-2] == '/' && (nameEnd[-1] == '1' || nameEnd[-1] == '2'))
+        nameEnd -= 2;
+    return nameEnd;
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_RENAME_PATTERN_H_
@@ -0,0 +1,192 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// In-place reverse-complementation of raw character buffers.
+//
+// In contrast to converting to Dna5String, case and IUPAC codes are kept,
+// e.g. "acgRN" becomes "NYcgt".  Characters that are not letters are kept
+// as they are.  Qualities can be reversed in the same pass.
+//
+// If SSSE3 is available at compile time (CMake adds -mssse3 unless
+// FX_TOOLS_USE_SSSE3 is switched off), 16 characters are processed at once:
+// the complement is looked up with byte shuffles on the low nibble of the
+// upper-cased character and the block is reversed with a byte shuffle.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_REVERSE_COMPLEMENT_H_
+#define SANDBOX_FX_TOOLS_APPS_FX_TOOLS_REVERSE_COMPLEMENT_H_
+
+#include <algorithm>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif  // #if defined(__SSSE3__)
+
+#include <seqan/basic.h>
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class ComplementTable_
+// ----------------------------------------------------------------------------
+
+// Complements of upper case letters from '@' (0x40) to '_' (0x5f), the lower
+// nibble is the index.  Entries for non-letters are never used.
+
+struct ComplementTable_
+{
+    char table[256];
+
+    static char const * upper()
+    {
+        static char const UPPER[33] = "@TVGHEFCDIJMLKNOPQYSAABWXRZ[\\]^_";
+        return UPPER;
+    }
+
+    ComplementTable_()
+    {
+        for (unsigned i = 0; i < 256; ++i)
+            table[i] = static_cast<char>(i);
+        for (unsigned c = 'A'; c <= 'Z'; ++c)
+        {
+            table[c] = upper()[c - 0x40];
+            table[c | 0x20] = upper()[c - 0x40] | 0x20;
+        }
+    }
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function complementChar()
+// ----------------------------------------------------------------------------
+
+inline char complementChar(char c)
+{
+    static ComplementTable_ const TABLE;
+    return TABLE.table[static_cast<unsigned char>(c)];
+}
+
+#if defined(__SSSE3__)
+
+// ----------------------------------------------------------------------------
+// Function reverseComplementBlock_()
+// ----------------------------------------------------------------------------
+
+// Reverse-complement the 16 characters in x.  Returns false if x contains
+// non-letters, x is unchanged then.
+
+inline bool reverseComplementBlock_(__m128i & x)
+{
+    char const * upper = ComplementTable_::upper();
+    __m128i const table4 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(upper));
+    __m128i const table5 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(upper + 16));
+    __m128i const caseBit = _mm_set1_epi8(0x20);
+    __m128i const reverseIdx = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+    // Check that all characters are letters, i.e. 'A' <= (x & ~0x20) <= 'Z'.
+    __m128i u = _mm_andnot_si128(caseBit, x);
+    __m128i tooSmall = _mm_cmplt_epi8(u, _mm_set1_epi8('A'));
+    __m128i tooLarge = _mm_cmpgt_epi8(u, _mm_set1_epi8('Z'));
+    if (_mm_movemask_epi8(_mm_or_si128(tooSmall, tooLarge)))
+        return false;
+
+    // Lookup complement of upper case characters by low nibble, select by high nibble, restore case bit.
+    __m128i lo = _mm_and_si128(u, _mm_set1_epi8(0x0f));
+    __m128i is5 = _mm_cmpeq_epi8(_mm_and_si128(u, _mm_set1_epi8(0x10)), _mm_set1_epi8(0x10));
+    __m128i c4 = _mm_shuffle_epi8(table4, lo);
+    __m128i c5 = _mm_shuffle_epi8(table5, lo);
+    __m128i c = _mm_or_si128(_mm_and_si128(is5, c5), _mm_andnot_si128(is5, c4));
+    c = _mm_or_si128(c, _mm_and_si128(x, caseBit));
+
+    x = _mm_shuffle_epi8(c, reverseIdx);
+    return true;
+}
+
+#endif  // #if defined(__SSSE3__)
+
+// ----------------------------------------------------------------------------
+// Function reverseComplementInPlace()
+// ----------------------------------------------------------------------------
+
+// Reverse-complement the characters in [first, last).  If quals is not NULL
+// then the last - first characters starting at quals are reversed.
+
+inline void reverseComplementInPlace(char * first, char * last, char * quals)
+{
+    char * qualsLast = quals ? quals + (last - first) : 0;
+
+#if defined(__SSSE3__)
+    // Swap reverse-complemented blocks of 16 characters from both ends.
+    __m128i const reverseIdx = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    while (last - first >= 32)
+    {
+        __m128i front = _mm_loadu_si128(reinterpret_cast<__m128i const *>(first));
+        __m128i back = _mm_loadu_si128(reinterpret_cast<__m128i const *>(last - 16));
+        if (!reverseComplementBlock_(front) || !reverseComplementBlock_(back))
+            break;  // Continue with scalar code below.
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(first), back);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(last - 16), front);
+        first += 16;
+        last -= 16;
+
+        if (quals)
+        {
+            __m128i qFront = _mm_loadu_si128(reinterpret_cast<__m128i const *>(quals));
+            __m128i qBack = _mm_loadu_si128(reinterpret_cast<__m128i const *>(qualsLast - 16));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(quals), _mm_shuffle_epi8(qBack, reverseIdx));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(qualsLast - 16), _mm_shuffle_epi8(qFront, reverseIdx));
+            quals += 16;
+            qualsLast -= 16;
+        }
+    }
+#endif  // #if defined(__SSSE3__)
+
+    for (; last - first >= 2; ++first, --last)
+    {
+        char c = complementChar(*first);
+        *first = complementChar(last[-1]);
+        last[-1] = c;
+    }
+    if (first != last)
+        *first = complementChar(*first);
+
+    if (quals)
+        std::reverse(quals, qualsLast);
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_APPS_FX_TOOLS_REVERSE_COMPLEMENT_H_
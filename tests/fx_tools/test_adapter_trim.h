@@ -0,0 +1,155 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Tests for adapter_trim.h.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_ADAPTER_TRIM_H_
+#define SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_ADAPTER_TRIM_H_
+
+#include <cctype>
+#include <string>
+#include <vector>
+
+#include <seqan/basic.h>
+
+#include "adapter_trim.h"
+
+// Returns whether read character c matches adapter character a.
+
+inline bool adapterCharMatches(char c, char a)
+{
+    return toupper(a) == 'N' || toupper(c) == toupper(a);
+}
+
+// Brute force version of findAdapter(): the leftmost position where an adapter matches with at most maxErrors
+// mismatches or an adapter prefix of at least minOverlap characters matches the read end.
+
+inline size_t findAdapterNaive(std::vector<std::string> const & adapters, unsigned maxErrors, unsigned minOverlap,
+                               std::string const & read)
+{
+    size_t len = read.size();
+    for (size_t p = 0; p < len; ++p)
+    {
+        for (unsigned a = 0; a < adapters.size(); ++a)
+        {
+            size_t m = std::min((size_t)64, adapters[a].size());
+            size_t l = std::min(m, len - p);
+            if (l < m && l < minOverlap)
+                continue;
+            unsigned errors = 0;
+            for (size_t i = 0; i < l; ++i)
+                errors += !adapterCharMatches(read[p + i], adapters[a][i]);
+            if (errors <= ((l < m) ? l * maxErrors / m : maxErrors))
+                return p;
+        }
+    }
+    return len;
+}
+
+inline char randomDnaChar(__uint64 & state)
+{
+    state = state * 6364136223846793005ull + 1442695040888963407ull;
+    return "ACGTACGTACGTACGTACGTACGTACGTACGN"[state >> 59];
+}
+
+SEQAN_DEFINE_TEST(test_adapter_trim_examples)
+{
+    AdapterTrimmer trimmer;
+    init(trimmer, 1, 3);
+    addAdapter(trimmer, "AGATCGGAAGAGC");
+
+    // Exact and one mismatch full matches.
+    std::string read = "ACGTACGTAGATCGGAAGAGCTTTT";
+    SEQAN_ASSERT_EQ(findAdapter(trimmer, read.data(), read.size()), 8u);
+    read = "ACGTACGTAGATCGGTAGAGCTTTT";
+    SEQAN_ASSERT_EQ(findAdapter(trimmer, read.data(), read.size()), 8u);
+    // Two mismatches are too many.
+    read = "ACGTACGTAGATCCGTAGAGCTTTT";
+    SEQAN_ASSERT_EQ(findAdapter(trimmer, read.data(), read.size()), read.size());
+    // Partial matches at the end, the shortest allowed is three characters.
+    read = "ACGTACGTTTTTAGATCG";
+    SEQAN_ASSERT_EQ(findAdapter(trimmer, read.data(), read.size()), 12u);
+    read = "ACGTACGTTTTTAGA";
+    SEQAN_ASSERT_EQ(findAdapter(trimmer, read.data(), read.size()), 12u);
+    read = "ACGTACGTTTTTCAG";
+    SEQAN_ASSERT_EQ(findAdapter(trimmer, read.data(), read.size()), read.size());
+    // Lower case reads match.
+    read = "acgtacgtagatcggaagagc";
+    SEQAN_ASSERT_EQ(findAdapter(trimmer, read.data(), read.size()), 8u);
+}
+
+SEQAN_DEFINE_TEST(test_adapter_trim_naive)
+{
+    __uint64 state = 13;
+    for (unsigned round = 0; round < 300u; ++round)
+    {
+        unsigned maxErrors = round % 3;
+        unsigned minOverlap = 1 + round % 5;
+
+        // Enough adapters to fill several groups, one of them longer than a word.
+        std::vector<std::string> adapters(1 + round % 7);
+        for (unsigned a = 0; a < adapters.size(); ++a)
+        {
+            unsigned m = (a == 3u) ? 70 : 3 + (round * 7 + a * 5) % 25;
+            for (unsigned i = 0; i < m; ++i)
+                adapters[a] += randomDnaChar(state);
+        }
+
+        AdapterTrimmer trimmer;
+        init(trimmer, maxErrors, minOverlap);
+        for (unsigned a = 0; a < adapters.size(); ++a)
+            addAdapter(trimmer, adapters[a]);
+
+        for (unsigned r = 0; r < 20u; ++r)
+        {
+            // Random reads with a mutated copy of an adapter at a random position, possibly hanging off the end.
+            std::string read;
+            unsigned len = (r * 13 + round) % 120;
+            for (unsigned i = 0; i < len; ++i)
+                read += randomDnaChar(state);
+            if (len > 0u && r % 4 != 0u)
+            {
+                std::string const & adapter = adapters[(r + round) % adapters.size()];
+                unsigned pos = (r * 31 + round * 3) % len;
+                for (unsigned i = 0; i < adapter.size() && pos + i < len; ++i)
+                    read[pos + i] = (i % 11 == 10u) ? randomDnaChar(state) : adapter[i];
+            }
+
+            size_t expected = findAdapterNaive(adapters, maxErrors, minOverlap, read);
+            SEQAN_ASSERT_EQ(findAdapter(trimmer, read.data(), read.size()), expected);
+        }
+    }
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_ADAPTER_TRIM_H_
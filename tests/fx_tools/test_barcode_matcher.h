@@ -0,0 +1,125 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Tests for barcode_matcher.h.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_BARCODE_MATCHER_H_
+#define SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_BARCODE_MATCHER_H_
+
+#include <string>
+
+#include <seqan/basic.h>
+
+#include "barcode_matcher.h"
+
+inline __uint32 findBarcode(BarcodeMatcher const & matcher, std::string const & barcode)
+{
+    return findBarcode(matcher, barcode.data(), barcode.size());
+}
+
+inline void insert(BarcodeMatcher & matcher, std::string const & barcode, __uint32 sampleId)
+{
+    insert(matcher, barcode.data(), barcode.size(), sampleId);
+}
+
+SEQAN_DEFINE_TEST(test_barcode_matcher_exact)
+{
+    BarcodeMatcher matcher;
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "ACGTAC"), (__uint32)BARCODE_NO_MATCH);
+
+    insert(matcher, "ACGTAC", 0);
+    insert(matcher, "ACGTTC", 1);
+    insert(matcher, "ACGT+TTGC", 2);
+    SEQAN_ASSERT_EQ(build(matcher, 0), 0);
+
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "ACGTAC"), 0u);
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "acgtac"), 0u);
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "ACGTTC"), 1u);
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "ACGT+TTGC"), 2u);
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "ACGAAC"), (__uint32)BARCODE_NO_MATCH);
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "ACGTA"), (__uint32)BARCODE_NO_MATCH);
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "ACGTACG"), (__uint32)BARCODE_NO_MATCH);
+}
+
+SEQAN_DEFINE_TEST(test_barcode_matcher_hamming_one)
+{
+    BarcodeMatcher matcher;
+    // The first two barcodes differ in one position, the last two belong to the same sample.
+    insert(matcher, "ACGTAC", 0);
+    insert(matcher, "ACGTTC", 1);
+    insert(matcher, "GGGGGG", 2);
+    insert(matcher, "GGGGGA", 2);
+    insert(matcher, "ACGT+TTGC", 3);
+    SEQAN_ASSERT_EQ(build(matcher, 1), 0);
+
+    // Exact barcodes take precedence over the neighbours of other barcodes.
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "ACGTAC"), 0u);
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "ACGTTC"), 1u);
+    // One mismatch, including N.
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "TCGTAC"), 0u);
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "ACGTAN"), 0u);
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "acgttg"), 1u);
+    // Neighbours of both ACGTAC and ACGTTC are ambiguous.
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "ACGTGC"), (__uint32)BARCODE_AMBIGUOUS);
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "ACGTNC"), (__uint32)BARCODE_AMBIGUOUS);
+    // Neighbours shared by barcodes of the same sample are not.
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "GGGGGC"), 2u);
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "GGGGCG"), 2u);
+    // Two mismatches.
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "TTGTAC"), (__uint32)BARCODE_NO_MATCH);
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "GGGGCC"), (__uint32)BARCODE_NO_MATCH);
+    // Dual index barcodes, the '+' is never substituted.
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "ACGA+TTGC"), 3u);
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "ACGT+TTGA"), 3u);
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "ACGTATTGC"), (__uint32)BARCODE_NO_MATCH);
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "ACGA+TTGA"), (__uint32)BARCODE_NO_MATCH);
+}
+
+SEQAN_DEFINE_TEST(test_barcode_matcher_conflicts)
+{
+    // The same barcode twice for one sample is fine.
+    BarcodeMatcher matcher;
+    insert(matcher, "ACGTAC", 0);
+    insert(matcher, "acgtac", 0);
+    SEQAN_ASSERT_EQ(build(matcher, 1), 0);
+    SEQAN_ASSERT_EQ(findBarcode(matcher, "ACGTAC"), 0u);
+
+    // The same barcode for two samples is an error.
+    BarcodeMatcher matcher2;
+    insert(matcher2, "ACGTAC", 0);
+    insert(matcher2, "ACGTAC", 1);
+    SEQAN_ASSERT_EQ(build(matcher2, 0), 1);
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_BARCODE_MATCHER_H_
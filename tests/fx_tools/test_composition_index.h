@@ -0,0 +1,201 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Tests for composition_index.h.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_COMPOSITION_INDEX_H_
+#define SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_COMPOSITION_INDEX_H_
+
+#include <cctype>
+#include <cstdlib>
+#include <string>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include "composition_index.h"
+
+// Minimal in-memory stand-in for the FAI index, the composition index
+// functions only need the entry store, the sequence lengths and infixes.
+
+struct TestFaiIndex_
+{
+    seqan::String<std::string> indexEntryStore;
+};
+
+inline __uint64 sequenceLength(TestFaiIndex_ const & faiIndex, unsigned seqId)
+{
+    return faiIndex.indexEntryStore[seqId].size();
+}
+
+inline int getSequenceInfix(seqan::CharString & buffer, TestFaiIndex_ & faiIndex, unsigned seqId,
+                            __uint64 beginPos, __uint64 endPos)
+{
+    std::string const & seq = faiIndex.indexEntryStore[seqId];
+    if (beginPos > endPos || endPos > seq.size())
+        return 1;
+    buffer = seqan::CharString(seq.substr(beginPos, endPos - beginPos));
+    return 0;
+}
+
+// Fill faiIndex with random sequences of the given lengths over upper and
+// lower case nucleotides, N and IUPAC characters.
+
+inline void buildTestFaiIndex(TestFaiIndex_ & faiIndex, unsigned const * lengths, unsigned n)
+{
+    char const ALPHABET[] = "ACGTNacgtnRY";
+    clear(faiIndex.indexEntryStore);
+    for (unsigned i = 0; i < n; ++i)
+    {
+        std::string seq;
+        for (unsigned j = 0; j < lengths[i]; ++j)
+            seq += ALPHABET[rand() % 12];
+        appendValue(faiIndex.indexEntryStore, seq);
+    }
+}
+
+// Check getComposition() for [beginPos, endPos) of sequence seqId against counting directly.
+
+inline void checkComposition(CompositionIndex const & index, TestFaiIndex_ & faiIndex, unsigned seqId,
+                             __uint64 beginPos, __uint64 endPos)
+{
+    std::string const & seq = faiIndex.indexEntryStore[seqId];
+    __uint64 expected[5] = {0, 0, 0, 0, 0};
+    for (__uint64 i = beginPos; i < endPos; ++i)
+    {
+        char c = toupper(seq[i]);
+        expected[(c == 'A') ? 0 : (c == 'C') ? 1 : (c == 'G') ? 2 : (c == 'T') ? 3 : 4] += 1;
+    }
+
+    CompositionCounts counts;
+    SEQAN_ASSERT_EQ(getComposition(counts, index, faiIndex, seqId, beginPos, endPos), 0);
+    for (unsigned c = 0; c < 5; ++c)
+        SEQAN_ASSERT_EQ(counts.counts[c], expected[c]);
+    SEQAN_ASSERT_EQ(cgCount(counts), expected[1] + expected[2]);
+}
+
+SEQAN_DEFINE_TEST(test_composition_index_naive)
+{
+    srand(42);
+    unsigned const LENGTHS[] = {0, 1, 63, 64, 65, 1000, 4096};
+    TestFaiIndex_ faiIndex;
+    buildTestFaiIndex(faiIndex, LENGTHS, 7);
+
+    CompositionIndex index;
+    SEQAN_ASSERT_EQ(build(index, faiIndex, 0), 1);
+    SEQAN_ASSERT_EQ(build(index, faiIndex, 64), 0);
+    SEQAN_ASSERT_EQ(numSeqs(index), 7u);
+
+    // All regions of the short sequences, including the ones ending at sample boundaries.
+    for (unsigned i = 0; i < 5; ++i)
+        for (unsigned b = 0; b <= LENGTHS[i]; ++b)
+            for (unsigned e = b; e <= LENGTHS[i]; ++e)
+                checkComposition(index, faiIndex, i, b, e);
+    // Random regions of the longer ones, most of these cross sample boundaries.
+    for (unsigned k = 0; k < 2000; ++k)
+    {
+        unsigned i = 5 + k % 2;
+        unsigned b = rand() % (LENGTHS[i] + 1), e = rand() % (LENGTHS[i] + 1);
+        checkComposition(index, faiIndex, i, std::min(b, e), std::max(b, e));
+    }
+
+    // Out of range regions are errors.
+    CompositionCounts counts;
+    SEQAN_ASSERT_EQ(getComposition(counts, index, faiIndex, 5, 10, 1001), 1);
+    SEQAN_ASSERT_EQ(getComposition(counts, index, faiIndex, 5, 10, 9), 1);
+    SEQAN_ASSERT_EQ(getComposition(counts, index, faiIndex, 7, 0, 0), 1);
+}
+
+SEQAN_DEFINE_TEST(test_composition_index_chunks)
+{
+    // A sequence longer than one chunk with a sample rate that does not divide the chunk size, so samples span
+    // chunk boundaries.
+    srand(7);
+    unsigned const LENGTHS[] = {CompositionIndex::CHUNK_SIZE + 5000, 3};
+    TestFaiIndex_ faiIndex;
+    buildTestFaiIndex(faiIndex, LENGTHS, 2);
+
+    CompositionIndex index;
+    SEQAN_ASSERT_EQ(build(index, faiIndex, 1000), 0);
+    SEQAN_ASSERT_EQ(length(index.samples), 4u * (LENGTHS[0] / 1000 + 1 + LENGTHS[1] / 1000 + 1));
+    __uint64 const CHUNK_SIZE = CompositionIndex::CHUNK_SIZE;
+    checkComposition(index, faiIndex, 0, 0, LENGTHS[0]);
+    checkComposition(index, faiIndex, 0, CHUNK_SIZE - 1500, CHUNK_SIZE + 1500);
+    checkComposition(index, faiIndex, 0, CHUNK_SIZE - 576, CHUNK_SIZE + 424);
+    checkComposition(index, faiIndex, 0, 999, LENGTHS[0] - 1);
+    checkComposition(index, faiIndex, 1, 0, 3);
+
+    // Sample rates larger than the chunk size.
+    SEQAN_ASSERT_EQ(build(index, faiIndex, 3000000000u), 0);
+    SEQAN_ASSERT_EQ(length(index.samples), 8u);
+    checkComposition(index, faiIndex, 0, 17, LENGTHS[0]);
+}
+
+SEQAN_DEFINE_TEST(test_composition_index_compatible)
+{
+    srand(3);
+    unsigned const LENGTHS[] = {500, 200};
+    TestFaiIndex_ faiIndex;
+    buildTestFaiIndex(faiIndex, LENGTHS, 2);
+
+    CompositionIndex index;
+    SEQAN_ASSERT_EQ(build(index, faiIndex, 16), 0);
+    SEQAN_ASSERT(isCompatible(index, faiIndex, 16));
+    SEQAN_ASSERT_NOT(isCompatible(index, faiIndex, 32));
+
+    // Save and load keep the checksum.
+    std::string path = SEQAN_TEMP_FILENAME();
+    SEQAN_ASSERT_EQ(save(index, path.c_str()), 0);
+    CompositionIndex loaded;
+    SEQAN_ASSERT_EQ(load(loaded, path.c_str()), 0);
+    SEQAN_ASSERT_EQ(loaded.sampleRate, 16u);
+    SEQAN_ASSERT_EQ(loaded.checksum, index.checksum);
+    SEQAN_ASSERT(loaded.samples == index.samples);
+    SEQAN_ASSERT(isCompatible(loaded, faiIndex, 16));
+
+    // Edited content of the same length.
+    std::string & seq = faiIndex.indexEntryStore[1];
+    seq[100] = (seq[100] == 'A') ? 'C' : 'A';
+    SEQAN_ASSERT_NOT(isCompatible(loaded, faiIndex, 16));
+    seq[100] = (seq[100] == 'A') ? 'C' : 'A';
+    SEQAN_ASSERT(isCompatible(loaded, faiIndex, 16));
+
+    // Changed lengths and sequence counts.
+    faiIndex.indexEntryStore[1] += "A";
+    SEQAN_ASSERT_NOT(isCompatible(loaded, faiIndex, 16));
+    resize(faiIndex.indexEntryStore, 1);
+    SEQAN_ASSERT_NOT(isCompatible(loaded, faiIndex, 16));
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_COMPOSITION_INDEX_H_
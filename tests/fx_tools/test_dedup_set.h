@@ -0,0 +1,131 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Tests for dedup_set.h.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_DEDUP_SET_H_
+#define SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_DEDUP_SET_H_
+
+#include <cstdio>
+#include <cstring>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include "dedup_set.h"
+
+// Fingerprint of the sequence "SEQ<i>".
+
+inline void testFingerprint(DedupFingerprint & fp, unsigned i, unsigned numWords)
+{
+    char seq[32];
+    snprintf(seq, sizeof(seq), "SEQ%u", i);
+    computeFingerprint(fp, 0, 0, seq, strlen(seq), numWords);
+}
+
+SEQAN_DEFINE_TEST(test_dedup_set_fingerprint)
+{
+    DedupFingerprint a, b;
+    computeFingerprint(a, "r1", 2, "ACGT", 4, 1);
+    computeFingerprint(b, "r2", 2, "ACGT", 4, 1);
+    SEQAN_ASSERT_NEQ(a.h1, 0u);
+    SEQAN_ASSERT_EQ(a.h2, 0u);
+    SEQAN_ASSERT_NEQ(a.h1, b.h1);
+
+    // Without the identifier, only the sequence counts.
+    computeFingerprint(a, "r1", 0, "ACGT", 4, 2);
+    computeFingerprint(b, "r2", 0, "ACGT", 4, 2);
+    SEQAN_ASSERT_EQ(a.h1, b.h1);
+    SEQAN_ASSERT_EQ(a.h2, b.h2);
+    SEQAN_ASSERT_NEQ(a.h1, a.h2);
+}
+
+SEQAN_DEFINE_TEST(test_dedup_set_insert)
+{
+    for (unsigned numWords = 1; numWords <= 2u; ++numWords)
+    {
+        DedupSet set;
+        init(set, numWords, 1024 * 1024 * 1024);
+        DedupFingerprint fp;
+        // The table grows several times.
+        for (unsigned i = 0; i < 10000u; ++i)
+        {
+            testFingerprint(fp, i, numWords);
+            SEQAN_ASSERT_EQ(insert(set, fp), 1);
+        }
+        SEQAN_ASSERT_EQ(set.size, 10000u);
+        SEQAN_ASSERT_GEQ(4 * numSlots(set), 3 * set.size);
+        for (unsigned i = 0; i < 10000u; i += 7)
+        {
+            testFingerprint(fp, i, numWords);
+            SEQAN_ASSERT_EQ(insert(set, fp), 0);
+        }
+        SEQAN_ASSERT_EQ(set.size, 10000u);
+    }
+}
+
+SEQAN_DEFINE_TEST(test_dedup_set_budget)
+{
+    // The budget does not allow growing the initial table of 1024 slots, it is filled up to 7/8.
+    DedupSet set;
+    init(set, 1, 1024 * sizeof(__uint64));
+    DedupFingerprint fp;
+    for (unsigned i = 0; i < 896u; ++i)
+    {
+        testFingerprint(fp, i, 1);
+        SEQAN_ASSERT_EQ(insert(set, fp), 1);
+    }
+    testFingerprint(fp, 896, 1);
+    SEQAN_ASSERT_EQ(insert(set, fp), -1);
+    SEQAN_ASSERT_EQ(set.size, 896u);
+    SEQAN_ASSERT_EQ(numSlots(set), 1024u);
+
+    // Twice the budget allows one growth step.
+    init(set, 2, 2 * 2048 * sizeof(__uint64));
+    unsigned numInserted = 0;
+    for (unsigned i = 0; i < 4096u; ++i)
+    {
+        testFingerprint(fp, i, 2);
+        int res = insert(set, fp);
+        if (res < 0)
+            break;
+        SEQAN_ASSERT_EQ(res, 1);
+        ++numInserted;
+    }
+    SEQAN_ASSERT_EQ(numInserted, 1792u);
+    SEQAN_ASSERT_EQ(numSlots(set), 2048u);
+    SEQAN_ASSERT_LEQ(length(set.table) * sizeof(__uint64), 2 * 2048 * sizeof(__uint64));
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_DEDUP_SET_H_
@@ -0,0 +1,504 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Tests for fastq_stats.h.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_FASTQ_STATS_H_
+#define SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_FASTQ_STATS_H_
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include "fastq_stats.h"
+
+inline void registerTestRead(FastqStats & stats, std::string const & seq, std::string const & quals)
+{
+    stats.registerRead(seq.data(), quals.data(), seq.size());
+}
+
+// Random reads of length 0..maxLength, the quality of a base is derived from its position.
+
+inline void buildTestReads(std::vector<std::string> & seqs, std::vector<std::string> & quals, unsigned numReads,
+                           unsigned maxLength, __uint64 seed)
+{
+    seqs.clear();
+    quals.clear();
+    __uint64 state = seed;
+    for (unsigned i = 0; i < numReads; ++i)
+    {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        unsigned len = (state >> 33) % (maxLength + 1);
+        seqs.push_back(std::string());
+        quals.push_back(std::string());
+        for (unsigned j = 0; j < len; ++j)
+        {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            seqs.back() += "ACGTNacgt"[(state >> 33) % 9];
+            quals.back() += (char)('!' + ((state >> 40) % 30 + 41 - j % 40));
+        }
+    }
+}
+
+// FASTQ file with the reads, every fifth record has line breaks in its sequence and qualities.
+
+inline std::string buildTestStatsFastq(std::vector<std::string> const & seqs, std::vector<std::string> const & quals)
+{
+    std::stringstream ss;
+    for (unsigned i = 0; i < seqs.size(); ++i)
+    {
+        ss << "@read" << i << "\n";
+        if (i % 5 == 4u && seqs[i].size() > 3u)
+            ss << seqs[i].substr(0, 3) << "\n" << seqs[i].substr(3) << "\n+\n" << quals[i].substr(0, 3) << "\n"
+               << quals[i].substr(3) << "\n";
+        else
+            ss << seqs[i] << "\n+\n" << quals[i] << "\n";
+    }
+    return ss.str();
+}
+
+// Assert that a and b have the same counts.
+
+inline void assertSameStatsCounts(FastqStats const & a, FastqStats const & b)
+{
+    SEQAN_ASSERT_EQ(a.maxLength, b.maxLength);
+    SEQAN_ASSERT_EQ(a.numColumns, b.numColumns);
+    for (unsigned i = 0; i < 5 * a.numColumns; ++i)
+        SEQAN_ASSERT_EQ(a.nucleotideCounts[i], b.nucleotideCounts[i]);
+    for (unsigned i = 0; i < a.numColumns; ++i)
+        for (unsigned q = 0; q < QualHistograms::NUM_QUALS; ++q)
+            SEQAN_ASSERT_EQ(a.qualHistos.row(i)[q], b.qualHistos.row(i)[q]);
+    SEQAN_ASSERT_EQ(length(a.lengthCounts), length(b.lengthCounts));
+    for (unsigned i = 0; i < length(a.lengthCounts); ++i)
+        SEQAN_ASSERT_EQ(a.lengthCounts[i], b.lengthCounts[i]);
+    for (unsigned q = 0; q < QualHistograms::NUM_QUALS; ++q)
+        SEQAN_ASSERT_EQ(a.meanQualCounts[q], b.meanQualCounts[q]);
+}
+
+SEQAN_DEFINE_TEST(test_fastq_stats_qual_histograms)
+{
+    QualHistograms histos;
+    histos.resize(3);
+    SEQAN_ASSERT_EQ(histos.numColumns, 3u);
+    for (unsigned i = 0; i < 3u; ++i)
+    {
+        // Rows start at cache line boundaries.
+        SEQAN_ASSERT_EQ(reinterpret_cast<size_t>(histos.row(i)) % 64, 0u);
+        for (unsigned q = 0; q < QualHistograms::NUM_QUALS; ++q)
+            SEQAN_ASSERT_EQ(histos.row(i)[q], 0u);
+        histos.row(i)[i + 1] = 10 + i;
+    }
+
+    // Growing keeps the counts, the new rows are empty.
+    histos.resize(100);
+    SEQAN_ASSERT_EQ(reinterpret_cast<size_t>(histos.row(99)) % 64, 0u);
+    for (unsigned i = 0; i < 3u; ++i)
+        SEQAN_ASSERT_EQ(histos.row(i)[i + 1], 10u + i);
+    for (unsigned q = 0; q < QualHistograms::NUM_QUALS; ++q)
+        SEQAN_ASSERT_EQ(histos.row(99)[q], 0u);
+
+    QualHistograms copy(histos);
+    SEQAN_ASSERT_EQ(copy.numColumns, 100u);
+    SEQAN_ASSERT_EQ(copy.row(2)[3], 12u);
+    SEQAN_ASSERT(copy.row(0) != histos.row(0));
+    copy = QualHistograms();
+    SEQAN_ASSERT_EQ(copy.numColumns, 0u);
+}
+
+SEQAN_DEFINE_TEST(test_fastq_stats_register_read)
+{
+    FastqStats stats;
+    // PHRED scores 0, 10, 20, 30, 40 and 40, 40, 40, 40.  Characters outside '!'..'~' are clamped.
+    registerTestRead(stats, "ACGTN", "!+5?I");
+    registerTestRead(stats, "aaXa", "II\x7fI");
+    registerTestRead(stats, "", "");
+    stats.finalizeStats();
+
+    SEQAN_ASSERT_EQ(stats.maxLength, 5u);
+    SEQAN_ASSERT_EQ(stats.numColumns, 5u);
+
+    // Nucleotide counts, all characters but ACGT count as N.
+    __int64 const expectedCounts[5][5] =
+    {
+        {2, 0, 0, 0, 0},
+        {1, 1, 0, 0, 0},
+        {0, 0, 1, 0, 1},
+        {1, 0, 0, 1, 0},
+        {0, 0, 0, 0, 1}
+    };
+    for (unsigned i = 0; i < 5u; ++i)
+        for (unsigned c = 0; c < 5u; ++c)
+            SEQAN_ASSERT_EQ(stats.nucleotideCounts[5 * i + c], expectedCounts[i][c]);
+
+    SEQAN_ASSERT_EQ(stats.numBases[0], 2);
+    SEQAN_ASSERT_EQ(stats.numBases[4], 1);
+    SEQAN_ASSERT_EQ(stats.minScores[0], 0);
+    SEQAN_ASSERT_EQ(stats.maxScores[0], 40);
+    SEQAN_ASSERT_EQ(stats.sumScores[0], 40);
+    SEQAN_ASSERT_IN_DELTA(stats.meanScores[0], 20.0, 1e-9);
+    SEQAN_ASSERT_EQ(stats.minScores[2], 20);
+    SEQAN_ASSERT_EQ(stats.maxScores[2], 93);
+    SEQAN_ASSERT_EQ(stats.minScores[4], 40);
+    SEQAN_ASSERT_EQ(stats.maxScores[4], 40);
+
+    // One read each of length 0, 4 and 5, and with mean quality 20 and 53.
+    SEQAN_ASSERT_EQ(length(stats.lengthCounts), 6u);
+    SEQAN_ASSERT_EQ(stats.lengthCounts[0], 1);
+    SEQAN_ASSERT_EQ(stats.lengthCounts[4], 1);
+    SEQAN_ASSERT_EQ(stats.lengthCounts[5], 1);
+    SEQAN_ASSERT_EQ(stats.meanQualCounts[20], 1);
+    SEQAN_ASSERT_EQ(stats.meanQualCounts[53], 1);
+}
+
+SEQAN_DEFINE_TEST(test_fastq_stats_quartiles)
+{
+    // Qualities 10, 20, 30, 40 in one column, four reads each.
+    FastqStats stats;
+    char const * quals = "+5?I";
+    for (unsigned i = 0; i < 16u; ++i)
+        registerTestRead(stats, "A", std::string(1, quals[i % 4]));
+    stats.finalizeStats();
+
+    SEQAN_ASSERT_IN_DELTA(stats.firstQuartiles[0], 10.0, 1e-9);
+    SEQAN_ASSERT_IN_DELTA(stats.medianScores[0], 20.0, 1e-9);
+    SEQAN_ASSERT_IN_DELTA(stats.thirdQuartiles[0], 30.0, 1e-9);
+    SEQAN_ASSERT_IN_DELTA(stats.interQuartileRanges[0], 20.0, 1e-9);
+    SEQAN_ASSERT_EQ(stats.leftWhiskers[0], 10);
+    SEQAN_ASSERT_EQ(stats.rightWhiskers[0], 40);
+    SEQAN_ASSERT_IN_DELTA(stats.meanScores[0], 25.0, 1e-9);
+}
+
+SEQAN_DEFINE_TEST(test_fastq_stats_merge)
+{
+    std::vector<std::string> seqs, quals;
+    buildTestReads(seqs, quals, 300, 150, 31);
+
+    // Split the reads into three accumulators, the second one gets the longest reads.
+    FastqStats all, parts[3];
+    for (unsigned i = 0; i < seqs.size(); ++i)
+    {
+        registerTestRead(all, seqs[i], quals[i]);
+        registerTestRead(parts[(seqs[i].size() >= 140u) ? 1 : 2 * (i % 2)], seqs[i], quals[i]);
+    }
+    SEQAN_ASSERT_LT(parts[0].maxLength, parts[1].maxLength);
+
+    FastqStats merged;
+    for (unsigned i = 0; i < 3u; ++i)
+        SEQAN_ASSERT_EQ(merged.merge(parts[i]), 0);
+    assertSameStatsCounts(merged, all);
+
+    // Merging into an accumulator with longer reads.
+    SEQAN_ASSERT_EQ(parts[1].merge(parts[0]), 0);
+    SEQAN_ASSERT_EQ(parts[1].merge(parts[2]), 0);
+    assertSameStatsCounts(parts[1], all);
+}
+
+SEQAN_DEFINE_TEST(test_fastq_stats_compute_stats)
+{
+    std::vector<std::string> seqs, quals;
+    buildTestReads(seqs, quals, 500, 120, 32);
+    std::string file = "\n" + buildTestStatsFastq(seqs, quals) + "\n\n";
+
+    FastqStats expected;
+    for (unsigned i = 0; i < seqs.size(); ++i)
+        registerTestRead(expected, seqs[i], quals[i]);
+
+    for (unsigned numThreads = 1; numThreads <= 4u; numThreads += 3)
+    {
+        FastqStats stats;
+        SEQAN_ASSERT_EQ(computeStats(stats, file.data(), file.data() + file.size(), numThreads), 0);
+        assertSameStatsCounts(stats, expected);
+    }
+
+    // Empty files and invalid records.
+    FastqStats stats;
+    SEQAN_ASSERT_EQ(computeStats(stats, file.data(), file.data(), 1), 0);
+    SEQAN_ASSERT_EQ(stats.numColumns, 0u);
+    std::string bad = "@r1\nACGT\n+\nIII\n";
+    SEQAN_ASSERT_EQ(computeStats(stats, bad.data(), bad.data() + bad.size(), 1), 1);
+}
+
+SEQAN_DEFINE_TEST(test_fastq_stats_binning)
+{
+    PositionBinning binning;
+    binning.exactLength = 50;
+    binning.binWidth = 10;
+    for (unsigned m = 0; m < 2u; ++m)
+    {
+        binning.mode = m ? BIN_LOG : BIN_FIXED;
+        // Each position lies in the range of its column, the columns are consecutive.
+        for (__uint64 pos = 0; pos < 100000u; ++pos)
+        {
+            unsigned c = binning.column(pos);
+            SEQAN_ASSERT_LEQ(binning.columnBegin(c), pos);
+            SEQAN_ASSERT_LT(pos, binning.columnBegin(c + 1));
+            if (pos < 50u)
+                SEQAN_ASSERT_EQ(c, pos);
+            else
+                SEQAN_ASSERT_LEQ(c - binning.column(pos - 1), 1u);
+        }
+    }
+
+    binning.mode = BIN_FIXED;
+    SEQAN_ASSERT_EQ(binning.column(59), 50u);
+    SEQAN_ASSERT_EQ(binning.column(60), 51u);
+    SEQAN_ASSERT_EQ(binning.columnBegin(52), 70u);
+    binning.mode = BIN_LOG;
+    SEQAN_ASSERT_EQ(binning.column(59), 50u);
+    SEQAN_ASSERT_EQ(binning.column(60), 51u);
+    SEQAN_ASSERT_EQ(binning.column(79), 51u);
+    SEQAN_ASSERT_EQ(binning.column(80), 52u);
+    SEQAN_ASSERT_EQ(binning.columnBegin(53), 120u);
+    // A read of a billion bases needs few columns.
+    SEQAN_ASSERT_LT(binning.column(1000000000ull), 80u);
+}
+
+SEQAN_DEFINE_TEST(test_fastq_stats_long_reads)
+{
+    std::vector<std::string> seqs, quals;
+    buildTestReads(seqs, quals, 40, 3000, 33);
+
+    FastqStats stats;
+    stats.binning.exactLength = 100;
+    stats.binning.binWidth = 50;
+    for (unsigned i = 0; i < seqs.size(); ++i)
+        registerTestRead(stats, seqs[i], quals[i]);
+    stats.finalizeStats();
+    SEQAN_ASSERT_EQ(stats.numColumns, stats.binning.column(stats.maxLength - 1) + 1);
+    SEQAN_ASSERT_LT(stats.numColumns, 110u);
+
+    // The columns count the bases of the positions in their range.
+    for (unsigned c = 0; c < stats.numColumns; ++c)
+    {
+        __int64 numBases = 0;
+        __uint64 qualCounts[QualHistograms::NUM_QUALS] = {0};
+        for (unsigned i = 0; i < seqs.size(); ++i)
+        {
+            for (__uint64 j = stats.binning.columnBegin(c); j < stats.binning.columnBegin(c + 1) && j < seqs[i].size();
+                 ++j)
+            {
+                ++numBases;
+                qualCounts[quals[i][j] - '!'] += 1;
+            }
+        }
+        SEQAN_ASSERT_EQ(stats.numBases[c], numBases);
+        for (unsigned q = 0; q < QualHistograms::NUM_QUALS; ++q)
+            SEQAN_ASSERT_EQ(stats.qualHistos.row(c)[q], qualCounts[q]);
+    }
+
+    // Read lengths are binned the same way.
+    __int64 numReads = 0;
+    for (unsigned i = 0; i < length(stats.lengthCounts); ++i)
+        numReads += stats.lengthCounts[i];
+    SEQAN_ASSERT_EQ(numReads, 40);
+    SEQAN_ASSERT_EQ(length(stats.lengthCounts), stats.binning.column(stats.maxLength) + 1);
+}
+
+// Read and write whole files for the snapshot tests.
+
+inline std::string readTestFile(std::string const & path)
+{
+    std::ifstream in(path.c_str(), std::ios::binary | std::ios::in);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+inline void writeTestFile(std::string const & path, std::string const & contents)
+{
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::out);
+    out.write(contents.data(), contents.size());
+}
+
+SEQAN_DEFINE_TEST(test_fastq_stats_snapshot_round_trip)
+{
+    std::vector<std::string> seqs, quals;
+    buildTestReads(seqs, quals, 200, 300, 34);
+
+    FastqStats stats;
+    stats.binning.exactLength = 100;
+    stats.binning.mode = BIN_FIXED;
+    stats.binning.binWidth = 30;
+    init(stats.kmers, 8, 6, 10);
+    for (unsigned i = 0; i < seqs.size(); ++i)
+        registerTestRead(stats, seqs[i], quals[i]);
+
+    std::string path = SEQAN_TEMP_FILENAME();
+    SEQAN_ASSERT_EQ(saveSnapshot(stats, path.c_str()), 0);
+    FastqStats loaded;
+    SEQAN_ASSERT_EQ(loadSnapshot(loaded, path.c_str()), 0);
+
+    SEQAN_ASSERT_EQ(loaded.binning.exactLength, 100u);
+    SEQAN_ASSERT_EQ(loaded.binning.mode, BIN_FIXED);
+    SEQAN_ASSERT_EQ(loaded.binning.binWidth, 30u);
+    assertSameStatsCounts(loaded, stats);
+
+    SEQAN_ASSERT_EQ(loaded.kmers.k, 8u);
+    SEQAN_ASSERT_EQ(loaded.kmers.numKmers, stats.kmers.numKmers);
+    SEQAN_ASSERT_EQ(loaded.kmers.numReads, 200u);
+    SEQAN_ASSERT_EQ(loaded.kmers.counts.numLines, 64u);
+    for (size_t i = 0; i < 64u * CountMinSketch::LINE_SIZE; ++i)
+        SEQAN_ASSERT_EQ(loaded.kmers.counts.store[loaded.kmers.counts.offset + i],
+                        stats.kmers.counts.store[stats.kmers.counts.offset + i]);
+    SEQAN_ASSERT(loaded.kmers.distinctReads.registers == stats.kmers.distinctReads.registers);
+    std::vector<std::pair<__uint64, __uint64> > expectedTop, loadedTop;
+    topKmers(expectedTop, stats.kmers);
+    topKmers(loadedTop, loaded.kmers);
+    SEQAN_ASSERT(loadedTop == expectedTop);
+}
+
+SEQAN_DEFINE_TEST(test_fastq_stats_snapshot_merge)
+{
+    std::vector<std::string> seqs, quals;
+    buildTestReads(seqs, quals, 300, 200, 35);
+
+    // Shards with the even and odd reads.
+    FastqStats all, shards[2];
+    init(all.kmers, 12, 8, 20);
+    for (unsigned s = 0; s < 2u; ++s)
+        shards[s].copyConfig(all);
+    for (unsigned i = 0; i < seqs.size(); ++i)
+    {
+        registerTestRead(all, seqs[i], quals[i]);
+        registerTestRead(shards[i % 2], seqs[i], quals[i]);
+    }
+
+    FastqStats merged;
+    for (unsigned s = 0; s < 2u; ++s)
+    {
+        std::string path = SEQAN_TEMP_FILENAME();
+        SEQAN_ASSERT_EQ(saveSnapshot(shards[s], path.c_str()), 0);
+        FastqStats snapshot;
+        SEQAN_ASSERT_EQ(loadSnapshot(snapshot, path.c_str()), 0);
+        SEQAN_ASSERT_EQ(merged.merge(snapshot), 0);
+    }
+    assertSameStatsCounts(merged, all);
+    SEQAN_ASSERT_EQ(merged.kmers.numKmers, all.kmers.numKmers);
+    SEQAN_ASSERT_EQ(merged.kmers.numReads, all.kmers.numReads);
+    SEQAN_ASSERT(merged.kmers.distinctReads.registers == all.kmers.distinctReads.registers);
+
+    // Snapshots with other k-mer sketch parameters are rejected without merging anything.
+    FastqStats other;
+    init(other.kmers, merged.kmers.k + 1, 10, 5);
+    registerTestRead(other, seqs[0], quals[0]);
+    SEQAN_ASSERT_EQ(merged.merge(other), 1);
+    assertSameStatsCounts(merged, all);
+}
+
+SEQAN_DEFINE_TEST(test_fastq_stats_snapshot_versions)
+{
+    std::vector<std::string> seqs, quals;
+    buildTestReads(seqs, quals, 50, 100, 36);
+    FastqStats stats;
+    for (unsigned i = 0; i < seqs.size(); ++i)
+        registerTestRead(stats, seqs[i], quals[i]);
+    std::string path = SEQAN_TEMP_FILENAME();
+    SEQAN_ASSERT_EQ(saveSnapshot(stats, path.c_str()), 0);
+    std::string contents = readTestFile(path);
+
+    // Version 1 snapshots end before the k-mer length, 0 without sketch.
+    std::string v1 = contents.substr(0, contents.size() - 1);
+    v1[7] = '\1';
+    std::string v1Path = SEQAN_TEMP_FILENAME();
+    writeTestFile(v1Path, v1);
+    FastqStats loaded;
+    SEQAN_ASSERT_EQ(loadSnapshot(loaded, v1Path.c_str()), 0);
+    assertSameStatsCounts(loaded, stats);
+    SEQAN_ASSERT_EQ(loaded.kmers.k, 0u);
+
+    // Unknown versions, wrong magic and truncated files.
+    std::string bad[3] = {contents, contents, contents.substr(0, contents.size() / 2)};
+    bad[0][7] = '\3';
+    bad[1][0] = 'X';
+    for (unsigned i = 0; i < 3u; ++i)
+    {
+        std::string badPath = SEQAN_TEMP_FILENAME();
+        writeTestFile(badPath, bad[i]);
+        FastqStats badStats;
+        SEQAN_ASSERT_EQ(loadSnapshot(badStats, badPath.c_str()), 1);
+    }
+}
+
+SEQAN_DEFINE_TEST(test_fastq_stats_scan_stats)
+{
+    std::vector<std::string> seqs, quals;
+    buildTestReads(seqs, quals, 2000, 150, 37);
+    std::string file = buildTestStatsFastq(seqs, quals);
+    std::string path = SEQAN_TEMP_FILENAME();
+    writeTestFile(path, file);
+
+    FastqStats expected;
+    for (unsigned i = 0; i < seqs.size(); ++i)
+        registerTestRead(expected, seqs[i], quals[i]);
+
+    // Without sampling options the whole file is read, also if the default block size is larger than the file.
+    double fraction = 0;
+    FastqStats stats;
+    SEQAN_ASSERT_EQ(scanStats(stats, fraction, path.c_str(), file.data(), file.data() + file.size(), 0, 256 * 1024,
+                              0, 2), 0);
+    SEQAN_ASSERT_EQ(fraction, 1.0);
+    assertSameStatsCounts(stats, expected);
+    stats.finalizeStats();
+    for (unsigned i = 0; i < 150u; ++i)
+        SEQAN_ASSERT_GT(stats.numBases[i], 0);
+
+    // Blocks that cover the file and whose total size overflows are not sampled either.
+    __uint64 numBlocks[2] = {file.size() / 1024 + 1, (__uint64)1 << 60};
+    for (unsigned i = 0; i < 2u; ++i)
+    {
+        FastqStats stats2;
+        SEQAN_ASSERT_EQ(scanStats(stats2, fraction, path.c_str(), file.data(), file.data() + file.size(), numBlocks[i],
+                                  1024, 0, 1), 0);
+        SEQAN_ASSERT_EQ(fraction, 1.0);
+        assertSameStatsCounts(stats2, expected);
+    }
+
+    // Fewer blocks sample a part of the file.
+    FastqStats sampled;
+    SEQAN_ASSERT_EQ(scanStats(sampled, fraction, path.c_str(), file.data(), file.data() + file.size(), 10, 1024, 0, 1),
+                    0);
+    SEQAN_ASSERT_GT(fraction, 0.0);
+    SEQAN_ASSERT_LT(fraction, 1.0);
+    __int64 numSampledReads = 0;
+    for (unsigned i = 0; i < length(sampled.lengthCounts); ++i)
+        numSampledReads += sampled.lengthCounts[i];
+    SEQAN_ASSERT_GT(numSampledReads, 0);
+    SEQAN_ASSERT_LT(numSampledReads, 2000);
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_FASTQ_STATS_H_
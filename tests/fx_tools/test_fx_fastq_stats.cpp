@@ -0,0 +1,62 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Tests for the statistics accumulators of fx_fastq_stats.
+// ==========================================================================
+
+#include <seqan/basic.h>
+#include <seqan/file.h>
+
+#include "test_fastq_stats.h"
+#include "test_kmer_sketch.h"
+
+SEQAN_BEGIN_TESTSUITE(test_fx_fastq_stats)
+{
+    SEQAN_CALL_TEST(test_fastq_stats_qual_histograms);
+    SEQAN_CALL_TEST(test_fastq_stats_register_read);
+    SEQAN_CALL_TEST(test_fastq_stats_quartiles);
+    SEQAN_CALL_TEST(test_fastq_stats_merge);
+    SEQAN_CALL_TEST(test_fastq_stats_compute_stats);
+    SEQAN_CALL_TEST(test_fastq_stats_binning);
+    SEQAN_CALL_TEST(test_fastq_stats_long_reads);
+    SEQAN_CALL_TEST(test_fastq_stats_snapshot_round_trip);
+    SEQAN_CALL_TEST(test_fastq_stats_snapshot_merge);
+    SEQAN_CALL_TEST(test_fastq_stats_snapshot_versions);
+    SEQAN_CALL_TEST(test_fastq_stats_scan_stats);
+
+    SEQAN_CALL_TEST(test_kmer_sketch_dna_code_table);
+    SEQAN_CALL_TEST(test_kmer_sketch_count_min_merge);
+    SEQAN_CALL_TEST(test_kmer_sketch_hyper_log_log_merge);
+    SEQAN_CALL_TEST(test_kmer_sketch_merge);
+}
+SEQAN_END_TESTSUITE
@@ -0,0 +1,113 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Tests for the record scanning and selection helpers of fx_sak.
+// ==========================================================================
+
+#include <seqan/basic.h>
+#include <seqan/file.h>
+
+#include "test_adapter_trim.h"
+#include "test_barcode_matcher.h"
+#include "test_dedup_set.h"
+#include "test_index_interval_set.h"
+#include "test_infix_file.h"
+#include "test_minimizer.h"
+#include "test_name_matcher.h"
+#include "test_output_set.h"
+#include "test_quality_trim.h"
+#include "test_random_sampling.h"
+#include "test_record_index.h"
+#include "test_record_sorter.h"
+#include "test_reverse_complement.h"
+
+SEQAN_BEGIN_TESTSUITE(test_fx_sak)
+{
+    SEQAN_CALL_TEST(test_record_scanner_skip_fastq_record);
+    SEQAN_CALL_TEST(test_record_scanner_skip_fasta_record);
+    SEQAN_CALL_TEST(test_record_scanner_find_record_begin_fastq);
+    SEQAN_CALL_TEST(test_record_scanner_find_record_begin_fasta);
+    SEQAN_CALL_TEST(test_record_index_build_fastq);
+    SEQAN_CALL_TEST(test_record_index_build_fasta);
+    SEQAN_CALL_TEST(test_record_index_find_record);
+    SEQAN_CALL_TEST(test_record_index_save_load);
+
+    SEQAN_CALL_TEST(test_index_interval_set_merge);
+    SEQAN_CALL_TEST(test_index_interval_set_contains);
+    SEQAN_CALL_TEST(test_index_interval_set_empty);
+
+    SEQAN_CALL_TEST(test_reverse_complement_char);
+    SEQAN_CALL_TEST(test_reverse_complement_in_place);
+
+    SEQAN_CALL_TEST(test_random_sampling_unit_random);
+    SEQAN_CALL_TEST(test_random_sampling_bernoulli);
+    SEQAN_CALL_TEST(test_random_sampling_reservoir);
+
+    SEQAN_CALL_TEST(test_dedup_set_fingerprint);
+    SEQAN_CALL_TEST(test_dedup_set_insert);
+    SEQAN_CALL_TEST(test_dedup_set_budget);
+
+    SEQAN_CALL_TEST(test_record_sorter_in_memory);
+    SEQAN_CALL_TEST(test_record_sorter_spill_merge);
+    SEQAN_CALL_TEST(test_record_sorter_truncated_run);
+
+    SEQAN_CALL_TEST(test_infix_file_streamed_names);
+    SEQAN_CALL_TEST(test_infix_file_streamed_names_mismatch);
+    SEQAN_CALL_TEST(test_infix_file_streamed_indices);
+    SEQAN_CALL_TEST(test_infix_file_unordered);
+    SEQAN_CALL_TEST(test_infix_file_parse_errors);
+
+    SEQAN_CALL_TEST(test_quality_trim_threshold_scans);
+    SEQAN_CALL_TEST(test_quality_trim_sliding_window);
+    SEQAN_CALL_TEST(test_quality_trim_bwa);
+
+    SEQAN_CALL_TEST(test_adapter_trim_examples);
+    SEQAN_CALL_TEST(test_adapter_trim_naive);
+
+    SEQAN_CALL_TEST(test_barcode_matcher_exact);
+    SEQAN_CALL_TEST(test_barcode_matcher_hamming_one);
+    SEQAN_CALL_TEST(test_barcode_matcher_conflicts);
+
+    SEQAN_CALL_TEST(test_minimizer_naive);
+    SEQAN_CALL_TEST(test_minimizer_strand_symmetry);
+    SEQAN_CALL_TEST(test_minimizer_overlap);
+
+    SEQAN_CALL_TEST(test_name_matcher_hash_set);
+    SEQAN_CALL_TEST(test_name_matcher_prefix_trie);
+    SEQAN_CALL_TEST(test_name_matcher_matches);
+
+    SEQAN_CALL_TEST(test_output_set_open_files);
+    SEQAN_CALL_TEST(test_output_set_rotate_files);
+    SEQAN_CALL_TEST(test_output_set_close_error);
+}
+SEQAN_END_TESTSUITE
@@ -0,0 +1,118 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Tests for index_interval_set.h.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_INDEX_INTERVAL_SET_H_
+#define SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_INDEX_INTERVAL_SET_H_
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include "index_interval_set.h"
+
+SEQAN_DEFINE_TEST(test_index_interval_set_merge)
+{
+    seqan::String<__uint64> indices;
+    appendValue(indices, 20u);
+    appendValue(indices, 3u);
+    appendValue(indices, 4u);
+    appendValue(indices, 4u);
+    appendValue(indices, 100u);
+    seqan::String<seqan::Pair<__uint64> > ranges;
+    appendValue(ranges, seqan::Pair<__uint64>(10, 15));
+    appendValue(ranges, seqan::Pair<__uint64>(5, 8));    // Adjacent to index 4.
+    appendValue(ranges, seqan::Pair<__uint64>(12, 21));  // Overlaps [10, 15) and contains 20.
+    appendValue(ranges, seqan::Pair<__uint64>(50, 50));  // Empty.
+    appendValue(ranges, seqan::Pair<__uint64>(60, 40));  // Empty.
+    appendValue(ranges, seqan::Pair<__uint64>(21, 22));  // Adjacent to [12, 21).
+
+    IndexIntervalSet set;
+    build(set, indices, ranges);
+    SEQAN_ASSERT(set.active);
+    SEQAN_ASSERT_EQ(length(set.intervals), 3u);
+    SEQAN_ASSERT_EQ(set.intervals[0].i1, 3u);
+    SEQAN_ASSERT_EQ(set.intervals[0].i2, 8u);
+    SEQAN_ASSERT_EQ(set.intervals[1].i1, 10u);
+    SEQAN_ASSERT_EQ(set.intervals[1].i2, 22u);
+    SEQAN_ASSERT_EQ(set.intervals[2].i1, 100u);
+    SEQAN_ASSERT_EQ(set.intervals[2].i2, 101u);
+    SEQAN_ASSERT_EQ(beginIndex(set), 3u);
+    SEQAN_ASSERT_EQ(endIndex(set), 101u);
+}
+
+SEQAN_DEFINE_TEST(test_index_interval_set_contains)
+{
+    seqan::String<__uint64> indices;
+    appendValue(indices, 7u);
+    seqan::String<seqan::Pair<__uint64> > ranges;
+    appendValue(ranges, seqan::Pair<__uint64>(2, 5));
+    appendValue(ranges, seqan::Pair<__uint64>(9, 12));
+
+    IndexIntervalSet set;
+    build(set, indices, ranges);
+    bool const expected[14] = {false, false, true, true, true, false, false,
+                               true, false, true, true, true, false, false};
+    for (unsigned i = 0; i < 14u; ++i)
+        SEQAN_ASSERT_EQ(contains(set, i), expected[i]);
+
+    // Repeated queries of the same index and skipping over intervals.
+    build(set, indices, ranges);
+    SEQAN_ASSERT(contains(set, 3));
+    SEQAN_ASSERT(contains(set, 3));
+    SEQAN_ASSERT(contains(set, 10));
+    SEQAN_ASSERT_NOT(contains(set, 12));
+    SEQAN_ASSERT_NOT(contains(set, 1000));
+}
+
+SEQAN_DEFINE_TEST(test_index_interval_set_empty)
+{
+    seqan::String<__uint64> indices;
+    seqan::String<seqan::Pair<__uint64> > ranges;
+
+    IndexIntervalSet set;
+    build(set, indices, ranges);
+    SEQAN_ASSERT_NOT(set.active);
+    SEQAN_ASSERT_EQ(beginIndex(set), seqan::maxValue<__uint64>());
+    SEQAN_ASSERT_EQ(endIndex(set), 0u);
+
+    // Only empty ranges still make the set active, but nothing is selected.
+    appendValue(ranges, seqan::Pair<__uint64>(5, 5));
+    build(set, indices, ranges);
+    SEQAN_ASSERT(set.active);
+    SEQAN_ASSERT(empty(set.intervals));
+    SEQAN_ASSERT_NOT(contains(set, 5));
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_INDEX_INTERVAL_SET_H_
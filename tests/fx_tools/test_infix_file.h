@@ -0,0 +1,172 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Tests for infix_file.h.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_INFIX_FILE_H_
+#define SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_INFIX_FILE_H_
+
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include "infix_file.h"
+
+// Write contents to a new temporary file, its path is returned.
+
+inline std::string writeTestInfixFile(char const * contents)
+{
+    std::string path = SEQAN_TEMP_FILENAME();
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::out);
+    out << contents;
+    return path;
+}
+
+// Look up record name/idx in file and compare the result to the expected infix, found is false for beginPos ==
+// endPos == 0.
+
+inline int testInfixLookup(InfixFile & file, __uint64 idx, char const * name, __uint64 expectedBegin,
+                           __uint64 expectedEnd)
+{
+    bool found = false;
+    __uint64 beginPos = 0, endPos = 0;
+    int res = lookup(found, beginPos, endPos, file, idx, name, strlen(name));
+    if (res != 0)
+        return res;
+    SEQAN_ASSERT_EQ(found, expectedBegin != 0u || expectedEnd != 0u);
+    if (found)
+    {
+        SEQAN_ASSERT_EQ(beginPos, expectedBegin);
+        SEQAN_ASSERT_EQ(endPos, expectedEnd);
+    }
+    return 0;
+}
+
+SEQAN_DEFINE_TEST(test_infix_file_streamed_names)
+{
+    std::string path = writeTestInfixFile("# name\tbegin\tend\nr1\t1\t5\n\nr2\t0\t3\r\nr3\t2\t2\n");
+    InfixFile file;
+    SEQAN_ASSERT_EQ(open(file, path.c_str(), false, true), 0);
+    SEQAN_ASSERT_EQ(testInfixLookup(file, 0, "r1", 1, 5), 0);
+    SEQAN_ASSERT_EQ(testInfixLookup(file, 1, "r2", 0, 3), 0);
+    SEQAN_ASSERT_NOT(atEnd(file));
+    SEQAN_ASSERT_EQ(testInfixLookup(file, 7, "r3", 2, 2), 0);
+    SEQAN_ASSERT(atEnd(file));
+}
+
+SEQAN_DEFINE_TEST(test_infix_file_streamed_names_mismatch)
+{
+    // The entry for r2 stalls the stream if r2 is never written, this is reported right away.
+    std::string path = writeTestInfixFile("r1\t1\t5\nr2\t0\t3\nr3\t2\t4\n");
+    InfixFile file;
+    SEQAN_ASSERT_EQ(open(file, path.c_str(), false, true), 0);
+    SEQAN_ASSERT_EQ(testInfixLookup(file, 0, "r1", 1, 5), 0);
+    SEQAN_ASSERT_EQ(testInfixLookup(file, 2, "r3", 0, 0), 2);
+    SEQAN_ASSERT_EQ(file.pendingName, std::string("r2"));
+    SEQAN_ASSERT_EQ(file.lineNo, 2u);
+
+    // The pending entry is kept.  Records behind the last entry are reported, too.
+    SEQAN_ASSERT_EQ(testInfixLookup(file, 1, "r2", 0, 3), 0);
+    SEQAN_ASSERT_EQ(testInfixLookup(file, 2, "r3", 2, 4), 0);
+    SEQAN_ASSERT_EQ(testInfixLookup(file, 3, "r4", 0, 0), 2);
+}
+
+SEQAN_DEFINE_TEST(test_infix_file_streamed_indices)
+{
+    // Entries for records that are not written are skipped.
+    std::string path = writeTestInfixFile("0\t1\t2\n3\t3\t4\n5\t5\t6\n9\t9\t10\n");
+    InfixFile file;
+    SEQAN_ASSERT_EQ(open(file, path.c_str(), true, true), 0);
+    SEQAN_ASSERT_EQ(testInfixLookup(file, 1, "x", 0, 0), 0);
+    SEQAN_ASSERT_EQ(testInfixLookup(file, 3, "x", 3, 4), 0);
+    SEQAN_ASSERT_EQ(testInfixLookup(file, 4, "x", 0, 0), 0);
+    SEQAN_ASSERT_EQ(testInfixLookup(file, 9, "x", 9, 10), 0);
+    SEQAN_ASSERT(atEnd(file));
+    SEQAN_ASSERT_EQ(testInfixLookup(file, 10, "x", 0, 0), 0);
+
+    // Indices must increase.
+    path = writeTestInfixFile("0\t1\t2\n3\t3\t4\n2\t5\t6\n");
+    InfixFile file2;
+    SEQAN_ASSERT_EQ(open(file2, path.c_str(), true, true), 0);
+    SEQAN_ASSERT_EQ(testInfixLookup(file2, 0, "x", 1, 2), 0);
+    SEQAN_ASSERT_EQ(testInfixLookup(file2, 3, "x", 3, 4), 1);
+}
+
+SEQAN_DEFINE_TEST(test_infix_file_unordered)
+{
+    std::string contents;
+    for (unsigned i = 0; i < 5000u; ++i)
+    {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "read%u\t%u\t%u\n", 4999 - i, i, 2 * i);
+        contents += buffer;
+    }
+    contents += "read7\t1\t2\n";  // Later entries replace earlier ones.
+    std::string path = writeTestInfixFile(contents.c_str());
+    InfixFile file;
+    SEQAN_ASSERT_EQ(open(file, path.c_str(), false, false), 0);
+    SEQAN_ASSERT_EQ(file.size, 5000u);
+    for (unsigned i = 0; i < 5000u; i += 3)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "read%u", i);
+        if (i == 7u)
+            SEQAN_ASSERT_EQ(testInfixLookup(file, 0, name, 1, 2), 0);
+        else
+            SEQAN_ASSERT_EQ(testInfixLookup(file, 0, name, 4999 - i, 2 * (4999 - i)), 0);
+    }
+    SEQAN_ASSERT_EQ(testInfixLookup(file, 0, "read5000", 0, 0), 0);
+    SEQAN_ASSERT(atEnd(file));
+}
+
+SEQAN_DEFINE_TEST(test_infix_file_parse_errors)
+{
+    char const * BAD[4] = {"r1\t1\t2\nr2\t1\n", "r1\t1\t2\nr2\t3\t2\n", "r1\t1\t2\n\tr2\t1\t2\n", "r1\t1\t2\nr2\tx\t2\n"};
+    for (unsigned i = 0; i < 4u; ++i)
+    {
+        std::string path = writeTestInfixFile(BAD[i]);
+        InfixFile file;
+        SEQAN_ASSERT_EQ(open(file, path.c_str(), false, false), 1);
+        SEQAN_ASSERT_EQ(file.lineNo, 2u);
+    }
+
+    std::string path = writeTestInfixFile("r1\t1\t2\n");
+    InfixFile file;
+    SEQAN_ASSERT_EQ(open(file, path.c_str(), true, false), 1);
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_INFIX_FILE_H_
@@ -0,0 +1,210 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Tests for kmer_sketch.h.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_KMER_SKETCH_H_
+#define SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_KMER_SKETCH_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include "kmer_sketch.h"
+
+SEQAN_DEFINE_TEST(test_kmer_sketch_dna_code_table)
+{
+    DnaCodeTable codes;
+    SEQAN_ASSERT_EQ(codes.table[(unsigned char)'A'], 0u);
+    SEQAN_ASSERT_EQ(codes.table[(unsigned char)'c'], 1u);
+    SEQAN_ASSERT_EQ(codes.table[(unsigned char)'G'], 2u);
+    SEQAN_ASSERT_EQ(codes.table[(unsigned char)'t'], 3u);
+    SEQAN_ASSERT_EQ(codes.table[(unsigned char)'N'], 4u);
+    SEQAN_ASSERT_EQ(codes.table[(unsigned char)'U'], 4u);
+    SEQAN_ASSERT_EQ(codes.table[0xff], 4u);
+}
+
+SEQAN_DEFINE_TEST(test_kmer_sketch_count_min_merge)
+{
+    // Two sketches with overlapping key sets of different frequencies.
+    CountMinSketch sketches[2], all;
+    init(sketches[0], 8);
+    init(sketches[1], 8);
+    init(all, 8);
+    std::map<__uint64, __uint64> counts;
+    for (unsigned i = 0; i < 20000u; ++i)
+    {
+        __uint64 key = (i % 7 == 0u) ? i % 5 : 100 + i % 1000;
+        unsigned s = (i / 3) % 2;
+        SEQAN_ASSERT_GEQ(increment(sketches[s], mixHash64(key)), 1u);
+        increment(all, mixHash64(key));
+        counts[key] += 1;
+    }
+
+    CountMinSketch merged(sketches[0]);
+    SEQAN_ASSERT_EQ(merge(merged, sketches[1]), 0);
+    for (std::map<__uint64, __uint64>::const_iterator it = counts.begin(); it != counts.end(); ++it)
+    {
+        __uint64 h = mixHash64(it->first);
+        // Count-min sketches never underestimate, also after merging.
+        SEQAN_ASSERT_GEQ(estimate(all, h), it->second);
+        SEQAN_ASSERT_GEQ(estimate(merged, h), it->second);
+        SEQAN_ASSERT_GEQ(estimate(merged, h), estimate(sketches[0], h));
+        SEQAN_ASSERT_GEQ(estimate(merged, h), estimate(sketches[1], h));
+    }
+    // The heavy hitters stand out.
+    for (__uint64 key = 0; key < 5u; ++key)
+        SEQAN_ASSERT_LT(estimate(merged, mixHash64(key)), counts[key] + counts[key] / 2);
+
+    // Merging saturates.
+    CountMinSketch big;
+    init(big, 0);
+    for (unsigned i = 0; i < CountMinSketch::LINE_SIZE; ++i)
+        big.store[big.offset + i] = seqan::maxValue<__uint32>() - 1;
+    CountMinSketch bigCopy(big);
+    SEQAN_ASSERT_EQ(merge(big, bigCopy), 0);
+    SEQAN_ASSERT_EQ(estimate(big, 0), (__uint64)seqan::maxValue<__uint32>());
+    SEQAN_ASSERT_EQ(increment(big, 0), (__uint64)seqan::maxValue<__uint32>());
+
+    // Sketches with different numbers of lines cannot be merged.
+    SEQAN_ASSERT_EQ(merge(merged, big), 1);
+    SEQAN_ASSERT_EQ(merge(big, merged), 1);
+    SEQAN_ASSERT_EQ(estimate(big, 0), (__uint64)seqan::maxValue<__uint32>());
+}
+
+SEQAN_DEFINE_TEST(test_kmer_sketch_hyper_log_log_merge)
+{
+    HyperLogLog hlls[2], all;
+    init(hlls[0], 14);
+    init(hlls[1], 14);
+    init(all, 14);
+    SEQAN_ASSERT_EQ(cardinality(all), 0.0);
+
+    // 30000 items in the first, 30000 in the second, 10000 of them in both.
+    for (__uint64 x = 0; x < 50000u; ++x)
+    {
+        __uint64 h = mixHash64(x);
+        if (x < 30000u)
+            insert(hlls[0], h);
+        if (x >= 20000u)
+            insert(hlls[1], h);
+        insert(all, h);
+    }
+    SEQAN_ASSERT_IN_DELTA(cardinality(hlls[0]), 30000.0, 1500.0);
+
+    HyperLogLog merged(hlls[0]);
+    SEQAN_ASSERT_EQ(merge(merged, hlls[1]), 0);
+    SEQAN_ASSERT_EQ(merge(merged, hlls[1]), 0);  // Merging is idempotent.
+    SEQAN_ASSERT(merged.registers == all.registers);
+    SEQAN_ASSERT_IN_DELTA(cardinality(merged), 50000.0, 2500.0);
+    HyperLogLog other;
+    init(other, 10);
+    SEQAN_ASSERT_EQ(merge(merged, other), 1);
+
+    // Small cardinalities use linear counting.
+    HyperLogLog small;
+    init(small, 14);
+    for (__uint64 x = 0; x < 100u; ++x)
+        insert(small, mixHash64(x));
+    SEQAN_ASSERT_IN_DELTA(cardinality(small), 100.0, 5.0);
+}
+
+SEQAN_DEFINE_TEST(test_kmer_sketch_merge)
+{
+    // An adapter k-mer in the reads of both sketches, random reads otherwise.
+    std::string const adapter = "AGATCGGAAGAGCACACGTCTGAACTCCAGTCAC";
+    KmerSketch sketches[2], empty;
+    init(sketches[0], 12, 10, 5);
+    initLike(sketches[1], sketches[0]);
+    SEQAN_ASSERT_EQ(sketches[1].k, 12u);
+    SEQAN_ASSERT_EQ(sketches[1].counts.numLines, 1024u);
+    SEQAN_ASSERT_EQ(sketches[1].top.capacity, 5u);
+
+    __uint64 state = 41;
+    __uint64 numKmers = 0;
+    for (unsigned i = 0; i < 400u; ++i)
+    {
+        std::string read;
+        for (unsigned j = 0; j < 60u; ++j)
+        {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            read += "ACGT"[state >> 62];
+        }
+        if (i % 4 == 0u)
+            read.replace(10, adapter.size(), adapter);
+        addRead(sketches[i % 2], read.data(), read.size());
+        numKmers += 60 - 12 + 1;
+    }
+
+    KmerSketch merged(sketches[0]);
+    SEQAN_ASSERT_EQ(merge(merged, sketches[1]), 0);
+    SEQAN_ASSERT_EQ(merge(merged, empty), 0);  // Disabled sketches are ignored.
+    SEQAN_ASSERT_EQ(merged.numReads, 400u);
+    SEQAN_ASSERT_EQ(merged.numKmers, numKmers);
+
+    // The adapter k-mers are the heavy hitters, with the counts of both sketches.
+    std::vector<std::pair<__uint64, __uint64> > top;
+    topKmers(top, merged);
+    SEQAN_ASSERT_EQ(top.size(), 5u);
+    for (unsigned i = 0; i < top.size(); ++i)
+    {
+        seqan::CharString kmer;
+        kmerToString(kmer, top[i].first, 12);
+        SEQAN_ASSERT_NEQ(adapter.find(toCString(kmer)), std::string::npos);
+        SEQAN_ASSERT_GEQ(top[i].second, 100u);
+        SEQAN_ASSERT(i == 0u || top[i - 1].second >= top[i].second);
+    }
+
+    // Sketches with a different k or size are rejected and left unchanged.
+    KmerSketch otherK, otherSize;
+    init(otherK, 11, 10, 5);
+    init(otherSize, 12, 8, 5);
+    addRead(otherK, adapter.data(), adapter.size());
+    addRead(otherSize, adapter.data(), adapter.size());
+    SEQAN_ASSERT_EQ(merge(merged, otherK), 1);
+    SEQAN_ASSERT_EQ(merge(merged, otherSize), 1);
+    SEQAN_ASSERT_EQ(merge(otherSize, merged), 1);
+    SEQAN_ASSERT_EQ(merged.numReads, 400u);
+    SEQAN_ASSERT_EQ(merged.numKmers, numKmers);
+
+    // Merging into a disabled sketch copies.
+    SEQAN_ASSERT_EQ(merge(empty, merged), 0);
+    SEQAN_ASSERT_EQ(empty.k, 12u);
+    SEQAN_ASSERT_EQ(empty.numKmers, numKmers);
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_KMER_SKETCH_H_
@@ -0,0 +1,154 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Tests for minimizer.h.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_MINIMIZER_H_
+#define SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_MINIMIZER_H_
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <string>
+
+#include <seqan/basic.h>
+
+#include "minimizer.h"
+
+inline std::string minimizerTestReverseComplement(std::string const & seq)
+{
+    std::string result(seq.rbegin(), seq.rend());
+    for (unsigned i = 0; i < result.size(); ++i)
+    {
+        char const * fwd = "ACGTacgt";
+        char const * rev = "TGCAtgca";
+        char const * pos = std::find(fwd, fwd + 8, result[i]);
+        if (pos != fwd + 8)
+            result[i] = rev[pos - fwd];
+    }
+    return result;
+}
+
+// Random sequences with lower case characters and a few Ns.
+
+inline std::string minimizerTestSequence(__uint64 & state, size_t len)
+{
+    std::string seq;
+    for (size_t i = 0; i < len; ++i)
+    {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        seq += "ACGTACGTACGTACGTACGTACGTacgtacgtacgtNACGTACGTACGTACG"[(state >> 33) % 52];
+    }
+    return seq;
+}
+
+// Brute force version of readMinimizer().
+
+inline __uint64 readMinimizerNaive(std::string const & seq, unsigned k)
+{
+    static char const DNA[] = "ACGT";
+    __uint64 best = ~(__uint64)0;
+    for (size_t i = 0; i + k <= seq.size(); ++i)
+    {
+        __uint64 fwd = 0, rev = 0;
+        bool valid = true;
+        for (size_t j = 0; j < k; ++j)
+        {
+            char const * pos = strchr(DNA, toupper(seq[i + j]));
+            if (!pos || !*pos)
+            {
+                valid = false;
+                break;
+            }
+            fwd = (fwd << 2) | (pos - DNA);
+            rev |= (__uint64)(3 - (pos - DNA)) << (2 * j);
+        }
+        if (valid)
+            best = std::min(best, mixHash64(std::min(fwd, rev)));
+    }
+    return best;
+}
+
+SEQAN_DEFINE_TEST(test_minimizer_naive)
+{
+    __uint64 state = 17;
+    for (unsigned k = 1; k <= 31u; k += 3)
+    {
+        for (size_t len = 0; len <= 200u; len += 7)
+        {
+            std::string seq = minimizerTestSequence(state, len);
+            SEQAN_ASSERT_EQ(readMinimizer(seq.data(), seq.size(), k), readMinimizerNaive(seq, k));
+        }
+    }
+
+    // No k-mer without ambiguous bases.
+    std::string seq = "ACGTNACGTNACGT";
+    SEQAN_ASSERT_EQ(readMinimizer(seq.data(), seq.size(), 5), ~(__uint64)0);
+    SEQAN_ASSERT_EQ(readMinimizer(seq.data(), 3, 5), ~(__uint64)0);
+    SEQAN_ASSERT_NEQ(readMinimizer(seq.data(), seq.size(), 4), ~(__uint64)0);
+}
+
+SEQAN_DEFINE_TEST(test_minimizer_strand_symmetry)
+{
+    __uint64 state = 18;
+    for (unsigned k = 1; k <= 31u; ++k)
+    {
+        for (size_t len = k; len <= 300u; len += 23)
+        {
+            std::string seq = minimizerTestSequence(state, len);
+            std::string rev = minimizerTestReverseComplement(seq);
+            SEQAN_ASSERT_EQ(readMinimizer(seq.data(), seq.size(), k), readMinimizer(rev.data(), rev.size(), k));
+        }
+    }
+}
+
+SEQAN_DEFINE_TEST(test_minimizer_overlap)
+{
+    // A read contains the minimizer of its substrings if that is the minimizer of the read.
+    __uint64 state = 19;
+    for (unsigned round = 0; round < 50u; ++round)
+    {
+        std::string seq = minimizerTestSequence(state, 150);
+        __uint64 best = readMinimizer(seq.data(), seq.size(), 21);
+        for (size_t i = 0; i + 21 <= seq.size(); i += 10)
+        {
+            __uint64 part = readMinimizer(seq.data() + i, seq.size() - i, 21);
+            SEQAN_ASSERT_GEQ(part, best);
+            __uint64 prefix = readMinimizer(seq.data(), i + 21, 21);
+            SEQAN_ASSERT(part == best || prefix == best);
+        }
+    }
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_MINIMIZER_H_
@@ -0,0 +1,167 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Tests for name_map.h.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_NAME_MAP_H_
+#define SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_NAME_MAP_H_
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include "name_map.h"
+
+// Illumina style headers with a few irregular ones in between.
+
+inline void buildTestNames(std::vector<std::string> & names, unsigned numNames)
+{
+    names.clear();
+    __uint64 state = 21;
+    for (unsigned i = 0; i < numNames; ++i)
+    {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        std::stringstream ss;
+        if (i % 89 == 7u)
+            ss << "odd read " << (state >> 40) << "\tcomment";
+        else if (i % 97 != 13u)  // Some headers are empty.
+            ss << "M00123:45:000000000-ABCDE:1:" << 1101 + i / 500 << ":" << (state >> 50) << ":"
+               << ((state >> 20) & 0xffff) << " " << 1 + i % 2 << ":N:0:ACGT";
+        names.push_back(ss.str());
+    }
+}
+
+// Write names to a name map at path.
+
+inline void writeTestNameMap(char const * path, std::vector<std::string> const & names, __uint64 blockSize,
+                             NameMapCodec codec)
+{
+    NameMapWriter writer;
+    writer.blockSize = blockSize;
+    SEQAN_ASSERT_EQ(open(writer, path, "{prefix}{index}", "pre", 5, codec), 0);
+    for (unsigned i = 0; i < names.size(); ++i)
+        SEQAN_ASSERT_EQ(appendName(writer, names[i].data(), names[i].data() + names[i].size()), 0);
+    SEQAN_ASSERT_EQ(close(writer), 0);
+}
+
+inline void testNameMapRoundTrip(NameMapCodec codec)
+{
+    std::vector<std::string> names;
+    buildTestNames(names, 2000);
+
+    __uint64 blockSizes[] = {1, 7, 1000, 1024, 5000};
+    unsigned numNames[] = {0, 1, 999, 1000, 2000};
+    for (unsigned b = 0; b < 5u; ++b)
+    {
+        for (unsigned n = 0; n < 5u; ++n)
+        {
+            std::vector<std::string> prefix(names.begin(), names.begin() + numNames[n]);
+            std::string path = SEQAN_TEMP_FILENAME();
+            writeTestNameMap(path.c_str(), prefix, blockSizes[b], codec);
+
+            NameMapReader reader;
+            SEQAN_ASSERT_EQ(open(reader, path.c_str()), 0);
+            SEQAN_ASSERT_EQ(reader.numRecords, (__uint64)prefix.size());
+            SEQAN_ASSERT_EQ(reader.startIndex, 5u);
+            SEQAN_ASSERT_EQ(reader.blockSize, blockSizes[b]);
+            SEQAN_ASSERT_EQ(reader.pattern, "{prefix}{index}");
+            SEQAN_ASSERT_EQ(reader.prefix, "pre");
+            SEQAN_ASSERT_EQ(reader.codec, codec);
+
+            // Sequential and random access.
+            char const * nameBegin = 0;
+            char const * nameEnd = 0;
+            for (unsigned i = 0; i < prefix.size(); ++i)
+            {
+                SEQAN_ASSERT(lookup(nameBegin, nameEnd, reader, i));
+                SEQAN_ASSERT_EQ(std::string(nameBegin, nameEnd), prefix[i]);
+            }
+            for (unsigned i = 0, j = 0; i < prefix.size(); ++i, j = (j + 7919) % prefix.size())
+            {
+                SEQAN_ASSERT(lookup(nameBegin, nameEnd, reader, j));
+                SEQAN_ASSERT_EQ(std::string(nameBegin, nameEnd), prefix[j]);
+            }
+            SEQAN_ASSERT_NOT(lookup(nameBegin, nameEnd, reader, prefix.size()));
+        }
+    }
+}
+
+SEQAN_DEFINE_TEST(test_name_map_front_coding)
+{
+    testNameMapRoundTrip(NAME_MAP_FRONT_CODING);
+}
+
+SEQAN_DEFINE_TEST(test_name_map_tokens)
+{
+    testNameMapRoundTrip(NAME_MAP_TOKENS);
+}
+
+SEQAN_DEFINE_TEST(test_name_map_corrupt)
+{
+    std::vector<std::string> names;
+    buildTestNames(names, 100);
+    std::string path = SEQAN_TEMP_FILENAME();
+    writeTestNameMap(path.c_str(), names, 16, NAME_MAP_FRONT_CODING);
+
+    std::string contents;
+    {
+        std::ifstream in(path.c_str(), std::ios::binary | std::ios::in);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        contents = ss.str();
+    }
+
+    // Truncated files, a wrong magic and an unknown version are rejected when opening.
+    std::string paths[4];
+    std::string variants[4] = {contents.substr(0, 20), contents.substr(0, contents.size() - 8), contents, contents};
+    variants[2][0] = 'X';
+    variants[3][7] = '\3';
+    for (unsigned i = 0; i < 4u; ++i)
+    {
+        paths[i] = SEQAN_TEMP_FILENAME();
+        std::ofstream out(paths[i].c_str(), std::ios::binary | std::ios::out);
+        out.write(variants[i].data(), variants[i].size());
+    }
+    for (unsigned i = 0; i < 4u; ++i)
+    {
+        NameMapReader reader;
+        SEQAN_ASSERT_EQ(open(reader, paths[i].c_str()), 1);
+    }
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_NAME_MAP_H_
@@ -0,0 +1,156 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Tests for name_matcher.h.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_NAME_MATCHER_H_
+#define SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_NAME_MATCHER_H_
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include "name_matcher.h"
+
+SEQAN_DEFINE_TEST(test_name_matcher_hash_set)
+{
+    NameHashSet set;
+    SEQAN_ASSERT_NOT(contains(set, "read0", 5));
+
+    // Enough names to trigger several rehashes.
+    char name[32];
+    for (unsigned i = 0; i < 10000; i += 2)
+    {
+        snprintf(name, sizeof(name), "read%u", i);
+        insert(set, name, strlen(name));
+    }
+    insert(set, "read0", 5);  // Duplicates are not counted twice.
+    SEQAN_ASSERT_EQ(set.size, 5000u);
+    SEQAN_ASSERT_GEQ(length(set.table), 2 * set.size);
+
+    for (unsigned i = 0; i < 10000; ++i)
+    {
+        snprintf(name, sizeof(name), "read%u", i);
+        SEQAN_ASSERT_EQ(contains(set, name, strlen(name)), (i % 2 == 0u));
+    }
+}
+
+// Returns true if one of prefixes is a prefix of name.
+
+inline bool naiveHasPrefix(std::vector<std::string> const & prefixes, std::string const & name)
+{
+    for (unsigned i = 0; i < prefixes.size(); ++i)
+        if (name.compare(0, prefixes[i].size(), prefixes[i]) == 0)
+            return true;
+    return false;
+}
+
+SEQAN_DEFINE_TEST(test_name_matcher_prefix_trie)
+{
+    // Includes bytes >= 0x80, these sort behind the ASCII characters.
+    std::vector<std::string> prefixes;
+    prefixes.push_back("SRR1.");
+    prefixes.push_back("SRR12");
+    prefixes.push_back("SRR123");  // Redundant because of "SRR12".
+    prefixes.push_back("ERR");
+    prefixes.push_back("r\xc3\xa9" "ad");
+    prefixes.push_back("r\xff");
+    prefixes.push_back("rA");
+
+    PrefixTrie trie;
+    SEQAN_ASSERT_NOT(contains(trie, "SRR1.1", 6));
+    for (unsigned i = 0; i < prefixes.size(); ++i)
+        insert(trie, prefixes[i].data(), prefixes[i].size());
+    build(trie);
+
+    std::vector<std::string> names;
+    names.push_back("SRR1.1");
+    names.push_back("SRR1");
+    names.push_back("SRR123.7");
+    names.push_back("SRR13");
+    names.push_back("ERR");
+    names.push_back("ER");
+    names.push_back("r\xc3\xa9" "ad1");
+    names.push_back("r\xc3\xa9" "a");
+    names.push_back("r\xc3\xa8" "ad1");
+    names.push_back("r\xff\x01");
+    names.push_back("r\xfe");
+    names.push_back("rA1");
+    names.push_back("rB");
+    names.push_back("");
+    for (unsigned i = 0; i < names.size(); ++i)
+        SEQAN_ASSERT_EQ(contains(trie, names[i].data(), names[i].size()), naiveHasPrefix(prefixes, names[i]));
+
+    // Compare against the naive check on all short strings over a few characters.
+    char const ALPHABET[] = {'A', 'C', 'z', '\x7f', '\x80', '\xff'};
+    std::vector<std::string> all(1, std::string());
+    for (unsigned i = 0; i < all.size() && all[i].size() < 4u; ++i)
+        for (unsigned j = 0; j < sizeof(ALPHABET); ++j)
+            all.push_back(all[i] + ALPHABET[j]);
+    prefixes.clear();
+    PrefixTrie trie2;
+    for (unsigned i = 0; i < all.size(); i += 37)
+    {
+        prefixes.push_back(all[i] + "\x80");
+        insert(trie2, prefixes.back().data(), prefixes.back().size());
+    }
+    build(trie2);
+    for (unsigned i = 0; i < all.size(); ++i)
+        SEQAN_ASSERT_EQ(contains(trie2, all[i].data(), all[i].size()), naiveHasPrefix(prefixes, all[i]));
+}
+
+SEQAN_DEFINE_TEST(test_name_matcher_matches)
+{
+    NameMatcher matcher;
+    SEQAN_ASSERT(empty(matcher));
+    insert(matcher.names, "read1", 5);
+    insert(matcher.prefixes, "SRR", 3);
+    build(matcher.prefixes);
+    SEQAN_ASSERT_NOT(empty(matcher));
+
+    // Names are compared to the first word, prefixes to the whole identifier.
+    SEQAN_ASSERT_EQ(firstWordLength("read1 length=10", 15), 5u);
+    SEQAN_ASSERT(matches(matcher, "read1 length=10", 15));
+    SEQAN_ASSERT(matches(matcher, "read1\tx", 7));
+    SEQAN_ASSERT_NOT(matches(matcher, "read10", 6));
+    SEQAN_ASSERT_NOT(matches(matcher, "x read1", 7));
+    SEQAN_ASSERT(matches(matcher, "SRR001.1 x", 10));
+    SEQAN_ASSERT_NOT(matches(matcher, "ERR001.1", 8));
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_NAME_MATCHER_H_
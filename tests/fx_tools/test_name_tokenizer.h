@@ -0,0 +1,171 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Tests for name_tokenizer.h.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_NAME_TOKENIZER_H_
+#define SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_NAME_TOKENIZER_H_
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <seqan/basic.h>
+
+#include "name_tokenizer.h"
+
+// Names that exercise the corner cases of the tokenizer.
+
+inline void buildTestTokenizerNames(std::vector<std::string> & names)
+{
+    names.clear();
+    for (unsigned i = 0; i < 50u; ++i)
+    {
+        std::stringstream ss;
+        ss << "A00123:45:HXXXXXXXX:1:" << 1101 + i / 20 << ":" << 12345 + 37 * i << ":" << 23456 - 101 * i
+           << " " << 1 + i % 2 << ":N:0:ACGTACGT";
+        names.push_back(ss.str());
+    }
+    names.push_back("");
+    names.push_back("");
+    names.push_back("::::");
+    names.push_back("read_007/1");
+    names.push_back("read_008/1");
+    names.push_back("read_0/1");
+    names.push_back("read_999999999999999999/1");
+    names.push_back("read_1000000000000000000/1");
+    names.push_back("read_18446744073709551615/1");
+    names.push_back("read_5/1");
+    names.push_back("read_x/1");
+    names.push_back("read_5/1");
+    names.push_back("SRR001666.1 071112_SLXA-EAS1_s_7:5:1:817:345 length=36");
+    names.push_back("SRR001666.2 071112_SLXA-EAS1_s_7:5:1:801:338 length=36");
+    // More separators than tokens fit into the change mask.
+    std::string longName;
+    for (unsigned i = 0; i < 100u; ++i)
+    {
+        std::stringstream ss;
+        ss << i << ((i % 3) ? ':' : '.');
+        longName += ss.str();
+    }
+    names.push_back(longName);
+    longName[longName.size() - 2] = '7';
+    names.push_back(longName);
+    names.push_back(longName.substr(0, 150));
+}
+
+SEQAN_DEFINE_TEST(test_name_tokenizer_round_trip)
+{
+    std::vector<std::string> names;
+    buildTestTokenizerNames(names);
+
+    std::string encoded;
+    NameTokenizer encoder;
+    for (unsigned i = 0; i < names.size(); ++i)
+        encodeName(encoded, encoder, names[i].data(), names[i].data() + names[i].size());
+
+    NameTokenizer decoder;
+    char const * it = encoded.data();
+    char const * itEnd = encoded.data() + encoded.size();
+    for (unsigned i = 0; i < names.size(); ++i)
+    {
+        std::string name = "x";
+        SEQAN_ASSERT(decodeName(name, decoder, it, itEnd));
+        SEQAN_ASSERT_EQ(name, "x" + names[i]);
+    }
+    SEQAN_ASSERT(it == itEnd);
+}
+
+SEQAN_DEFINE_TEST(test_name_tokenizer_compression)
+{
+    // Consecutive Illumina names only differ in their coordinates.
+    std::vector<std::string> names;
+    buildTestTokenizerNames(names);
+    std::string encoded;
+    NameTokenizer encoder;
+    encodeName(encoded, encoder, names[0].data(), names[0].data() + names[0].size());
+    for (unsigned i = 1; i < 20u; ++i)
+    {
+        size_t oldSize = encoded.size();
+        encodeName(encoded, encoder, names[i].data(), names[i].data() + names[i].size());
+        SEQAN_ASSERT_LEQ(encoded.size() - oldSize, 8u);
+    }
+
+    // After clear(), names are encoded in full.
+    NameTokenizer decoder;
+    clear(encoder);
+    encoded.clear();
+    encodeName(encoded, encoder, names[20].data(), names[20].data() + names[20].size());
+    char const * it = encoded.data();
+    std::string name;
+    SEQAN_ASSERT(decodeName(name, decoder, it, encoded.data() + encoded.size()));
+    SEQAN_ASSERT_EQ(name, names[20]);
+}
+
+SEQAN_DEFINE_TEST(test_name_tokenizer_truncated)
+{
+    std::vector<std::string> names;
+    buildTestTokenizerNames(names);
+    std::string encoded;
+    NameTokenizer encoder;
+    for (unsigned i = 0; i < names.size(); ++i)
+        encodeName(encoded, encoder, names[i].data(), names[i].data() + names[i].size());
+
+    // Decoding a truncated encoding yields a prefix of the names, the first incomplete one fails.
+    for (size_t len = 0; len < encoded.size(); ++len)
+    {
+        NameTokenizer decoder;
+        char const * it = encoded.data();
+        char const * itEnd = encoded.data() + len;
+        unsigned i = 0;
+        for (std::string name; it != itEnd; ++i)
+        {
+            name.clear();
+            if (!decodeName(name, decoder, it, itEnd))
+                break;
+            SEQAN_ASSERT_LT(i, names.size());
+            SEQAN_ASSERT_EQ(name, names[i]);
+        }
+        SEQAN_ASSERT_LT(i, names.size());
+    }
+
+    // The first name must start a new shape.
+    NameTokenizer decoder;
+    std::string bad(1, '\2');
+    char const * it = bad.data();
+    std::string name;
+    SEQAN_ASSERT_NOT(decodeName(name, decoder, it, bad.data() + bad.size()));
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_NAME_TOKENIZER_H_
@@ -0,0 +1,152 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Tests for output_set.h.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_OUTPUT_SET_H_
+#define SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_OUTPUT_SET_H_
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if SEQAN_HAS_ZLIB
+#include <zlib.h>
+#endif  // #if SEQAN_HAS_ZLIB
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include "output_set.h"
+
+// Read the file at path into contents, decompressing it if gzip is true.
+
+inline void readTestOutput(std::string & contents, char const * path, bool gzip)
+{
+    contents.clear();
+#if SEQAN_HAS_ZLIB
+    if (gzip)
+    {
+        gzFile file = gzopen(path, "rb");
+        SEQAN_ASSERT(file != 0);
+        char buffer[4096];
+        int n = 0;
+        while ((n = gzread(file, buffer, sizeof(buffer))) > 0)
+            contents.append(buffer, n);
+        SEQAN_ASSERT_EQ(n, 0);
+        gzclose(file);
+        return;
+    }
+#endif  // #if SEQAN_HAS_ZLIB
+    (void)gzip;
+    std::ifstream in(path, std::ios::binary | std::ios::in);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    contents = ss.str();
+}
+
+// Write records to numOutputs outputs of which at most maxOpenFiles are kept open and check the contents of every
+// file.  The small block and batch sizes make the outputs rotate many times.
+
+inline void testOutputSet(unsigned numOutputs, unsigned maxOpenFiles, bool gzip)
+{
+    seqan::String<seqan::CharString> paths;
+    for (unsigned i = 0; i < numOutputs; ++i)
+        appendValue(paths, seqan::CharString(SEQAN_TEMP_FILENAME()));
+
+    OutputSet set;
+    set.blockSize = 100;
+    set.batchSize = 1000;
+    set.maxOpenFiles = maxOpenFiles;
+    SEQAN_ASSERT_EQ(open(set, paths, gzip, 2), 0);
+    SEQAN_ASSERT_EQ(set.files[0] != 0, numOutputs <= maxOpenFiles);
+
+    std::vector<std::string> expected(numOutputs);
+    __uint64 state = 5;
+    for (unsigned r = 0; r < 5000; ++r)
+    {
+        // Skewed choice of outputs, output 0 gets most records and the last output none.
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        unsigned x = (state >> 33) % (numOutputs - 1);
+        unsigned i = x * x / (numOutputs - 1);
+        std::stringstream ss;
+        ss << "@read" << r << "\nACGT\n+\nIIII\n";
+        outputStream(set, i) << ss.str();
+        expected[i] += ss.str();
+        SEQAN_ASSERT_EQ(recordWritten(set, i), 0);
+    }
+    SEQAN_ASSERT_EQ(close(set), 0);
+
+    std::string contents;
+    for (unsigned i = 0; i < numOutputs; ++i)
+    {
+        readTestOutput(contents, toCString(paths[i]), gzip);
+        SEQAN_ASSERT(contents == expected[i]);
+    }
+    SEQAN_ASSERT(expected[numOutputs - 1].empty());
+}
+
+SEQAN_DEFINE_TEST(test_output_set_open_files)
+{
+    testOutputSet(5, 256, false);
+#if SEQAN_HAS_ZLIB
+    testOutputSet(5, 256, true);
+#endif  // #if SEQAN_HAS_ZLIB
+}
+
+SEQAN_DEFINE_TEST(test_output_set_rotate_files)
+{
+    testOutputSet(12, 3, false);
+    testOutputSet(12, 1, false);
+#if SEQAN_HAS_ZLIB
+    testOutputSet(12, 3, true);
+#endif  // #if SEQAN_HAS_ZLIB
+}
+
+SEQAN_DEFINE_TEST(test_output_set_close_error)
+{
+    // Writing to a full device only fails when the data is flushed on closing, close() must report it.
+    if (!std::ifstream("/dev/full").good())
+        return;
+    seqan::String<seqan::CharString> paths;
+    appendValue(paths, seqan::CharString("/dev/full"));
+    OutputSet set;
+    SEQAN_ASSERT_EQ(open(set, paths, false, 1), 0);
+    outputStream(set, 0) << "@read\nACGT\n+\nIIII\n";
+    SEQAN_ASSERT_EQ(recordWritten(set, 0), 0);
+    SEQAN_ASSERT_EQ(close(set), 1);
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_OUTPUT_SET_H_
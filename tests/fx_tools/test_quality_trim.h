@@ -0,0 +1,141 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Tests for quality_trim.h.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_QUALITY_TRIM_H_
+#define SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_QUALITY_TRIM_H_
+
+#include <string>
+
+#include <seqan/basic.h>
+
+#include "quality_trim.h"
+
+// Random Phred+33 quality strings of all lengths up to 80, mostly high with runs of low qualities.
+
+inline void buildTestQualities(std::string & quals, __uint64 & state, size_t len)
+{
+    quals.clear();
+    bool low = false;
+    for (size_t i = 0; i < len; ++i)
+    {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        if ((state >> 60) == 0u)
+            low = !low;
+        quals += (char)(33 + (low ? (state >> 33) % 15 : 20 + (state >> 33) % 21));
+    }
+}
+
+SEQAN_DEFINE_TEST(test_quality_trim_threshold_scans)
+{
+    __uint64 state = 11;
+    std::string quals;
+    for (unsigned len = 0; len <= 80u; ++len)
+    {
+        for (unsigned k = 0; k < 20u; ++k)
+        {
+            buildTestQualities(quals, state, len);
+            int minQual = 5 + k;
+
+            size_t expectedFirstAtLeast = len, expectedFirstBelow = len, expectedBehindLast = 0;
+            for (size_t i = len; i > 0u; --i)
+            {
+                if (quals[i - 1] - 33 >= minQual)
+                    expectedFirstAtLeast = i - 1;
+                else
+                    expectedFirstBelow = i - 1;
+            }
+            for (size_t i = 0; i < len; ++i)
+                if (quals[i] - 33 >= minQual)
+                    expectedBehindLast = i + 1;
+
+            SEQAN_ASSERT_EQ(firstAtLeast(quals.data(), len, minQual), expectedFirstAtLeast);
+            SEQAN_ASSERT_EQ(firstBelow(quals.data(), len, minQual), expectedFirstBelow);
+            SEQAN_ASSERT_EQ(behindLastAtLeast(quals.data(), len, minQual), expectedBehindLast);
+        }
+    }
+}
+
+SEQAN_DEFINE_TEST(test_quality_trim_sliding_window)
+{
+    // Qualities 40, 40, 40, 40, 2, 2, 2, 40: the window 2-5 has mean 21, the windows 3-6 and 4-7 have mean 11.5.
+    std::string quals = "IIII###I";
+    SEQAN_ASSERT_EQ(slidingWindowEnd(quals.data(), quals.size(), 4, 20), 3u);
+    SEQAN_ASSERT_EQ(slidingWindowEnd(quals.data(), quals.size(), 4, 10), 8u);
+    SEQAN_ASSERT_EQ(slidingWindowEnd(quals.data(), quals.size(), 1, 10), 4u);
+    // Reads shorter than the window are one window.
+    SEQAN_ASSERT_EQ(slidingWindowEnd(quals.data(), quals.size(), 100, 30), 0u);
+    SEQAN_ASSERT_EQ(slidingWindowEnd(quals.data(), 0, 4, 30), 0u);
+
+    __uint64 state = 12;
+    for (unsigned len = 0; len <= 80u; ++len)
+    {
+        for (unsigned k = 0; k < 20u; ++k)
+        {
+            buildTestQualities(quals, state, len);
+            unsigned windowSize = 1 + k % 12;
+            int minQual = 10 + k;
+
+            unsigned w = std::min((size_t)windowSize, (size_t)len);
+            size_t expected = len;
+            for (size_t i = 0; w > 0u && i + w <= len && expected == len; ++i)
+            {
+                long sum = 0;
+                for (size_t j = i; j < i + w; ++j)
+                    sum += quals[j] - 33;
+                if (sum < (long)minQual * w)
+                    expected = i;
+            }
+            SEQAN_ASSERT_EQ(slidingWindowEnd(quals.data(), len, windowSize, minQual), expected);
+        }
+    }
+}
+
+SEQAN_DEFINE_TEST(test_quality_trim_bwa)
+{
+    // From the 3' end, the sums of 20 - quality are 18, 36, 16, -4: cut behind the first 6 bases.
+    std::string quals = "IIIIII##";
+    SEQAN_ASSERT_EQ(bwaTrimEnd(quals.data(), quals.size(), 20), 6u);
+    // Nothing to trim.
+    SEQAN_ASSERT_EQ(bwaTrimEnd(quals.data(), 6, 20), 6u);
+    // Everything is trimmed.
+    quals = "######";
+    SEQAN_ASSERT_EQ(bwaTrimEnd(quals.data(), quals.size(), 20), 0u);
+    // A single good base in the low quality tail does not stop trimming.
+    quals = "IIII###I###";
+    SEQAN_ASSERT_EQ(bwaTrimEnd(quals.data(), quals.size(), 20), 4u);
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_QUALITY_TRIM_H_
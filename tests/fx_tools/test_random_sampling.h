@@ -0,0 +1,151 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Tests for random_sampling.h.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_RANDOM_SAMPLING_H_
+#define SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_RANDOM_SAMPLING_H_
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include "random_sampling.h"
+
+SEQAN_DEFINE_TEST(test_random_sampling_unit_random)
+{
+    FastRandom rng(5);
+    double sum = 0;
+    for (unsigned i = 0; i < 100000u; ++i)
+    {
+        double x = nextUnitRandom(rng);
+        SEQAN_ASSERT_GT(x, 0.0);
+        SEQAN_ASSERT_LEQ(x, 1.0);
+        sum += x;
+    }
+    SEQAN_ASSERT_IN_DELTA(sum / 100000, 0.5, 0.01);
+}
+
+SEQAN_DEFINE_TEST(test_random_sampling_bernoulli)
+{
+    BernoulliSampler sampler;
+
+    init(sampler, 0, 1);
+    for (unsigned i = 0; i < 1000u; ++i)
+        SEQAN_ASSERT_NOT(sample(sampler, i));
+    init(sampler, 1, 1);
+    for (unsigned i = 0; i < 1000u; ++i)
+        SEQAN_ASSERT(sample(sampler, i));
+
+    // About 10% are selected, standard deviation ~95.
+    init(sampler, 0.1, 7);
+    seqan::String<__uint64> picks;
+    for (unsigned i = 0; i < 100000u; ++i)
+        if (sample(sampler, i))
+            appendValue(picks, i);
+    SEQAN_ASSERT_GT(length(picks), 9500u);
+    SEQAN_ASSERT_LT(length(picks), 10500u);
+
+    // The same seed selects the same items, also if unselected items are left out.
+    init(sampler, 0.1, 7);
+    for (unsigned i = 0, j = 0; i < 100000u; ++i)
+    {
+        bool picked = (j < length(picks) && picks[j] == i);
+        if (!picked && i % 3 != 0u)
+            continue;
+        SEQAN_ASSERT_EQ(sample(sampler, i), picked);
+        j += picked;
+    }
+
+    // Other seeds select other items.
+    init(sampler, 0.1, 8);
+    unsigned numSame = 0;
+    for (unsigned i = 0, j = 0; i < 100000u; ++i)
+    {
+        while (j < length(picks) && picks[j] < i)
+            ++j;
+        numSame += sample(sampler, i) && j < length(picks) && picks[j] == i;
+    }
+    SEQAN_ASSERT_LT(numSame, 2000u);
+}
+
+SEQAN_DEFINE_TEST(test_random_sampling_reservoir)
+{
+    ReservoirSampler sampler;
+
+    init(sampler, 0, 1);
+    SEQAN_ASSERT_EQ(sample(sampler, 0), seqan::maxValue<__uint64>());
+
+    // Fewer items than the reservoir size are all kept in order.
+    init(sampler, 10, 1);
+    for (unsigned i = 0; i < 5u; ++i)
+        SEQAN_ASSERT_EQ(sample(sampler, i), i);
+
+    // Each of 100 items ends up in a reservoir of 10 with probability 0.1, i.e. 200 times in 2000 runs with a
+    // standard deviation of ~13.
+    unsigned counts[100] = {0};
+    for (unsigned seed = 0; seed < 2000u; ++seed)
+    {
+        init(sampler, 10, seed);
+        __uint64 reservoir[10];
+        for (unsigned i = 0; i < 10u; ++i)
+            reservoir[i] = seqan::maxValue<__uint64>();
+        for (unsigned i = 0; i < 100u; ++i)
+        {
+            __uint64 slot = sample(sampler, i);
+            if (slot == seqan::maxValue<__uint64>())
+                continue;
+            SEQAN_ASSERT_LT(slot, 10u);
+            reservoir[slot] = i;
+        }
+        for (unsigned i = 0; i < 10u; ++i)
+        {
+            SEQAN_ASSERT_LT(reservoir[i], 100u);
+            counts[reservoir[i]] += 1;
+        }
+    }
+    for (unsigned i = 0; i < 100u; ++i)
+    {
+        SEQAN_ASSERT_GT(counts[i], 130u);
+        SEQAN_ASSERT_LT(counts[i], 270u);
+    }
+
+    // The same seed gives the same slots.
+    ReservoirSampler other;
+    init(sampler, 50, 3);
+    init(other, 50, 3);
+    for (unsigned i = 0; i < 100000u; ++i)
+        SEQAN_ASSERT_EQ(sample(sampler, i), sample(other, i));
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_RANDOM_SAMPLING_H_
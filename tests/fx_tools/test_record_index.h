@@ -0,0 +1,288 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Tests for record_scanner.h and record_index.h.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_RECORD_INDEX_H_
+#define SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_RECORD_INDEX_H_
+
+#include <string>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include "record_index.h"
+#include "record_scanner.h"
+
+// Build a FASTQ file with numRecords records of varying length.  Every third quality line starts with '@' to make
+// record resynchronization non-trivial.  The record begin offsets are appended to starts.
+
+inline void buildTestFastq(std::string & file, seqan::String<__uint64> & starts, unsigned numRecords)
+{
+    __uint64 state = 42;
+    for (unsigned i = 0; i < numRecords; ++i)
+    {
+        appendValue(starts, file.size());
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        unsigned len = 1 + (state >> 33) % 120;
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "@read%u\n", i);
+        file += buffer;
+        for (unsigned j = 0; j < len; ++j)
+            file += "ACGT"[(state >> (j % 60)) & 3];
+        file += "\n+\n";
+        for (unsigned j = 0; j < len; ++j)
+            file += (j == 0u && i % 3 == 0u) ? '@' : (char)('!' + (i + j) % 40);
+        file += '\n';
+    }
+}
+
+// Build a multi-line FASTA file, the header lines contain '>' characters.
+
+inline void buildTestFasta(std::string & file, seqan::String<__uint64> & starts, unsigned numRecords)
+{
+    for (unsigned i = 0; i < numRecords; ++i)
+    {
+        appendValue(starts, file.size());
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), ">seq%u a>b\n", i);
+        file += buffer;
+        for (unsigned j = 0; j < 7 * i % 200; ++j)
+        {
+            file += "ACGTN"[j % 5];
+            if (j % 60 == 59u)
+                file += '\n';
+        }
+        file += '\n';
+    }
+}
+
+SEQAN_DEFINE_TEST(test_record_scanner_skip_fastq_record)
+{
+    std::string file = "@r1 x\nACGT\nAC\n+\nIIII\nII\n@r2\nA\n+\nI\n";
+    char const * fileBegin = file.data();
+    char const * fileEnd = fileBegin + file.size();
+
+    __uint64 seqLength = 0;
+    char const * plusLine = 0;
+    char const * next = skipFastqRecord(seqLength, plusLine, fileBegin, fileEnd);
+    SEQAN_ASSERT_EQ(next - fileBegin, (int)file.find("@r2"));
+    SEQAN_ASSERT_EQ(seqLength, 6u);
+    SEQAN_ASSERT_EQ(plusLine - fileBegin, (int)file.find("+"));
+    SEQAN_ASSERT(skipFastqRecord(next, fileEnd) == fileEnd);
+
+    // Quality string too short or missing.
+    std::string bad = "@r1\nACGT\n+\nIII\n";
+    SEQAN_ASSERT(skipFastqRecord(bad.data(), bad.data() + bad.size()) == 0);
+    bad = "@r1\nACGT\n";
+    SEQAN_ASSERT(skipFastqRecord(bad.data(), bad.data() + bad.size()) == 0);
+    // Not at a record begin.
+    SEQAN_ASSERT(skipRawRecord(fileBegin + 1, fileEnd, RAW_FORMAT_FASTQ) == 0);
+
+    // Windows line endings and trailing blank lines.
+    std::string crlf = "@r1\r\nACG\r\n+\r\nIII\r\n\r\n\n@r2\r\nA\r\n+\r\nI\r\n";
+    next = skipRawRecord(crlf.data(), crlf.data() + crlf.size(), RAW_FORMAT_FASTQ);
+    SEQAN_ASSERT_EQ(next - crlf.data(), (int)crlf.find("@r2"));
+}
+
+SEQAN_DEFINE_TEST(test_record_scanner_skip_fasta_record)
+{
+    std::string file = ">r1 a>b\nACGT\nAC\n\n>r2\nA\n";
+    char const * fileBegin = file.data();
+    char const * fileEnd = fileBegin + file.size();
+
+    SEQAN_ASSERT_EQ(guessRawFormat(fileBegin, fileEnd), RAW_FORMAT_FASTA);
+    char const * next = skipRawRecord(fileBegin, fileEnd, RAW_FORMAT_FASTA);
+    SEQAN_ASSERT_EQ(next - fileBegin, (int)file.find(">r2"));
+    SEQAN_ASSERT(skipRawRecord(next, fileEnd, RAW_FORMAT_FASTA) == fileEnd);
+    SEQAN_ASSERT(skipRawRecord(fileBegin + 1, fileEnd, RAW_FORMAT_FASTA) == 0);
+}
+
+SEQAN_DEFINE_TEST(test_record_scanner_find_record_begin_fastq)
+{
+    // The quality line of r1 starts with '@' and parses as a header if only one record is checked.
+    std::string file = "@r1\nACGT\n+\n@III\n@r2\nCCCC\n+\nIIII\n@r3\nGG\n+\nII\n";
+    char const * fileBegin = file.data();
+    char const * fileEnd = fileBegin + file.size();
+
+    SEQAN_ASSERT_EQ(guessRawFormat(fileBegin, fileEnd), RAW_FORMAT_FASTQ);
+    SEQAN_ASSERT(findRawRecordBegin(fileBegin, fileBegin, fileEnd, RAW_FORMAT_FASTQ) == fileBegin);
+    char const * r2 = fileBegin + file.find("@r2");
+    SEQAN_ASSERT(findRawRecordBegin(fileBegin + file.find("@III"), fileBegin, fileEnd, RAW_FORMAT_FASTQ) == r2);
+    SEQAN_ASSERT(findRawRecordBegin(fileBegin + 1, fileBegin, fileEnd, RAW_FORMAT_FASTQ) == r2);
+    SEQAN_ASSERT(findRawRecordBegin(r2 + 1, fileBegin, fileEnd, RAW_FORMAT_FASTQ) == fileBegin + file.find("@r3"));
+
+    // Resynchronize from every position of a larger file.
+    seqan::String<__uint64> starts;
+    file.clear();
+    buildTestFastq(file, starts, 200);
+    fileBegin = file.data();
+    fileEnd = fileBegin + file.size();
+    unsigned next = 0;
+    for (__uint64 pos = 0; pos < file.size(); ++pos)
+    {
+        while (next < length(starts) && starts[next] < pos)
+            ++next;
+        char const * expected = (next < length(starts)) ? fileBegin + starts[next] : fileEnd;
+        SEQAN_ASSERT(findRawRecordBegin(fileBegin + pos, fileBegin, fileEnd, RAW_FORMAT_FASTQ) == expected);
+    }
+}
+
+SEQAN_DEFINE_TEST(test_record_scanner_find_record_begin_fasta)
+{
+    std::string file;
+    seqan::String<__uint64> starts;
+    buildTestFasta(file, starts, 50);
+    char const * fileBegin = file.data();
+    char const * fileEnd = fileBegin + file.size();
+
+    unsigned next = 0;
+    for (__uint64 pos = 0; pos < file.size(); ++pos)
+    {
+        while (next < length(starts) && starts[next] < pos)
+            ++next;
+        char const * expected = (next < length(starts)) ? fileBegin + starts[next] : fileEnd;
+        SEQAN_ASSERT(findRawRecordBegin(fileBegin + pos, fileBegin, fileEnd, RAW_FORMAT_FASTA) == expected);
+    }
+}
+
+SEQAN_DEFINE_TEST(test_record_index_build_fastq)
+{
+    std::string file;
+    seqan::String<__uint64> starts;
+    buildTestFastq(file, starts, 5000);
+
+    RecordIndex index;
+    SEQAN_ASSERT_EQ(build(index, file.data(), file.data() + file.size(), 16, 4), 0);
+    SEQAN_ASSERT_EQ(index.format, RAW_FORMAT_FASTQ);
+    SEQAN_ASSERT_EQ(index.sampleRate, 16u);
+    SEQAN_ASSERT_EQ(index.fileSize, file.size());
+    SEQAN_ASSERT_EQ(index.numRecords, 5000u);
+    SEQAN_ASSERT_EQ(length(index.recordNos), (5000u + 15) / 16);
+    SEQAN_ASSERT_EQ(length(index.offsets), length(index.recordNos));
+    for (unsigned i = 0; i < length(index.recordNos); ++i)
+    {
+        SEQAN_ASSERT_EQ(index.recordNos[i], i * 16u);
+        SEQAN_ASSERT_EQ(index.offsets[i], starts[index.recordNos[i]]);
+    }
+
+    // Truncated files are rejected.
+    SEQAN_ASSERT_EQ(build(index, file.data(), file.data() + file.size() - 2, 16, 4), 1);
+}
+
+SEQAN_DEFINE_TEST(test_record_index_build_fasta)
+{
+    std::string file;
+    seqan::String<__uint64> starts;
+    buildTestFasta(file, starts, 300);
+
+    RecordIndex index;
+    SEQAN_ASSERT_EQ(build(index, file.data(), file.data() + file.size(), 7, 2), 0);
+    SEQAN_ASSERT_EQ(index.format, RAW_FORMAT_FASTA);
+    SEQAN_ASSERT_EQ(index.numRecords, 300u);
+    for (unsigned i = 0; i < length(index.recordNos); ++i)
+        SEQAN_ASSERT_EQ(index.offsets[i], starts[index.recordNos[i]]);
+
+    // Empty files give empty indices, other files must be FASTA or FASTQ.
+    std::string empty = "\n\n";
+    SEQAN_ASSERT_EQ(build(index, empty.data(), empty.data() + empty.size(), 7, 2), 0);
+    SEQAN_ASSERT_EQ(index.numRecords, 0u);
+    std::string none;
+    SEQAN_ASSERT_EQ(build(index, none.data(), none.data() + none.size(), 7, 2), 0);
+    SEQAN_ASSERT_EQ(index.numRecords, 0u);
+    std::string other = "ACGT\n";
+    SEQAN_ASSERT_EQ(build(index, other.data(), other.data() + other.size(), 7, 2), 1);
+    std::string junk = "\nfoo bar\n";
+    SEQAN_ASSERT_EQ(build(index, junk.data(), junk.data() + junk.size(), 7, 2), 1);
+}
+
+SEQAN_DEFINE_TEST(test_record_index_find_record)
+{
+    std::string file;
+    seqan::String<__uint64> starts;
+    buildTestFastq(file, starts, 1000);
+    char const * fileBegin = file.data();
+    char const * fileEnd = fileBegin + file.size();
+
+    RecordIndex index;
+    SEQAN_ASSERT_EQ(build(index, fileBegin, fileEnd, 10, 1), 0);
+
+    // Seek to the closest sample and skip forward to the record.
+    for (__uint64 recordNo = 0; recordNo < 1000u; recordNo += 37)
+    {
+        __uint64 offset = 0, foundNo = 0;
+        findRecord(offset, foundNo, index, recordNo);
+        SEQAN_ASSERT_LEQ(foundNo, recordNo);
+        SEQAN_ASSERT_LT(recordNo - foundNo, 10u);
+        SEQAN_ASSERT_EQ(offset, starts[foundNo]);
+
+        char const * it = fileBegin + offset;
+        for (; foundNo < recordNo; ++foundNo)
+            it = skipRawRecord(it, fileEnd, RAW_FORMAT_FASTQ);
+        SEQAN_ASSERT_EQ((__uint64)(it - fileBegin), starts[recordNo]);
+    }
+}
+
+SEQAN_DEFINE_TEST(test_record_index_save_load)
+{
+    std::string file;
+    seqan::String<__uint64> starts;
+    buildTestFastq(file, starts, 1000);
+
+    RecordIndex index;
+    SEQAN_ASSERT_EQ(build(index, file.data(), file.data() + file.size(), 3, 1), 0);
+
+    std::string path = SEQAN_TEMP_FILENAME();
+    SEQAN_ASSERT_EQ(save(index, path.c_str()), 0);
+    RecordIndex loaded;
+    SEQAN_ASSERT_EQ(load(loaded, path.c_str()), 0);
+    SEQAN_ASSERT_EQ(loaded.format, index.format);
+    SEQAN_ASSERT_EQ(loaded.sampleRate, index.sampleRate);
+    SEQAN_ASSERT_EQ(loaded.fileSize, index.fileSize);
+    SEQAN_ASSERT_EQ(loaded.numRecords, index.numRecords);
+    SEQAN_ASSERT_EQ(length(loaded.recordNos), length(index.recordNos));
+    for (unsigned i = 0; i < length(index.recordNos); ++i)
+    {
+        SEQAN_ASSERT_EQ(loaded.recordNos[i], index.recordNos[i]);
+        SEQAN_ASSERT_EQ(loaded.offsets[i], index.offsets[i]);
+    }
+
+    // Other files are rejected.
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::out);
+    out << "@r1\nA\n+\nI\n";
+    out.close();
+    SEQAN_ASSERT_EQ(load(loaded, path.c_str()), 1);
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_RECORD_INDEX_H_
@@ -0,0 +1,173 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Tests for record_sorter.h.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_RECORD_SORTER_H_
+#define SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_RECORD_SORTER_H_
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include "record_sorter.h"
+
+// Collects the records in the order given by forEachSorted().
+
+struct SortedRecordCollector_
+{
+    std::vector<std::pair<__uint64, __uint64> > records;
+
+    int operator()(__uint64 beginPos, __uint64 endPos)
+    {
+        records.push_back(std::make_pair(beginPos, endPos));
+        return 0;
+    }
+};
+
+// Orders record numbers by their keys as unsigned bytes, stable sorting keeps the input order for equal keys.
+
+struct LessTestKey_
+{
+    std::vector<std::string> const * keys;
+
+    explicit LessTestKey_(std::vector<std::string> const & keys) : keys(&keys)
+    {}
+
+    bool operator()(unsigned lhs, unsigned rhs) const
+    {
+        std::string const & l = (*keys)[lhs];
+        std::string const & r = (*keys)[rhs];
+        return std::lexicographical_compare((unsigned char const *)l.data(), (unsigned char const *)l.data() + l.size(),
+                                            (unsigned char const *)r.data(), (unsigned char const *)r.data() + r.size());
+    }
+};
+
+// Sort numKeys random keys with the given memory limit and compare against std::stable_sort.  The keys share long
+// prefixes, contain bytes >= 0x80 and repeat, record i has the byte range [10 * i, 10 * i + 5).
+
+inline void testRecordSorter(unsigned numKeys, __uint64 maxBytes, unsigned numThreads, bool expectRuns)
+{
+    std::vector<std::string> keys;
+    __uint64 state = 3;
+    for (unsigned i = 0; i < numKeys; ++i)
+    {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        std::string key((state >> 60) % 2 ? "PREFIX__" : "");
+        unsigned len = (state >> 33) % 12;
+        for (unsigned j = 0; j < len; ++j)
+            key += "AC\x80\xff"[(state >> (2 * j + 8)) & 3];
+        keys.push_back(key);
+    }
+
+    RecordSorter sorter;
+    init(sorter, maxBytes, std::string(SEQAN_TEMP_FILENAME()) + ".", numThreads);
+    for (unsigned i = 0; i < numKeys; ++i)
+        SEQAN_ASSERT_EQ(add(sorter, keys[i].data(), keys[i].size(), 10 * i, 10 * i + 5), 0);
+    SEQAN_ASSERT_EQ(sorter.numRecords, numKeys);
+    SEQAN_ASSERT_EQ(!sorter.runPaths.empty(), expectRuns);
+
+    SortedRecordCollector_ collector;
+    SEQAN_ASSERT_EQ(forEachSorted(sorter, collector), 0);
+
+    std::vector<unsigned> expected(numKeys);
+    for (unsigned i = 0; i < numKeys; ++i)
+        expected[i] = i;
+    std::stable_sort(expected.begin(), expected.end(), LessTestKey_(keys));
+
+    SEQAN_ASSERT_EQ(collector.records.size(), numKeys);
+    for (unsigned i = 0; i < numKeys; ++i)
+    {
+        SEQAN_ASSERT_EQ(collector.records[i].first, 10u * expected[i]);
+        SEQAN_ASSERT_EQ(collector.records[i].second, 10u * expected[i] + 5);
+    }
+}
+
+SEQAN_DEFINE_TEST(test_record_sorter_in_memory)
+{
+    testRecordSorter(0, 1024 * 1024 * 1024, 1, false);
+    testRecordSorter(1, 1024 * 1024 * 1024, 1, false);
+    testRecordSorter(50000, 1024 * 1024 * 1024, 1, false);
+    testRecordSorter(50000, 1024 * 1024 * 1024, 4, false);
+}
+
+SEQAN_DEFINE_TEST(test_record_sorter_spill_merge)
+{
+    // About 700 records per run.
+    testRecordSorter(50000, 32 * 1024, 1, true);
+    testRecordSorter(50000, 32 * 1024, 4, true);
+    // Every record is its own run.
+    testRecordSorter(100, 1, 1, true);
+}
+
+// Shorten the file at path by numBytes bytes.
+
+inline void truncateTestFile(std::string const & path, size_t numBytes)
+{
+    std::ifstream in(path.c_str(), std::ios::binary | std::ios::in);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    in.close();
+    std::string contents = ss.str();
+    SEQAN_ASSERT_GEQ(contents.size(), numBytes);
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::out | std::ios::trunc);
+    out.write(contents.data(), contents.size() - numBytes);
+}
+
+SEQAN_DEFINE_TEST(test_record_sorter_truncated_run)
+{
+    // Every entry of a run takes 3 * 8 bytes plus the 4 key bytes.  Cutting a run in the middle of an entry or at an
+    // entry boundary are both errors, the records must not be dropped silently.
+    for (unsigned numBytes = 1; numBytes <= 28u; numBytes += 27)
+    {
+        RecordSorter sorter;
+        init(sorter, 1024, std::string(SEQAN_TEMP_FILENAME()) + ".", 1);
+        for (unsigned i = 0; i < 200; ++i)
+            SEQAN_ASSERT_EQ(add(sorter, (i % 2) ? "KEY1" : "KEY0", 4, 10 * i, 10 * i + 5), 0);
+        SEQAN_ASSERT_GT(sorter.runPaths.size(), 1u);
+        truncateTestFile(sorter.runPaths[0], numBytes);
+
+        SortedRecordCollector_ collector;
+        SEQAN_ASSERT_EQ(forEachSorted(sorter, collector), 1);
+        SEQAN_ASSERT_LT(collector.records.size(), 200u);
+    }
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_RECORD_SORTER_H_
@@ -0,0 +1,183 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Tests for rename_pattern.h.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_RENAME_PATTERN_H_
+#define SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_RENAME_PATTERN_H_
+
+#include <string>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include "rename_pattern.h"
+
+// Format the name for index, mate and header with pattern.
+
+inline std::string formatTestName(RenamePattern const & pattern, __uint64 index, char mate, std::string const & header)
+{
+    std::string buffer(maxNameLength(pattern, header.size()), '\0');
+    char * end = formatName(&buffer[0], pattern, index, mate, header.data(), header.data() + header.size());
+    buffer.resize(end - &buffer[0]);
+    return buffer;
+}
+
+SEQAN_DEFINE_TEST(test_rename_pattern_compile)
+{
+    RenamePattern pattern;
+    SEQAN_ASSERT_EQ(compile(pattern, "{prefix}.{index}/{mate}", "run7"), 0);
+    SEQAN_ASSERT_EQ(formatTestName(pattern, 42, '2', "r1 comment"), "run7.42/2");
+    SEQAN_ASSERT_EQ(compile(pattern, "{{{name}}}:{comment}", ""), 0);
+    SEQAN_ASSERT_EQ(formatTestName(pattern, 42, '1', "r1 1:N:0:ACGT"), "{r1}:1:N:0:ACGT");
+    SEQAN_ASSERT_EQ(formatTestName(pattern, 42, '1', "r1"), "{r1}:");
+    SEQAN_ASSERT_EQ(compile(pattern, "r{index:16:6}_{index:36}_{index:64:3}", ""), 0);
+    SEQAN_ASSERT_EQ(formatTestName(pattern, 255, '1', ""), "r0000ff_73_-2z");
+    SEQAN_ASSERT_EQ(compile(pattern, "", ""), 0);
+    SEQAN_ASSERT_EQ(formatTestName(pattern, 1, '1', "r1"), "");
+
+    // Syntax errors.
+    SEQAN_ASSERT_EQ(compile(pattern, "{index", ""), 1);
+    SEQAN_ASSERT_EQ(compile(pattern, "index}", ""), 1);
+    SEQAN_ASSERT_EQ(compile(pattern, "{unknown}", ""), 1);
+    SEQAN_ASSERT_EQ(compile(pattern, "{prefix:1}", ""), 1);
+    SEQAN_ASSERT_EQ(compile(pattern, "{mate:1}", ""), 1);
+    SEQAN_ASSERT_EQ(compile(pattern, "{index:7}", ""), 1);
+    SEQAN_ASSERT_EQ(compile(pattern, "{index:10:65}", ""), 1);
+    SEQAN_ASSERT_EQ(compile(pattern, "{index:x}", ""), 1);
+}
+
+SEQAN_DEFINE_TEST(test_rename_pattern_radix_64_order)
+{
+    // Zero padded radix 64 names sort like their numbers.
+    RenamePattern pattern;
+    SEQAN_ASSERT_EQ(compile(pattern, "{index:64:4}", ""), 0);
+    std::string last = formatTestName(pattern, 0, '1', "");
+    SEQAN_ASSERT_EQ(last, "----");
+    for (__uint64 index = 1; index < 100000u; index += 7)
+    {
+        std::string name = formatTestName(pattern, index, '1', "");
+        SEQAN_ASSERT_LT(last, name);
+        last = name;
+    }
+}
+
+SEQAN_DEFINE_TEST(test_rename_pattern_is_invertible)
+{
+    RenamePattern pattern;
+    compile(pattern, "{prefix}{index:64}/{mate}", "x");
+    SEQAN_ASSERT(isInvertible(pattern));
+    compile(pattern, "r{index}_{name}", "");
+    SEQAN_ASSERT(isInvertible(pattern));
+    compile(pattern, "r{index}.{index:16}", "");
+    SEQAN_ASSERT(isInvertible(pattern));
+    // No index, a name before it or a digit behind it.
+    compile(pattern, "{prefix}/{mate}", "x");
+    SEQAN_ASSERT_NOT(isInvertible(pattern));
+    compile(pattern, "{name}.{index}", "");
+    SEQAN_ASSERT_NOT(isInvertible(pattern));
+    compile(pattern, "{index}0", "");
+    SEQAN_ASSERT_NOT(isInvertible(pattern));
+    compile(pattern, "{index:16}a", "");
+    SEQAN_ASSERT_NOT(isInvertible(pattern));
+    compile(pattern, "{index}{mate}", "");
+    SEQAN_ASSERT_NOT(isInvertible(pattern));
+}
+
+SEQAN_DEFINE_TEST(test_rename_pattern_parse_index)
+{
+    char const * patterns[] =
+    {
+        "{index}",
+        "{prefix}{index:64}/{mate}",
+        "{prefix}_{index:16:8}_{name}",
+        "{mate}:{index:36:3}.{index}",
+        "{index:64:12}"
+    };
+    __uint64 indices[] = {0, 1, 9, 10, 63, 64, 4095, 123456789, 0xffffffffffffffffull};
+
+    for (unsigned p = 0; p < 5u; ++p)
+    {
+        RenamePattern pattern;
+        SEQAN_ASSERT_EQ(compile(pattern, patterns[p], "sample"), 0);
+        SEQAN_ASSERT(isInvertible(pattern));
+        for (unsigned i = 0; i < 9u; ++i)
+        {
+            std::string name = formatTestName(pattern, indices[i], '2', "orig/2 comment");
+            SEQAN_ASSERT_LEQ(name.size(), maxNameLength(pattern, 14));
+            __uint64 index = 0;
+            SEQAN_ASSERT(parseIndex(index, pattern, name.data(), name.data() + name.size()));
+            SEQAN_ASSERT_EQ(index, indices[i]);
+            // Stripped mate suffixes are accepted.
+            if (name.size() > 2u && name[name.size() - 2] == '/')
+            {
+                SEQAN_ASSERT(parseIndex(index, pattern, name.data(), name.data() + name.size() - 2));
+                SEQAN_ASSERT_EQ(index, indices[i]);
+            }
+        }
+    }
+
+    // Names that do not match.
+    RenamePattern pattern;
+    compile(pattern, "r{index}.{index:16}", "");
+    __uint64 index = 0;
+    std::string name = "r12.c";
+    SEQAN_ASSERT(parseIndex(index, pattern, name.data(), name.data() + name.size()));
+    SEQAN_ASSERT_EQ(index, 12u);
+    name = "r12.d";
+    SEQAN_ASSERT_NOT(parseIndex(index, pattern, name.data(), name.data() + name.size()));
+    name = "s12.c";
+    SEQAN_ASSERT_NOT(parseIndex(index, pattern, name.data(), name.data() + name.size()));
+    name = "r.c";
+    SEQAN_ASSERT_NOT(parseIndex(index, pattern, name.data(), name.data() + name.size()));
+    name = "r12";
+    SEQAN_ASSERT_NOT(parseIndex(index, pattern, name.data(), name.data() + name.size()));
+}
+
+SEQAN_DEFINE_TEST(test_rename_pattern_mates)
+{
+    std::string header = "read7/2 extra";
+    SEQAN_ASSERT_EQ(mateOfHeader(header.data(), header.data() + header.size()), '2');
+    SEQAN_ASSERT_EQ(mateNameEnd(header.data(), header.data() + header.size()) - header.data(), 5);
+    header = "read7 1:N:0:ACGT";
+    SEQAN_ASSERT_EQ(mateOfHeader(header.data(), header.data() + header.size()), '1');
+    header = "read7\t2:Y:0:ACGT";
+    SEQAN_ASSERT_EQ(mateOfHeader(header.data(), header.data() + header.size()), '2');
+    SEQAN_ASSERT_EQ(mateNameEnd(header.data(), header.data() + header.size()) - header.data(), 5);
+    header = "read7/3";
+    SEQAN_ASSERT_EQ(mateOfHeader(header.data(), header.data() + header.size()), '1');
+    SEQAN_ASSERT_EQ(mateNameEnd(header.data(), header.data() + header.size()) - header.data(), 7);
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_RENAME_PATTERN_H_
@@ -0,0 +1,95 @@
+// ==========================================================================
+//                               FX Tools
+// ==========================================================================
+// Copyright (c) 2006-2012, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Author: Manuel Holtgrewe <manuel.holtgrewe@fu-berlin.de>
+// ==========================================================================
+// Tests for reverse_complement.h.
+// ==========================================================================
+
+#ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_REVERSE_COMPLEMENT_H_
+#define SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_REVERSE_COMPLEMENT_H_
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include <seqan/basic.h>
+
+#include "reverse_complement.h"
+
+SEQAN_DEFINE_TEST(test_reverse_complement_char)
+{
+    std::string const from = "ACGTUNRYSWKMBDHVacgtunryswkmbdhv.-*";
+    std::string const to   = "TGCAANYRSWMKVHDBtgcaanyrswmkvhdb.-*";
+    for (unsigned i = 0; i < from.size(); ++i)
+        SEQAN_ASSERT_EQ(complementChar(from[i]), to[i]);
+    // Every character but U is its complement's complement.
+    for (unsigned c = 0; c < 256u; ++c)
+        if (c != 'U' && c != 'u')
+            SEQAN_ASSERT_EQ(complementChar(complementChar((char)c)), (char)c);
+}
+
+SEQAN_DEFINE_TEST(test_reverse_complement_in_place)
+{
+    std::string seq = "acgRN";
+    reverseComplementInPlace(&seq[0], &seq[0] + seq.size(), 0);
+    SEQAN_ASSERT_EQ(seq, std::string("NYcgt"));
+
+    // All lengths around the 16 and 32 character blocks, with and without non-letters that make the vectorized code
+    // fall back to the scalar one.
+    char const * ALPHABET[2] = {"ACGTNacgtnRYKM", "ACGTN-acgt.n"};
+    __uint64 state = 1;
+    for (unsigned a = 0; a < 2u; ++a)
+    {
+        unsigned alphabetSize = strlen(ALPHABET[a]);
+        for (unsigned len = 0; len < 100u; ++len)
+        {
+            std::string seq, quals;
+            for (unsigned i = 0; i < len; ++i)
+            {
+                state = state * 6364136223846793005ull + 1442695040888963407ull;
+                seq += ALPHABET[a][(state >> 33) % alphabetSize];
+                quals += (char)('!' + (state >> 40) % 41);
+            }
+            std::string expectedSeq = seq, expectedQuals = quals;
+            std::reverse(expectedSeq.begin(), expectedSeq.end());
+            for (unsigned i = 0; i < len; ++i)
+                expectedSeq[i] = complementChar(expectedSeq[i]);
+            std::reverse(expectedQuals.begin(), expectedQuals.end());
+
+            reverseComplementInPlace(&seq[0], &seq[0] + len, &quals[0]);
+            SEQAN_ASSERT_EQ(seq, expectedSeq);
+            SEQAN_ASSERT_EQ(quals, expectedQuals);
+        }
+    }
+}
+
+#endif  // #ifndef SANDBOX_FX_TOOLS_TESTS_FX_TOOLS_TEST_REVERSE_COMPLEMENT_H_